@@ -2,6 +2,7 @@
 #define _CHEATAPI_H_
 
 #include "include/cheat_engine.h"
+#include "include/cheat_prog.h"
 #include "include/ee_core.h"
 
 void EnableCheats(void);
@@ -36,4 +36,8 @@ extern u32 numcodes;
 extern u32 hooklist[];
 extern u32 codelist[];
 
+/* When the frontend supplied a compiled program, it is stored in codelist instead of the codes. */
+extern u32 numprogwords;
+extern void CheatProgramHandler(void);
+
 #endif /* _CHEATENGINE_H_ */
@@ -0,0 +1,59 @@
+#ifndef _CHEATPROG_H_
+#define _CHEATPROG_H_
+
+/*
+ * Pre-decoded cheat program
+ *
+ * Compiled by the frontend (src/cheatman.c) from the code list, run by the EE core (src/cheat_prog.c)
+ * instead of interpreting the raw codes. Constant writes are merged and sorted by address, and
+ * conditional codes know how many program words to skip. The program never needs more space than
+ * the code list it was compiled from.
+ *
+ * Every operation starts with a header word: bits 31-28 operation, 27-25 flags, 24-0 address.
+ * The operands that follow are listed next to each operation.
+ */
+#define CHEAT_OP_WRITE8  0x1 // value
+#define CHEAT_OP_WRITE16 0x2 // value
+#define CHEAT_OP_WRITE32 0x3 // value
+#define CHEAT_OP_RUN32   0x4 // count, values for count consecutive words
+#define CHEAT_OP_INC     0x5 // flags = size; delta (negative to decrement)
+#define CHEAT_OP_SERIAL  0x6 // count << 16 | step in words, value, increment
+#define CHEAT_OP_COPY    0x7 // length, destination address
+#define CHEAT_OP_POINTER 0x8 // flags = size; value, offset
+#define CHEAT_OP_BOOL    0x9 // flags = CHEAT_BOOL_*; value
+#define CHEAT_OP_STOPNE  0xA // value; stop processing, unless the word at the address is equal to it
+#define CHEAT_OP_IF      0xB // flags = CHEAT_SIZE_8 or CHEAT_SIZE_16; value | test << 16 | skip << 19
+
+#define CHEAT_SIZE_8  0
+#define CHEAT_SIZE_16 1
+#define CHEAT_SIZE_32 2
+
+#define CHEAT_BOOL_16  0x1 // 16-bit instead of 8-bit
+#define CHEAT_BOOL_OR  0x0
+#define CHEAT_BOOL_AND 0x2
+#define CHEAT_BOOL_XOR 0x4
+
+/* Tests of CHEAT_OP_IF, the same as the ones of the D code type.
+   When the test fails, the next skip words of the program are skipped. */
+#define CHEAT_TEST_EQ   0
+#define CHEAT_TEST_NE   1
+#define CHEAT_TEST_LT   2
+#define CHEAT_TEST_GT   3
+#define CHEAT_TEST_NAND 4
+#define CHEAT_TEST_AND  5
+#define CHEAT_TEST_NOR  6
+#define CHEAT_TEST_OR   7
+
+#define CHEAT_ADDR_MASK 0x01FFFFFF
+
+#define CHEAT_OP_HEADER(op, flags, addr) ((u32)(op) << 28 | (u32)(flags) << 25 | ((addr)&CHEAT_ADDR_MASK))
+#define CHEAT_OP(header)                 ((header) >> 28)
+#define CHEAT_FLAGS(header)              (((header) >> 25) & 7)
+#define CHEAT_ADDR(header)               ((header)&CHEAT_ADDR_MASK)
+
+#define CHEAT_IF_ARG(value, test, skip) ((value) | (u32)(test) << 16 | (u32)(skip) << 19)
+#define CHEAT_IF_VALUE(arg)             ((arg)&0xFFFF)
+#define CHEAT_IF_TEST(arg)              (((arg) >> 16) & 7)
+#define CHEAT_IF_SKIP(arg)              ((arg) >> 19)
+
+#endif /* _CHEATPROG_H_ */
@@ -45,7 +45,9 @@ struct EECoreConfig_t
     char g_ps2_gateway[16];
     unsigned char g_ps2_ETHOpMode;
 
-    u32 *gCheatList; // Store hooks/codes addr+val pairs
+    u32 *gCheatList;       // Store hooks/codes addr+val pairs
+    u32 *gCheatProgram;    // Codes compiled into a cheat program (cheat_prog.h), NULL to interpret gCheatList
+    int gCheatProgramSize; // Number of words in gCheatProgram
 
     void *eeloadCopy;
     void *initUserMemory;
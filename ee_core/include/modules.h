@@ -49,8 +49,19 @@ typedef struct
 {
     irxptr_t *modules;
     int count;
+    void *scratch; // Buffer for decompressing modules, large enough for the largest one
+    unsigned int scratchSize;
 } irxtab_t;
 
+// Compressed modules (pc/irxlz4.py) start with this header, followed by a raw LZ4 block.
+#define IRXLZ4_MAGIC 0x4D345A4C // "LZ4M"
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int size; // Uncompressed size
+} irxlz4_header_t;
+
 // Macros for working with module information.
 #define GET_OPL_MOD_ID(x)   ((x) >> 24)
 #define SET_OPL_MOD_ID(x)   ((x) << 24)
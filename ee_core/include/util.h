@@ -12,6 +12,32 @@
 
 #include <tamtypes.h>
 
+// Limits of scan_patterns_with_mask(), which sets scan_result_t::overflow when they are exceeded
+#define SCAN_MAX_PATTERNS 8
+#define SCAN_MAX_HITS     8  // Per pattern
+#define SCAN_MAX_CALLS    32
+
+// scan_patterns_with_mask() flags
+#define SCAN_CALLS         0x01 // Collect the J/JAL instructions that jump to a pattern match
+#define SCAN_STOP_ON_FIRST 0x02 // Stop at the first match of the first pattern
+
+typedef struct
+{
+    const u32 *pattern;
+    const u32 *mask;
+    unsigned int len; // In bytes
+} scan_pattern_t;
+
+typedef struct
+{
+    u32 *hits[SCAN_MAX_PATTERNS][SCAN_MAX_HITS]; // Matches of each pattern, in ascending order
+    u8 hitCount[SCAN_MAX_PATTERNS];
+    u32 *calls[SCAN_MAX_CALLS];   // J/JAL instructions
+    u32 *targets[SCAN_MAX_CALLS]; // The pattern match that each one jumps to
+    int callCount;
+    u8 overflow; // Some matches or calls were beyond the limits above and are missing
+} scan_result_t;
+
 void _strcpy(char *dst, const char *src);
 void _strcat(char *dst, const char *src);
 int _strncmp(const char *s1, const char *s2, int length);
@@ -28,6 +54,8 @@ int _strtoi(const char *p);
 u64 _strtoul(const char *p);
 void set_ipconfig(void);
 u32 *find_pattern_with_mask(u32 *buf, unsigned int bufsize, const u32 *pattern, const u32 *mask, unsigned int len);
+int scan_patterns_with_mask(u32 *buf, unsigned int bufsize, const scan_pattern_t *patterns, int count, int flags, scan_result_t *result);
+int lz4_decompress(const u8 *src, unsigned int srcsize, u8 *dst, unsigned int dstsize);
 void CopyToIop(void *eedata, unsigned int size, void *iopptr);
 void WipeUserMemory(void *start, void *end);
 void delay(int count);
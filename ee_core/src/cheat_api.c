@@ -70,6 +70,14 @@ void SetupCheats()
     }
     numhooks = j / 2;
     numcodes = k / 2;
+
+    // Run the compiled program instead of the codes, it was built from the same code list.
+    if (config->gCheatProgram != NULL && config->gCheatProgramSize <= MAX_CODES * 2) {
+        for (i = 0; i < config->gCheatProgramSize; i++)
+            codelist[i] = config->gCheatProgram[i];
+        numprogwords = config->gCheatProgramSize;
+        numcodes = 0;
+    }
 }
 
 /*-----------------------------------------------------*/
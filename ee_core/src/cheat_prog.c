@@ -0,0 +1,165 @@
+/*
+  Copyright 2009-2010, Ifcaro, jimmikaelkael & Polo
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Runs the pre-decoded cheat program (see cheat_prog.h), which the frontend compiled from the code list.
+  Called by EngineHandler, right after the code handler.
+*/
+
+#include <tamtypes.h>
+#include "include/cheat_api.h"
+
+/* Memory accessors, these may be replaced to run the program against a memory image. */
+#ifndef CHEAT_MEM8
+#define CHEAT_MEM8(addr)  (*(vu8 *)(addr))
+#define CHEAT_MEM16(addr) (*(vu16 *)(addr))
+#define CHEAT_MEM32(addr) (*(vu32 *)(addr))
+#endif
+
+u32 numprogwords;
+
+static int CheatTest(u32 header, u32 arg)
+{
+    u32 addr, value, current;
+
+    addr = CHEAT_ADDR(header);
+    value = CHEAT_IF_VALUE(arg);
+    current = (CHEAT_FLAGS(header) == CHEAT_SIZE_8) ? CHEAT_MEM8(addr) : CHEAT_MEM16(addr);
+
+    switch (CHEAT_IF_TEST(arg)) {
+        case CHEAT_TEST_EQ:
+            return current == value;
+        case CHEAT_TEST_NE:
+            return current != value;
+        case CHEAT_TEST_LT:
+            return current < value;
+        case CHEAT_TEST_GT:
+            return current > value;
+        case CHEAT_TEST_NAND:
+            return (current & value) == 0;
+        case CHEAT_TEST_AND:
+            return (current & value) != 0;
+        case CHEAT_TEST_NOR:
+            return (current | value) == 0;
+        default: // CHEAT_TEST_OR
+            return (current | value) != 0;
+    }
+}
+
+static void CheatWrite(int size, u32 addr, u32 value)
+{
+    switch (size) {
+        case CHEAT_SIZE_8:
+            CHEAT_MEM8(addr) = value;
+            break;
+        case CHEAT_SIZE_16:
+            CHEAT_MEM16(addr) = value;
+            break;
+        default:
+            CHEAT_MEM32(addr) = value;
+    }
+}
+
+void CheatProgramHandler(void)
+{
+    const u32 *op, *end;
+    u32 header, addr, value, dst;
+    s32 count, i;
+
+    op = codelist;
+    end = codelist + numprogwords;
+
+    while (op < end) {
+        header = op[0];
+        addr = CHEAT_ADDR(header);
+
+        switch (CHEAT_OP(header)) {
+            case CHEAT_OP_WRITE8:
+                CHEAT_MEM8(addr) = op[1];
+                op += 2;
+                break;
+            case CHEAT_OP_WRITE16:
+                CHEAT_MEM16(addr) = op[1];
+                op += 2;
+                break;
+            case CHEAT_OP_WRITE32:
+                CHEAT_MEM32(addr) = op[1];
+                op += 2;
+                break;
+            case CHEAT_OP_RUN32:
+                count = op[1];
+                for (i = 0; i < count; i++, addr += 4)
+                    CHEAT_MEM32(addr) = op[2 + i];
+                op += 2 + count;
+                break;
+            case CHEAT_OP_INC:
+                switch (CHEAT_FLAGS(header)) {
+                    case CHEAT_SIZE_8:
+                        CHEAT_MEM8(addr) += op[1];
+                        break;
+                    case CHEAT_SIZE_16:
+                        CHEAT_MEM16(addr) += op[1];
+                        break;
+                    default:
+                        CHEAT_MEM32(addr) += op[1];
+                }
+                op += 2;
+                break;
+            case CHEAT_OP_SERIAL:
+                // Like the code handler, at least one word is always written.
+                count = op[1] >> 16;
+                value = op[2];
+                do {
+                    CHEAT_MEM32(addr) = value;
+                    value += op[3];
+                    addr += (op[1] & 0xFFFF) << 2;
+                } while (--count > 0);
+                op += 4;
+                break;
+            case CHEAT_OP_COPY:
+                count = op[1];
+                dst = op[2];
+                do {
+                    CHEAT_MEM8(dst) = CHEAT_MEM8(addr);
+                    dst++;
+                    addr++;
+                } while (--count > 0);
+                op += 3;
+                break;
+            case CHEAT_OP_POINTER:
+                if ((dst = CHEAT_MEM32(addr) & 0x3FFFFFFC) != 0)
+                    CheatWrite(CHEAT_FLAGS(header), dst + op[2], op[1]);
+                op += 3;
+                break;
+            case CHEAT_OP_BOOL:
+                value = (CHEAT_FLAGS(header) & CHEAT_BOOL_16) ? CHEAT_MEM16(addr) : CHEAT_MEM8(addr);
+                switch (CHEAT_FLAGS(header) & ~CHEAT_BOOL_16) {
+                    case CHEAT_BOOL_OR:
+                        value |= op[1];
+                        break;
+                    case CHEAT_BOOL_AND:
+                        value &= op[1];
+                        break;
+                    default:
+                        value ^= op[1];
+                }
+                CheatWrite((CHEAT_FLAGS(header) & CHEAT_BOOL_16) ? CHEAT_SIZE_16 : CHEAT_SIZE_8, addr, value);
+                op += 2;
+                break;
+            case CHEAT_OP_STOPNE:
+                if (CHEAT_MEM32(addr) != op[1])
+                    return;
+                op += 2;
+                break;
+            case CHEAT_OP_IF:
+                value = op[1];
+                op += 2;
+                if (!CheatTest(header, value))
+                    op += CHEAT_IF_SKIP(value);
+                break;
+            default: // Not a valid program
+                return;
+        }
+    }
+}
@@ -144,6 +144,26 @@ int GetOPLModInfo(int id, void **pointer, unsigned int *size)
         }
     }
 
+    // Compressed modules are decompressed into the scratch buffer, which is only valid until the next module is retrieved.
+    if (result == 0 && *pointer != NULL && *size > sizeof(irxlz4_header_t)) {
+        irxlz4_header_t *header = (irxlz4_header_t *)*pointer;
+
+        if (header->magic == IRXLZ4_MAGIC) {
+            if (header->size > irxtable->scratchSize ||
+                lz4_decompress((u8 *)(header + 1), *size - sizeof(irxlz4_header_t), irxtable->scratch, header->size) != header->size) {
+                DPRINTF("GetOPLModInfo: module %d could not be decompressed\n", id);
+                *size = 0;
+                return -1;
+            }
+
+            // The module is sent to the IOP by DMA
+            FlushCache(0);
+
+            *pointer = irxtable->scratch;
+            *size = header->size;
+        }
+    }
+
     return result;
 }
 
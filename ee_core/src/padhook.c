@@ -507,14 +507,45 @@ static int Hook_scePad2CreateSocket(pad2socketparam_t *SocketParam, void *addr)
     return ret;
 }
 
+static scan_result_t padopen_scan;
+
+// Overwrites a J/JAL call to PadOpen() with a call to its hook
+static void Patch_PadOpen_Call(u32 *ptr2, const pattern_t *padopen_pattern)
+{
+    u32 inst, fncall;
+
+    DPRINTF("IGR: found padOpen call at 0x%08x\n", (int)ptr2);
+
+    fncall = (u32)ptr2;
+
+    // Get PadOpen call Jump Instruction type (JAL or J).
+    inst = (ptr2[0] & 0xfc000000);
+
+    // Get Hook_PadOpen call Instruction code
+    if (padopen_pattern->type == IGR_LIBPAD) {
+        DPRINTF("IGR: Hook_scePadPortOpen addr 0x%08x\n", (int)Hook_scePadPortOpen);
+        inst |= 0x03ffffff & ((u32)Hook_scePadPortOpen >> 2);
+    } else {
+        DPRINTF("IGR: Hook_scePad2CreateSocket addr 0x%08x\n", (int)Hook_scePad2CreateSocket);
+        inst |= 0x03ffffff & ((u32)Hook_scePad2CreateSocket >> 2);
+    }
+
+    DPRINTF("IGR: patching padopen call at addr 0x%08x with opcode %08x\n", (int)fncall, (int)inst);
+    // Overwrite the original PadOpen function call with our function call
+    _sw(inst, fncall);
+
+    Pad_Data.libpad = padopen_pattern->type;
+    Pad_Data.libversion = padopen_pattern->version;
+}
+
 // This function patch the padOpen calls. (scePadPortOpen or scePad2CreateSocket)
 int Install_PadOpen_Hook(u32 mem_start, u32 mem_end, int mode)
 {
     u32 *ptr, *ptr2;
     u32 inst, fncall;
-    u32 mem_size, mem_size2;
+    u32 mem_size2;
     u32 pattern[1], mask[1];
-    int i, found, patched;
+    int i, h, c, found, patched, multipass;
 
     pattern_t padopen_patterns[NB_PADOPEN_PATTERN] = {
         {padPortOpenpattern0, padPortOpenpattern0_mask, sizeof(padPortOpenpattern0), 1, 0x0211},
@@ -524,43 +555,56 @@ int Install_PadOpen_Hook(u32 mem_start, u32 mem_end, int mode)
         {padPortOpenpattern1, padPortOpenpattern1_mask, sizeof(padPortOpenpattern1), 1, 0x0210},
         {padPortOpenpattern2, padPortOpenpattern2_mask, sizeof(padPortOpenpattern2), 1, 0x0160},
         {padPortOpenpattern3, padPortOpenpattern3_mask, sizeof(padPortOpenpattern3), 1, 0x0150}};
+    scan_pattern_t scan_patterns[NB_PADOPEN_PATTERN];
 
     found = 0;
     patched = 0;
 
-    // Loop for each libpad version
     for (i = 0; i < NB_PADOPEN_PATTERN; i++) {
-        ptr = (u32 *)mem_start;
-        while (ptr) {
-            // Purple while PadOpen pattern search
-            if (EnableDebug)
-                DBGCOL(0x800080, PADHOOK, "Searching PadOpen() pattern");
+        scan_patterns[i].pattern = padopen_patterns[i].pattern;
+        scan_patterns[i].mask = padopen_patterns[i].mask;
+        scan_patterns[i].len = padopen_patterns[i].size;
+    }
+
+    // Purple while PadOpen pattern search
+    if (EnableDebug)
+        DBGCOL(0x800080, PADHOOK, "Searching PadOpen() pattern");
+
+    // Locate the PadOpen function of every libpad version in a single pass over memory, along with the J/JAL calls to them.
+    // Without hooking, the first libpad version is preferred, so the search can stop as soon as it is found.
+    scan_patterns_with_mask((u32 *)mem_start, mem_end - mem_start, scan_patterns, NB_PADOPEN_PATTERN, mode == PADOPEN_HOOK ? SCAN_CALLS : SCAN_STOP_ON_FIRST, &padopen_scan);
 
-            mem_size = mem_end - (u32)ptr;
+    // More matches or calls than the scan results can hold: search memory again for every match and call, as many times as needed.
+    // Without hooking, only the first match matters and it is always kept.
+    multipass = (mode == PADOPEN_HOOK && padopen_scan.overflow);
+    if (multipass)
+        DPRINTF("IGR: too many padopen matches or calls, searching again\n");
 
-            // First try to locate the orginal libpad's PadOpen function
-            ptr = find_pattern_with_mask(ptr, mem_size, padopen_patterns[i].pattern, padopen_patterns[i].mask, padopen_patterns[i].size);
-            if (ptr) {
-                DPRINTF("IGR: found padopen pattern%d at 0x%08x mode=%d\n", i, (int)ptr, mode);
-                found = 1;
+    // Loop for each libpad version
+    for (i = 0; i < NB_PADOPEN_PATTERN; i++) {
+        h = 0;
+        ptr = multipass ? find_pattern_with_mask((u32 *)mem_start, mem_end - mem_start, padopen_patterns[i].pattern, padopen_patterns[i].mask, padopen_patterns[i].size) : (padopen_scan.hitCount[i] > 0 ? padopen_scan.hits[i][0] : NULL);
+
+        while (ptr) {
+            DPRINTF("IGR: found padopen pattern%d at 0x%08x mode=%d\n", i, (int)ptr, mode);
+            found = 1;
 
-                // Green while PadOpen patches
-                if (EnableDebug)
-                    DBGCOL(0x008000, PADHOOK, "Patching PadOpen()");
+            // Green while PadOpen patches
+            if (EnableDebug)
+                DBGCOL(0x008000, PADHOOK, "Patching PadOpen()");
 
-                // Save original PadOpen function
-                if (padopen_patterns[i].type == IGR_LIBPAD)
-                    scePadPortOpen = (void *)ptr;
-                else
-                    scePad2CreateSocket = (void *)ptr;
+            // Save original PadOpen function
+            if (padopen_patterns[i].type == IGR_LIBPAD)
+                scePadPortOpen = (void *)ptr;
+            else
+                scePad2CreateSocket = (void *)ptr;
 
-                if (mode == PADOPEN_HOOK) {
+            if (mode == PADOPEN_HOOK) {
+                if (multipass) {
                     // Generate generic instruction pattern & mask for a J/JAL to PadOpen()
                     // Use 000010 as the operation, to match both J & JAL.
-                    inst = 0x08000000 | (0x03ffffff & ((u32)ptr >> 2));
-
                     // Ignore bit 26 for the mask because the jump type can be either J (000010) or JAL (000011)
-                    pattern[0] = inst;
+                    pattern[0] = 0x08000000 | (0x03ffffff & ((u32)ptr >> 2));
                     mask[0] = 0xfbffffff;
 
                     DPRINTF("IGR: searching opcode %08x witk mask %08x\n", (int)pattern[0], (int)mask[0]);
@@ -570,6 +614,37 @@ int Install_PadOpen_Hook(u32 mem_start, u32 mem_end, int mode)
                     while (ptr2) {
                         mem_size2 = (u32)((u8 *)mem_end - (u8 *)ptr2);
 
+                        ptr2 = find_pattern_with_mask(ptr2, mem_size2, pattern, mask, sizeof(pattern));
+                        if (ptr2) {
+                            patched = 1;
+                            Patch_PadOpen_Call(ptr2, &padopen_patterns[i]);
+                        }
+                    }
+                } else {
+                    // Patch the J/JAL calls to PadOpen(), found during the pattern search
+                    for (c = 0; c < padopen_scan.callCount; c++) {
+                        if (padopen_scan.targets[c] == ptr) {
+                            patched = 1;
+                            Patch_PadOpen_Call(padopen_scan.calls[c], &padopen_patterns[i]);
+                        }
+                    }
+                }
+
+                // Locate pointers to scePadOpen(), likely used for JALR.
+                if (!patched) {
+                    DPRINTF("IGR: 2nd padOpen patch attempt...\n");
+
+                    // Make pattern with function address saved above
+                    pattern[0] = (u32)ptr;
+                    mask[0] = 0xffffffff;
+
+                    DPRINTF("IGR: searching opcode %08x witk mask %08x\n", (int)pattern[0], (int)mask[0]);
+
+                    // Search & patch for PadOpen function address
+                    ptr2 = (u32 *)mem_start;
+                    while (ptr2) {
+                        mem_size2 = (u32)((u8 *)mem_end - (u8 *)ptr2);
+
                         ptr2 = find_pattern_with_mask(ptr2, mem_size2, pattern, mask, sizeof(pattern));
                         if (ptr2) {
                             DPRINTF("IGR: found padOpen call at 0x%08x\n", (int)ptr2);
@@ -578,78 +653,36 @@ int Install_PadOpen_Hook(u32 mem_start, u32 mem_end, int mode)
 
                             fncall = (u32)ptr2;
 
-                            // Get PadOpen call Jump Instruction type (JAL or J).
-                            inst = (ptr2[0] & 0xfc000000);
-
-                            // Get Hook_PadOpen call Instruction code
+                            // Get Hook_PadOpen function address
                             if (padopen_patterns[i].type == IGR_LIBPAD) {
                                 DPRINTF("IGR: Hook_scePadPortOpen addr 0x%08x\n", (int)Hook_scePadPortOpen);
-                                inst |= 0x03ffffff & ((u32)Hook_scePadPortOpen >> 2);
+                                inst = (u32)Hook_scePadPortOpen;
                             } else {
                                 DPRINTF("IGR: Hook_scePad2CreateSocket addr 0x%08x\n", (int)Hook_scePad2CreateSocket);
-                                inst |= 0x03ffffff & ((u32)Hook_scePad2CreateSocket >> 2);
+                                inst = (u32)Hook_scePad2CreateSocket;
                             }
 
                             DPRINTF("IGR: patching padopen call at addr 0x%08x with opcode %08x\n", (int)fncall, (int)inst);
-                            // Overwrite the original PadOpen function call with our function call
+                            // Overwrite the original PadOpen function address with our function address
                             _sw(inst, fncall);
 
                             Pad_Data.libpad = padopen_patterns[i].type;
                             Pad_Data.libversion = padopen_patterns[i].version;
                         }
                     }
-
-                    // Locate pointers to scePadOpen(), likely used for JALR.
-                    if (!patched) {
-                        DPRINTF("IGR: 2nd padOpen patch attempt...\n");
-
-                        // Make pattern with function address saved above
-                        pattern[0] = (u32)ptr;
-                        mask[0] = 0xffffffff;
-
-                        DPRINTF("IGR: searching opcode %08x witk mask %08x\n", (int)pattern[0], (int)mask[0]);
-
-                        // Search & patch for PadOpen function address
-                        ptr2 = (u32 *)mem_start;
-                        while (ptr2) {
-                            mem_size2 = (u32)((u8 *)mem_end - (u8 *)ptr2);
-
-                            ptr2 = find_pattern_with_mask(ptr2, mem_size2, pattern, mask, sizeof(pattern));
-                            if (ptr2) {
-                                DPRINTF("IGR: found padOpen call at 0x%08x\n", (int)ptr2);
-
-                                patched = 1;
-
-                                fncall = (u32)ptr2;
-
-                                // Get Hook_PadOpen function address
-                                if (padopen_patterns[i].type == IGR_LIBPAD) {
-                                    DPRINTF("IGR: Hook_scePadPortOpen addr 0x%08x\n", (int)Hook_scePadPortOpen);
-                                    inst = (u32)Hook_scePadPortOpen;
-                                } else {
-                                    DPRINTF("IGR: Hook_scePad2CreateSocket addr 0x%08x\n", (int)Hook_scePad2CreateSocket);
-                                    inst = (u32)Hook_scePad2CreateSocket;
-                                }
-
-                                DPRINTF("IGR: patching padopen call at addr 0x%08x with opcode %08x\n", (int)fncall, (int)inst);
-                                // Overwrite the original PadOpen function address with our function address
-                                _sw(inst, fncall);
-
-                                Pad_Data.libpad = padopen_patterns[i].type;
-                                Pad_Data.libversion = padopen_patterns[i].version;
-                            }
-                        }
-                    }
-                } else {
-                    DPRINTF("IGR: no hooking requested, breaking loop...\n");
-                    // Hooking is not required and padOpen function was found, so stop searching
-                    break;
                 }
+            } else {
+                DPRINTF("IGR: no hooking requested, breaking loop...\n");
+                // Hooking is not required and padOpen function was found, so stop searching
+                break;
+            }
 
-                // Increment search pointer
-                // ptr += padopen_patterns[i].size;
+            // Next match of this libpad version
+            if (multipass) {
                 ptr += (padopen_patterns[i].size >> 2);
-            }
+                ptr = find_pattern_with_mask(ptr, mem_end - (u32)ptr, padopen_patterns[i].pattern, padopen_patterns[i].mask, padopen_patterns[i].size);
+            } else
+                ptr = (++h < padopen_scan.hitCount[i]) ? padopen_scan.hits[i][h] : NULL;
         }
 
         // If a padOpen function call was patched or ( hooking is not required and a padOpen function was found ), so stop the libpad version search loop
@@ -0,0 +1,164 @@
+/*
+  Copyright 2009-2010, Ifcaro, jimmikaelkael & Polo
+  Copyright 2006-2008 Polo
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Some parts of the code are taken from HD Project by Polo
+*/
+
+#include <tamtypes.h>
+#include <string.h>
+
+#include "util.h"
+
+/*----------------------------------------------------------------------------------------*/
+/* This function retrieve a pattern in a buffer, using a mask                             */
+/*----------------------------------------------------------------------------------------*/
+u32 *find_pattern_with_mask(u32 *buf, unsigned int bufsize, const u32 *pattern, const u32 *mask, unsigned int len)
+{
+    unsigned int i, j;
+
+    len /= sizeof(u32);
+    bufsize /= sizeof(u32);
+
+    for (i = 0; i + len <= bufsize; i++) {
+        for (j = 0; j < len; j++) {
+            if ((buf[i + j] & mask[j]) != pattern[j])
+                break;
+        }
+        if (j == len)
+            return &buf[i];
+    }
+
+    return NULL;
+}
+
+#define SCAN_HASH_SIZE  64
+#define SCAN_HASH(word) (((word) ^ ((word) >> 16)) & (SCAN_HASH_SIZE - 1))
+#define SCAN_MEMO_SIZE  64
+
+static int match_pattern_with_mask(const u32 *buf, const scan_pattern_t *pattern, unsigned int len)
+{
+    unsigned int j;
+
+    for (j = 0; j < len; j++) {
+        if ((buf[j] & pattern->mask[j]) != pattern->pattern[j])
+            return 0;
+    }
+
+    return 1;
+}
+
+/*----------------------------------------------------------------------------------------*/
+/* This function retrieves several patterns in a single pass over a buffer, using masks.  */
+/* Each pattern is indexed by its first fully masked word (its anchor), so every word is  */
+/* only compared with the anchors that share its hash. With SCAN_CALLS, the J/JAL         */
+/* instructions that jump to a location where a pattern matches are collected too.        */
+/* Matches and calls beyond SCAN_MAX_HITS/SCAN_MAX_CALLS are not kept: result->overflow   */
+/* is set then, and the caller has to search again for them.                              */
+/* Returns the number of matches found.                                                   */
+/*----------------------------------------------------------------------------------------*/
+int scan_patterns_with_mask(u32 *buf, unsigned int bufsize, const scan_pattern_t *patterns, int count, int flags, scan_result_t *result)
+{
+    s8 buckets[SCAN_HASH_SIZE], next[SCAN_MAX_PATTERNS], unanchored;
+    u32 anchorWord[SCAN_MAX_PATTERNS], anchorMask[SCAN_MAX_PATTERNS];
+    unsigned int anchor[SCAN_MAX_PATTERNS], len[SCAN_MAX_PATTERNS], resume[SCAN_MAX_PATTERNS];
+    unsigned int memoTarget[SCAN_MEMO_SIZE]; // Recently checked J/JAL targets (+1, 0 is unused)
+    u8 memoMatch[SCAN_MEMO_SIZE];
+    unsigned int i, j, start, target, hits;
+    u32 word;
+    int p;
+
+    if (count > SCAN_MAX_PATTERNS)
+        count = SCAN_MAX_PATTERNS;
+
+    memset(result, 0, sizeof(scan_result_t));
+    memset(buckets, -1, sizeof(buckets));
+    memset(memoTarget, 0, sizeof(memoTarget));
+    unanchored = -1;
+    bufsize /= sizeof(u32);
+    hits = 0;
+
+    // Index the patterns by their anchor. A pattern without a fully masked word is anchored on its first word instead, which is tried at every location.
+    for (p = count - 1; p >= 0; p--) {
+        len[p] = patterns[p].len / sizeof(u32);
+        resume[p] = 0;
+
+        for (j = 0; j < len[p] && patterns[p].mask[j] != 0xffffffff; j++)
+            ;
+
+        if (j < len[p]) {
+            next[p] = buckets[SCAN_HASH(patterns[p].pattern[j])];
+            buckets[SCAN_HASH(patterns[p].pattern[j])] = p;
+        } else {
+            j = 0;
+            next[p] = unanchored;
+            unanchored = p;
+        }
+
+        anchor[p] = j;
+        anchorWord[p] = patterns[p].pattern[j];
+        anchorMask[p] = patterns[p].mask[j];
+    }
+
+    for (i = 0; i < bufsize; i++) {
+        word = buf[i];
+
+        p = buckets[SCAN_HASH(word)];
+        if (p < 0)
+            p = unanchored;
+
+        while (p >= 0) {
+            if ((word & anchorMask[p]) == anchorWord[p] && i >= anchor[p]) {
+                start = i - anchor[p];
+
+                // Matches of the same pattern do not overlap
+                if (start >= resume[p] && len[p] <= bufsize - start && match_pattern_with_mask(&buf[start], &patterns[p], len[p])) {
+                    if (result->hitCount[p] < SCAN_MAX_HITS)
+                        result->hits[p][result->hitCount[p]++] = &buf[start];
+                    else
+                        result->overflow = 1;
+                    resume[p] = start + len[p];
+                    hits++;
+
+                    if ((flags & SCAN_STOP_ON_FIRST) && p == 0)
+                        return hits;
+                }
+            }
+
+            // Continue with the unanchored patterns, once the bucket is done
+            p = (next[p] < 0 && anchorMask[p] == 0xffffffff) ? unanchored : next[p];
+        }
+
+        // J (000010) or JAL (000011), resolve the target within the buffer
+        if ((flags & SCAN_CALLS) && (word >> 27) == 1) {
+            target = (word & 0x03ffffff) - ((u32)buf >> 2);
+            if (target >= bufsize)
+                continue;
+
+            j = target & (SCAN_MEMO_SIZE - 1);
+            if (memoTarget[j] != target + 1) {
+                memoTarget[j] = target + 1;
+                memoMatch[j] = 0;
+                for (p = 0; p < count; p++) {
+                    if (len[p] <= bufsize - target && match_pattern_with_mask(&buf[target], &patterns[p], len[p])) {
+                        memoMatch[j] = 1;
+                        break;
+                    }
+                }
+            }
+
+            if (memoMatch[j]) {
+                if (result->callCount < SCAN_MAX_CALLS) {
+                    result->calls[result->callCount] = &buf[i];
+                    result->targets[result->callCount] = &buf[target];
+                    result->callCount++;
+                } else
+                    result->overflow = 1;
+            }
+        }
+    }
+
+    return hits;
+}
@@ -320,25 +320,66 @@ void set_ipconfig(void)
 }
 
 /*----------------------------------------------------------------------------------------*/
-/* This function retrieve a pattern in a buffer, using a mask                             */
+/* Decompress a raw LZ4 block of 'srcsize' bytes into 'dst', which holds 'dstsize' bytes. */
+/* Returns the decompressed size, or -1 if the block is corrupted.                       */
 /*----------------------------------------------------------------------------------------*/
-u32 *find_pattern_with_mask(u32 *buf, unsigned int bufsize, const u32 *pattern, const u32 *mask, unsigned int len)
+int lz4_decompress(const u8 *src, unsigned int srcsize, u8 *dst, unsigned int dstsize)
 {
-    unsigned int i, j;
+    const u8 *ip = src, *iend = src + srcsize, *match;
+    u8 *op = dst, *oend = dst + dstsize;
+    unsigned int token, length, offset, s;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        // Literals
+        length = token >> 4;
+        if (length == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                s = *ip++;
+                length += s;
+            } while (s == 255);
+        }
+        if (length > (unsigned int)(iend - ip) || length > (unsigned int)(oend - op))
+            return -1;
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
 
-    len /= sizeof(u32);
-    bufsize /= sizeof(u32);
+        // The last sequence has no match
+        if (ip >= iend)
+            break;
+
+        // Match
+        if (iend - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (unsigned int)(op - dst))
+            return -1;
 
-    for (i = 0; i < bufsize - len; i++) {
-        for (j = 0; j < len; j++) {
-            if ((buf[i + j] & mask[j]) != pattern[j])
-                break;
+        length = token & 15;
+        if (length == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                s = *ip++;
+                length += s;
+            } while (s == 255);
         }
-        if (j == len)
-            return &buf[i];
+        length += 4;
+        if (length > (unsigned int)(oend - op))
+            return -1;
+
+        // Byte by byte, as the match may overlap the output
+        match = op - offset;
+        while (length--)
+            *op++ = *match++;
     }
 
-    return NULL;
+    return (int)(op - dst);
 }
 
 /*----------------------------------------------------------------------------------------*/
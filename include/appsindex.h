@@ -0,0 +1,13 @@
+#ifndef __APPS_INDEX_H
+#define __APPS_INDEX_H
+
+// Apps index: the app folders of a device with their parsed title.cfg, saved as APP_INDEX_FILE so that
+// the title.cfg of a folder only gets parsed again when its size or time changes.
+
+/** Lists the app folders of appsPath, using and updating the apps index at indexPath.
+ * @param callback Called for each valid app. Returns 0 if the app was added, a negative value to stop the scan.
+ * @param exception Nonzero to only list the folders with an '_' in their name (memory cards)
+ * @return The count of apps added by the callback */
+int appsIndexScan(int (*callback)(const char *path, const char *title, const char *boot, const char *argv1, void *arg), void *arg, char *appsPath, const char *indexPath, int exception);
+
+#endif
@@ -15,6 +15,9 @@
 #define APP_CONFIG_ARGV1 "argv1"
 
 #define APP_TITLE_CONFIG_FILE "title.cfg"
+#define APP_INDEX_FILE        "apps.bin"
+
+#define APP_FOLDER_MAX 64
 
 typedef struct
 {
@@ -25,6 +28,17 @@ typedef struct
     u8 legacy;
 } app_info_t;
 
+/// Cached entry of an app folder, kept in the apps index so that title.cfg only gets parsed again when it changes.
+typedef struct
+{
+    char folder[APP_FOLDER_MAX + 1];
+    u32 cfgSize; // title.cfg size and modification time
+    u32 cfgTime;
+    char title[APP_TITLE_MAX + 1]; // Empty if the folder is not a valid app
+    char boot[APP_BOOT_MAX + 1];
+    char argv1[APP_ARGV1_MAX + 1];
+} app_index_entry_t;
+
 void appInit(item_list_t *itemList);
 item_list_t *appGetObject(int initOnly);
 void appPostUpdateCallback(int mode);
@@ -1,17 +1,49 @@
 #ifndef __ATLAS_H
 #define __ATLAS_H
 
+/// Maximal count of shelves (rows of slots) per atlas
+#define ATLAS_MAX_SHELVES 64
+/// Size of the slot pool per atlas (used and released slots together)
+#define ATLAS_MAX_SLOTS   512
+
 struct atlas_allocation_t
 {
     int x, y;
     int w, h;
 
-    struct atlas_allocation_t *leaf1, *leaf2;
+    /// Nonzero if the slot holds a pixmap, zero if it was released
+    int used;
+    /// Index of the shelf the slot is on
+    int shelf;
+
+    /// Next slot on the same shelf (ordered by x), or the next unused pool entry
+    struct atlas_allocation_t *next;
+};
+
+struct atlas_shelf_t
+{
+    int y, h;
+
+    /// Start of the never allocated space at the end of the shelf
+    int x;
+
+    /// Slots on this shelf, ordered by x
+    struct atlas_allocation_t *slots;
 };
 
 typedef struct
 {
-    struct atlas_allocation_t *allocation;
+    /// Start of the never allocated space below the last shelf
+    int shelfY;
+    int shelfCount;
+    struct atlas_shelf_t shelves[ATLAS_MAX_SHELVES];
+
+    /// Fixed slot pool, so that placing a pixmap never calls malloc
+    struct atlas_allocation_t slotPool[ATLAS_MAX_SLOTS];
+    struct atlas_allocation_t *freeSlots;
+
+    /// Count of pixels covered by used slots
+    int usedArea;
 
     GSTEXTURE surface;
 } atlas_t;
@@ -30,4 +62,10 @@ void atlasFree(atlas_t *atlas);
 struct atlas_allocation_t *atlasPlace(atlas_t *atlas, size_t width,
                                       size_t height, const void *surface);
 
+/** Releases a single allocation, so that its space can be reused by atlasPlace */
+void atlasRelease(atlas_t *atlas, struct atlas_allocation_t *allocation);
+
+/// Returns the percentage of the atlas covered by used allocations
+int atlasOccupancy(atlas_t *atlas);
+
 #endif
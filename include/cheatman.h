@@ -25,7 +25,7 @@
 #ifndef _CHEATMAN_H_
 #define _CHEATMAN_H_
 
-#include "opl.h"
+#include "include/opl.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -72,6 +72,7 @@ extern cheat_entry_t gCheats[MAX_CODES];
 void InitCheatsConfig(config_set_t *configSet);
 int GetCheatsEnabled(void);
 const u32 *GetCheatsList(void);
+const u32 *GetCheatsProgram(int *size);
 int load_cheats(const char *cheatfile);
 void set_cheats_list(void);
 
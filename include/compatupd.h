@@ -6,6 +6,18 @@
 #define OPL_COMPAT_HTTP_PORT    80
 #define OPL_COMPAT_HTTP_RETRIES 3
 #define OPL_COMPAT_HTTP_URI     "/oplcl/sync.ashx?code=%s&device=%d"
+#define OPL_COMPAT_HTTP_PIPELINE 4 // Requests that are sent ahead of their responses
+
+#define COMPAT_UPD_MODE_UPD_USR   1 // Update all records, even those that were modified by the user.
+#define COMPAT_UPD_MODE_NO_MTIME  2 // Do not check the modified time-stamp.
+#define COMPAT_UPD_MODE_MTIME_GMT 4 // Modified time-stamp is in GMT, not JST.
+
+// Progress of the update. compatUpdate() stops as soon as CompatUpdateStopFlag is set.
+extern unsigned int CompatUpdateComplete;
+extern unsigned char CompatUpdateStopFlag;
+extern short int CompatUpdateStatus;
+
+void compatUpdate(item_list_t *support, unsigned char mode, config_set_t *configSet, int id);
 
 void oplUpdateGameCompat(int UpdateAll);
 int oplGetUpdateGameCompatStatus(unsigned int *done, unsigned int *total);
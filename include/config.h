@@ -31,6 +31,7 @@ enum CONFIG_INDEX {
 #define CONFIG_ITEM_FORMAT       "#Format"
 #define CONFIG_ITEM_MEDIA        "#Media"
 #define CONFIG_ITEM_STARTUP      "#Startup"
+#define CONFIG_ITEM_DEVICES      "#Devices" // Number of devices with a copy of the game
 #define CONFIG_ITEM_ALTSTARTUP   "$AltStartup"
 #define CONFIG_ITEM_VMC          "$VMC"
 #define CONFIG_ITEM_COMPAT       "$Compatibility"
@@ -77,6 +78,7 @@ enum CONFIG_INDEX {
 #define CONFIG_OPL_XOFF                 "xoff"
 #define CONFIG_OPL_YOFF                 "yoff"
 #define CONFIG_OPL_OVERSCAN             "overscan"
+#define CONFIG_OPL_FRAME_QUEUE          "frame_queue"
 #define CONFIG_OPL_DISABLE_DEBUG        "disable_debug"
 #define CONFIG_OPL_PS2LOGO              "ps2logo"
 #define CONFIG_OPL_HDD_GAME_LIST_CACHE  "hdd_game_list_cache"
@@ -109,6 +111,7 @@ enum CONFIG_INDEX {
 #define CONFIG_OPL_BOOT_SND_VOLUME      "boot_snd_volume"
 #define CONFIG_OPL_BGM_VOLUME           "bgm_volume"
 #define CONFIG_OPL_DEFAULT_BGM_PATH     "default_bgm_path"
+#define CONFIG_OPL_BGM_CACHE            "bgm_cache"
 #define CONFIG_OPL_XSENSITIVITY         "x_sensitivity"
 #define CONFIG_OPL_YSENSITIVITY         "y_sensitivity"
 
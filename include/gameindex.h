@@ -0,0 +1,57 @@
+#ifndef __GAME_INDEX_H
+#define __GAME_INDEX_H
+
+#include "include/iosupport.h"
+
+// Game index: the games of all the devices, by startup ID, with where each of them is located.
+// Device scans are merged into it, and each device page is a projection of its list sorted by name.
+// Only used from the io thread (the menu updates).
+
+// Changes found by gameIndexUpdate
+#define GAME_INDEX_ADDED   0x01
+#define GAME_INDEX_REMOVED 0x02
+#define GAME_INDEX_RENAMED 0x04
+#define GAME_INDEX_MOVED   0x08 // Same games, at other positions in the list of the device
+
+/// Where a game is found on a device
+typedef struct game_location
+{
+    struct game_entry *entry;
+    short int mode;
+    int id;            // Position in the list of the device
+    char *name;        // Copy of the name, for sorting and finding renames
+    unsigned int seen; // Scan the game was last found in
+
+    struct game_location *nextOnEntry; // Same game, on another device or another copy
+
+    // All the locations, sorted by name
+    struct game_location *prev;
+    struct game_location *next;
+} game_location_t;
+
+/// A game, by startup ID
+typedef struct game_entry
+{
+    char *startup;
+    unsigned int devices; // Bit per mode with a copy of the game
+    game_location_t *locations;
+
+    struct game_entry *nextInBucket;
+} game_entry_t;
+
+/** Merges the current list of a device into the index.
+ * @param count The game count returned by itemUpdate
+ * @return GAME_INDEX_* flags, 0 if the list is unchanged, or -1 if out of memory (the device is then left out of the index) */
+int gameIndexUpdate(item_list_t *support, int count);
+
+/** Removes all the games of a device */
+void gameIndexRemoveDevice(int mode);
+
+/** @return Bit per mode holding a copy of the game, 0 if it is not known */
+unsigned int gameIndexGetDevices(const char *startup);
+
+/** Iterates over the games of a device, sorted by name.
+ * @param location NULL to get the first one */
+game_location_t *gameIndexNext(game_location_t *location, int mode);
+
+#endif
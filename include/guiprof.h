@@ -0,0 +1,45 @@
+#ifndef __GUIPROF_H
+#define __GUIPROF_H
+
+/// Phases of a GUI main loop frame, in the order they run
+enum GPROF_PHASE {
+    GPROF_START = 0,     // Waiting for the GUI lock, starting the frame
+    GPROF_PADS,          // Reading the pads
+    GPROF_RENDER,        // Rendering the current screen
+    GPROF_OVERLAYS,      // Busy icon, debug info and this HUD
+    GPROF_NOTIFICATIONS, // Notification popups
+    GPROF_DEFERRED,      // Deferred menu operations
+    GPROF_SUBMIT,        // Sending the rendering queue to the GS
+    GPROF_GS_WAIT,       // Waiting for the GS to finish drawing
+    GPROF_VSYNC_WAIT,    // Waiting for the vsync to show the frame
+    GPROF_INPUT,         // Input handling and the frame hook
+
+    GPROF_COUNT
+};
+
+/// Number of frames kept for the HUD and the CSV dump
+#define GPROF_HISTORY 256
+
+/// CSV file name, written to the configuration device
+#define GPROF_CSV_FILE "guiprof.csv"
+
+#ifdef __GUI_PROFILER
+/// Ends the previous frame record and starts a new one
+void guiProfStartFrame(void);
+/// Adds the time since the previous mark to a phase of the current frame
+void guiProfMark(int phase);
+/// Splits the time since the previous mark, spent in rmEndFrame, into the submit and wait phases
+void guiProfMarkEndFrame(void);
+/// R3 toggles the HUD, L3 dumps the recorded frames to GPROF_CSV_FILE
+void guiProfHandleInput(void);
+/// Draws min/avg/max per phase over the recorded frames, if enabled
+void guiProfDrawHud(void);
+#else
+#define guiProfStartFrame()
+#define guiProfMark(phase)
+#define guiProfMarkEndFrame()
+#define guiProfHandleInput()
+#define guiProfDrawHud()
+#endif
+
+#endif
@@ -52,6 +52,7 @@
 #define IO_MENU_UPDATE_DEFFERED   2
 #define IO_CACHE_LOAD_ART         3 // io call to handle the loading of covers
 #define IO_COMPAT_UPDATE_DEFFERED 4
+#define IO_THEME_LOAD_IMAGE       5 // io call to load the theme images on first draw
 
 // Codes have been planned to fit the design of the GUI functions within gui.c.
 #define OPL_COMPAT_UPDATE_STAT_WIP        0
@@ -62,9 +63,12 @@
 
 #define OPL_VMODE_CHANGE_CONFIRMATION_TIMEOUT_MS 10000
 
+// cpu_ticks() per one millisecond
+#define CPU_TICKS_PER_MSEC 147456
+
 int oplPath2Mode(const char *path);
 int oplGetAppImage(const char *device, char *folder, int isRelative, char *value, char *suffix, GSTEXTURE *resultTex, short psm);
-int oplScanApps(int (*callback)(const char *path, config_set_t *appConfig, void *arg), void *arg);
+int oplScanApps(int (*callback)(const char *path, const char *title, const char *boot, const char *argv1, void *arg), void *arg);
 int oplShouldAppsUpdate(void);
 config_set_t *oplGetLegacyAppsConfig(void);
 config_set_t *oplGetLegacyAppsInfo(char *name);
@@ -136,6 +140,7 @@ extern int gVMode; // 0 - Auto, 1 - PAL, 2 - NTSC
 extern int gXOff;
 extern int gYOff;
 extern int gOverscan;
+extern int gFrameQueue;
 extern int gSelectButton;
 extern int gHDDGameListCache;
 
@@ -146,6 +151,7 @@ extern int gSFXVolume;
 extern int gBootSndVolume;
 extern int gBGMVolume;
 extern char gDefaultBGMPath[128];
+extern int gBGMCache;
 
 extern int gXSensitivity;
 extern int gYSensitivity;
@@ -81,6 +81,18 @@ void rmGetScreenExtentsNative(int *w, int *h);
 /** Fills the parameters with the virtual (640x480) screen width and height */
 void rmGetScreenExtents(int *w, int *h);
 
+/// Time spent in the last rmEndFrame call, in cpu_ticks() units
+typedef struct
+{
+    u32 gsWait;    ///< Waiting for the GS to finish drawing
+    u32 vsyncWait; ///< Waiting for the vsync to show the frame
+} rm_frame_pacing_t;
+
+/** Waits for the GS to finish drawing the frames that were sent to it.
+ * With the frame queue enabled, the GS may still be drawing the previous frame while the next one is built.
+ * Call it before changing or freeing the memory of a texture that was drawn (rmUnloadTexture does). */
+void rmWaitGS(void);
+
 /** Invalidate a texture so it will be re-transferred to VRAM the next time.
  * @param txt The texture to invalidate */
 void rmInvalidateTexture(GSTEXTURE *txt);
@@ -90,6 +102,11 @@ void rmUnloadTexture(GSTEXTURE *txt);
 
 void rmDrawQuad(rm_quad_t *q);
 
+/** Queues a list of textured sprites that share one texture and colour.
+ * The texture and alpha state are set up only once for the whole list.
+ * @param coords Upper left and bottom right corner of every sprite (2 * count entries) */
+void rmDrawQuadList(GSTEXTURE *txt, u64 color, int count, const rm_tx_coord_t *coords);
+
 /** Queues a specified pixmap (tinted with colour) to be rendered on specified position */
 void rmDrawPixmap(GSTEXTURE *txt, int x, int y, short aligned, int w, int h, short scaled, u64 color);
 
@@ -99,6 +116,9 @@ void rmDrawOverlayPixmap(GSTEXTURE *overlay, int x, int y, short aligned, int w,
 /** Queues a opaque rectangle to be rendered */
 void rmDrawRect(int x, int y, int w, int h, u64 color);
 
+/** Queues a rectangle to be rendered, placed as rmDrawPixmap places a pixmap of that size */
+void rmDrawAlignedRect(int x, int y, short aligned, int w, int h, short scaled, u64 color);
+
 /** Queues a single color line to be rendered */
 void rmDrawLine(int x1, int y1, int x2, int y2, u64 color);
 
@@ -108,6 +128,9 @@ void rmStartFrame(void);
 /** Ends the frame - last to call every frame */
 void rmEndFrame(void);
 
+/** Fills the parameter with the frame pacing of the last frame */
+void rmGetFramePacing(rm_frame_pacing_t *pacing);
+
 /** Sets the display offset in units of pixels */
 void rmSetDisplayOffset(int x, int y);
 
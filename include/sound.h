@@ -25,6 +25,8 @@ void sfxPlay(int id);
 void bgmStart(void);
 void bgmStop(void);
 int isBgmPlaying(void);
+/// Filled ring buffer parts now and at worst, and the number of times the ring ran empty during playback
+void bgmGetRingStats(int *depth, int *minDepth, int *underruns);
 void bgmMute(void);
 void bgmUnMute(void);
 
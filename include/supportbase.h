@@ -45,6 +45,9 @@ int sbPrepare(base_game_info_t *game, config_set_t *configSet, int size_cdvdman,
 void sbUnprepare(void *pCommon);
 void sbRebuildULCfg(base_game_info_t **list, const char *prefix, int gamecount, int excludeID);
 void sbCreatePath(const base_game_info_t *game, char *path, const char *prefix, const char *sep, int part);
+#ifdef __IO_TRACE
+int sbCreateIoTrace(const base_game_info_t *game, const char *prefix, const char *sep); // Returns the open file, or a negative error.
+#endif
 void sbDelete(base_game_info_t **list, const char *prefix, const char *sep, int gamecount, int id);
 void sbRename(base_game_info_t **list, const char *prefix, const char *sep, int gamecount, int id, char *newname);
 config_set_t *sbPopulateConfig(base_game_info_t *game, const char *prefix, const char *sep);
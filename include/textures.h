@@ -103,6 +103,7 @@ enum INTERNAL_TEXTURE {
 #define ERR_MISSING_ALPHA -6
 #define ERR_BAD_DEPTH     -7
 
+void texInit(void);
 int texLookupInternalTexId(const char *name);
 int texLoadInternal(GSTEXTURE *texture, int texId);
 int texDiscoverLoad(GSTEXTURE *texture, const char *path, int texId);
@@ -23,6 +23,10 @@ typedef struct
     // basic texture information
     char *name;
     GSTEXTURE source;
+
+    // Images of a theme on a device are loaded by the io worker when first drawn
+    char *path;             // Full path of the image, without the extension
+    volatile int loadState; // THM_IMAGE_*
 } image_texture_t;
 
 typedef struct
@@ -124,11 +128,14 @@ typedef struct theme
 
     GSTEXTURE textures[TEXTURES_COUNT];
     int fonts[THM_MAX_FONTS]; //!< Storage of font handles for removal once not needed
+    int fontsLoaded;          //!< Bit mask of the font slots already loaded, as they are loaded when first used
 } theme_t;
 
 extern theme_t *gTheme;
 
 void thmInit(void);
+/** Registers the io handler that loads the theme images, once the io worker is running */
+void thmInitLoader(void);
 void thmReinit(const char *path);
 void thmReloadScreenExtents(void);
 int thmAddElements(char *path, const char *separator, int forceRefresh);
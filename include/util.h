@@ -17,15 +17,25 @@ typedef struct
     unsigned int size;
     unsigned int available;
     char *lastPtr;
-    short allocResult;
 } file_buffer_t;
 
-file_buffer_t *openFileBufferBuffer(short allocResult, const void *buffer, unsigned int size);
-file_buffer_t *openFileBuffer(char *fpath, int mode, short allocResult, unsigned int size);
-int readFileBuffer(file_buffer_t *readContext, char **outBuf);
+file_buffer_t *openFileBuffer(char *fpath, int mode, unsigned int size);
 void writeFileBuffer(file_buffer_t *fileBuffer, char *inBuf, int size);
 void closeFileBuffer(file_buffer_t *fileBuffer);
 
+// A text file, read whole into a single buffer
+typedef struct
+{
+    char *buffer;
+    char *next; // Start of the next line
+    char *end;
+} text_buffer_t;
+
+int openTextBuffer(text_buffer_t *text, char *fpath);
+void openTextBufferBuffer(text_buffer_t *text, char *buffer, unsigned int size);
+int readTextLine(text_buffer_t *text, char **line, int *length);
+void closeTextBuffer(text_buffer_t *text);
+
 int max(int a, int b);
 int min(int a, int b);
 int fromHex(char digit);
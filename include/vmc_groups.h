@@ -5,9 +5,10 @@
 /**
  * @brief Finds the Group ID associated with a given Title ID.
  *
- * This function iterates through all embedded memory card groups.
+ * The Title ID is looked up in a perfect hash table generated from the
+ * embedded memory card groups by pc/vmcgroups.py.
  * If the provided Title ID is found within any group's list of Title IDs,
- * the Group ID for that group is returned.
+ * the Group ID for the first such group is returned.
  * If the Title ID is not found in any group, the original Title ID
  * passed as a parameter is returned.
  *
@@ -1,6 +1,7 @@
 import json
+import struct
 from io import TextIOWrapper
-from typing import Any, Dict
+from typing import Any, Dict, List
 
 import yaml
 
@@ -28,6 +29,11 @@ STRINGS_START = """
 
 CURLY_BRACE_END = "};\n"
 
+# Compiled language pack, loaded by src/lang.c in place of a text .lng file:
+# header (magic, version, reserved, string count, blob size), u32 offset table, blob of NUL terminated strings
+LNG_PACK_MAGIC = b'OPLL'
+LNG_PACK_VERSION = 1
+
 
 # By default PyYAML quoting rules put multi-line strings in single quotes which is dumb
 # This function fixes that
@@ -108,15 +114,8 @@ def update_translation_yml(base_obj: Dict[str, Any], translation_obj: Dict[str,
     yaml.dump(translation_obj, output_file, **YAML_DUMP_ARGS)
 
 
-def make_lng(
-    base_obj: Dict[str, Any],
-    translation_obj: Dict[str, Any],
-    output_file: TextIOWrapper,
-    translation_filename: str,
-) -> None:
-    for comm_line in translation_obj['comments'].splitlines():
-        output_file.write(f'# {comm_line}\n')
-
+def resolve_translations(base_obj: Dict[str, Any], translation_obj: Dict[str, Any], translation_filename: str) -> List[str]:
+    translations = []
     for string_def in base_obj['gui_strings']:
         label = string_def['label']
         translation = translation_obj['translations'].get(label)
@@ -129,9 +128,44 @@ def make_lng(
 
             translation = string_def['string']
 
+        translations.append(translation)
+
+    return translations
+
+
+def make_lng(
+    base_obj: Dict[str, Any],
+    translation_obj: Dict[str, Any],
+    output_file: TextIOWrapper,
+    translation_filename: str,
+) -> None:
+    for comm_line in translation_obj['comments'].splitlines():
+        output_file.write(f'# {comm_line}\n')
+
+    for translation in resolve_translations(base_obj, translation_obj, translation_filename):
         output_file.write(f'{translation}\n')
 
 
+def make_lng_bin(
+    base_obj: Dict[str, Any],
+    translation_obj: Dict[str, Any],
+    output_file: TextIOWrapper,
+    translation_filename: str,
+) -> None:
+    offsets = []
+    blob = bytearray()
+    for translation in resolve_translations(base_obj, translation_obj, translation_filename):
+        offsets.append(len(blob))
+        blob += translation.encode('utf-8') + b'\0'
+
+    output_file.flush()
+    output = output_file.buffer
+    output.write(LNG_PACK_MAGIC + struct.pack('<HHII', LNG_PACK_VERSION, 0, len(offsets), len(blob)))
+    output.write(struct.pack(f'<{len(offsets)}I', *offsets))
+    output.write(blob)
+    output.flush()
+
+
 if __name__ == '__main__':
     import argparse
     import sys
@@ -142,6 +176,7 @@ if __name__ == '__main__':
     action_group.add_argument('--make_template_yml', action='store_true')
     action_group.add_argument('--update_translation_yml', action='store_true')
     action_group.add_argument('--make_lng', action='store_true')
+    action_group.add_argument('--make_lng_bin', action='store_true')
 
     parser.add_argument('--base', type=argparse.FileType('r', encoding='utf-8'), required=True, metavar="BASE_YML")
     parser.add_argument('--translation', type=argparse.FileType('r+', encoding='utf-8'), metavar="LANG_YML")
@@ -149,10 +184,12 @@ if __name__ == '__main__':
 
     args = parser.parse_args()
     if args.translation is None:
-        if args.make_lng or args.update_translation_yml:
+        if args.make_lng or args.make_lng_bin or args.update_translation_yml:
             option = ''
             if args.make_lng:
                 option = 'make_lng'
+            elif args.make_lng_bin:
+                option = 'make_lng_bin'
             elif args.update_translation_yml:
                 option = 'update_translation_yml'
 
@@ -173,3 +210,6 @@ if __name__ == '__main__':
     elif args.make_lng:
         translation_obj = yaml.safe_load(args.translation)
         make_lng(base_obj, translation_obj, args.output_file, args.translation.name)
+    elif args.make_lng_bin:
+        translation_obj = yaml.safe_load(args.translation)
+        make_lng_bin(base_obj, translation_obj, args.output_file, args.translation.name)
@@ -13,6 +13,7 @@
 #include <sysclib.h>
 #include <stdio.h>
 #include <thbase.h>
+#include <errno.h>
 
 #include <io_common.h>
 
@@ -30,6 +31,54 @@ static char recv_packet[PACKET_MAXSIZE] __attribute__((aligned(16)));
 static int pko_fileio_sock = -1;
 static int pko_fileio_active = 0;
 
+/*
+ * The host serves the requests in order, so requests can be sent before the replies to
+ * the earlier ones were received. This is used for:
+ *  - reading ahead: small reads are served from a buffer, and the next chunk of the file
+ *    is requested before the buffer runs out.
+ *  - writing: the segments of a write are sent without waiting for each reply. All the
+ *    replies are received before the write returns, so its result is the host's.
+ * Only one kind of request is outstanding at a time, so the replies are received in order.
+ *
+ * Small writes are collected in a buffer and sent as one write, when it is full, when
+ * another file is written, or before any other request. As they return before the host
+ * wrote them, a failure of the host is returned by the next write or the close of the file.
+ *
+ * Each can be disabled, for comparison: a chunk of 0 does not read ahead, 1 pending write
+ * waits for each segment, and a write buffer of 0 sends each write.
+ */
+#ifndef PKO_READAHEAD_CHUNK
+#define PKO_READAHEAD_CHUNK 4096 // Two chunks fit into the TCP window of the in-game stack
+#endif
+#ifndef PKO_MAX_PENDING_WRITES
+#define PKO_MAX_PENDING_WRITES 8
+#endif
+#ifndef PKO_WRITEBUF_SIZE
+#define PKO_WRITEBUF_SIZE PKO_MAX_WRITE_SEGMENT // One segment
+#endif
+
+static struct
+{
+    int fd;      // -1 = not in use
+    int head;    // Offset of the buffered data
+    int len;     // Bytes of buffered data
+    int pending; // Bytes requested from the host, whose reply was not received yet
+    int eof;
+    char buf[2 * PKO_READAHEAD_CHUNK];
+} pko_readahead __attribute__((aligned(16))) = {-1, 0, 0, 0, 0};
+
+static int pko_pending_writes = 0;
+static int pko_pending_nbytes[PKO_MAX_PENDING_WRITES];
+
+static struct
+{
+    int fd;       // -1 = empty
+    int len;
+    int error_fd; // File of the failure of the host to write the buffer, -1 = none
+    int error;
+    char buf[PKO_WRITEBUF_SIZE];
+} pko_writebuf __attribute__((aligned(16))) = {-1, 0, -1, 0};
+
 #ifdef DEBUG
 #define dbgprintf(args...) printf(args)
 #else
@@ -38,6 +87,21 @@ static int pko_fileio_active = 0;
     } while (0)
 #endif
 
+//----------------------------------------------------------------------
+//
+static void pko_reset_pipeline(void)
+{
+    pko_readahead.fd = -1;
+    pko_readahead.head = 0;
+    pko_readahead.len = 0;
+    pko_readahead.pending = 0;
+    pko_readahead.eof = 0;
+    pko_pending_writes = 0;
+    pko_writebuf.fd = -1;
+    pko_writebuf.len = 0;
+    pko_writebuf.error_fd = -1;
+}
+
 //----------------------------------------------------------------------
 //
 void pko_close_socket(void)
@@ -49,6 +113,7 @@ void pko_close_socket(void)
         printf("pko_file: disconnect returned error %d\n", ret);
     }
     pko_fileio_sock = -1;
+    pko_reset_pipeline();
 }
 
 //----------------------------------------------------------------------
@@ -159,6 +224,283 @@ int pko_accept_pkt(int sock, char *buf, int len, int pkt_type)
     return 1;
 }
 
+//----------------------------------------------------------------------
+// Send a read request without waiting for the reply.
+static int pko_send_read_req(int fd, int nbytes)
+{
+    pko_pkt_read_req *readcmd;
+
+    readcmd = (pko_pkt_read_req *)&send_packet[0];
+
+    readcmd->cmd = htonl(PKO_READ_CMD);
+    readcmd->len = htons((unsigned short)sizeof(pko_pkt_read_req));
+    readcmd->fd = htonl(fd);
+    readcmd->nbytes = htonl(nbytes);
+
+    return pko_lwip_send(pko_fileio_sock, readcmd, sizeof(pko_pkt_read_req), 0);
+}
+
+//----------------------------------------------------------------------
+// Receive the reply to a read request and its data, of up to 'length' bytes.
+static int pko_recv_read_rly(char *buf, int length)
+{
+    pko_pkt_read_rly *readrly;
+    int nbytes;
+
+    readrly = (pko_pkt_read_rly *)&recv_packet[0];
+
+    if (!pko_accept_pkt(pko_fileio_sock, (char *)readrly,
+                        sizeof(pko_pkt_read_rly), PKO_READ_RLY)) {
+        dbgprintf("pko_file: pko_read_file: "
+                  "did not receive PKO_READ_RLY\n");
+        return -1;
+    }
+
+    nbytes = ntohl(readrly->nbytes);
+    dbgprintf("pko_file: pko_read_file: Reply said there's %d bytes to read "
+              "(wanted %d)\n",
+              nbytes, length);
+
+    if (nbytes > length) {
+        dbgprintf("pko_file: pko_read_file: host sent too much data\n");
+        pko_close_socket();
+        return -1;
+    }
+
+    // Now read the actual file data
+    if (pko_recv_bytes(pko_fileio_sock, buf, nbytes) < 0) {
+        dbgprintf("pko_file: pko_read_file, data read error\n");
+        return -1;
+    }
+    return nbytes;
+}
+
+//----------------------------------------------------------------------
+// Request the next chunk of the read-ahead file. The buffer must not hold more than one chunk.
+static int pko_readahead_send(void)
+{
+    if (pko_readahead.head > 0) {
+        memmove(pko_readahead.buf, &pko_readahead.buf[pko_readahead.head], pko_readahead.len);
+        pko_readahead.head = 0;
+    }
+
+    if (pko_send_read_req(pko_readahead.fd, PKO_READAHEAD_CHUNK) < 0)
+        return -1;
+    pko_readahead.pending = PKO_READAHEAD_CHUNK;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Receive the chunk that was requested ahead, if any. It goes after the buffered data.
+static int pko_readahead_recv(void)
+{
+    int nbytes;
+
+    if (pko_readahead.pending == 0)
+        return 0;
+
+    nbytes = pko_recv_read_rly(&pko_readahead.buf[pko_readahead.head + pko_readahead.len], pko_readahead.pending);
+    if (nbytes < 0)
+        return -1;
+
+    if (nbytes < pko_readahead.pending)
+        pko_readahead.eof = 1;
+    pko_readahead.len += nbytes;
+    pko_readahead.pending = 0;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Stop reading ahead. If 'restore' is set, seek the host file back to where the reader is.
+static int pko_readahead_drop(int restore)
+{
+    int fd, len;
+
+    if (pko_readahead.fd < 0)
+        return 0;
+
+    if (pko_readahead_recv() < 0)
+        return -1;
+
+    fd = pko_readahead.fd;
+    len = pko_readahead.len;
+    pko_readahead.fd = -1;
+    pko_readahead.head = 0;
+    pko_readahead.len = 0;
+    pko_readahead.eof = 0;
+
+    if (restore && len > 0)
+        return pko_lseek_file(fd, -len, SEEK_CUR);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Receive the replies to the writes that were sent. The bytes written are added to 'written', until
+// a write fails or is short: 'written' is then the error, or stays at the bytes written before it.
+static int pko_write_sync(int *written, int *stopped)
+{
+    pko_pkt_file_rly *writerly;
+    int i, retval;
+
+    writerly = (pko_pkt_file_rly *)&recv_packet[0];
+
+    for (i = 0; i < pko_pending_writes; i++) {
+        if (!pko_accept_pkt(pko_fileio_sock, (char *)writerly,
+                            sizeof(pko_pkt_file_rly), PKO_WRITE_RLY)) {
+            dbgprintf("pko_file: pko_write_file: "
+                      "did not receive PKO_WRITE_RLY\n");
+            pko_pending_writes = 0;
+            return -1;
+        }
+        retval = ntohl(writerly->retval);
+
+        dbgprintf("pko_file: wrote %d bytes (asked for %d)\n",
+                  retval, pko_pending_nbytes[i]);
+
+        if (*stopped) {
+            continue;
+        }
+        if (retval < 0) {
+            // Error
+            dbgprintf("pko_file: pko_write_file: received error on write req (%d)\n",
+                      retval);
+            *written = retval;
+            *stopped = 1;
+            continue;
+        }
+
+        *written += retval;
+        if (retval < pko_pending_nbytes[i]) {
+            // EOF?
+            *stopped = 1;
+        }
+    }
+    pko_pending_writes = 0;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Send a write, without waiting for the reply to each of its segments.
+static int pko_send_write(int fd, char *buf, int length)
+{
+    pko_pkt_write_req *writecmd;
+    int hlen;
+    int writtenbytes;
+    int sentbytes;
+    int stopped;
+    int nbytes;
+
+    writecmd = (pko_pkt_write_req *)&send_packet[0];
+
+    hlen = (unsigned short)sizeof(pko_pkt_write_req);
+    writecmd->cmd = htonl(PKO_WRITE_CMD);
+    writecmd->len = htons(hlen);
+    writecmd->fd = htonl(fd);
+
+    /* Divide the write request. The replies are not waited for, but not more than PKO_MAX_PENDING_WRITES are outstanding.
+       Once one of them failed or was short, no more are sent, but those already sent may still be written. */
+    writtenbytes = 0;
+    sentbytes = 0;
+    stopped = 0;
+    while (sentbytes < length) {
+
+        if ((length - sentbytes) > PKO_MAX_WRITE_SEGMENT) {
+            // Need to split in several write reqs
+            nbytes = PKO_MAX_WRITE_SEGMENT;
+        } else {
+            nbytes = length - sentbytes;
+        }
+
+        if (pko_pending_writes == PKO_MAX_PENDING_WRITES) {
+            if (pko_write_sync(&writtenbytes, &stopped) < 0) {
+                return -1;
+            }
+            if (stopped) {
+                break;
+            }
+        }
+
+        writecmd->nbytes = htonl(nbytes);
+#ifdef ZEROCOPY
+        /* Send the packet header.  */
+        if (pko_lwip_send(pko_fileio_sock, writecmd, hlen, 0) < 0)
+            return -1;
+        /* Send the write() data.  */
+        if (pko_lwip_send(pko_fileio_sock, &buf[sentbytes], nbytes, 0) < 0)
+            return -1;
+#else
+        // Copy data to the acutal packet
+        memcpy(&send_packet[sizeof(pko_pkt_write_req)], &buf[sentbytes],
+               nbytes);
+
+        if (pko_lwip_send(pko_fileio_sock, writecmd, hlen + nbytes, 0) < 0)
+            return -1;
+#endif
+
+        pko_pending_nbytes[pko_pending_writes++] = nbytes;
+        sentbytes += nbytes;
+    }
+
+    if (pko_write_sync(&writtenbytes, &stopped) < 0) {
+        return -1;
+    }
+    return writtenbytes;
+}
+
+//----------------------------------------------------------------------
+// Send the buffered writes. If the host does not write them all, the failure is kept for
+// the next write or the close of the file. Only the last failure is kept.
+static int pko_writebuf_flush(void)
+{
+    int fd, len, written;
+
+    if (pko_writebuf.len == 0) {
+        return 0;
+    }
+
+    if (pko_readahead_recv() < 0) {
+        return -1;
+    }
+
+    fd = pko_writebuf.fd;
+    len = pko_writebuf.len;
+    pko_writebuf.fd = -1;
+    pko_writebuf.len = 0;
+
+    written = pko_send_write(fd, pko_writebuf.buf, len);
+    if (pko_fileio_sock < 0) {
+        return -1;
+    }
+    if (written != len) {
+        pko_writebuf.error_fd = fd;
+        pko_writebuf.error = written < 0 ? written : -EIO;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Return and forget the failure of the host to write the buffer, if it was for this file.
+static int pko_writebuf_error(int fd)
+{
+    if (pko_writebuf.error_fd != fd) {
+        return 0;
+    }
+
+    pko_writebuf.error_fd = -1;
+    return pko_writebuf.error;
+}
+
+//----------------------------------------------------------------------
+// Receive all outstanding replies and send the buffered writes, before sending a request
+// that waits for its own reply. Writes have no replies left once they return.
+static int pko_sync(void)
+{
+    if (pko_readahead_recv() < 0) {
+        return -1;
+    }
+    return pko_writebuf_flush();
+}
+
 //----------------------------------------------------------------------
 //
 int pko_open_file(char *path, int flags)
@@ -170,6 +512,10 @@ int pko_open_file(char *path, int flags)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: file open req (%s, %x)\n", path, flags);
 
     openreq = (pko_pkt_open_req *)&send_packet[0];
@@ -205,7 +551,7 @@ int pko_close_file(int fd)
 {
     pko_pkt_close_req *closereq;
     pko_pkt_file_rly *closerly;
-
+    int ret, error;
 
     if (pko_fileio_sock < 0) {
         return -1;
@@ -213,6 +559,13 @@ int pko_close_file(int fd)
 
     dbgprintf("pko_file: file close req (fd: %d)\n", fd);
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+    if (pko_readahead.fd == fd) {
+        pko_readahead_drop(0);
+    }
+
     closereq = (pko_pkt_close_req *)&send_packet[0];
     closerly = (pko_pkt_file_rly *)&recv_packet[0];
 
@@ -233,7 +586,12 @@ int pko_close_file(int fd)
     dbgprintf("pko_file: pko_close_file: close reply received (ret %ld)\n",
               ntohl(closerly->retval));
 
-    return ntohl(closerly->retval);
+    ret = ntohl(closerly->retval);
+    // The file is closed in any case, but the buffered writes may have failed
+    if ((error = pko_writebuf_error(fd)) < 0) {
+        return error;
+    }
+    return ret;
 }
 
 //----------------------------------------------------------------------
@@ -250,6 +608,17 @@ int pko_lseek_file(int fd, unsigned int offset, int whence)
 
     dbgprintf("pko_file: file lseek req (fd: %d)\n", fd);
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+    if (pko_readahead.fd == fd) {
+        // The host file is ahead of the reader by the buffered data.
+        if (whence == SEEK_CUR) {
+            offset -= pko_readahead.len;
+        }
+        pko_readahead_drop(0);
+    }
+
     lseekreq = (pko_pkt_lseek_req *)&send_packet[0];
     lseekrly = (pko_pkt_file_rly *)&recv_packet[0];
 
@@ -277,15 +646,10 @@ int pko_lseek_file(int fd, unsigned int offset, int whence)
 
 
 //----------------------------------------------------------------------
-//
+// Writes smaller than the write buffer are buffered, larger ones are sent at once.
 int pko_write_file(int fd, char *buf, int length)
 {
-    pko_pkt_write_req *writecmd;
-    pko_pkt_file_rly *writerly;
-    int hlen;
-    int writtenbytes;
-    int nbytes;
-    int retval;
+    int error;
 
     if (pko_fileio_sock < 0) {
         return -1;
@@ -293,124 +657,119 @@ int pko_write_file(int fd, char *buf, int length)
 
     dbgprintf("pko_file: file write req (fd: %d)\n", fd);
 
-    writecmd = (pko_pkt_write_req *)&send_packet[0];
-    writerly = (pko_pkt_file_rly *)&recv_packet[0];
-
-    hlen = (unsigned short)sizeof(pko_pkt_write_req);
-    writecmd->cmd = htonl(PKO_WRITE_CMD);
-    writecmd->len = htons(hlen);
-    writecmd->fd = htonl(fd);
-
-    // Divide the write request
-    writtenbytes = 0;
-    while (writtenbytes < length) {
-
-        if ((length - writtenbytes) > PKO_MAX_WRITE_SEGMENT) {
-            // Need to split in several read reqs
-            nbytes = PKO_MAX_READ_SEGMENT;
-        } else {
-            nbytes = length - writtenbytes;
-        }
-
-        writecmd->nbytes = htonl(nbytes);
-#ifdef ZEROCOPY
-        /* Send the packet header.  */
-        if (pko_lwip_send(pko_fileio_sock, writecmd, hlen, 0) < 0)
-            return -1;
-        /* Send the write() data.  */
-        if (pko_lwip_send(pko_fileio_sock, &buf[writtenbytes], nbytes, 0) < 0)
-            return -1;
-#else
-        // Copy data to the acutal packet
-        memcpy(&send_packet[sizeof(pko_pkt_write_req)], &buf[writtenbytes],
-               nbytes);
+    if ((error = pko_writebuf_error(fd)) < 0) {
+        return error;
+    }
 
-        if (pko_lwip_send(pko_fileio_sock, writecmd, hlen + nbytes, 0) < 0)
+    // Put the host file back to where the reader is, before writing there.
+    if (pko_readahead.fd == fd) {
+        if (pko_readahead_drop(1) < 0) {
             return -1;
-#endif
-
+        }
+    }
 
-        // Get reply
-        if (!pko_accept_pkt(pko_fileio_sock, (char *)writerly,
-                            sizeof(pko_pkt_file_rly), PKO_WRITE_RLY)) {
-            dbgprintf("pko_file: pko_write_file: "
-                      "did not receive PKO_WRITE_RLY\n");
+    if (pko_writebuf.len > 0 && (pko_writebuf.fd != fd || pko_writebuf.len + length > PKO_WRITEBUF_SIZE)) {
+        if (pko_writebuf_flush() < 0) {
             return -1;
         }
-        retval = ntohl(writerly->retval);
-
-        dbgprintf("pko_file: wrote %d bytes (asked for %d)\n",
-                  retval, nbytes);
-
-        if (retval < 0) {
-            // Error
-            dbgprintf("pko_file: pko_write_file: received error on write req (%d)\n",
-                      retval);
-            return retval;
+        if ((error = pko_writebuf_error(fd)) < 0) {
+            return error;
         }
+    }
 
-        writtenbytes += retval;
-        if (retval < nbytes) {
-            // EOF?
-            break;
-        }
+    if (length > 0 && length < PKO_WRITEBUF_SIZE) {
+        memcpy(&pko_writebuf.buf[pko_writebuf.len], buf, length);
+        pko_writebuf.fd = fd;
+        pko_writebuf.len += length;
+        return length;
     }
-    return writtenbytes;
+
+    if (pko_readahead_recv() < 0) {
+        return -1;
+    }
+    return pko_send_write(fd, buf, length);
 }
 
 //----------------------------------------------------------------------
-//
+// Small reads are served from the read-ahead buffer. Larger reads get the
+// buffered data and then read the rest directly.
 int pko_read_file(int fd, char *buf, int length)
 {
     int nbytes;
     int i;
-    pko_pkt_read_req *readcmd;
-    pko_pkt_read_rly *readrly;
-
 
     if (pko_fileio_sock < 0) {
         return -1;
     }
 
-    readcmd = (pko_pkt_read_req *)&send_packet[0];
-    readrly = (pko_pkt_read_rly *)&recv_packet[0];
-
-    readcmd->cmd = htonl(PKO_READ_CMD);
-    readcmd->len = htons((unsigned short)sizeof(pko_pkt_read_req));
-    readcmd->fd = htonl(fd);
-
     if (length < 0) {
         dbgprintf("pko_read_file: illegal req!! (whish to read < 0 bytes!)\n");
         return -1;
     }
 
-    readcmd->nbytes = htonl(length);
-
-    i = send(pko_fileio_sock, readcmd, sizeof(pko_pkt_read_req), 0);
-    if (i < 0) {
-        dbgprintf("pko_file: pko_read_file: send failed (%d)\n", i);
+    if (pko_writebuf_flush() < 0) {
         return -1;
     }
 
-    if (!pko_accept_pkt(pko_fileio_sock, (char *)readrly,
-                        sizeof(pko_pkt_read_rly), PKO_READ_RLY)) {
-        dbgprintf("pko_file: pko_read_file: "
-                  "did not receive PKO_READ_RLY\n");
-        return -1;
+    if (length < PKO_READAHEAD_CHUNK && pko_readahead.fd != fd) {
+        // Read ahead on this file instead.
+        if (pko_readahead_drop(1) < 0) {
+            return -1;
+        }
+        pko_readahead.fd = fd;
+    } else if (pko_readahead.fd != fd) {
+        if (pko_readahead_recv() < 0) {
+            return -1;
+        }
     }
 
-    nbytes = ntohl(readrly->nbytes);
-    dbgprintf("pko_file: pko_read_file: Reply said there's %d bytes to read "
-              "(wanted %d)\n",
-              nbytes, length);
+    nbytes = 0;
+    if (pko_readahead.fd == fd) {
+        while (pko_readahead.len < length && !pko_readahead.eof) {
+            if (pko_readahead.pending == 0 && length < PKO_READAHEAD_CHUNK) {
+                if (pko_readahead_send() < 0) {
+                    return -1;
+                }
+            }
+            if (pko_readahead.pending == 0) {
+                break;
+            }
+            if (pko_readahead_recv() < 0) {
+                return -1;
+            }
+        }
 
-    // Now read the actual file data
-    i = pko_recv_bytes(pko_fileio_sock, &buf[0], nbytes);
+        nbytes = pko_readahead.len < length ? pko_readahead.len : length;
+        memcpy(buf, &pko_readahead.buf[pko_readahead.head], nbytes);
+        pko_readahead.head += nbytes;
+        pko_readahead.len -= nbytes;
+
+        if (length < PKO_READAHEAD_CHUNK) {
+            // Request the next chunk now, so that it arrives while the data is being used.
+            if (pko_readahead.pending == 0 && pko_readahead.len <= PKO_READAHEAD_CHUNK && !pko_readahead.eof) {
+                if (pko_readahead_send() < 0) {
+                    return -1;
+                }
+            }
+            return nbytes;
+        }
+
+        if (nbytes == length || pko_readahead.eof) {
+            return nbytes;
+        }
+    }
+
+    // Read the rest directly.
+    if (pko_send_read_req(fd, length - nbytes) < 0) {
+        dbgprintf("pko_file: pko_read_file: send failed\n");
+        return -1;
+    }
+
+    i = pko_recv_read_rly(&buf[nbytes], length - nbytes);
     if (i < 0) {
-        dbgprintf("pko_file: pko_read_file, data read error\n");
         return -1;
     }
-    return nbytes;
+    return nbytes + i;
 }
 
 //----------------------------------------------------------------------
@@ -424,6 +783,10 @@ int pko_remove(char *name)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: file remove req (%s)\n", name);
 
     removereq = (pko_pkt_remove_req *)&send_packet[0];
@@ -460,6 +823,10 @@ int pko_mkdir(char *name, int mode)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: make dir req (%s)\n", name);
 
     mkdirreq = (pko_pkt_mkdir_req *)&send_packet[0];
@@ -497,6 +864,10 @@ int pko_rmdir(char *name)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: remove dir req (%s)\n", name);
 
     rmdirreq = (pko_pkt_rmdir_req *)&send_packet[0];
@@ -533,6 +904,10 @@ int pko_open_dir(char *path)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: dir open req (%s)\n", path);
 
     openreq = (pko_pkt_open_req *)&send_packet[0];
@@ -573,6 +948,10 @@ int pko_read_dir(int fd, void *buf)
         return -1;
     }
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     dbgprintf("pko_file: dir read req (%x)\n", fd);
 
     dirreq = (pko_pkt_dread_req *)&send_packet[0];
@@ -625,6 +1004,10 @@ int pko_close_dir(int fd)
 
     dbgprintf("pko_file: dir close req (fd: %d)\n", fd);
 
+    if (pko_sync() < 0) {
+        return -1;
+    }
+
     closereq = (pko_pkt_close_req *)&send_packet[0];
     closerly = (pko_pkt_file_rly *)&recv_packet[0];
 
@@ -715,6 +1098,7 @@ int pko_file_serv(void *argv)
             dbgprintf("close ret %d\n", ret);
         }
         pko_fileio_sock = client_sock;
+        pko_reset_pipeline();
     }
 
     if (pko_fileio_sock > 0) {
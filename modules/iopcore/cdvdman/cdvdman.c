@@ -25,7 +25,6 @@ extern struct irx_export_table _exp_dev9;
 #endif
 
 // reader function interface, raw reader impementation by default
-int DeviceReadSectorsCached(u64 sector, void *buffer, unsigned int count);
 int (*DeviceReadSectorsPtr)(u64 sector, void *buffer, unsigned int count) = &DeviceReadSectors;
 
 // internal functions prototypes
@@ -36,12 +35,7 @@ static void cdvdman_signal_read_end(void);
 static void cdvdman_signal_read_end_intr(void);
 static void cdvdman_startThreads(void);
 static void cdvdman_create_semaphores(void);
-static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf);
-
-// Sector cache to improve IO
-static u8 MAX_SECTOR_CACHE = 0;
-static u8 *sector_cache = NULL;
-static u64 cur_sector = 0xffffffffffffffff;
+static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller);
 
 struct cdvdman_cb_data
 {
@@ -80,11 +74,12 @@ static oplShutdownCb_t vmcShutdownCb = NULL;
 
 void initCache()
 {
+    static u8 *sector_cache = NULL;
+
     u8 cache_size = cdvdman_settings.common.zso_cache;
     if (cache_size && sector_cache == NULL) {
         sector_cache = AllocSysMemory(ALLOC_FIRST, cache_size * 2048, NULL);
-        if (sector_cache)
-            MAX_SECTOR_CACHE = cache_size;
+        ZSOSetSectorCache(sector_cache, cache_size);
     }
 }
 
@@ -97,6 +92,9 @@ static void oplShutdown(int poff)
 {
     u32 stat;
 
+#ifdef __IO_TRACE
+    IoTraceFlush();
+#endif
     DeviceLock();
     if (vmcShutdownCb != NULL)
         vmcShutdownCb();
@@ -164,79 +162,6 @@ void *ziso_alloc(u32 size)
     return AllocSysMemory(0, size, NULL);
 }
 
-/*
-  This small improvement will mostly benefit ZSO files.
-  For the same size of an ISO sector, we can have more than one ZSO blocks.
-  If we do a consecutive read of many ISO sectors we will have a huge amount of ZSO sectors ready.
-  Therefore reducing IO access for ZSO files.
-*/
-int DeviceReadSectorsCached(u64 lsn, void *buffer, unsigned int sectors)
-{
-    if (sectors < MAX_SECTOR_CACHE) { // if MAX_SECTOR_CACHE is 0 then it will act as disabled and passthrough
-        if (cur_sector == 0xffffffffffff || lsn < cur_sector || (lsn + sectors) - cur_sector > MAX_SECTOR_CACHE) {
-            DeviceReadSectors(lsn, sector_cache, MAX_SECTOR_CACHE);
-            cur_sector = lsn;
-        }
-        int pos = lsn - cur_sector;
-        memcpy(buffer, &(sector_cache[pos * 2048]), 2048 * sectors);
-        return SCECdErNO;
-    }
-    int res = DeviceReadSectors(lsn, buffer, sectors);
-    return res;
-}
-
-/*
-  For ZSO we need to be able to read at arbitrary offsets with arbitrary sizes.
-  Since we can only do sector-based reads, this funtions acts as a wrapper.
-  It will do at most 3 IO reads, most of the time only 1.
-*/
-int read_raw_data(u8 *addr, u32 size, u32 offset, u32 shift)
-{
-    u32 o_size = size;
-    u64 lba = offset / (2048 >> shift); // avoid overflow by shifting sector size instead of offset
-    u32 pos = (offset << shift) & 2047; // doesn't matter if it overflows since we only care about the 11 LSB anyways
-
-    // prevent caching if already reading into ZSO index cache
-    int (*ReadSectors)(u64 lsn, void *buffer, unsigned int sectors) = (addr == (u8 *)ziso_idx_cache) ? &DeviceReadSectors : &DeviceReadSectorsCached;
-
-    // read first block if not aligned to sector size
-    if (pos) {
-        int r = MIN(size, (2048 - pos));
-        ReadSectors(lba, ziso_tmp_buf, 1);
-        memcpy(addr, ziso_tmp_buf + pos, r);
-        size -= r;
-        lba++;
-        addr += r;
-    }
-
-    // read intermediate blocks if more than one block is left
-    u32 n_blocks = size / 2048;
-    if (size % 2048)
-        n_blocks++;
-    if (n_blocks > 1) {
-        int r = 2048 * (n_blocks - 1);
-        ReadSectors(lba, addr, n_blocks - 1);
-        size -= r;
-        addr += r;
-        lba += n_blocks - 1;
-    }
-
-    // read remaining data
-    if (size) {
-        ReadSectors(lba, ziso_tmp_buf, 1);
-        memcpy(addr, ziso_tmp_buf, size);
-        size = 0;
-    }
-
-    // return remaining size
-    return o_size - size;
-}
-
-int DeviceReadSectorsCompressed(u64 lsn, void *addr, unsigned int count)
-{
-    return (ziso_read_sector(addr, (u32)lsn, count) == count) ? SCECdErNO : SCECdErEOM;
-}
-
 static int probed = 0;
 static int ProbeZSO(u8 *buffer)
 {
@@ -254,10 +179,28 @@ static int ProbeZSO(u8 *buffer)
     return 1;
 }
 
+#if defined(HDD_DRIVER) || defined(USE_BDM_ATA)
+// Synthesizes the 12-byte header of a 2340-byte sector: its position, then the subheader twice.
+static void cdvdman_fill_header(u32 lsn, u8 *header)
+{
+    sceCdlLOCCD p;
+
+    sceCdIntToPos(lsn, &p);
+    header[0] = p.minute;
+    header[1] = p.second;
+    header[2] = p.sector;
+    header[3] = 0; // p.track for cdda only non-zero
+
+    // Subheader and copy of subheader.
+    header[4] = header[8] = 0;
+    header[5] = header[9] = 0;
+    header[6] = header[10] = 0x8;
+    header[7] = header[11] = 0;
+}
+#endif
+
 static int cdvdman_read_sectors(u32 lsn, unsigned int sectors, void *buf)
 {
-    unsigned int remaining;
-    void *ptr;
     int endOfMedia = 0;
 
     DPRINTF("cdvdman_read lsn=%lu sectors=%u buf=%p\n", lsn, sectors, buf);
@@ -287,55 +230,27 @@ static int cdvdman_read_sectors(u32 lsn, unsigned int sectors, void *buf)
     }
 
     cdvdman_stat.err = SCECdErNO;
-    for (ptr = buf, remaining = sectors; remaining > 0;) {
-        unsigned int SectorsToRead = remaining;
+    if (sectors == 0)
+        return 0;
 
-        if (cdvdman_settings.common.flags & IOPCORE_COMPAT_ACCU_READS) {
-            // Limit transfers to a maximum length of 8, with a restricted transfer rate.
-            iop_sys_clock_t TargetTime;
-
-            if (SectorsToRead > 8)
-                SectorsToRead = 8;
-
-            TargetTime.hi = 0;
-            TargetTime.lo = (cdvdman_settings.common.media == 0x12 ? 81920 : 33512) * SectorsToRead;
-            // SP193: approximately 2KB/3600KB/s = 555us required per 2048-byte data sector at 3600KB/s, so 555 * 36.864 = 20460 ticks per sector with a 36.864MHz clock.
-            /* AKuHAK: 3600KB/s is too fast, it is CD 24x - theoretical maximum on CD
-               However, when setting SCECdSpinMax we will get 900KB/s (81920) for CD, and 2200KB/s (33512) for DVD */
-            ClearEventFlag(cdvdman_stat.intr_ef, ~0x1000);
-            SetAlarm(&TargetTime, &cdvdemu_read_end_cb, NULL);
-        }
+    if (cdvdman_settings.common.flags & IOPCORE_COMPAT_ACCU_READS) {
+        // Read everything at once, but only complete after the time that the drive would have taken (see mediatiming.c).
+        iop_sys_clock_t TargetTime;
 
-        cdvdman_stat.err = DeviceReadSectorsPtr(lsn, ptr, SectorsToRead);
-        if (cdvdman_stat.err != SCECdErNO) {
-            if (cdvdman_settings.common.flags & IOPCORE_COMPAT_ACCU_READS)
-                CancelAlarm(&cdvdemu_read_end_cb, NULL);
-            break;
-        }
+        TargetTime.hi = 0;
+        TargetTime.lo = MediaTimingRead(&cdvdman_settings.common, lsn, sectors);
+        ClearEventFlag(cdvdman_stat.intr_ef, ~0x1000);
+        SetAlarm(&TargetTime, &cdvdemu_read_end_cb, NULL);
+    }
 
-        /* PS2LOGO Decryptor algorithm; based on misfire's code (https://github.com/mlafeldt/ps2logo)
-           The PS2 logo is stored within the first 12 sectors, scrambled.
-           This algorithm exploits the characteristic that the value used for scrambling will be recorded,
-           when it is XOR'ed against a black pixel. The first pixel is black, hence the value of the first byte
-           was the value used for scrambling. */
-        if (lsn < 13) {
-            u32 j;
-            u8 *logo = (u8 *)ptr;
-            static u8 key = 0;
-            if (lsn == 0) // First sector? Copy the first byte as the value for unscrambling the logo.
-                key = logo[0];
-            if (key != 0) {
-                for (j = 0; j < (SectorsToRead * 2048); j++) {
-                    logo[j] ^= key;
-                    logo[j] = (logo[j] << 3) | (logo[j] >> 5);
-                }
-            }
-        }
+    cdvdman_stat.err = DeviceReadSectorsPtr(lsn, buf, sectors);
+    if (cdvdman_stat.err != SCECdErNO) {
+        if (cdvdman_settings.common.flags & IOPCORE_COMPAT_ACCU_READS)
+            CancelAlarm(&cdvdemu_read_end_cb, NULL);
+    } else {
+        PS2LogoRead(lsn, sectors, buf);
 
-        ptr = (void *)((u8 *)ptr + (SectorsToRead * 2048));
-        remaining -= SectorsToRead;
-        lsn += SectorsToRead;
-        ReadPos += SectorsToRead * 2048;
+        ReadPos += sectors * 2048;
 
         if (cdvdman_settings.common.flags & IOPCORE_COMPAT_ACCU_READS) {
             // Sleep until the required amount of time has been spent.
@@ -351,8 +266,13 @@ static int cdvdman_read_sectors(u32 lsn, unsigned int sectors, void *buf)
     return (cdvdman_stat.err == SCECdErNO ? 0 : 1);
 }
 
-static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf)
+static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller)
 {
+#ifdef __IO_TRACE
+    u32 trace_start = IoTraceClock();
+    u32 trace_sectors = sectors;
+#endif
+
     cdvdman_stat.status = SCECdStatRead;
     buf = (void *)PHYSADDR(buf);
 
@@ -392,23 +312,8 @@ static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf)
             memcpy((void *)((u32)buf + offset), cdvdman_buf, nbytes);
 
             // For these custom sizes we need to manually fix the header.
-            // For 2340 we have 12bytes. 4 are position.
-            if (sector_size == 2340) {
-                u8 *header = (u8 *)buf;
-                // position.
-                sceCdlLOCCD p;
-                sceCdIntToPos(rpos - 1, &p); // to get current pos.
-                header[0] = p.minute;
-                header[1] = p.second;
-                header[2] = p.sector;
-                header[3] = 0; // p.track for cdda only non-zero
-
-                // Subheader and copy of subheader.
-                header[4] = header[8] = 0;
-                header[5] = header[9] = 0;
-                header[6] = header[10] = 0x8;
-                header[7] = header[11] = 0;
-            }
+            if (sector_size == 2340)
+                cdvdman_fill_header(rpos - 1, buf);
 
             buf = (void *)((u8 *)buf + nbytes);
         }
@@ -423,6 +328,10 @@ static int cdvdman_read(u32 lsn, u32 sectors, u16 sector_size, void *buf)
 
     ReadPos = 0; /* Reset the buffer offset indicator. */
 
+#ifdef __IO_TRACE
+    IoTraceRecord(trace_start, lsn, trace_sectors, sector_size, caller, cdvdman_stat.err);
+#endif
+
     cdvdman_stat.status = SCECdStatPause;
 
     return 1;
@@ -452,7 +361,7 @@ static int cdvdman_common_lock(int IntrContext)
     return 1;
 }
 
-int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf)
+int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller)
 {
     int IsIntrContext, OldState;
 
@@ -469,6 +378,7 @@ int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf)
     cdvdman_stat.cdread_lba = lsn;
     cdvdman_stat.cdread_sectors = sectors;
     cdvdman_stat.sector_size = sector_size;
+    cdvdman_stat.cdread_caller = caller;
     cdvdman_stat.cdread_buf = buf;
 
     CpuResumeIntr(OldState);
@@ -481,7 +391,7 @@ int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf)
     return 1;
 }
 
-int cdvdman_SyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf)
+int cdvdman_SyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller)
 {
     int IsIntrContext, OldState;
 
@@ -497,7 +407,7 @@ int cdvdman_SyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf)
 
     CpuResumeIntr(OldState);
 
-    cdvdman_read(lsn, sectors, sector_size, buf);
+    cdvdman_read(lsn, sectors, sector_size, buf, caller);
 
     cdvdman_cb_event(SCECdFuncRead);
     sync_flag = 0;
@@ -737,7 +647,7 @@ static void cdvdman_cdread_Thread(void *args)
     while (1) {
         WaitSema(cdrom_rthread_sema);
 
-        cdvdman_read(cdvdman_stat.cdread_lba, cdvdman_stat.cdread_sectors, cdvdman_stat.sector_size, cdvdman_stat.cdread_buf);
+        cdvdman_read(cdvdman_stat.cdread_lba, cdvdman_stat.cdread_sectors, cdvdman_stat.sector_size, cdvdman_stat.cdread_buf, cdvdman_stat.cdread_caller);
 
         /* This streaming callback is not compatible with the original SONY stream channel 0 (IOP) callback's design.
        The original is run from the interrupt handler, but we want it to run
@@ -169,3 +169,31 @@ void bdm_writeSector(u64 lba, unsigned short int nsectors, const unsigned char *
     g_bd->write(g_bd, lba, buffer, nsectors);
     SignalSema(bdm_io_sema);
 }
+
+#ifdef __IO_TRACE
+int DeviceWriteTrace(const void *buffer, unsigned int size)
+{
+    const u8 *p = (const u8 *)buffer;
+    u32 remaining, count;
+    int i, last;
+
+    // The file is created and pre-allocated by the frontend, only its fragments are overwritten.
+    if (g_bd == NULL || cdvdman_settings.fragfile[1].frag_count == 0)
+        return SCECdErTRMOPN;
+
+    remaining = size / g_bd->sectorSize;
+    last = cdvdman_settings.fragfile[1].frag_start + cdvdman_settings.fragfile[1].frag_count;
+
+    WaitSema(bdm_io_sema);
+    for (i = cdvdman_settings.fragfile[1].frag_start; i < last && remaining > 0; i++) {
+        count = cdvdman_settings.frags[i].count < remaining ? cdvdman_settings.frags[i].count : remaining;
+        if (g_bd->write(g_bd, cdvdman_settings.frags[i].sector, p, count) != (int)count)
+            break;
+        p += count * g_bd->sectorSize;
+        remaining -= count;
+    }
+    SignalSema(bdm_io_sema);
+
+    return (remaining == 0 ? SCECdErNO : SCECdErREAD);
+}
+#endif
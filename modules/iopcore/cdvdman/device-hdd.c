@@ -131,3 +131,11 @@ int DeviceReadSectors(u64 lsn, void *buffer, unsigned int sectors)
 
     return SCECdErNO;
 }
+
+#ifdef __IO_TRACE
+int DeviceWriteTrace(const void *buffer, unsigned int size)
+{
+    // Games on the HDD are in APA partitions, there is no filesystem to keep the trace file in.
+    return SCECdErTRMOPN;
+}
+#endif
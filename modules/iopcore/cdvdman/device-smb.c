@@ -155,3 +155,37 @@ int DeviceReadSectors(u64 lsn, void *buffer, unsigned int sectors)
 
     return rv;
 }
+
+#ifdef __IO_TRACE
+int DeviceWriteTrace(const void *buffer, unsigned int size)
+{
+    char path[256];
+    u16 fid;
+    int result;
+
+    // <image>.iot, next to the disc image. Named like in DeviceFSInit(), without the part number.
+    if (!(cdvdman_settings.common.flags & IOPCORE_SMB_FORMAT_USBLD)) {
+        if (cdvdman_settings.smb_prefix[0])
+            sprintf(path, "\\%s\\%s\\%s.iot", cdvdman_settings.smb_prefix, cdvdman_settings.common.media == 0x12 ? "CD" : "DVD", cdvdman_settings.filename);
+        else
+            sprintf(path, "\\%s\\%s.iot", cdvdman_settings.common.media == 0x12 ? "CD" : "DVD", cdvdman_settings.filename);
+    } else {
+        if (cdvdman_settings.smb_prefix[0])
+            sprintf(path, "\\%s\\%s.iot", cdvdman_settings.smb_prefix, cdvdman_settings.filename);
+        else
+            sprintf(path, "\\%s.iot", cdvdman_settings.filename);
+    }
+
+    // smb_OpenAndX() only opens existing files, the frontend creates it.
+    if (smb_OpenAndX(path, (u8 *)&fid, 1) <= 0)
+        return SCECdErTRMOPN;
+
+    result = smb_WriteFile(fid, 0, 0, (void *)buffer, size) == (int)size ? SCECdErNO : SCECdErREAD;
+
+    WaitSema(smb_io_sema);
+    smb_Close(fid);
+    SignalSema(smb_io_sema);
+
+    return result;
+}
+#endif
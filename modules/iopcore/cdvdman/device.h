@@ -8,3 +8,6 @@ void DeviceUnmount(void); // Called when OPL is shutting down.
 void DeviceStop(void);    // Called before the PS2 is to be shut down.
 
 int DeviceReadSectors(u64 lsn, void *buffer, unsigned int sectors);
+#ifdef __IO_TRACE
+int DeviceWriteTrace(const void *buffer, unsigned int size); // Overwrites the I/O trace file. Called before DeviceLock().
+#endif
@@ -9,7 +9,11 @@
 #include "ioplib_util.h"
 #include "cdvdman_opl.h"
 #include "cdvd_config.h"
+#include "iotrace.h"
 #include "device.h"
+#include "mediatiming.h"
+#include "ps2logo.h"
+#include "zsoread.h"
 
 #include <loadcore.h>
 #include <stdio.h>
@@ -64,8 +68,13 @@ struct SteamingData
     unsigned short int StStreamed;
     unsigned short int StStat;
     unsigned short int StIsReading;
+    unsigned short int StFillsize; // Sectors of the read in progress
+    unsigned short int StIsPaused;
+    unsigned short int StUnderruns; // Times that sceCdStRead() had to wait for data
     void *StIOP_bufaddr;
     u32 Stlsn;
+    u32 StFillStart;    // When the read in progress started, in IOP clock ticks
+    u32 StFillTicksMax; // Longest read
 };
 
 typedef struct
@@ -78,6 +87,7 @@ typedef struct
     u32 cdread_lba;
     u32 cdread_sectors;
     u16 sector_size;
+    u8 cdread_caller; // IOTRACE_CALLER_*
     void *cdread_buf;
 } cdvdman_status_t;
 
@@ -100,8 +110,9 @@ typedef void (*StmCallback_t)(void);
 
 // Internal (common) function prototypes
 extern void SetStm0Callback(StmCallback_t callback);
-extern int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf);
-extern int cdvdman_SyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf);
+extern int cdvdman_Read(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode, u8 caller);
+extern int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller);
+extern int cdvdman_SyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller);
 extern int cdvdman_sendSCmd(u8 cmd, const void *in, u16 in_size, void *out, u16 out_size);
 extern void cdvdman_cb_event(int reason);
 
@@ -109,6 +120,13 @@ extern void cdvdman_init(void);
 extern void cdvdman_fs_init(void);
 extern void cdvdman_searchfile_init(void);
 extern void cdvdman_initdev(void);
+extern int cdvdman_IsFsvBuf(const void *buf);
+
+#ifdef __IO_TRACE
+extern u32 IoTraceClock(void);
+extern void IoTraceRecord(u32 start, u32 lsn, u32 sectors, u16 sector_size, u8 caller, int err);
+extern void IoTraceFlush(void);
+#endif
 
 extern struct CDVDMAN_SETTINGS_TYPE cdvdman_settings;
 
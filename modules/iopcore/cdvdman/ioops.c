@@ -282,7 +282,7 @@ static int cdrom_read(iop_file_t *f, void *buf, int size)
             nbytes = 2048 - offset;
             if (size < nbytes)
                 nbytes = size;
-            while (sceCdRead(fh->lsn + (fh->position / 2048), 1, cdvdman_fs_buf, NULL) == 0)
+            while (cdvdman_Read(fh->lsn + (fh->position / 2048), 1, cdvdman_fs_buf, NULL, IOTRACE_CALLER_IOOPS) == 0)
                 DelayThread(10000);
 
             fh->position += nbytes;
@@ -298,7 +298,7 @@ static int cdrom_read(iop_file_t *f, void *buf, int size)
         if ((nsectors = size / 2048) > 0) {
             nbytes = nsectors * 2048;
 
-            while (sceCdRead(fh->lsn + (fh->position / 2048), nsectors, buf, NULL) == 0)
+            while (cdvdman_Read(fh->lsn + (fh->position / 2048), nsectors, buf, NULL, IOTRACE_CALLER_IOOPS) == 0)
                 DelayThread(10000);
 
             buf += nbytes;
@@ -311,7 +311,7 @@ static int cdrom_read(iop_file_t *f, void *buf, int size)
 
         // Phase 3: read any remaining data that isn't divisible by 2048.
         if ((nbytes = size) > 0) {
-            while (sceCdRead(fh->lsn + (fh->position / 2048), 1, cdvdman_fs_buf, NULL) == 0)
+            while (cdvdman_Read(fh->lsn + (fh->position / 2048), 1, cdvdman_fs_buf, NULL, IOTRACE_CALLER_IOOPS) == 0)
                 DelayThread(10000);
 
             fh->position += nbytes;
@@ -397,7 +397,7 @@ static int cdrom_dread(iop_file_t *f, iox_dirent_t *dirent)
 
     DPRINTF("cdrom_dread fh->lsn=%lu\n", fh->lsn);
 
-    if ((r = sceCdRead(fh->lsn, 1, cdvdman_fs_buf, NULL)) == 1) {
+    if ((r = cdvdman_Read(fh->lsn, 1, cdvdman_fs_buf, NULL, IOTRACE_CALLER_IOOPS)) == 1) {
         sceCdSync(0);
 
         do {
@@ -585,6 +585,11 @@ void *sceGetFsvRbuf(void)
     return cdvdman_fs_buf;
 }
 
+int cdvdman_IsFsvBuf(const void *buf)
+{
+    return (PHYSADDR(buf) >= PHYSADDR(cdvdman_fs_buf) && PHYSADDR(buf) < PHYSADDR(&cdvdman_fs_buf[sizeof(cdvdman_fs_buf)]));
+}
+
 //-------------------------------------------------------------------------
 void cdvdman_initdev(void)
 {
@@ -0,0 +1,73 @@
+/*
+  Copyright 2009-2010, jimmikaelkael
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  I/O trace of the disc image reads (see common/iotrace.h), only built with IO_TRACE=1.
+*/
+
+#include "internal.h"
+#include "device.h"
+#include "iotrace.h"
+
+// The file is written as-is, so keep the ring in a buffer of the size of the file.
+static union
+{
+    struct iotrace_file file;
+    u8 raw[IOTRACE_FILE_SIZE];
+} trace __attribute__((aligned(64)));
+
+u32 IoTraceClock(void)
+{
+    iop_sys_clock_t clock;
+
+    GetSystemTime(&clock);
+    return (clock.hi << (32 - IOTRACE_TIME_SHIFT)) | (clock.lo >> IOTRACE_TIME_SHIFT);
+}
+
+void IoTraceRecord(u32 start, u32 lsn, u32 sectors, u16 sector_size, u8 caller, int err)
+{
+    struct iotrace_header *header = &trace.file.header;
+    struct iotrace_record *record;
+    u32 latency;
+    int OldState;
+
+    latency = IoTraceClock() - start;
+
+    CpuSuspendIntr(&OldState);
+
+    record = &trace.file.records[header->next];
+    if (++header->next == IOTRACE_ENTRIES)
+        header->next = 0;
+    if (header->count < IOTRACE_ENTRIES)
+        header->count++;
+    else
+        header->dropped++;
+
+    record->time = start;
+    record->lsn = lsn;
+    record->sectors = sectors;
+    record->latency = latency > 0xFFFF ? 0xFFFF : latency;
+    record->caller = caller | (err != SCECdErNO ? IOTRACE_ERROR : 0);
+    record->size = sector_size == 2340 ? IOTRACE_SIZE_2340 : (sector_size == 2328 ? IOTRACE_SIZE_2328 : IOTRACE_SIZE_2048);
+
+    CpuResumeIntr(OldState);
+}
+
+// Called when OPL shuts down, before the device is locked.
+void IoTraceFlush(void)
+{
+    struct iotrace_header *header = &trace.file.header;
+
+    header->magic = IOTRACE_MAGIC;
+    header->version = IOTRACE_VERSION;
+    header->record_size = sizeof(struct iotrace_record);
+    header->layer1_start = cdvdman_settings.common.layer1_start;
+    header->flags = cdvdman_settings.common.flags;
+    header->media = cdvdman_settings.common.media;
+    header->zso_cache = cdvdman_settings.common.zso_cache;
+
+    DPRINTF("IoTraceFlush: %lu records, %lu dropped\n", header->count, header->dropped);
+    if (DeviceWriteTrace(trace.raw, IOTRACE_FILE_SIZE) != SCECdErNO)
+        DPRINTF("IoTraceFlush: cannot write the trace file.\n");
+}
@@ -0,0 +1,136 @@
+/*
+  Copyright 2009-2010, jimmikaelkael
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Timing model of the disc drive, for IOPCORE_COMPAT_ACCU_READS.
+  Tracks the position of the pick-up and returns how long the drive would take to seek to and transfer each read.
+*/
+
+#include <tamtypes.h>
+
+#include "cdvd_config.h"
+#include "mediatiming.h"
+
+/*  The drive spins the disc at a constant angular velocity (CAV), so the transfer rate grows with the radius.
+    Data is written at a constant density, so the radius of a sector grows with the square root of its position:
+        r(lsn)^2 = inner_radius^2 + (outer_radius^2 - inner_radius^2) * lsn / layer_sectors
+    Layer 1 of dual-layer DVDs uses an opposite track path: it starts at the outer radius and ends at the inner radius.
+
+    A read that starts shortly after the pick-up, within one revolution, waits for the data in between to pass under it.
+    Anything else costs a seek, which grows with the square root of the distance, plus half a revolution on average.
+
+    All times are in IOP clock ticks (36.864MHz). */
+typedef struct
+{
+    u16 inner_radius;    // In 0.01mm, at the first sector
+    u16 outer_radius;    // In 0.01mm, at the last sector of a full layer
+    u32 layer_sectors;   // Sectors of a full layer
+    u32 inner_ticks;     // Per sector, at the inner radius
+    u32 rev_ticks;       // Per revolution
+    u32 seek_min_ticks;  // Shortest seek
+    u32 seek_full_ticks; // Full-stroke seek
+    u32 layer_ticks;     // Focus jump to the other layer
+} media_profile_t;
+
+/*  CD: 80 minutes. 900KB/s at the inner radius, as measured with SCECdSpinMax (AKuHAK), up to 2100KB/s at the outer radius.
+        About 21 sectors per revolution at the outer radius (1.3m/s per 1x), so 20ms per revolution.
+    DVD: 4x CAV. 2200KB/s at the inner radius (AKuHAK), up to 5300KB/s at the outer radius.
+        About 70 sectors per revolution at the outer radius (3.49m/s per 1x), so 26.5ms per revolution.
+    Seeks take 20ms at least and 200ms (CD) or 230ms (DVD) for a full stroke, plus half a revolution.
+    Jumping to the other layer adds 60ms.
+    The first sectors get the same rates as the former flat model. */
+static const media_profile_t media_profiles[2] = {
+    {2500, 5800, 360000, 81920, 741000, 737280, 7372800, 0},        // PS2 CD
+    {2400, 5800, 2295104, 33512, 979000, 737280, 8478720, 2211840}, // PS2 DVD
+};
+
+static u32 head_lsn = 0;   // Next sector under the pick-up
+static int head_layer = 0; // Layer of the last sector read, which head_lsn may be past the end of
+
+static const media_profile_t *MediaProfile(const struct cdvdman_settings_common *settings)
+{
+    return &media_profiles[settings->media == 0x12 ? 0 : 1];
+}
+
+static int MediaLayer(const struct cdvdman_settings_common *settings, u32 lsn)
+{
+    return (settings->layer1_start != 0 && lsn >= settings->layer1_start);
+}
+
+static u32 isqrt(u32 x)
+{
+    u32 root = 0, bit = 1 << 30;
+
+    while (bit > x)
+        bit >>= 2;
+
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else
+            root >>= 1;
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+static u32 MediaRadius(const struct cdvdman_settings_common *settings, const media_profile_t *profile, u32 lsn)
+{
+    u32 inner2, outer2, pos, frac;
+
+    if (MediaLayer(settings, lsn)) {
+        // Opposite track path, back from where layer 0 ended.
+        pos = lsn - settings->layer1_start;
+        pos = pos < settings->layer1_start ? settings->layer1_start - pos : 0;
+    } else
+        pos = lsn;
+
+    // Position within the layer, in 1/4096. The products stay within 32 bits.
+    frac = pos / (profile->layer_sectors >> 12);
+    if (frac > 4096)
+        frac = 4096;
+
+    inner2 = profile->inner_radius * profile->inner_radius;
+    outer2 = profile->outer_radius * profile->outer_radius;
+    return isqrt(inner2 + ((outer2 - inner2) >> 12) * frac);
+}
+
+static u32 MediaSectorTicks(const media_profile_t *profile, u32 radius)
+{
+    return profile->inner_ticks * profile->inner_radius / radius;
+}
+
+u32 MediaTimingRead(const struct cdvdman_settings_common *settings, u32 lsn, u32 sectors)
+{
+    const media_profile_t *profile = MediaProfile(settings);
+    u32 radius, head_radius, sector_ticks, distance, ticks;
+
+    radius = MediaRadius(settings, profile, lsn);
+    sector_ticks = MediaSectorTicks(profile, radius);
+
+    if (MediaLayer(settings, lsn) == head_layer && lsn >= head_lsn && lsn - head_lsn <= profile->rev_ticks / sector_ticks) {
+        // Close ahead on the same track: wait for it to pass under the pick-up.
+        ticks = (lsn - head_lsn) * sector_ticks;
+    } else {
+        head_radius = MediaRadius(settings, profile, head_lsn);
+        distance = radius > head_radius ? radius - head_radius : head_radius - radius;
+
+        // Seek time grows with the square root of the distance, in 1/256 of a full stroke.
+        ticks = profile->seek_min_ticks + ((profile->seek_full_ticks - profile->seek_min_ticks) >> 8) * isqrt((distance << 16) / (profile->outer_radius - profile->inner_radius));
+        ticks += profile->rev_ticks / 2;
+        if (MediaLayer(settings, lsn) != head_layer)
+            ticks += profile->layer_ticks;
+    }
+
+    // Transfer, at the rate of the middle of the read.
+    sector_ticks = MediaSectorTicks(profile, MediaRadius(settings, profile, lsn + sectors / 2));
+    ticks = (sectors > (0xFFFFFFFF - ticks) / sector_ticks) ? 0xFFFFFFFF : ticks + sectors * sector_ticks;
+
+    head_lsn = lsn + sectors;
+    head_layer = MediaLayer(settings, sectors != 0 ? head_lsn - 1 : lsn);
+
+    return ticks;
+}
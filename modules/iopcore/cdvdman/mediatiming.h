@@ -0,0 +1,10 @@
+#ifndef __CDVDMAN_MEDIATIMING__
+#define __CDVDMAN_MEDIATIMING__
+
+#include <tamtypes.h>
+#include "cdvd_config.h"
+
+/* Returns how long the drive would take to read the sectors, in IOP clock ticks, and moves the pick-up after them. */
+extern u32 MediaTimingRead(const struct cdvdman_settings_common *settings, u32 lsn, u32 sectors);
+
+#endif
@@ -24,7 +24,7 @@ int sceCdSync(int mode)
 }
 
 //-------------------------------------------------------------------------
-int sceCdRead(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode)
+int cdvdman_Read(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode, u8 caller)
 {
     int result;
 
@@ -43,14 +43,21 @@ int sceCdRead(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode)
     DPRINTF("sceCdRead lsn=%d sectors=%d sector_size=%d buf=%08x\n", (int)lsn, (int)sectors, (int)sector_size, (int)buf);
 
     if ((!(cdvdman_settings.common.flags & IOPCORE_COMPAT_ALT_READ)) || QueryIntrContext()) {
-        result = cdvdman_AsyncRead(lsn, sectors, sector_size, buf);
+        result = cdvdman_AsyncRead(lsn, sectors, sector_size, buf, caller);
     } else {
-        result = cdvdman_SyncRead(lsn, sectors, sector_size, buf);
+        result = cdvdman_SyncRead(lsn, sectors, sector_size, buf, caller);
     }
 
     return result;
 }
 
+//-------------------------------------------------------------------------
+int sceCdRead(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode)
+{
+    // CDVDFSV reads for the EE through the buffer of sceGetFsvRbuf(). The cdrom device uses cdvdman_Read().
+    return cdvdman_Read(lsn, sectors, buf, mode, cdvdman_IsFsvBuf(buf) ? IOTRACE_CALLER_READEE : IOTRACE_CALLER_CDREAD);
+}
+
 //-------------------------------------------------------------------------
 int sceCdReadCdda(u32 lsn, u32 sectors, void *buf, sceCdRMode *mode)
 {
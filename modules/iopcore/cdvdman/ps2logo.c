@@ -0,0 +1,49 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  PS2LOGO Decryptor algorithm; based on misfire's code (https://github.com/mlafeldt/ps2logo)
+  The PS2 logo is stored within the first 12 sectors, scrambled.
+  This algorithm exploits the characteristic that the value used for scrambling will be recorded,
+  when it is XOR'ed against a black pixel. The first pixel is black, hence the value of the first byte
+  was the value used for scrambling.
+*/
+
+#include <tamtypes.h>
+
+#include "ps2logo.h"
+
+#define LOGO_SECTORS 12
+
+static u8 logo_key = 0;
+
+static void PS2LogoUnscramble(u8 *logo, u32 size)
+{
+    u32 *words, key, i;
+
+    if (((u32)logo & 3) == 0) {
+        // 4 bytes at once: XOR, then rotate each byte left by 3.
+        key = logo_key * 0x01010101;
+        words = (u32 *)logo;
+        for (i = 0; i < size / 4; i++) {
+            u32 word = words[i] ^ key;
+            words[i] = ((word << 3) & 0xF8F8F8F8) | ((word >> 5) & 0x07070707);
+        }
+    } else {
+        for (i = 0; i < size; i++) {
+            logo[i] ^= logo_key;
+            logo[i] = (logo[i] << 3) | (logo[i] >> 5);
+        }
+    }
+}
+
+void PS2LogoRead(u32 lsn, unsigned int sectors, u8 *buf)
+{
+    // Only the sectors of the logo, even if the read goes on past it.
+    if (lsn < LOGO_SECTORS) {
+        if (lsn == 0) // First sector? Copy the first byte as the value for unscrambling the logo.
+            logo_key = buf[0];
+        if (logo_key != 0)
+            PS2LogoUnscramble(buf, ((sectors < LOGO_SECTORS - lsn) ? sectors : LOGO_SECTORS - lsn) * 2048);
+    }
+}
@@ -0,0 +1,9 @@
+#ifndef __CDVDMAN_PS2LOGO__
+#define __CDVDMAN_PS2LOGO__
+
+#include <tamtypes.h>
+
+/* Unscrambles the sectors of the PS2 logo within the sectors read, once read into the buffer. */
+extern void PS2LogoRead(u32 lsn, unsigned int sectors, u8 *buf);
+
+#endif
@@ -755,8 +755,10 @@ int smb_WriteFile(u16 FID, u32 offsetlow, u32 offsethigh, void *writebuf, int nb
         toWrite = remaining > CLIENT_MAX_XMIT_SIZE ? CLIENT_MAX_XMIT_SIZE : remaining;
 
         result = smb_WriteAndX(FID, offsetlow, offsethigh, ptr, toWrite);
-        if (result <= 0)
+        if (result <= 0) {
+            SIGNALIOSEMA(smb_io_sema);
             return result;
+        }
 
         //Check for and handle overflow.
         if (offsetlow + result < offsetlow)
@@ -6,29 +6,67 @@
 
 #include "internal.h"
 
-static int AllocBank(void **pointer);
+static unsigned int AllocBanks(void **pointer);
 static int ReadSectors(int maxcount, void *buffer);
 static int StFillStreamBuffer(void);
 static void StStartFillStreamBuffer(void);
 
-static unsigned int StmScheduleCb(void *arg)
+static int StFillSema = -1;
+
+/*  The stream buffer is filled from this thread, so that neither the game nor the read thread wait for it.
+    It is woken up whenever there may be room in the buffer, or whenever a read of the stream ends.
+    The reads are still done by the read thread, so the stream and the game's own reads never access the device at the same time. */
+static void StFillThread(void *arg)
 {
-    return ((StFillStreamBuffer() >= 0) ? 0 : 0x00704000);
+    while (1) {
+        WaitSema(StFillSema);
+
+        // If the game is reading, start as soon as it is done.
+        while (StFillStreamBuffer() < 0)
+            WaitEventFlag(cdvdman_stat.intr_ef, 1, WEF_AND, NULL);
+    }
+}
+
+static void StCreateFillThread(void)
+{
+    iop_thread_t thread_param;
+    iop_sema_t smp;
+
+    smp.initial = 0;
+    smp.max = 1;
+    smp.attr = 0;
+    smp.option = 0;
+    StFillSema = CreateSema(&smp);
+
+    thread_param.thread = &StFillThread;
+    thread_param.stacksize = 0x600;
+    thread_param.priority = 0x0f;
+    thread_param.attr = TH_C;
+    thread_param.option = 0xABCD0002;
+    StartThread(CreateThread(&thread_param), NULL);
 }
 
 static void StmCallback(void)
 {
+    iop_sys_clock_t clock;
+    u32 ticks;
     int OldState;
 
     // Only update parameters if the streaming system was reading. Otherwise, this callback might have been triggered by the game reading data (BUG!)
     if (cdvdman_stat.StreamingData.StIsReading) {
+        GetSystemTime(&clock);
+
         CpuSuspendIntr(&OldState);
-        cdvdman_stat.StreamingData.Stlsn += cdvdman_stat.StreamingData.StBanksize;
-        cdvdman_stat.StreamingData.StStreamed += cdvdman_stat.StreamingData.StBanksize;
-        cdvdman_stat.StreamingData.StWritePtr += cdvdman_stat.StreamingData.StBanksize;
+        cdvdman_stat.StreamingData.Stlsn += cdvdman_stat.StreamingData.StFillsize;
+        cdvdman_stat.StreamingData.StStreamed += cdvdman_stat.StreamingData.StFillsize;
+        cdvdman_stat.StreamingData.StWritePtr += cdvdman_stat.StreamingData.StFillsize;
         if (cdvdman_stat.StreamingData.StWritePtr >= cdvdman_stat.StreamingData.StBufmax)
             cdvdman_stat.StreamingData.StWritePtr = 0;
         cdvdman_stat.StreamingData.StIsReading = 0;
+
+        ticks = clock.lo - cdvdman_stat.StreamingData.StFillStart;
+        if (ticks > cdvdman_stat.StreamingData.StFillTicksMax)
+            cdvdman_stat.StreamingData.StFillTicksMax = ticks;
         CpuResumeIntr(OldState);
     }
 
@@ -43,12 +81,15 @@ static void StReset(void)
     cdvdman_stat.StreamingData.StReadPtr = 0;
     cdvdman_stat.StreamingData.StStreamed = 0;
     cdvdman_stat.StreamingData.StIsReading = 0;
+    cdvdman_stat.StreamingData.StIsPaused = 0;
 }
 
-// 0 = OK. <0 = error in sceCdRead. >0 = full buffer.
+// 0 = OK or already reading. <0 = the drive is busy. >0 = full buffer, or not streaming.
 static int StFillStreamBuffer(void)
 {
-    int result, OldState;
+    iop_sys_clock_t clock;
+    unsigned int sectors;
+    int OldState;
     void *ptr;
 
     /* SCEI used a similar design, but their implementation uses a bitmap to mark the filled/empty banks instead
@@ -60,43 +101,32 @@ static int StFillStreamBuffer(void)
         return 0;
     }
 
-    CancelAlarm(&StmScheduleCb, &cdvdman_stat.StreamingData);
-    cdvdman_stat.StreamingData.StIsReading = 1;
-
     // Determine how much more to read.
-    result = AllocBank(&ptr);
+    if (!cdvdman_stat.StreamingData.StStat || cdvdman_stat.StreamingData.StIsPaused || (sectors = AllocBanks(&ptr)) == 0) {
+        CpuResumeIntr(OldState);
+        return 1;
+    }
+
+    cdvdman_stat.StreamingData.StIsReading = 1;
+    cdvdman_stat.StreamingData.StFillsize = sectors;
+    GetSystemTime(&clock);
+    cdvdman_stat.StreamingData.StFillStart = clock.lo;
 
     CpuResumeIntr(OldState);
 
-    if (result == 0) {
-        // iDPRINTF("Stream fill buffer: Stream lsn 0x%08x - %u sectors:%p\n", cdvdman_stat.StreamingData.Stlsn, cdvdman_stat.StreamingData.StBanksize, ptr);
-        if (cdvdman_AsyncRead(cdvdman_stat.StreamingData.Stlsn, cdvdman_stat.StreamingData.StBanksize, 2048, ptr) == 0) {
-            // Failed to start reading.
-            cdvdman_stat.StreamingData.StIsReading = 0;
-            result = -1;
-        } else {
-            result = 0;
-        }
-    } else {
-        iDPRINTF("Stream fill buffer: Stream full.\n");
-        // Nothing else to read.
+    // iDPRINTF("Stream fill buffer: Stream lsn 0x%08x - %u sectors:%p\n", cdvdman_stat.StreamingData.Stlsn, sectors, ptr);
+    if (cdvdman_AsyncRead(cdvdman_stat.StreamingData.Stlsn, sectors, 2048, ptr, IOTRACE_CALLER_STREAM) == 0) {
+        // Failed to start reading.
         cdvdman_stat.StreamingData.StIsReading = 0;
-        result = 1;
+        return -1;
     }
 
-    return result;
+    return 0;
 }
 
 static void StStartFillStreamBuffer(void)
 {
-    iop_sys_clock_t StmScheduleClock;
-
-    if (StFillStreamBuffer() < 0) {
-        DPRINTF("StmCallback: Rescheduling read.\n");
-        StmScheduleClock.lo = 0x00704000;
-        StmScheduleClock.hi = 0;
-        SetAlarm(&StmScheduleClock, &StmScheduleCb, &cdvdman_stat.StreamingData);
-    }
+    SignalSema(StFillSema);
 }
 
 int sceCdStInit(u32 bufmax, u32 bankmax, void *iop_bufaddr)
@@ -105,7 +135,8 @@ int sceCdStInit(u32 bufmax, u32 bankmax, void *iop_bufaddr)
 
     cdvdman_stat.err = SCECdErNO;
 
-    CancelAlarm(&StmScheduleCb, &cdvdman_stat.StreamingData);
+    if (StFillSema < 0)
+        StCreateFillThread();
 
     CpuSuspendIntr(&OldState);
     cdvdman_stat.StreamingData.StBankmax = bankmax;
@@ -121,22 +152,31 @@ int sceCdStInit(u32 bufmax, u32 bankmax, void *iop_bufaddr)
     return 1;
 }
 
-// Must be called from an interrupt-disabled state.
-static int AllocBank(void **pointer)
+/*  Returns the number of sectors to read next, in whole banks. 0 = full buffer.
+    The free banks after the write pointer are read together, as each read to the device has its own overhead.
+    But the read must complete before the game runs out of data, so it is not made larger than the data that is still buffered.
+    Must be called from an interrupt-disabled state. */
+static unsigned int AllocBanks(void **pointer)
 {
-    int result;
+    unsigned int banksize, free, sectors;
 
-    if (cdvdman_stat.StreamingData.StBufmax - cdvdman_stat.StreamingData.StStreamed >= cdvdman_stat.StreamingData.StBanksize) {
-        *pointer = cdvdman_stat.StreamingData.StIOP_bufaddr + cdvdman_stat.StreamingData.StWritePtr * 2048;
-        result = 0;
-    } else {
-        *pointer = NULL;
-        result = -ENOMEM;
-    }
+    banksize = cdvdman_stat.StreamingData.StBanksize;
+    free = (cdvdman_stat.StreamingData.StBufmax - cdvdman_stat.StreamingData.StStreamed) / banksize * banksize;
+    // The write pointer is always at the start of a bank, so this does not cut a bank.
+    if (free > cdvdman_stat.StreamingData.StBufmax - cdvdman_stat.StreamingData.StWritePtr)
+        free = cdvdman_stat.StreamingData.StBufmax - cdvdman_stat.StreamingData.StWritePtr;
 
-    //	iDPRINTF("AllocBank: wrptr: %u, rdptr: %u, streamed: %u\n", cdvdman_stat.StreamingData.StWritePtr, cdvdman_stat.StreamingData.StReadPtr, cdvdman_stat.StreamingData.StStreamed);
+    sectors = cdvdman_stat.StreamingData.StStreamed / banksize * banksize;
+    if (sectors < banksize)
+        sectors = banksize;
+    if (sectors > free)
+        sectors = free;
 
-    return result;
+    *pointer = cdvdman_stat.StreamingData.StIOP_bufaddr + cdvdman_stat.StreamingData.StWritePtr * 2048;
+
+    //	iDPRINTF("AllocBanks: wrptr: %u, rdptr: %u, streamed: %u, sectors: %u\n", cdvdman_stat.StreamingData.StWritePtr, cdvdman_stat.StreamingData.StReadPtr, cdvdman_stat.StreamingData.StStreamed, sectors);
+
+    return sectors;
 }
 
 static int ReadSectorsEE(int maxcount, void *buffer)
@@ -272,6 +312,8 @@ int sceCdStStart(u32 lsn, sceCdRMode *mode)
 
     cdvdman_stat.StreamingData.Stlsn = lsn;
     cdvdman_stat.StreamingData.StStat = 1;
+    cdvdman_stat.StreamingData.StUnderruns = 0;
+    cdvdman_stat.StreamingData.StFillTicksMax = 0;
     StReset();
     SetStm0Callback(&StmCallback);
     CpuResumeIntr(OldState);
@@ -299,7 +341,7 @@ int sceCdStStop(void)
     cdvdman_stat.err = SCECdErNO;
     cdvdman_stat.status = SCECdStatPause;
     if (cdvdman_stat.StreamingData.StStat) {
-        CancelAlarm(&StmScheduleCb, &cdvdman_stat.StreamingData);
+        DPRINTF("StStop: %u underruns, longest read %lu ms\n", cdvdman_stat.StreamingData.StUnderruns, cdvdman_stat.StreamingData.StFillTicksMax / 36864);
 
         CpuSuspendIntr(&OldState);
 
@@ -326,12 +368,11 @@ int sceCdStPause(void)
     cdvdman_stat.err = SCECdErNO;
     cdvdman_stat.status = SCECdStatPause;
     if (cdvdman_stat.StreamingData.StStat) {
-        CancelAlarm(&StmScheduleCb, &cdvdman_stat.StreamingData);
-
         CpuSuspendIntr(&OldState);
-        // Pause.
+        // Pause. The read in progress is discarded, as its callback will not be run.
         SetStm0Callback(NULL);
         cdvdman_stat.StreamingData.StIsReading = 0;
+        cdvdman_stat.StreamingData.StIsPaused = 1;
         CpuResumeIntr(OldState);
 
         sceCdSync(0);
@@ -354,6 +395,7 @@ int sceCdStResume(void)
         CpuSuspendIntr(&OldState);
         // Resume
         SetStm0Callback(&StmCallback);
+        cdvdman_stat.StreamingData.StIsPaused = 0;
         CpuResumeIntr(OldState);
 
         StStartFillStreamBuffer();
@@ -366,11 +408,29 @@ int sceCdStResume(void)
 
 int sceCdStSeek(u32 lsn)
 {
+    u32 buffered;
+    int OldState;
+
     DPRINTF("StSeek: %lu\n", lsn);
 
     cdvdman_stat.err = SCECdErNO;
     cdvdman_stat.status = SCECdStatPause;
     if (cdvdman_stat.StreamingData.StStat) {
+        // If the sector is already in the buffer or is the next to be read, skip to it and keep the rest, along with the read in progress.
+        CpuSuspendIntr(&OldState);
+        buffered = cdvdman_stat.StreamingData.Stlsn - cdvdman_stat.StreamingData.StStreamed;
+        if (!cdvdman_stat.StreamingData.StIsPaused && lsn >= buffered && lsn <= cdvdman_stat.StreamingData.Stlsn) {
+            cdvdman_stat.StreamingData.StReadPtr += lsn - buffered;
+            if (cdvdman_stat.StreamingData.StReadPtr >= cdvdman_stat.StreamingData.StBufmax)
+                cdvdman_stat.StreamingData.StReadPtr -= cdvdman_stat.StreamingData.StBufmax;
+            cdvdman_stat.StreamingData.StStreamed -= lsn - buffered;
+            CpuResumeIntr(OldState);
+
+            StStartFillStreamBuffer();
+            return 1;
+        }
+        CpuResumeIntr(OldState);
+
         return sceCdStStart(lsn, NULL);
     } else {
         return 0;
@@ -398,8 +458,11 @@ int sceCdStRead(u32 sectors, u32 *buffer, u32 mode, u32 *error)
                 SectorsRead = ReadSectors(SectorsToRead, ptr);
             //		DPRINTF(", Read: %u\n", SectorsRead);
 
-            if (SectorsRead == 0)
+            if (SectorsRead == 0) {
                 DPRINTF("StRead: buffer underrun. %u/%lu read.\n", result, sectors);
+                cdvdman_stat.StreamingData.StUnderruns++;
+            } else // Make room for more, in case that the buffer was full and no read is in progress.
+                StStartFillStreamBuffer();
 
             result += SectorsRead;
             // if(mode == STMNBLK) break;
@@ -0,0 +1,109 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Reader of ZSO images: the raw reads of the ZSO decompressor (zso.c), from the device through the sector cache.
+  Also built on the PC by pc/iotrace, which replays the reads of a game through it.
+*/
+
+#include <tamtypes.h>
+#include <sysclib.h>
+#include <cdvdman.h>
+
+#include "../../isofs/zso.h"
+#include "device.h"
+#include "zsoread.h"
+
+// Sector cache to improve IO
+static u8 MAX_SECTOR_CACHE = 0;
+static u8 *sector_cache = NULL;
+static u64 cur_sector = 0xffffffffffffffff;
+
+#ifdef ZSO_CACHE_STATS
+u32 zso_cache_hits, zso_cache_misses;
+#endif
+
+void ZSOSetSectorCache(u8 *cache, u8 sectors)
+{
+    sector_cache = cache;
+    MAX_SECTOR_CACHE = cache != NULL ? sectors : 0;
+    cur_sector = 0xffffffffffffffff;
+}
+
+/*
+  This small improvement will mostly benefit ZSO files.
+  For the same size of an ISO sector, we can have more than one ZSO blocks.
+  If we do a consecutive read of many ISO sectors we will have a huge amount of ZSO sectors ready.
+  Therefore reducing IO access for ZSO files.
+*/
+static int DeviceReadSectorsCached(u64 lsn, void *buffer, unsigned int sectors)
+{
+    if (sectors < MAX_SECTOR_CACHE) { // if MAX_SECTOR_CACHE is 0 then it will act as disabled and passthrough
+        if (cur_sector == 0xffffffffffff || lsn < cur_sector || (lsn + sectors) - cur_sector > MAX_SECTOR_CACHE) {
+            DeviceReadSectors(lsn, sector_cache, MAX_SECTOR_CACHE);
+            cur_sector = lsn;
+#ifdef ZSO_CACHE_STATS
+            zso_cache_misses++;
+        } else {
+            zso_cache_hits++;
+#endif
+        }
+        int pos = lsn - cur_sector;
+        memcpy(buffer, &(sector_cache[pos * 2048]), 2048 * sectors);
+        return SCECdErNO;
+    }
+    int res = DeviceReadSectors(lsn, buffer, sectors);
+    return res;
+}
+
+/*
+  For ZSO we need to be able to read at arbitrary offsets with arbitrary sizes.
+  Since we can only do sector-based reads, this funtions acts as a wrapper.
+  It will do at most 3 IO reads, most of the time only 1.
+*/
+int read_raw_data(u8 *addr, u32 size, u32 offset, u32 shift)
+{
+    u32 o_size = size;
+    u64 lba = offset / (2048 >> shift); // avoid overflow by shifting sector size instead of offset
+    u32 pos = (offset << shift) & 2047; // doesn't matter if it overflows since we only care about the 11 LSB anyways
+
+    // prevent caching if already reading into ZSO index cache
+    int (*ReadSectors)(u64 lsn, void *buffer, unsigned int sectors) = (addr == (u8 *)ziso_idx_cache) ? &DeviceReadSectors : &DeviceReadSectorsCached;
+
+    // read first block if not aligned to sector size
+    if (pos) {
+        int r = MIN(size, (2048 - pos));
+        ReadSectors(lba, ziso_tmp_buf, 1);
+        memcpy(addr, ziso_tmp_buf + pos, r);
+        size -= r;
+        lba++;
+        addr += r;
+    }
+
+    // read intermediate blocks if more than one block is left
+    u32 n_blocks = size / 2048;
+    if (size % 2048)
+        n_blocks++;
+    if (n_blocks > 1) {
+        int r = 2048 * (n_blocks - 1);
+        ReadSectors(lba, addr, n_blocks - 1);
+        size -= r;
+        addr += r;
+        lba += n_blocks - 1;
+    }
+
+    // read remaining data
+    if (size) {
+        ReadSectors(lba, ziso_tmp_buf, 1);
+        memcpy(addr, ziso_tmp_buf, size);
+        size = 0;
+    }
+
+    // return remaining size
+    return o_size - size;
+}
+
+int DeviceReadSectorsCompressed(u64 lsn, void *addr, unsigned int count)
+{
+    return (ziso_read_sector(addr, (u32)lsn, count) == count) ? SCECdErNO : SCECdErEOM;
+}
@@ -0,0 +1,16 @@
+#ifndef __CDVDMAN_ZSOREAD__
+#define __CDVDMAN_ZSOREAD__
+
+#include <tamtypes.h>
+
+/* Sets the buffer of the sector cache, which holds the given number of sectors. 0 disables the cache. */
+extern void ZSOSetSectorCache(u8 *cache, u8 sectors);
+
+/* Reads sectors of a ZSO image, once ziso_init() was called. */
+extern int DeviceReadSectorsCompressed(u64 lsn, void *addr, unsigned int count);
+
+#ifdef ZSO_CACHE_STATS
+extern u32 zso_cache_hits, zso_cache_misses;
+#endif
+
+#endif
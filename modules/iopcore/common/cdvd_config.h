@@ -61,7 +61,11 @@ struct cdvdman_settings_smb
     };
 } __attribute__((packed));
 
+#ifdef __IO_TRACE
+#define BDM_MAX_FILES 2 // ISO, I/O trace
+#else
 #define BDM_MAX_FILES 1  // ISO
+#endif
 #define BDM_MAX_FRAGS 64 // 64 * 8bytes = 512bytes
 
 struct cdvdman_fragfile
@@ -76,6 +80,7 @@ struct cdvdman_settings_bdm
 
     // Fragmented files:
     // 0 = ISO
+    // 1 = I/O trace (IO_TRACE=1 only)
     struct cdvdman_fragfile fragfile[BDM_MAX_FILES];
 
     // Device ID of the block device to bind to.
@@ -0,0 +1,77 @@
+#ifndef __IOTRACE_H__
+#define __IOTRACE_H__
+
+#include <tamtypes.h>
+
+/*  I/O trace of the disc image reads, for OPL built with IO_TRACE=1.
+
+    cdvdman records every read into a ring and writes it out when OPL shuts down (IGR or exit).
+    The frontend pre-allocates the trace file next to the disc image: <image>.iot, where <image>
+    has no part number for split (USBLD) images. cdvdman can only overwrite it, not create it.
+    pc/iotrace replays the trace against the disc image on a PC.
+
+    The file is the ring as it was in IOP memory, in little-endian byte order.
+    When the ring wrapped around (dropped != 0), the oldest record is at index next. */
+
+#define IOTRACE_MAGIC      0x52544F49 // "IOTR"
+#define IOTRACE_VERSION    1
+#define IOTRACE_ENTRIES    2048
+#define IOTRACE_CLOCK      36864000 // The IOP clock, in Hz
+#define IOTRACE_TIME_SHIFT 8        // Times are in IOP clock cycles >> IOTRACE_TIME_SHIFT (about 6.9us)
+
+// Who requested the read
+enum IOTRACE_CALLER {
+    IOTRACE_CALLER_CDREAD = 0, // sceCdRead() from the game's IOP modules
+    IOTRACE_CALLER_READEE,     // sceCdRead() from CDVDFSV, on behalf of the EE
+    IOTRACE_CALLER_STREAM,     // Streaming (sceCdSt*)
+    IOTRACE_CALLER_IOOPS,      // The cdrom device (open, read)
+    IOTRACE_CALLER_SEARCH,     // sceCdSearchFile() and the layer 1 probe
+
+    IOTRACE_CALLER_COUNT
+};
+
+#define IOTRACE_CALLER_MASK 0x7F
+#define IOTRACE_ERROR       0x80 // Set in caller if the read failed
+
+// Sector sizes
+enum IOTRACE_SIZE {
+    IOTRACE_SIZE_2048 = 0,
+    IOTRACE_SIZE_2328,
+    IOTRACE_SIZE_2340
+};
+
+struct iotrace_header
+{
+    u32 magic;
+    u16 version;
+    u16 record_size;
+    u32 count;   // Valid records
+    u32 next;    // Index of the next record to write
+    u32 dropped; // Records overwritten after the ring was full
+    u32 layer1_start;
+    u16 flags; // IOPCORE_COMPAT_* and others, from cdvdman_settings_common
+    u8 media;
+    u8 zso_cache;
+    u32 reserved;
+} __attribute__((packed));
+
+struct iotrace_record
+{
+    u32 time; // When the read started
+    u32 lsn;
+    u32 sectors;
+    u16 latency; // Time taken, saturated at 0xFFFF
+    u8 caller;   // IOTRACE_CALLER_*, with IOTRACE_ERROR
+    u8 size;     // IOTRACE_SIZE_*
+} __attribute__((packed));
+
+struct iotrace_file
+{
+    struct iotrace_header header;
+    struct iotrace_record records[IOTRACE_ENTRIES];
+} __attribute__((packed));
+
+// The file is written in whole 2048-byte sectors.
+#define IOTRACE_FILE_SIZE ((sizeof(struct iotrace_file) + 2047) & ~2047)
+
+#endif
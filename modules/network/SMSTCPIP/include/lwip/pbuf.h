@@ -55,10 +55,11 @@ typedef enum {
 
 /* Definitions for the pbuf flag field (these are not the flags that
    are passed to pbuf_alloc()). */
-#define PBUF_FLAG_RAM  0x00U /* Flags that pbuf data is stored in RAM */
-#define PBUF_FLAG_ROM  0x01U /* Flags that pbuf data is stored in ROM */
-#define PBUF_FLAG_POOL 0x02U /* Flags that the pbuf comes from the pbuf pool */
-#define PBUF_FLAG_REF  0x04U /* Flags thet the pbuf payload refers to RAM */
+#define PBUF_FLAG_RAM    0x00U /* Flags that pbuf data is stored in RAM */
+#define PBUF_FLAG_ROM    0x01U /* Flags that pbuf data is stored in ROM */
+#define PBUF_FLAG_POOL   0x02U /* Flags that the pbuf comes from the pbuf pool */
+#define PBUF_FLAG_REF    0x04U /* Flags thet the pbuf payload refers to RAM */
+#define PBUF_FLAG_CUSTOM 0x08U /* Flags that the pbuf is a struct pbuf_custom, owned by the network driver */
 
 /** indicates this packet was broadcast on the link */
 #define PBUF_FLAG_LINK_BROADCAST 0x80U
@@ -94,6 +95,15 @@ struct pbuf
     u16_t ref;
 };
 
+/** A pbuf whose storage belongs to the network driver, which fills it in itself.
+ * The payload must directly follow this structure, so that pbuf_header() can reveal headers again.
+ * When the last reference is dropped, custom_free_function is called instead of freeing the pbuf. */
+struct pbuf_custom
+{
+    struct pbuf pbuf;
+    void (*custom_free_function)(struct pbuf *p);
+};
+
 /* pbuf_init():
 
    Initializes the pbuf module. The num parameter determines how many
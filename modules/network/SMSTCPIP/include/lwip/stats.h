@@ -63,6 +63,10 @@ struct stats_mem
     mem_size_t used;
     mem_size_t max;
     mem_size_t err;
+
+    u16_t size;  /* Size of an element, including overhead. */
+    u32_t since; /* Clock of when the pool became exhausted, 0 if it is not. */
+    u32_t time;  /* Clock ticks spent exhausted. */
 };
 
 struct stats_pbuf
@@ -74,6 +78,10 @@ struct stats_pbuf
 
     u16_t alloc_locked;
     u16_t refresh_locked;
+
+    u16_t size;
+    u32_t since;
+    u32_t time;
 };
 
 struct stats_syselem
@@ -107,11 +115,33 @@ extern struct stats_ lwip_stats;
 
 
 void stats_init(void);
+void stats_display(void);
+u32_t stats_clock(void);
+
+/* Clock ticks per millisecond: the IOP clock (36.864MHz) divided by 1024. */
+#define STATS_CLOCK_PER_MS 36
 
 #define STATS_INC(x) ++lwip_stats.x
+
+/* Marks the start and end of a period, during which a pool had no free elements. */
+#define STATS_EXHAUSTED(x)                      \
+    do {                                        \
+        if (lwip_stats.x.since == 0)            \
+            lwip_stats.x.since = stats_clock(); \
+    } while (0)
+#define STATS_REPLENISHED(x)                                         \
+    do {                                                             \
+        if (lwip_stats.x.since != 0) {                               \
+            lwip_stats.x.time += stats_clock() - lwip_stats.x.since; \
+            lwip_stats.x.since = 0;                                  \
+        }                                                            \
+    } while (0)
 #else
 #define stats_init()
+#define stats_display()
 #define STATS_INC(x)
+#define STATS_EXHAUSTED(x)
+#define STATS_REPLENISHED(x)
 #endif /* LWIP_STATS */
 
 #if TCP_STATS
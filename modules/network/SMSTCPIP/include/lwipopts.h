@@ -71,7 +71,11 @@ a lot of data that needs to be copied, this should be set high. */
 /* MEMP_NUM_SYS_TIMEOUT: the number of simulateously active
    timeouts. */
 // Only used by tcpip.c, which will be used for IP reassembly and ARP.
+#ifdef POOL_STATS
+#define MEMP_NUM_SYS_TIMEOUT 2 // Plus the statistics timer
+#else
 #define MEMP_NUM_SYS_TIMEOUT 1
+#endif
 
 /* MEMP_NUM_NETCONN: the number of struct netconns. */
 #ifdef INGAME_DRIVER
@@ -97,7 +101,8 @@ a lot of data that needs to be copied, this should be set high. */
 /* ---------- Pbuf options ---------- */
 /* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
 #ifdef INGAME_DRIVER
-#define PBUF_POOL_SIZE 8
+// The in-game SMAP driver receives into its own buffers, the pool is only its fallback and used for reassembly.
+#define PBUF_POOL_SIZE 4
 #else
 #define PBUF_POOL_SIZE 25
 #endif
@@ -219,9 +224,29 @@ a lot of data that needs to be copied, this should be set high. */
 
 
 /* ---------- Statistics options ---------- */
+#ifdef POOL_STATS
+/* Track the use of the heap and of the pools, including the time that each spent exhausted.
+   The totals are printed every STATS_DISPLAY_INTERVAL ms, for sizing the pools with pc/lwippools.py. */
+#define LWIP_STATS             1
+#define STATS_DISPLAY_INTERVAL 10000
+#else
 #define LWIP_STATS 0
+#endif
 
 #if LWIP_STATS
+#ifdef POOL_STATS
+#define LINK_STATS   0
+#define IP_STATS     0
+#define IPFRAG_STATS 0
+#define ICMP_STATS   0
+#define UDP_STATS    0
+#define TCP_STATS    0
+#define MEM_STATS    1
+#define MEMP_STATS   1
+#define PBUF_STATS   1
+#define SYS_STATS    0
+#define RAW_STATS    0
+#else
 #define LINK_STATS   1
 #define IP_STATS     1
 #define IPFRAG_STATS 1
@@ -233,6 +258,7 @@ a lot of data that needs to be copied, this should be set high. */
 #define PBUF_STATS   1
 #define SYS_STATS    1
 #define RAW_STATS    1
+#endif
 #endif /*LWIP_STATS*/
 
 // Boman666: This define will force the TX-data to be splitted in an even number of TCP-segments. This will significantly increase
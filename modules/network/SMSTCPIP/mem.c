@@ -205,6 +205,7 @@ void mem_init(void)
 
 #if MEM_STATS
     lwip_stats.mem.avail = MEM_SIZE;
+    lwip_stats.mem.size = 1;
 #endif /* MEM_STATS */
 }
 
@@ -242,7 +243,7 @@ void mem_free(void *rmem)
 
 #if MEM_STATS
     lwip_stats.mem.used -= mem->next - ((u8_t *)mem - ram);
-
+    STATS_REPLENISHED(mem);
 #endif /* MEM_STATS */
     plug_holes(mem);
     SYS_ARCH_UNPROTECT(old_level);
@@ -369,6 +370,7 @@ mem_malloc(mem_size_t size)
     LWIP_DEBUGF(MEM_DEBUG | 2, ("mem_malloc: could not allocate %d bytes\n", (int)size));
 #if MEM_STATS
     ++lwip_stats.mem.err;
+    STATS_EXHAUSTED(mem);
 #endif /* MEM_STATS */
     SYS_ARCH_UNPROTECT(old_level);
     return NULL;
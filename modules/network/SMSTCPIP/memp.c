@@ -156,6 +156,7 @@ void memp_init(void)
         lwip_stats.memp[i].used = lwip_stats.memp[i].max =
             lwip_stats.memp[i].err = 0;
         lwip_stats.memp[i].avail = memp_num[i];
+        lwip_stats.memp[i].size = MEM_ALIGN_SIZE(memp_sizes[i] + sizeof(struct memp));
     }
 #endif /* MEMP_STATS */
 
@@ -210,6 +211,9 @@ memp_malloc(memp_t type)
         if (lwip_stats.memp[type].used > lwip_stats.memp[type].max) {
             lwip_stats.memp[type].max = lwip_stats.memp[type].used;
         }
+        if (memp_tab[type] == NULL) {
+            STATS_EXHAUSTED(memp[type]);
+        }
 #endif /* MEMP_STATS */
 #if SYS_LIGHTWEIGHT_PROT
         SYS_ARCH_UNPROTECT(old_level);
@@ -255,6 +259,9 @@ void memp_free(memp_t type, void *mem)
 
 #if MEMP_STATS
     lwip_stats.memp[type].used--;
+    if (memp_tab[type] == NULL) {
+        STATS_REPLENISHED(memp[type]);
+    }
 #endif /* MEMP_STATS */
 
     memp->next = memp_tab[type];
@@ -106,6 +106,7 @@ void pbuf_init(void)
 
 #if PBUF_STATS
     lwip_stats.pbuf.avail = PBUF_POOL_SIZE;
+    lwip_stats.pbuf.size = PBUF_POOL_BUFSIZE + sizeof(struct pbuf);
 #endif /* PBUF_STATS */
 
     /* Set up ->next pointers to link the pbufs of the pool together */
@@ -173,6 +174,9 @@ pbuf_pool_alloc(void)
         if (lwip_stats.pbuf.used > lwip_stats.pbuf.max) {
             lwip_stats.pbuf.max = lwip_stats.pbuf.used;
         }
+        if (pbuf_pool == NULL) {
+            STATS_EXHAUSTED(pbuf);
+        }
     }
 #endif /* PBUF_STATS */
 
@@ -353,9 +357,12 @@ pbuf_alloc(pbuf_layer l, u16_t length, pbuf_flag flag)
 
 
 #if PBUF_STATS
-#define DEC_PBUF_STATS          \
-    do {                        \
-        --lwip_stats.pbuf.used; \
+#define DEC_PBUF_STATS               \
+    do {                             \
+        --lwip_stats.pbuf.used;      \
+        if (pbuf_pool == NULL) {     \
+            STATS_REPLENISHED(pbuf); \
+        }                            \
     } while (0)
 #else /* PBUF_STATS */
 #define DEC_PBUF_STATS
@@ -363,9 +370,9 @@ pbuf_alloc(pbuf_layer l, u16_t length, pbuf_flag flag)
 
 #define PBUF_POOL_FAST_FREE(p) \
     do {                       \
+        DEC_PBUF_STATS;        \
         p->next = pbuf_pool;   \
         pbuf_pool = p;         \
-        DEC_PBUF_STATS;        \
     } while (0)
 
 #if SYS_LIGHTWEIGHT_PROT
@@ -489,6 +496,13 @@ u8_t pbuf_header(struct pbuf *p, s16_t header_size)
             /* bail out unsuccesfully */
             return 1;
         }
+        /* driver-owned pbuf, the payload follows the structure */
+    } else if (p->flags == PBUF_FLAG_CUSTOM) {
+        p->payload = (u8_t *)p->payload - header_size;
+        if ((u8_t *)p->payload < (u8_t *)p + sizeof(struct pbuf_custom)) {
+            p->payload = payload;
+            return 1;
+        }
         /* pbuf types refering to payloads? */
     } else if (p->flags == PBUF_FLAG_REF || p->flags == PBUF_FLAG_ROM) {
         /* hide a header in the payload? */
@@ -555,7 +569,8 @@ u8_t pbuf_free(struct pbuf *p)
 
     LWIP_ASSERT("pbuf_free: sane flags",
                 p->flags == PBUF_FLAG_RAM || p->flags == PBUF_FLAG_ROM ||
-                    p->flags == PBUF_FLAG_REF || p->flags == PBUF_FLAG_POOL);
+                    p->flags == PBUF_FLAG_REF || p->flags == PBUF_FLAG_POOL ||
+                    p->flags == PBUF_FLAG_CUSTOM);
 
     count = 0;
     /* Since decrementing ref cannot be guaranteed to be a single machine operation
@@ -582,6 +597,9 @@ u8_t pbuf_free(struct pbuf *p)
                 /* a ROM or RAM referencing pbuf */
             } else if (p->flags == PBUF_FLAG_ROM || p->flags == PBUF_FLAG_REF) {
                 memp_free(MEMP_PBUF, p);
+                /* returned to the network driver */
+            } else if (p->flags == PBUF_FLAG_CUSTOM) {
+                ((struct pbuf_custom *)p)->custom_free_function(p);
                 /* p->flags == PBUF_FLAG_RAM */
             } else {
                 SYS_ARCH_UNPROTECT(old_level);
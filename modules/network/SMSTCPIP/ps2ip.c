@@ -25,6 +25,7 @@
 #include "smsutils.h"
 
 #include <lwip/memp.h>
+#include <lwip/stats.h>
 #include <lwip/sys.h>
 #include <lwip/tcpip.h>
 #include <lwip/netif.h>
@@ -299,6 +300,7 @@ int _start(int argc, char **argv)
 
     RegisterLibraryEntries(&_exp_ps2ip);
 
+    stats_init();
     mem_init();
     memp_init();
     pbuf_init();
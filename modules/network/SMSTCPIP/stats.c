@@ -0,0 +1,96 @@
+/**
+ * @file
+ * Statistics of the heap and of the pools.
+ *
+ * Only built with POOL_STATS=1. The use of each pool is printed periodically,
+ * one line per pool, to be collected by pc/lwippools.py:
+ *   lwip: <name> used <used>/<avail> peak <max> fail <err> exhausted <ms> ms size <bytes>
+ * For the heap, the peak is the highest offset reached, which includes any fragmentation.
+ */
+
+#include <thbase.h>
+#include <stdio.h>
+
+#include "lwip/opt.h"
+
+#if LWIP_STATS
+
+#include "lwip/def.h"
+#include "lwip/stats.h"
+#include "lwip/mem.h"
+#include "lwip/memp.h"
+#include "lwip/pbuf.h"
+
+#include "smsutils.h"
+
+struct stats_ lwip_stats;
+
+static const char *memp_names[MEMP_MAX] = {
+    "PBUF",
+    "RAW_PCB",
+    "UDP_PCB",
+    "TCP_PCB",
+    "TCP_PCB_LISTEN",
+    "TCP_SEG",
+    "NETBUF",
+    "NETCONN",
+    "API_MSG",
+    "TCPIP_MSG",
+    "SYS_TIMEOUT"};
+
+static u32_t last_signature;
+
+void stats_init(void)
+{
+    mips_memset(&lwip_stats, 0, sizeof(lwip_stats));
+    last_signature = 0;
+}
+
+u32_t stats_clock(void)
+{
+    iop_sys_clock_t clock;
+
+    GetSystemTime(&clock);
+    // Never 0, which marks a pool that is not exhausted.
+    return ((clock.hi << 22) | (clock.lo >> 10)) | 1;
+}
+
+static u32_t exhausted_ms(u32_t since, u32_t time)
+{
+    if (since != 0)
+        time += stats_clock() - since;
+    return time / STATS_CLOCK_PER_MS;
+}
+
+static void display_pool(const char *name, u32_t used, u32_t avail, u32_t max, u32_t err, u32_t since, u32_t time, u32_t size)
+{
+    printf("lwip: %s used %lu/%lu peak %lu fail %lu exhausted %lu ms size %lu\n", name, used, avail, max, err, exhausted_ms(since, time), size);
+}
+
+void stats_display(void)
+{
+    u32_t signature;
+    int i;
+
+    // Only print when something changed since the last time.
+    signature = lwip_stats.mem.max + lwip_stats.mem.err + lwip_stats.mem.time + lwip_stats.mem.since;
+    signature += lwip_stats.pbuf.max + lwip_stats.pbuf.err + lwip_stats.pbuf.time + lwip_stats.pbuf.since;
+    for (i = 0; i < MEMP_MAX; i++)
+        signature += lwip_stats.memp[i].max + lwip_stats.memp[i].err + lwip_stats.memp[i].time + lwip_stats.memp[i].since;
+    if (signature == last_signature)
+        return;
+    last_signature = signature;
+
+    display_pool("HEAP", lwip_stats.mem.used, lwip_stats.mem.avail, lwip_stats.mem.max, lwip_stats.mem.err,
+                 lwip_stats.mem.since, lwip_stats.mem.time, lwip_stats.mem.size);
+    display_pool("PBUF_POOL", lwip_stats.pbuf.used, lwip_stats.pbuf.avail, lwip_stats.pbuf.max, lwip_stats.pbuf.err,
+                 lwip_stats.pbuf.since, lwip_stats.pbuf.time, lwip_stats.pbuf.size);
+    for (i = 0; i < MEMP_MAX; i++) {
+        if (lwip_stats.memp[i].avail == 0)
+            continue;
+        display_pool(memp_names[i], lwip_stats.memp[i].used, lwip_stats.memp[i].avail, lwip_stats.memp[i].max, lwip_stats.memp[i].err,
+                     lwip_stats.memp[i].since, lwip_stats.memp[i].time, lwip_stats.memp[i].size);
+    }
+}
+
+#endif /* LWIP_STATS */
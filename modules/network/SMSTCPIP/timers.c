@@ -56,6 +56,7 @@
 #include "netif/etharp.h"
 #include "lwip/sys.h"
 #include "lwip/pbuf.h"
+#include "lwip/stats.h"
 
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
@@ -116,12 +117,30 @@ arp_timer(void *arg)
 }
 #endif /* LWIP_ARP */
 
+#if LWIP_STATS
+/**
+ * Timer callback function that prints the statistics and reschedules itself.
+ *
+ * @param arg unused argument
+ */
+static void
+stats_timer(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+    stats_display();
+    sys_timeout(STATS_DISPLAY_INTERVAL, stats_timer, NULL);
+}
+#endif /* LWIP_STATS */
+
 /** Initialize this module */
 void sys_timeouts_init(void)
 {
 #if LWIP_ARP
     sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
 #endif /* LWIP_ARP */
+#if LWIP_STATS
+    sys_timeout(STATS_DISPLAY_INTERVAL, stats_timer, NULL);
+#endif /* LWIP_STATS */
 }
 
 /**
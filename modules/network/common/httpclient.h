@@ -18,6 +18,12 @@ void HttpCloseConnection(s32 HttpSocket);
 
 int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 *mode, const u8 *mtime, const char *uri, char *output, u16 *out_len);
 
+/*  For pipelining: HttpQueueGetRequest() sends a request without waiting for its response.
+    HttpGetResponse() receives the responses, in the order that the requests were sent.
+    If the connection is closed by the server (mode becomes HTTP_CMODE_CLOSED), the requests after that response were not served. */
+int HttpQueueGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 mode, const u8 *mtime, const char *uri);
+int HttpGetResponse(s32 HttpSocket, s8 *mode, char *output, u16 *out_len);
+
 #define HTTP_CLIENT_SERVER_NAME_MAX 30
 #define HTTP_CLIENT_USER_AGENT_MAX  16
 #define HTTP_CLIENT_URI_MAX         128
@@ -26,6 +32,8 @@ enum HTTP_CLIENT_CMD {
     HTTP_CLIENT_CMD_CONN_ESTAB,
     HTTP_CLIENT_CMD_CONN_CLOSE,
     HTTP_CLIENT_CMD_SEND_GET_REQ,
+    HTTP_CLIENT_CMD_QUEUE_GET_REQ,
+    HTTP_CLIENT_CMD_GET_RESPONSE,
 };
 
 struct HttpClientConnEstabArgs
@@ -52,6 +60,15 @@ struct HttpClientSendGetArgs
     void *output;
 };
 
+struct HttpClientGetResponseArgs
+{
+    s32 socket;
+    s8 mode;
+    u8 padding;
+    u16 out_len;
+    void *output;
+};
+
 struct HttpClientSendGetResult
 {
     s32 result;
@@ -67,4 +84,6 @@ struct HttpClientSendGetResult
 #define I_HttpEstabConnection DECLARE_IMPORT(4, HttpEstabConnection)
 #define I_HttpCloseConnection DECLARE_IMPORT(5, HttpCloseConnection)
 #define I_HttpSendGetRequest  DECLARE_IMPORT(6, HttpSendGetRequest)
+#define I_HttpQueueGetRequest DECLARE_IMPORT(7, HttpQueueGetRequest)
+#define I_HttpGetResponse     DECLARE_IMPORT(8, HttpGetResponse)
 #endif
@@ -73,10 +73,11 @@ typedef enum {
 
 /* Definitions for the pbuf flag field (these are not the flags that
    are passed to pbuf_alloc()). */
-#define PBUF_FLAG_RAM  0x00 /* Flags that pbuf data is stored in RAM */
-#define PBUF_FLAG_ROM  0x01 /* Flags that pbuf data is stored in ROM */
-#define PBUF_FLAG_POOL 0x02 /* Flags that the pbuf comes from the pbuf pool */
-#define PBUF_FLAG_REF  0x04 /* Flags thet the pbuf payload refers to RAM */
+#define PBUF_FLAG_RAM    0x00 /* Flags that pbuf data is stored in RAM */
+#define PBUF_FLAG_ROM    0x01 /* Flags that pbuf data is stored in ROM */
+#define PBUF_FLAG_POOL   0x02 /* Flags that the pbuf comes from the pbuf pool */
+#define PBUF_FLAG_REF    0x04 /* Flags thet the pbuf payload refers to RAM */
+#define PBUF_FLAG_CUSTOM 0x08 /* Flags that the pbuf is a struct pbuf_custom, owned by the network driver */
 
 struct pbuf
 {
@@ -106,6 +107,14 @@ struct pbuf
     u16 ref;
 };
 
+/* A pbuf whose storage belongs to the network driver. The payload must directly follow this structure.
+   When the last reference is dropped, custom_free_function is called instead of freeing the pbuf. */
+struct pbuf_custom
+{
+    struct pbuf pbuf;
+    void (*custom_free_function)(struct pbuf *p);
+};
+
 /* From include/ipv4/lwip/ip_addr.h:  */
 
 struct ip_addr
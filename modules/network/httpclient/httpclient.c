@@ -1,5 +1,5 @@
 /*  Simple HTTP client for retrieving files.
-    Support for the "chunked" encoding has not been implemented.    */
+    Connections can be persistent and requests can be pipelined: several requests may be sent before the responses are received, in order.    */
 
 #include <stdio.h>
 #include <errno.h>
@@ -8,8 +8,25 @@
 
 #include "httpclient.h"
 
+#define HTTP_RECV_BUFFER_SIZE 512 // Not a really great design, but this must be long enough for the longest line in the HTTP entity.
+
+/*  Received data that was not consumed yet. With pipelined requests, the data after the end of a response belongs to the next response,
+    so it is kept for the connection. Only one connection is used at a time. */
+static char RecvBuffer[HTTP_RECV_BUFFER_SIZE];
+static int RecvSocket = -1;
+static unsigned short int RecvStart, RecvEnd;
+
+static void ResetRecvBuffer(int socket)
+{
+    RecvSocket = socket;
+    RecvStart = 0;
+    RecvEnd = 0;
+}
+
 void HttpCloseConnection(s32 HttpSocket)
 {
+    if (HttpSocket == RecvSocket)
+        RecvSocket = -1;
     shutdown(HttpSocket, SHUT_RDWR);
     closesocket(HttpSocket);
 }
@@ -49,33 +66,141 @@ static int GetData(int socket, char *buffer, int length)
 {
     struct timeval timeout;
     fd_set readfds;
-    char *pointer;
-    int remaining, ToRead, result;
 
-    for (remaining = length, pointer = buffer; remaining > 0;) {
-        ToRead = remaining;
+    // This safeguards against a deadlock, if the TCP connection gets broken for long enough. Long enough for the RST packet from the other side gets lost.
+    timeout.tv_sec = 10;
+    timeout.tv_usec = 0;
+    FD_ZERO(&readfds);
+    FD_SET(socket, &readfds);
+    if (select(socket + 1, &readfds, NULL, NULL, &timeout) <= 0)
+        return -1;
 
-        // This safeguards against a deadlock, if the TCP connection gets broken for long enough. Long enough for the RST packet from the other side gets lost.
-        timeout.tv_sec = 10;
-        timeout.tv_usec = 0;
-        FD_ZERO(&readfds);
-        FD_SET(socket, &readfds);
-        if (select(socket + 1, &readfds, NULL, NULL, &timeout) <= 0) {
-            break;
+    return recv(socket, buffer, length, 0);
+}
+
+// Returns the next line of the HTTP entity, without the CRLF. It is valid until the next read.
+static char *ReadLine(int socket)
+{
+    char *line;
+    int i, result;
+
+    if (socket != RecvSocket)
+        ResetRecvBuffer(socket);
+
+    for (i = RecvStart;; i++) {
+        if (i == RecvEnd) {
+            // Move the partial line to the start of the buffer and receive more.
+            if (RecvStart > 0) {
+                memmove(RecvBuffer, &RecvBuffer[RecvStart], RecvEnd - RecvStart);
+                RecvEnd -= RecvStart;
+                i -= RecvStart;
+                RecvStart = 0;
+            }
+            if (RecvEnd == HTTP_RECV_BUFFER_SIZE) // Line too long.
+                return NULL;
+            if ((result = GetData(socket, &RecvBuffer[RecvEnd], HTTP_RECV_BUFFER_SIZE - RecvEnd)) < 1)
+                return NULL;
+            RecvEnd += result;
+        }
+
+        if (RecvBuffer[i] == '\n') {
+            line = &RecvBuffer[RecvStart];
+            RecvStart = i + 1;
+            if (i > 0 && RecvBuffer[i - 1] == '\r')
+                i--;
+            RecvBuffer[i] = '\0';
+            return line;
         }
+    }
+}
 
-        if ((result = recv(socket, pointer, ToRead, 0)) < 1)
+/*  Receives length bytes of the entity body. Up to *out_len bytes are stored into buffer, the rest is discarded.
+    Returns 0, or -EPIPE if the connection was lost. */
+static int ReadBody(int socket, char *buffer, u16 *out_len, int length)
+{
+    int result, stored, amount;
+
+    if (socket != RecvSocket)
+        ResetRecvBuffer(socket);
+
+    for (stored = 0; length > 0; length -= amount) {
+        if (RecvStart == RecvEnd) {
+            RecvStart = 0;
+            RecvEnd = 0;
+            if (stored < *out_len && length >= *out_len - stored) {
+                // Receive directly into the output buffer.
+                if ((amount = GetData(socket, &buffer[stored], *out_len - stored)) < 1)
+                    break;
+                stored += amount;
+                continue;
+            }
+
+            if ((result = GetData(socket, RecvBuffer, HTTP_RECV_BUFFER_SIZE)) < 1)
+                break;
+            RecvEnd = result;
+        }
+
+        amount = RecvEnd - RecvStart;
+        if (amount > length)
+            amount = length;
+        if (stored < *out_len) {
+            result = *out_len - stored < amount ? *out_len - stored : amount;
+            memcpy(&buffer[stored], &RecvBuffer[RecvStart], result);
+            stored += result;
+        }
+        RecvStart += amount;
+    }
+
+    *out_len = stored;
+    return (length > 0 ? -EPIPE : 0);
+}
+
+// Receives a body with the chunked transfer encoding.
+static int ReadChunkedBody(int socket, char *buffer, u16 *out_len)
+{
+    char *line;
+    u16 stored, amount;
+    int size;
+
+    for (stored = 0;;) {
+        if ((line = ReadLine(socket)) == NULL)
+            break;
+        if ((size = strtoul(line, NULL, 16)) == 0) {
+            // Skip the trailer, up to the empty line.
+            while ((line = ReadLine(socket)) != NULL && line[0] != '\0')
+                ;
             break;
-        remaining -= result;
-        pointer += result;
-        if (result != ToRead) // No further data at the moment.
+        }
+
+        amount = *out_len - stored;
+        if (ReadBody(socket, &buffer[stored], &amount, size) < 0 || ReadLine(socket) == NULL) {
+            line = NULL;
             break;
+        }
+        stored += amount;
     }
 
-    return length - remaining;
+    *out_len = stored;
+    return (line == NULL ? -EPIPE : 0);
 }
 
-#define HTTP_WORK_BUFFER_SIZE 256 // Not a really great design, but this must be long enough for the longest line in the HTTP entity.
+// Receives data until the server closes the connection.
+static int ReadBodyUntilClosed(int socket, char *buffer, u16 *out_len)
+{
+    int result, stored;
+
+    stored = RecvEnd - RecvStart;
+    if (stored > *out_len)
+        stored = *out_len;
+    memcpy(buffer, &RecvBuffer[RecvStart], stored);
+    ResetRecvBuffer(socket);
+
+    while (stored < *out_len && (result = GetData(socket, &buffer[stored], *out_len - stored)) > 0)
+        stored += result;
+
+    *out_len = stored;
+    return 0;
+}
 
 enum TRANFER_ENCODING {
     TRANFER_ENCODING_PLAIN,
@@ -85,114 +210,85 @@ enum TRANFER_ENCODING {
 static int ContentLength;
 static short int StatusCode;
 static unsigned short int HeaderLineNumber;
-// static char TransferEncoding;
+static char TransferEncoding;
 static char ConnectionMode;
 
-static void HttpParseEntityLine(const char *line)
+static void HttpParseEntityLine(char *line)
 {
-    char *pColon;
-
-    if ((pColon = strchr(line, ':')) != NULL) {
-        for (pColon++; *pColon != '\0'; pColon++) {
-            if (look_ctype_table(*pColon) & 2)
-                *pColon = tolower(*pColon);
-        }
-    }
+    char *p;
 
     // printf("%u\t%s\n", HeaderLineNumber, line);
 
-    if (HeaderLineNumber == 0 && strncmp(line, "HTTP/1.1 ", 9) == 0)
-        StatusCode = strtoul(line + 9, NULL, 10);
+    if (HeaderLineNumber == 0) {
+        if (strncmp(line, "HTTP/1.", 7) == 0) {
+            StatusCode = strtoul(line + 9, NULL, 10);
+            if (line[7] == '0') // HTTP/1.0 connections are not persistent, unless the server says so.
+                ConnectionMode = HTTP_CMODE_CLOSED;
+        }
+    } else {
+        // Field names are case-insensitive and so are the values that are checked for.
+        for (p = line; *p != '\0'; p++)
+            *p = tolower(*p);
 
-    if (strncmp(line, "Content-Length: ", 16) == 0)
-        ContentLength = strtoul(line + 15, NULL, 10);
-    /*
-    if (strncmp(line, "Transfer-Encoding: ", 19) == 0) {
-        ContentLength = -1;
-        if (strcmp(line + 19, "chunked") == 0)
+        if (strncmp(line, "content-length: ", 16) == 0)
+            ContentLength = strtoul(line + 15, NULL, 10);
+        if (strncmp(line, "transfer-encoding: ", 19) == 0 && strstr(line + 19, "chunked") != NULL)
             TransferEncoding = TRANFER_ENCODING_CHUNKED;
+        if (strcmp(line, "connection: close") == 0)
+            ConnectionMode = HTTP_CMODE_CLOSED;
+        if (strcmp(line, "connection: keep-alive") == 0)
+            ConnectionMode = HTTP_CMODE_PERSISTENT;
     }
-    */
-    if (strcmp(line, "Connection: close") == 0)
-        ConnectionMode = HTTP_CMODE_CLOSED;
 
     HeaderLineNumber++;
 }
 
-static int HttpGetResponse(s32 socket, s8 *mode, char *buffer, u16 *length)
+int HttpGetResponse(s32 socket, s8 *mode, char *buffer, u16 *length)
 {
-    char work[HTTP_WORK_BUFFER_SIZE + 1], EndOfEntity, *ptr, *next_ptr, *PayloadPtr;
-    int result, DataAvailable, PayloadAmount;
+    char *line;
+    int result;
 
-    // TransferEncoding = TRANFER_ENCODING_PLAIN;
     ConnectionMode = *mode;
-    ContentLength = -1;
-    StatusCode = -1;
-    HeaderLineNumber = 0;
-    PayloadPtr = buffer;
-    PayloadAmount = 0;
-    EndOfEntity = 0;
-    ptr = work;
-    DataAvailable = 0;
-    work[HTTP_WORK_BUFFER_SIZE] = '\0';
+
+    // Informational (1xx) responses may come before the final response. They have no body.
     do {
-        if ((result = GetData(socket, ptr, HTTP_WORK_BUFFER_SIZE - DataAvailable)) > 0) {
-            DataAvailable += result;
-            ptr = work;
-            while ((next_ptr = strstr(ptr, "\r\n")) != NULL) {
-                *next_ptr = '\0';
-                // Parse line
-                HttpParseEntityLine(ptr);
-                DataAvailable -= (next_ptr + 2 - ptr);
-                ptr = next_ptr + 2; // skip CRLN
-                if (strncmp(ptr, "\r\n", 2) == 0) {
-                    EndOfEntity = 1;
-                    DataAvailable -= 2;
-                    ptr += 2;
-                    break;
-                }
-            }
+        TransferEncoding = TRANFER_ENCODING_PLAIN;
+        ContentLength = -1;
+        StatusCode = -1;
+        HeaderLineNumber = 0;
 
-            // At this point, the final line (preceding NULL terminator) has been reached. Move any outstanding characters to the start of the buffer.
-            if (!EndOfEntity) {
-                if (DataAvailable > 0) {
-                    memmove(work, ptr, DataAvailable);
-                    work[DataAvailable] = '\0';
-                    ptr = &work[DataAvailable];
-                } else
-                    ptr = work;
-            }
-        } else {
+        while ((line = ReadLine(socket)) != NULL && line[0] != '\0')
+            HttpParseEntityLine(line);
+
+        if (line == NULL) {
             // No more data. Connection lost?
             //             printf("DEBUG: connection lost?\n");
-            break;
+            *length = 0;
+            *mode = HTTP_CMODE_CLOSED;
+            return -EPIPE;
         }
-    } while (!EndOfEntity);
-
-    // Receive data normally (plain).
-    if (DataAvailable > 0) // Move leftover data into the output buffer.
-    {
-        memcpy(buffer, ptr, DataAvailable);
-        buffer[DataAvailable] = '\0';
-        PayloadPtr = buffer + DataAvailable;
-        PayloadAmount = DataAvailable;
+    } while (StatusCode >= 100 && StatusCode < 200);
+
+    if (StatusCode == 204 || StatusCode == 304) {
+        // These responses have no body.
+        *length = 0;
+        result = 0;
+    } else if (TransferEncoding == TRANFER_ENCODING_CHUNKED) {
+        result = ReadChunkedBody(socket, buffer, length);
+    } else if (ContentLength >= 0) {
+        result = ReadBody(socket, buffer, length, ContentLength);
+    } else {
+        // The body ends when the server closes the connection.
+        result = ReadBodyUntilClosed(socket, buffer, length);
+        ConnectionMode = HTTP_CMODE_CLOSED;
     }
 
-    if (ContentLength < 0 || PayloadAmount < ContentLength) {
-        if (ContentLength > *length)
-            ContentLength = *length;
-        if ((result = GetData(socket, PayloadPtr, ContentLength - PayloadAmount)) > 0)
-            *length = PayloadAmount + result;
-        else
-            *length = PayloadAmount;
+    if (result < 0) {
+        // Incomplete transfer.
+        // printf("Pipe broken: %d/%d\n", *length, ContentLength);
+        ConnectionMode = HTTP_CMODE_CLOSED;
     } else
-        *length = PayloadAmount;
-
-    result = StatusCode;
-    if (ContentLength > 0 && ContentLength > *length) {
-        result = -EPIPE; // Incomplete transfer.
-                         // printf("Pipe broken: %d/%d\n", *length, ContentLength);
-    }
+        result = StatusCode;
 
     *mode = ConnectionMode;
 
@@ -221,7 +317,8 @@ int HttpEstabConnection(char *server, u16 port)
     int result;
 
     if (ResolveHostname(server, &ip) == 0) {
-        result = EstablishConnection(&ip, port);
+        if ((result = EstablishConnection(&ip, port)) >= 0)
+            ResetRecvBuffer(result);
     } else {
         result = -ENXIO;
     }
@@ -250,7 +347,7 @@ static const char *GetDayInWeek(const unsigned char *mtime)
     return dayLabels[(5 + days) % 7]; // 2000/1/1 was a Saturday (5).
 }
 
-int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 *mode, const u8 *mtime, const char *uri, char *output, u16 *out_len)
+int HttpQueueGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 mode, const u8 *mtime, const char *uri)
 {
     const char *months[] = {
         "Jan",
@@ -266,7 +363,7 @@ int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host,
         "Nov",
         "Dec"};
     char buffer[512];
-    int result, length;
+    int length;
 
     sprintf(buffer, "GET %s HTTP/1.1\r\n"
                     "Accept: text/html, */*\r\n"
@@ -274,15 +371,23 @@ int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host,
                     "Host: %s\r\n",
             uri, UserAgent, host);
 
-    if (*mode == HTTP_CMODE_PERSISTENT)
-        strcat(buffer, "Proxy-Connection: Keep-Alive\r\n");
+    if (mode == HTTP_CMODE_PERSISTENT)
+        strcat(buffer, "Connection: Keep-Alive\r\n"
+                       "Proxy-Connection: Keep-Alive\r\n");
     if (mtime != NULL)
         sprintf(&buffer[strlen(buffer)], "If-Modified-Since: %s, %02u %s %04u %02u:%02u:%02u GMT\r\n", GetDayInWeek(mtime), mtime[2] + 1, months[mtime[1]], 2000 + mtime[0], mtime[3], mtime[4], mtime[5]);
     strcat(buffer, "\r\n");
 
     length = strlen(buffer);
 
-    if (SendData(HttpSocket, buffer, length) == length) {
+    return (SendData(HttpSocket, buffer, length) == length ? 0 : -1);
+}
+
+int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 *mode, const u8 *mtime, const char *uri, char *output, u16 *out_len)
+{
+    int result;
+
+    if (HttpQueueGetRequest(HttpSocket, UserAgent, host, *mode, mtime, uri) == 0) {
         result = HttpGetResponse(HttpSocket, mode, output, out_len);
     } else {
         result = -1;
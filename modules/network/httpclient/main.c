@@ -22,11 +22,24 @@ static unsigned char DmaBuffer[512];
 
 extern struct irx_export_table _exp_httpc;
 
-static void *SifRpc_handler(int fno, void *buffer, int nbytes)
+static void SendOutput(void *output, u16 length)
 {
     SifDmaTransfer_t dmat;
     int OldState;
 
+    dmat.src = DmaBuffer;
+    dmat.dest = output;
+    dmat.size = (length + 0xF) & ~0xF;
+    dmat.attr = 0;
+
+    CpuSuspendIntr(&OldState);
+    while (sceSifSetDma(&dmat, 1) == 0)
+        ;
+    CpuResumeIntr(OldState);
+}
+
+static void *SifRpc_handler(int fno, void *buffer, int nbytes)
+{
     switch (fno) {
         case HTTP_CLIENT_CMD_CONN_ESTAB:
             *(int *)SifServerTxBuffer = HttpEstabConnection(((struct HttpClientConnEstabArgs *)buffer)->server, ((struct HttpClientConnEstabArgs *)buffer)->port);
@@ -44,15 +57,22 @@ static void *SifRpc_handler(int fno, void *buffer, int nbytes)
             ((struct HttpClientSendGetResult *)SifServerTxBuffer)->mode = ((struct HttpClientSendGetArgs *)buffer)->mode;
             ((struct HttpClientSendGetResult *)SifServerTxBuffer)->out_len = ((struct HttpClientSendGetArgs *)buffer)->out_len;
 
-            dmat.src = DmaBuffer;
-            dmat.dest = ((struct HttpClientSendGetArgs *)buffer)->output;
-            dmat.size = (((struct HttpClientSendGetArgs *)buffer)->out_len + 0xF) & ~0xF;
-            dmat.attr = 0;
+            SendOutput(((struct HttpClientSendGetArgs *)buffer)->output, ((struct HttpClientSendGetArgs *)buffer)->out_len);
+            break;
+        case HTTP_CLIENT_CMD_QUEUE_GET_REQ:
+            *(int *)SifServerTxBuffer = HttpQueueGetRequest(((struct HttpClientSendGetArgs *)buffer)->socket, ((struct HttpClientSendGetArgs *)buffer)->UserAgent, ((struct HttpClientSendGetArgs *)buffer)->host, ((struct HttpClientSendGetArgs *)buffer)->mode, ((struct HttpClientSendGetArgs *)buffer)->hasMtime ? ((struct HttpClientSendGetArgs *)buffer)->mtime : NULL, ((struct HttpClientSendGetArgs *)buffer)->uri);
+            break;
+        case HTTP_CLIENT_CMD_GET_RESPONSE:
+            if (((struct HttpClientGetResponseArgs *)buffer)->out_len > sizeof(DmaBuffer)) {
+                printf("HttpClient: truncating output.\n");
+                ((struct HttpClientGetResponseArgs *)buffer)->out_len = sizeof(DmaBuffer);
+            }
+
+            ((struct HttpClientSendGetResult *)SifServerTxBuffer)->result = HttpGetResponse(((struct HttpClientGetResponseArgs *)buffer)->socket, &((struct HttpClientGetResponseArgs *)buffer)->mode, (char *)DmaBuffer, &((struct HttpClientGetResponseArgs *)buffer)->out_len);
+            ((struct HttpClientSendGetResult *)SifServerTxBuffer)->mode = ((struct HttpClientGetResponseArgs *)buffer)->mode;
+            ((struct HttpClientSendGetResult *)SifServerTxBuffer)->out_len = ((struct HttpClientGetResponseArgs *)buffer)->out_len;
 
-            CpuSuspendIntr(&OldState);
-            while (sceSifSetDma(&dmat, 1) == 0)
-                ;
-            CpuResumeIntr(OldState);
+            SendOutput(((struct HttpClientGetResponseArgs *)buffer)->output, ((struct HttpClientGetResponseArgs *)buffer)->out_len);
             break;
         default:
             *(int *)SifServerTxBuffer = -ENXIO;
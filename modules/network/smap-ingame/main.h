@@ -3,6 +3,9 @@
 
 #define MAX_FRAME_SIZE 1518
 
+// Number of receive buffers that are lent to the stack. Frames are received into the pbuf pool once they run out.
+#define SMAP_RX_BUFFERS 8
+
 #define PRE_LWIP_130_COMPAT 1
 
 struct SmapDriverData
@@ -22,6 +25,8 @@ struct SmapDriverData
     unsigned char LinkStatus;
     unsigned char LinkMode;
     iop_sys_clock_t LinkCheckTimer;
+    unsigned int RxBufferExhausted; // Frames that had to fall back to the pbuf pool.
+    unsigned int RxDropped;         // Frames dropped, because no pbuf was available.
 };
 
 /* Function prototypes */
@@ -33,3 +38,4 @@ int SMAPGetMACAddress(unsigned char *buffer);
 void SMapLowLevelInput(struct pbuf *pBuf);
 
 #include "xfer.h"
+#include "rxbuf.h"
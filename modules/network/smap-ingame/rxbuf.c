@@ -0,0 +1,69 @@
+#include <intrman.h>
+#include <thbase.h>
+#include <irx.h>
+
+#include "smstcpip.h"
+
+#include "main.h"
+
+/*  Frames are received directly into these buffers, which are then handed over to the stack as custom pbufs.
+    The stack returns them through SmapRxBufferFree() when it frees the pbuf, which may happen in any order. */
+struct SmapRxBuffer
+{
+    struct pbuf_custom pbuf;
+    u8 payload[(MAX_FRAME_SIZE + 3) & ~3];
+};
+
+static struct SmapRxBuffer RxBuffers[SMAP_RX_BUFFERS];
+static struct SmapRxBuffer *RxBufferFreeList;
+
+static void SmapRxBufferFree(struct pbuf *p)
+{
+    struct SmapRxBuffer *buffer = (struct SmapRxBuffer *)p;
+    int OldState;
+
+    CpuSuspendIntr(&OldState);
+    buffer->pbuf.pbuf.next = (struct pbuf *)RxBufferFreeList;
+    RxBufferFreeList = buffer;
+    CpuResumeIntr(OldState);
+}
+
+void SmapRxBufferInit(void)
+{
+    int i;
+
+    RxBufferFreeList = NULL;
+    for (i = 0; i < SMAP_RX_BUFFERS; i++) {
+        RxBuffers[i].pbuf.custom_free_function = &SmapRxBufferFree;
+        SmapRxBufferFree(&RxBuffers[i].pbuf.pbuf);
+    }
+}
+
+struct pbuf *SmapRxBufferAlloc(struct SmapDriverData *SmapDrivPrivData, u16 length)
+{
+    struct SmapRxBuffer *buffer;
+    struct pbuf *pbuf;
+    int OldState;
+
+    CpuSuspendIntr(&OldState);
+    if ((buffer = RxBufferFreeList) != NULL)
+        RxBufferFreeList = (struct SmapRxBuffer *)buffer->pbuf.pbuf.next;
+    CpuResumeIntr(OldState);
+
+    if (buffer != NULL) {
+        pbuf = &buffer->pbuf.pbuf;
+        pbuf->next = NULL;
+        pbuf->payload = buffer->payload;
+        pbuf->tot_len = length;
+        pbuf->len = length;
+        pbuf->flags = PBUF_FLAG_CUSTOM;
+        pbuf->ref = 1;
+    } else {
+        // All buffers are still held by the stack.
+        SmapDrivPrivData->RxBufferExhausted++;
+        if ((pbuf = pbuf_alloc(PBUF_RAW, length, PBUF_POOL)) == NULL)
+            SmapDrivPrivData->RxDropped++;
+    }
+
+    return pbuf;
+}
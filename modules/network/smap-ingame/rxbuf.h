@@ -0,0 +1,2 @@
+void SmapRxBufferInit(void);
+struct pbuf *SmapRxBufferAlloc(struct SmapDriverData *SmapDrivPrivData, u16 length);
@@ -653,6 +653,8 @@ int smap_init(int argc, char *argv[])
     dev9RegisterPreDmaCb(1, &Dev9PreDmaCbHandler);
     dev9RegisterPostDmaCb(1, &Dev9PostDmaCbHandler);
 
+    SmapRxBufferInit();
+
     return 0;
 }
 
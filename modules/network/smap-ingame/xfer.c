@@ -159,7 +159,7 @@ int HandleRxIntr(struct SmapDriverData *SmapDrivPrivData)
 
             if (ctrl_stat & (SMAP_BD_RX_INRANGE | SMAP_BD_RX_OUTRANGE | SMAP_BD_RX_FRMTOOLONG | SMAP_BD_RX_BADFCS | SMAP_BD_RX_ALIGNERR | SMAP_BD_RX_SHORTEVNT | SMAP_BD_RX_RUNTFRM | SMAP_BD_RX_OVERRUN)) {
             } else {
-                if ((pbuf = pbuf_alloc(PBUF_RAW, LengthRounded, PBUF_POOL)) != NULL) {
+                if ((pbuf = SmapRxBufferAlloc(SmapDrivPrivData, LengthRounded)) != NULL) {
                     CopyFromFIFO(SmapDrivPrivData->smap_regbase, pbuf->payload, length, pointer);
 
                     // Inform ps2ip that we've received data.
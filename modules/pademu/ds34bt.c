@@ -732,6 +732,7 @@ static void ds34pad_clear(int pad)
     ds34pad[pad].data[1] = 0xFF;
     mips_memset(&ds34pad[pad].data[2], 0x7F, 4);
     mips_memset(&ds34pad[pad].data[6], 0x00, 12);
+    padReportReset(&ds34pad[pad].report, ds34pad[pad].data);
 }
 
 static void ds34pad_init()
@@ -1310,6 +1311,8 @@ static void hid_readReport(u8 *data, int bytes, int pad_idx)
         if (pad->btn_delay > 0) {
             pad->update_rum = 1;
         }
+
+        padReportPublish(&pad->report, pad->data);
     } else {
         DPRINTF("Unmanaged Input Report: THDR 0x%02X ", data[8]);
         DPRINTF(" ID 0x%02X \n", data[9]);
@@ -1333,16 +1336,10 @@ void ds34bt_set_rumble(u8 lrum, u8 rrum, int port)
 
 int ds34bt_get_data(u8 *dst, int size, int port)
 {
-    int ret;
-
-    WaitSema(bt_dev.hid_sema);
-
-    mips_memcpy(dst, ds34pad[port].data, size);
-    ret = ds34pad[port].analog_btn & 1;
+    // Called from the SIO2 hook: take the newest report without waiting for the L2CAP callback to release hid_sema.
+    padReportRead(&ds34pad[port].report, dst, size, port);
 
-    SignalSema(bt_dev.hid_sema);
-
-    return ret;
+    return ds34pad[port].analog_btn & 1;
 }
 
 void ds34bt_set_mode(int mode, int lock, int port)
@@ -1370,6 +1367,11 @@ int ds34bt_get_status(int port)
     return ret;
 }
 
+int ds34bt_get_model(int port)
+{
+    return MODEL_PS2;
+}
+
 int ds34bt_init(u8 pads, u8 options)
 {
     int ret, i;
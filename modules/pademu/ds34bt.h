@@ -5,9 +5,13 @@
 
 #include <ds34common.h>
 
+#include "padreport.h"
+
 #define DS3 0
 #define DS4 1
 
+#define MODEL_PS2 3
+
 #define MAX_BUFFER_SIZE 64 // Size of general purpose data buffer
 
 #define PENDING    1
@@ -45,6 +49,7 @@ typedef struct
     };
     u8 analog_btn;
     u8 btn_delay;
+    pad_report_t report; // Copy of data for the SIO2 hook
 } ds34bt_pad_t;
 
 enum eDS34BTStatus {
@@ -232,6 +237,7 @@ enum eHID {
 
 int ds34bt_init(u8 pads, u8 options);
 int ds34bt_get_status(int port);
+int ds34bt_get_model(int port);
 void ds34bt_reset();
 int ds34bt_get_data(u8 *dst, int size, int port);
 void ds34bt_set_rumble(u8 lrum, u8 rrum, int port);
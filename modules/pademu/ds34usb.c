@@ -55,13 +55,17 @@ static u8 rgbled_patterns[][2][3] =
 };
 
 static u8 usb_buf[MAX_BUFFER_SIZE + 32] __attribute((aligned(4))) = {0};
+static u8 in_buf[MAX_PADS][MAX_BUFFER_SIZE] __attribute((aligned(4)));
+static int cmd_pad = -1; // Pad whose LED/rumble command is using usb_buf, -1 if none
 
 int usb_probe(int devId);
 int usb_connect(int devId);
 int usb_disconnect(int devId);
 
 static void usb_release(int pad);
+static void usb_reset_report(int pad);
 static void usb_config_set(int result, int count, void *arg);
+static void usb_data_cb(int resultCode, int bytes, void *arg);
 
 UsbDriver usb_driver = {NULL, NULL, "ds34usb", usb_probe, usb_connect, usb_disconnect};
 
@@ -203,29 +207,77 @@ static void usb_release(int pad)
     ds34pad[pad].devId = -1;
     ds34pad[pad].status = DS34USB_STATE_DISCONNECTED;
 
+    // Don't count on USBD calling back for the aborted transfers: a reconnected pad has to start reading again,
+    // and the LED/rumble commands of the other pads must not stay blocked.
+    ds34pad[pad].reading = 0;
+    if (cmd_pad == pad)
+        cmd_pad = -1;
+
+    // The SIO2 hook must not keep returning the last report of the disconnected pad
+    usb_reset_report(pad);
+
     SignalSema(ds34pad[pad].sema);
 }
 
-static int usb_resulCode;
+// Publishes a report with all the buttons released and the sticks centered
+static void usb_reset_report(int pad)
+{
+    ds34pad[pad].data[0] = 0xFF;
+    ds34pad[pad].data[1] = 0xFF;
 
+    mips_memset(&ds34pad[pad].data[2], 0x7F, 4);
+    mips_memset(&ds34pad[pad].data[6], 0x00, 12);
+    padReportReset(&ds34pad[pad].report, ds34pad[pad].data);
+}
+
+static int usb_read_report(int pad)
+{
+    int ret;
+
+    ds34pad[pad].reading = 1;
+
+    ret = UsbInterruptTransfer(ds34pad[pad].interruptEndp, in_buf[pad], MAX_BUFFER_SIZE, usb_data_cb, (void *)pad);
+    if (ret != USB_RC_OK) {
+        DPRINTF("DS34USB: usb_read_report usb transfer error %d\n", ret);
+        ds34pad[pad].reading = 0;
+    }
+
+    return ret;
+}
+
+/* Reports are translated and published here as they arrive, and the next transfer is queued right away.
+   The SIO2 hook only picks up the newest report. */
 static void usb_data_cb(int resultCode, int bytes, void *arg)
 {
     int pad = (int)arg;
 
     // DPRINTF("DS34USB: usb_data_cb: res %d, bytes %d, arg %p \n", resultCode, bytes, arg);
 
-    usb_resulCode = resultCode;
+    if (resultCode != USB_RC_OK || !(ds34pad[pad].status & DS34USB_STATE_RUNNING)) {
+        // Stop here, ds34usb_get_data() will start over.
+        ds34pad[pad].reading = 0;
+        return;
+    }
 
-    SignalSema(ds34pad[pad].sema);
+    readReport(in_buf[pad], pad);
+
+    if (ds34pad[pad].update_rum && cmd_pad < 0) {
+        if (LEDRumble(ds34pad[pad].oldled, ds34pad[pad].lrum, ds34pad[pad].rrum, pad) != USB_RC_OK)
+            DPRINTF("DS34USB: LEDRumble usb transfer error\n");
+
+        ds34pad[pad].update_rum = 0;
+    }
+
+    usb_read_report(pad);
 }
 
 static void usb_cmd_cb(int resultCode, int bytes, void *arg)
 {
-    int pad = (int)arg;
-
     // DPRINTF("DS34USB: usb_cmd_cb: res %d, bytes %d, arg %p \n", resultCode, bytes, arg);
 
-    SignalSema(ds34pad[pad].cmd_sema);
+    // The command may have been dropped by usb_release() already, and usb_buf given to another pad
+    if (cmd_pad == (int)arg)
+        cmd_pad = -1;
 }
 
 static void usb_config_set(int result, int count, void *arg)
@@ -361,14 +413,14 @@ static void readReport(u8 *data, int pad_idx)
             pad->update_rum = 1;
         }
     }
+
+    padReportPublish(&pad->report, pad->data);
 }
 
 static int LEDRumble(u8 *led, u8 lrum, u8 rrum, int pad)
 {
     int ret = 0;
 
-    PollSema(ds34pad[pad].cmd_sema);
-
     mips_memset(usb_buf, 0, sizeof(usb_buf));
 
     if (ds34pad[pad].type == DS3) {
@@ -410,6 +462,9 @@ static int LEDRumble(u8 *led, u8 lrum, u8 rrum, int pad)
         ret = UsbInterruptTransfer(ds34pad[pad].outEndp, usb_buf, 32, usb_cmd_cb, (void *)pad);
     }
 
+    if (ret == USB_RC_OK)
+        cmd_pad = pad;
+
     ds34pad[pad].oldled[0] = led[0];
     ds34pad[pad].oldled[1] = led[1];
     ds34pad[pad].oldled[2] = led[2];
@@ -418,26 +473,6 @@ static int LEDRumble(u8 *led, u8 lrum, u8 rrum, int pad)
     return ret;
 }
 
-static unsigned int timeout(void *arg)
-{
-    int sema = (int)arg;
-    iSignalSema(sema);
-    return 0;
-}
-
-static void TransferWait(int sema)
-{
-    iop_sys_clock_t cmd_timeout;
-
-    cmd_timeout.lo = 200000;
-    cmd_timeout.hi = 0;
-
-    if (SetAlarm(&cmd_timeout, timeout, (void *)sema) == 0) {
-        WaitSema(sema);
-        CancelAlarm(timeout, NULL);
-    }
-}
-
 void ds34usb_set_rumble(u8 lrum, u8 rrum, int port)
 {
     WaitSema(ds34pad[port].sema);
@@ -451,40 +486,13 @@ void ds34usb_set_rumble(u8 lrum, u8 rrum, int port)
 
 int ds34usb_get_data(u8 *dst, int size, int port)
 {
-    int ret = 0;
-
-    WaitSema(ds34pad[port].sema);
+    // Called from the SIO2 hook: reports are read by usb_data_cb(), only (re)start the transfers here.
+    if (!ds34pad[port].reading && (ds34pad[port].status & DS34USB_STATE_RUNNING))
+        usb_read_report(port);
 
-    PollSema(ds34pad[port].sema);
+    padReportRead(&ds34pad[port].report, dst, size, port);
 
-    ret = UsbInterruptTransfer(ds34pad[port].interruptEndp, usb_buf, MAX_BUFFER_SIZE, usb_data_cb, (void *)port);
-
-    if (ret == USB_RC_OK) {
-        TransferWait(ds34pad[port].sema);
-        if (!usb_resulCode)
-            readReport(usb_buf, port);
-
-        usb_resulCode = 1;
-    } else {
-        DPRINTF("DS34USB: ds34usb_get_data usb transfer error %d\n", ret);
-    }
-
-    mips_memcpy(dst, ds34pad[port].data, size);
-    ret = ds34pad[port].analog_btn & 1;
-
-    if (ds34pad[port].update_rum) {
-        ret = LEDRumble(ds34pad[port].oldled, ds34pad[port].lrum, ds34pad[port].rrum, port);
-        if (ret == USB_RC_OK)
-            TransferWait(ds34pad[port].cmd_sema);
-        else
-            DPRINTF("DS34USB: LEDRumble usb transfer error %d\n", ret);
-
-        ds34pad[port].update_rum = 0;
-    }
-
-    SignalSema(ds34pad[port].sema);
-
-    return ret;
+    return ds34pad[port].analog_btn & 1;
 }
 
 void ds34usb_set_mode(int mode, int lock, int port)
@@ -544,23 +552,19 @@ int ds34usb_init(u8 pads, u8 options)
         ds34pad[pad].rrum = 0;
         ds34pad[pad].update_rum = 1;
         ds34pad[pad].sema = -1;
-        ds34pad[pad].cmd_sema = -1;
         ds34pad[pad].controlEndp = -1;
         ds34pad[pad].interruptEndp = -1;
         ds34pad[pad].enabled = (pads >> pad) & 1;
         ds34pad[pad].type = 0;
 
-        ds34pad[pad].data[0] = 0xFF;
-        ds34pad[pad].data[1] = 0xFF;
         ds34pad[pad].analog_btn = 0;
 
-        mips_memset(&ds34pad[pad].data[2], 0x7F, 4);
-        mips_memset(&ds34pad[pad].data[6], 0x00, 12);
+        usb_reset_report(pad);
+        ds34pad[pad].reading = 0;
 
         ds34pad[pad].sema = CreateMutex(IOP_MUTEX_UNLOCKED);
-        ds34pad[pad].cmd_sema = CreateMutex(IOP_MUTEX_UNLOCKED);
 
-        if (ds34pad[pad].sema < 0 || ds34pad[pad].cmd_sema < 0) {
+        if (ds34pad[pad].sema < 0) {
             DPRINTF("DS34USB: Failed to allocate I/O semaphore.\n");
             return 0;
         }
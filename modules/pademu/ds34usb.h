@@ -5,6 +5,8 @@
 
 #include <ds34common.h>
 
+#include "padreport.h"
+
 #define DS3       0
 #define DS4       1
 #define GUITAR_GH 2
@@ -19,7 +21,6 @@ typedef struct _usb_ds34
 {
     int devId;
     int sema;
-    int cmd_sema;
     int controlEndp;
     int interruptEndp;
     int outEndp;
@@ -37,6 +38,8 @@ typedef struct _usb_ds34
     };
     u8 analog_btn;
     u8 btn_delay;
+    u8 reading;          // An interrupt IN transfer is queued
+    pad_report_t report; // Copy of data for the SIO2 hook
 } ds34usb_device;
 
 enum eDS34USBStatus {
@@ -7,19 +7,20 @@
 */
 
 #include "pademu.h"
+#include "pademu_cmd.h"
 #include "padmacro.h"
 
 #ifdef BT
 
 #include "ds34bt.h"
 
-#define PAD_INIT            ds34bt_init
-#define PAD_GET_STATUS      ds34bt_get_status
-#define PAD_RESET           ds34bt_reset
-#define PAD_GET_DATA        ds34bt_get_data
-#define PAD_SET_RUMBLE      ds34bt_set_rumble
-#define PAD_SET_MODE        ds34bt_set_mode
-#define PAD_GET_MODEL(port) 3
+#define PAD_INIT       ds34bt_init
+#define PAD_GET_STATUS ds34bt_get_status
+#define PAD_RESET      ds34bt_reset
+#define PAD_GET_DATA   ds34bt_get_data
+#define PAD_GET_MODEL  ds34bt_get_model
+#define PAD_SET_RUMBLE ds34bt_set_rumble
+#define PAD_SET_MODE   ds34bt_set_mode
 
 #elif defined(USB)
 
@@ -40,34 +41,10 @@
 //#define DPRINTF(x...) printf(x)
 #define DPRINTF(x...)
 
-typedef struct
-{
-    u8 mode;
-    u8 mode_p;
-    u8 mode_id;
-    u8 mode_cfg;
-    u8 mode_lock;
-    u8 enabled;
-    u8 vibration;
-    u8 lrum;
-    u8 rrum;
-    u8 mask[4];
-} pad_status_t;
-
-#define DIGITAL_MODE 0x41
-#define ANALOG_MODE  0x73
-#define ANALOGP_MODE 0x79
-#define CONFIG_MODE  0xF3
-
-#define MAX_PORTS 4
-
-#define PAD_STATE_RUNNING 0x08
-
 IRX_ID("pademu", 1, 1);
 
 PtrRegisterLibraryEntires pRegisterLibraryEntires; /* Pointer to RegisterLibraryEntires routine */
 Sio2McProc pSio2man25, pSio2man51;                 /* Pointers to SIO2MAN routines */
-pad_status_t pad[MAX_PORTS];
 
 static u8 pad_inited = 0;
 static u8 pad_enable = 0;
@@ -86,14 +63,19 @@ void hookSio2man51(sio2_transfer_data_t *sd);
 void InstallSio2manHook(void *exp, int ver);
 
 void pademu_hookSio2man(sio2_transfer_data_t *td, Sio2McProc sio2proc);
-void pademu_setup(u8 ports, u8 vib);
 void pademu(sio2_transfer_data_t *td);
-void pademu_cmd(int port, u8 *in, u8 *out, u8 out_size);
 
 void pademu_mtap(sio2_transfer_data_t *td);
 
 extern struct irx_export_table _exp_pademu;
 
+static const pademu_driver_t pad_driver = {
+    PAD_GET_STATUS,
+    PAD_GET_DATA,
+    PAD_SET_RUMBLE,
+    PAD_SET_MODE,
+    PAD_GET_MODEL};
+
 int _start(int argc, char *argv[])
 {
     union
@@ -140,7 +122,7 @@ int _start(int argc, char *argv[])
             return MODULE_NO_RESIDENT_END;
     }
 
-    pademu_setup(pad_enable, pad_vibration);
+    pademu_setup(pad_enable, pad_vibration, &pad_driver);
 
     return MODULE_RESIDENT_END;
 }
@@ -279,39 +261,6 @@ void pademu_hookSio2man(sio2_transfer_data_t *td, Sio2McProc sio2proc)
     sio2proc(td);
 }
 
-void pademu_setup(u8 ports, u8 vib)
-{
-    u8 i;
-
-    for (i = 0; i < MAX_PORTS; i++) {
-        pad[i].mode = 0;
-        pad[i].mode_p = 0;
-        pad[i].mode_id = DIGITAL_MODE;
-        pad[i].mode_cfg = 0;
-        pad[i].mode_lock = 0;
-
-        pad[i].enabled = ((ports >> i) & 1);
-        pad[i].vibration = ((vib >> i) & 1);
-
-        pad[i].mask[0] = 0xFF;
-        pad[i].mask[1] = 0xFF;
-        pad[i].mask[2] = 0x03;
-        pad[i].mask[3] = 0x00;
-
-        pad[i].lrum = 2;
-        pad[i].rrum = 2;
-    }
-}
-
-u8 pademu_data[6][6] =
-    {
-        {0x00, 0x00, 0x02, 0x00, 0x00, 0x5A},
-        {0x03, 0x02, 0x00, 0x02, 0x01, 0x00},
-        {0x00, 0x00, 0x01, 0x02, 0x00, 0x0A},
-        {0x00, 0x00, 0x01, 0x01, 0x01, 0x14},
-        {0x00, 0x00, 0x02, 0x00, 0x01, 0x00},
-        {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
-
 void pademu(sio2_transfer_data_t *td)
 {
     int port;
@@ -385,135 +334,6 @@ void pademu(sio2_transfer_data_t *td)
     pademu_cmd(port, in, out, cmd_size);
 }
 
-void pademu_cmd(int port, u8 *in, u8 *out, u8 out_size)
-{
-    u8 i;
-
-    mips_memset(out, 0x00, out_size);
-
-    if (!(PAD_GET_STATUS(port) & PAD_STATE_RUNNING)) {
-        pad[port].lrum = 2;
-        pad[port].rrum = 2;
-        return;
-    }
-
-    out[0] = 0xFF;
-    out[1] = CONFIG_MODE;
-    out[2] = 0x5A;
-
-    switch (in[1]) {
-        case 0x40: // set vref param
-            mips_memcpy(&out[3], &pademu_data[0], 6);
-            break;
-
-        case 0x41: // query button mask
-            if (pad[port].mode_id != DIGITAL_MODE) {
-                out[3] = pad[port].mask[0];
-                out[4] = pad[port].mask[1];
-                out[5] = pad[port].mask[2];
-                out[6] = pad[port].mask[3];
-                out[7] = 0x00;
-                out[8] = 0x5A;
-            }
-            break;
-
-        case 0x43: // enter/exit config mode
-            if (pad[port].mode_cfg) {
-                pad[port].mode_cfg = in[3];
-                break;
-            }
-
-            pad[port].mode_cfg = in[3];
-        case 0x42: // read data
-            if (in[1] == 0x42) {
-                if (pad[port].vibration) { // disable/enable vibration
-                    PAD_SET_RUMBLE(in[pad[port].lrum], in[pad[port].rrum], port);
-                }
-            }
-
-            i = PAD_GET_DATA(&out[3], out_size - 3, port);
-
-            if (pad[port].mode_lock == 0) { // mode unlocked
-                if (pad[port].mode != i) {
-                    pad[port].mode = i;
-
-                    if (pad[port].mode)
-                        pad[port].mode_id = ANALOG_MODE;
-                    else
-                        pad[port].mode_id = DIGITAL_MODE;
-                }
-            }
-
-            out[1] = pad[port].mode_id;
-            break;
-
-        case 0x44: // set mode and lock
-            pad[port].mode = in[3];
-            pad[port].mode_lock = in[4];
-            if (pad[port].mode) {
-                if (pad[port].mode_p) {
-                    pad[port].mode_id = ANALOGP_MODE;
-                } else {
-                    pad[port].mode_id = ANALOG_MODE;
-                }
-            } else {
-                pad[port].mode_id = DIGITAL_MODE;
-            }
-            PAD_SET_MODE(pad[port].mode, pad[port].mode_lock, port);
-            break;
-
-        case 0x45: // query model and mode
-            mips_memcpy(&out[3], &pademu_data[1], 6);
-            out[5] = pad[port].mode;
-            out[3] = PAD_GET_MODEL(port);
-            break;
-
-        case 0x46: // query act
-            if (in[3] == 0x00)
-                mips_memcpy(&out[3], &pademu_data[2], 6);
-            else
-                mips_memcpy(&out[3], &pademu_data[3], 6);
-
-            break;
-
-        case 0x47: // query comb
-            mips_memcpy(&out[3], &pademu_data[4], 6);
-            break;
-
-        case 0x4C: // query mode
-            if (in[3] == 0x00)
-                out[6] = 0x04;
-            else
-                out[6] = 0x07;
-
-            break;
-
-        case 0x4D: // set act align
-            mips_memcpy(&out[3], &pademu_data[5], 6);
-
-            for (i = 0; i < 6; i++) { // vibration
-                if (in[3 + i] == 0x00)
-                    pad[port].rrum = i + 3;
-
-                if (in[3 + i] == 0x01)
-                    pad[port].lrum = i + 3;
-            }
-            break;
-
-        case 0x4F: // set button info
-            pad[port].mode_id = ANALOGP_MODE;
-            pad[port].mode_p = 1;
-
-            out[8] = 0x5A;
-
-            pad[port].mask[0] = in[3];
-            pad[port].mask[1] = in[4];
-            pad[port].mask[2] = in[5];
-            pad[port].mask[3] = in[6];
-            break;
-    }
-}
-
 static u8 mtap_data[] = {
     0xff, 0x80, 0x5a, 0x00, 0x00, 0x5a};
 
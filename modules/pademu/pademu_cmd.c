@@ -0,0 +1,177 @@
+/*
+   Copyright 2006-2008, Romz
+   Copyright 2010, Polo
+   Licenced under Academic Free License version 3.0
+   Review OpenUsbLd README & LICENSE files for further details.
+*/
+
+#include "sys_utils.h"
+#include "pademu_cmd.h"
+
+pad_status_t pad[MAX_PORTS];
+
+static const pademu_driver_t *pad_driver;
+
+void pademu_setup(u8 ports, u8 vib, const pademu_driver_t *driver)
+{
+    u8 i;
+
+    pad_driver = driver;
+
+    for (i = 0; i < MAX_PORTS; i++) {
+        pad[i].mode = 0;
+        pad[i].mode_p = 0;
+        pad[i].mode_id = DIGITAL_MODE;
+        pad[i].mode_cfg = 0;
+        pad[i].mode_lock = 0;
+
+        pad[i].enabled = ((ports >> i) & 1);
+        pad[i].vibration = ((vib >> i) & 1);
+
+        pad[i].mask[0] = 0xFF;
+        pad[i].mask[1] = 0xFF;
+        pad[i].mask[2] = 0x03;
+        pad[i].mask[3] = 0x00;
+
+        pad[i].lrum = 2;
+        pad[i].rrum = 2;
+    }
+}
+
+u8 pademu_data[6][6] =
+    {
+        {0x00, 0x00, 0x02, 0x00, 0x00, 0x5A},
+        {0x03, 0x02, 0x00, 0x02, 0x01, 0x00},
+        {0x00, 0x00, 0x01, 0x02, 0x00, 0x0A},
+        {0x00, 0x00, 0x01, 0x01, 0x01, 0x14},
+        {0x00, 0x00, 0x02, 0x00, 0x01, 0x00},
+        {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+
+void pademu_cmd(int port, u8 *in, u8 *out, u8 out_size)
+{
+    u8 i;
+
+    mips_memset(out, 0x00, out_size);
+
+    if (!(pad_driver->get_status(port) & PAD_STATE_RUNNING)) {
+        pad[port].lrum = 2;
+        pad[port].rrum = 2;
+        return;
+    }
+
+    out[0] = 0xFF;
+    out[1] = CONFIG_MODE;
+    out[2] = 0x5A;
+
+    switch (in[1]) {
+        case 0x40: // set vref param
+            mips_memcpy(&out[3], &pademu_data[0], 6);
+            break;
+
+        case 0x41: // query button mask
+            if (pad[port].mode_id != DIGITAL_MODE) {
+                out[3] = pad[port].mask[0];
+                out[4] = pad[port].mask[1];
+                out[5] = pad[port].mask[2];
+                out[6] = pad[port].mask[3];
+                out[7] = 0x00;
+                out[8] = 0x5A;
+            }
+            break;
+
+        case 0x43: // enter/exit config mode
+            if (pad[port].mode_cfg) {
+                pad[port].mode_cfg = in[3];
+                break;
+            }
+
+            pad[port].mode_cfg = in[3];
+        case 0x42: // read data
+            if (in[1] == 0x42) {
+                if (pad[port].vibration) { // disable/enable vibration
+                    pad_driver->set_rumble(in[pad[port].lrum], in[pad[port].rrum], port);
+                }
+            }
+
+            i = pad_driver->get_data(&out[3], out_size - 3, port);
+
+            if (pad[port].mode_lock == 0) { // mode unlocked
+                if (pad[port].mode != i) {
+                    pad[port].mode = i;
+
+                    if (pad[port].mode)
+                        pad[port].mode_id = ANALOG_MODE;
+                    else
+                        pad[port].mode_id = DIGITAL_MODE;
+                }
+            }
+
+            out[1] = pad[port].mode_id;
+            break;
+
+        case 0x44: // set mode and lock
+            pad[port].mode = in[3];
+            pad[port].mode_lock = in[4];
+            if (pad[port].mode) {
+                if (pad[port].mode_p) {
+                    pad[port].mode_id = ANALOGP_MODE;
+                } else {
+                    pad[port].mode_id = ANALOG_MODE;
+                }
+            } else {
+                pad[port].mode_id = DIGITAL_MODE;
+            }
+            pad_driver->set_mode(pad[port].mode, pad[port].mode_lock, port);
+            break;
+
+        case 0x45: // query model and mode
+            mips_memcpy(&out[3], &pademu_data[1], 6);
+            out[5] = pad[port].mode;
+            out[3] = pad_driver->get_model(port);
+            break;
+
+        case 0x46: // query act
+            if (in[3] == 0x00)
+                mips_memcpy(&out[3], &pademu_data[2], 6);
+            else
+                mips_memcpy(&out[3], &pademu_data[3], 6);
+
+            break;
+
+        case 0x47: // query comb
+            mips_memcpy(&out[3], &pademu_data[4], 6);
+            break;
+
+        case 0x4C: // query mode
+            if (in[3] == 0x00)
+                out[6] = 0x04;
+            else
+                out[6] = 0x07;
+
+            break;
+
+        case 0x4D: // set act align
+            mips_memcpy(&out[3], &pademu_data[5], 6);
+
+            for (i = 0; i < 6; i++) { // vibration
+                if (in[3 + i] == 0x00)
+                    pad[port].rrum = i + 3;
+
+                if (in[3 + i] == 0x01)
+                    pad[port].lrum = i + 3;
+            }
+            break;
+
+        case 0x4F: // set button info
+            pad[port].mode_id = ANALOGP_MODE;
+            pad[port].mode_p = 1;
+
+            out[8] = 0x5A;
+
+            pad[port].mask[0] = in[3];
+            pad[port].mask[1] = in[4];
+            pad[port].mask[2] = in[5];
+            pad[port].mask[3] = in[6];
+            break;
+    }
+}
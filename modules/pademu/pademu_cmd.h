@@ -0,0 +1,45 @@
+#ifndef _PADEMU_CMD_H_
+#define _PADEMU_CMD_H_
+
+#include "types.h"
+
+#define DIGITAL_MODE 0x41
+#define ANALOG_MODE  0x73
+#define ANALOGP_MODE 0x79
+#define CONFIG_MODE  0xF3
+
+#define MAX_PORTS 4
+
+#define PAD_STATE_RUNNING 0x08
+
+typedef struct
+{
+    u8 mode;
+    u8 mode_p;
+    u8 mode_id;
+    u8 mode_cfg;
+    u8 mode_lock;
+    u8 enabled;
+    u8 vibration;
+    u8 lrum;
+    u8 rrum;
+    u8 mask[4];
+} pad_status_t;
+
+/* Controller driver behind the emulated pads. The SIO2 command state machine only talks to the controllers through this,
+   so it can also be fed with recorded reports. */
+typedef struct
+{
+    int (*get_status)(int port);
+    int (*get_data)(u8 *dst, int size, int port); // Returns the analog mode of the controller
+    void (*set_rumble)(u8 lrum, u8 rrum, int port);
+    void (*set_mode)(int mode, int lock, int port);
+    int (*get_model)(int port);
+} pademu_driver_t;
+
+extern pad_status_t pad[MAX_PORTS];
+
+void pademu_setup(u8 ports, u8 vib, const pademu_driver_t *driver);
+void pademu_cmd(int port, u8 *in, u8 *out, u8 out_size);
+
+#endif
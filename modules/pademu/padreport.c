@@ -0,0 +1,87 @@
+#include "types.h"
+#include "thbase.h"
+#include "sysclib.h"
+#include "sys_utils.h"
+#include "padreport.h"
+
+#ifdef PADEMU_LATENCY
+#define PAD_LATENCY_TICKS 9216 // 0.25ms at 36.864MHz
+
+static u32 latency_hist[PAD_LATENCY_PORTS][PAD_LATENCY_BUCKETS];
+
+static u32 padReportTime(void)
+{
+    iop_sys_clock_t clock;
+
+    GetSystemTime(&clock);
+    return clock.lo;
+}
+
+static void padReportLatency(pad_report_t *report, int index, int port)
+{
+    u32 ticks;
+    int bucket;
+
+    if (port < 0 || port >= PAD_LATENCY_PORTS)
+        return;
+
+    ticks = (padReportTime() - report->stamp[index]) / PAD_LATENCY_TICKS;
+    for (bucket = 0; ticks != 0 && bucket < PAD_LATENCY_BUCKETS - 1; bucket++)
+        ticks >>= 1;
+
+    latency_hist[port][bucket]++;
+}
+
+void pademu_get_latency(int port, u32 *histogram)
+{
+    if (port >= 0 && port < PAD_LATENCY_PORTS)
+        mips_memcpy(histogram, latency_hist[port], sizeof(latency_hist[port]));
+}
+#endif
+
+static void padReportWrite(pad_report_t *report, const u8 *data)
+{
+    u8 next = report->index ^ 1;
+
+    mips_memcpy(report->data[next], data, PAD_REPORT_SIZE);
+#ifdef PADEMU_LATENCY
+    report->stamp[next] = padReportTime();
+#endif
+    report->index = next;
+    report->seq++;
+}
+
+void padReportReset(pad_report_t *report, const u8 *data)
+{
+    padReportWrite(report, data);
+    report->seen = report->seq;
+}
+
+void padReportPublish(pad_report_t *report, const u8 *data)
+{
+    padReportWrite(report, data);
+}
+
+int padReportRead(pad_report_t *report, u8 *dst, int size, int port)
+{
+    u8 seq, index;
+
+    if (size > PAD_REPORT_SIZE)
+        size = PAD_REPORT_SIZE;
+
+    do {
+        seq = report->seq;
+        index = report->index;
+        mips_memcpy(dst, report->data[index], size);
+    } while (seq != report->seq);
+
+    if (seq == report->seen)
+        return 0;
+
+    report->seen = seq;
+#ifdef PADEMU_LATENCY
+    padReportLatency(report, index, port);
+#endif
+
+    return 1;
+}
@@ -0,0 +1,39 @@
+#ifndef _PADREPORT_H_
+#define _PADREPORT_H_
+
+#include "types.h"
+
+#define PAD_REPORT_SIZE 18
+
+#ifdef PADEMU_LATENCY
+#define PAD_LATENCY_PORTS   4
+#define PAD_LATENCY_BUCKETS 8 // <0.25ms, <0.5ms, <1ms, <2ms, <4ms, <8ms, <16ms, >=16ms
+#endif
+
+/* Newest translated report of a pad, handed from the USB/BT completion callback to the SIO2 hook without locking.
+   The writer fills the buffer that is not published and then flips index. The reader copies the published buffer
+   and copies it again if seq changed meanwhile, which only happens if the writer preempted it. */
+typedef struct
+{
+    u8 data[2][PAD_REPORT_SIZE];
+    volatile u8 index;
+    volatile u8 seq;
+    u8 seen; // Last seq returned to the SIO2 hook
+#ifdef PADEMU_LATENCY
+    u32 stamp[2]; // Arrival time of each buffer, in IOP bus clock ticks
+#endif
+} pad_report_t;
+
+/* Replaces the report without counting it as a new one, when a pad is (dis)connected. Writer side. */
+void padReportReset(pad_report_t *report, const u8 *data);
+/* Publishes a freshly translated report. Writer side. */
+void padReportPublish(pad_report_t *report, const u8 *data);
+/* Copies the newest report to dst. Returns 1 if it was not returned before. SIO2 side. */
+int padReportRead(pad_report_t *report, u8 *dst, int size, int port);
+
+#ifdef PADEMU_LATENCY
+/* Copies the report arrival to SIO2 poll latency histogram of a port, PAD_LATENCY_BUCKETS entries. */
+void pademu_get_latency(int port, u32 *histogram);
+#endif
+
+#endif
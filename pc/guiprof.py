@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Summarizes the guiprof.csv file written by an OPL build with GUI_PROFILER=1 (press L3 in the menu).
+#
+# Input: one line per frame, the frame number followed by the duration of every phase and of the
+# whole frame, in microseconds.
+# Output: min, mean, percentiles and max per phase in milliseconds, and the frames that missed the
+# frame budget.
+#
+# Only the Python standard library is required.
+
+import csv
+import sys
+
+from getopt import gnu_getopt, GetoptError
+
+PERCENTILES = (50, 90, 95, 99)
+
+
+def percentile(values, pct):
+    # Nearest-rank percentile of a sorted list
+    rank = max(1, -(-len(values) * pct // 100))
+    return values[rank - 1]
+
+
+def load(path):
+    with open(path, newline='') as f:
+        reader = csv.reader(f)
+        header = next(reader)
+        frames = []
+        for row in reader:
+            if len(row) == len(header):
+                frames.append([int(v) for v in row])
+    return header, frames
+
+
+def summarize(header, frames, budget_us):
+    print("%d frames (%d - %d)" % (len(frames), frames[0][0], frames[-1][0]))
+    print()
+    print("%-10s %8s %8s" % ("phase", "min", "mean") +
+          "".join("%8s" % ("p%d" % p) for p in PERCENTILES) + "%8s %6s" % ("max", "share"))
+
+    totals = [frame[-1] for frame in frames]
+    total_sum = sum(totals) or 1
+    for col, name in enumerate(header[1:], 1):
+        values = sorted(frame[col] for frame in frames)
+        line = "%-10s %8.2f %8.2f" % (name, values[0] / 1000, sum(values) / len(values) / 1000)
+        line += "".join("%8.2f" % (percentile(values, p) / 1000) for p in PERCENTILES)
+        line += "%8.2f" % (values[-1] / 1000)
+        if col < len(header) - 1:
+            line += " %5.1f%%" % (100.0 * sum(values) / total_sum)
+        print(line)
+
+    slow = [frame for frame in frames if frame[-1] > budget_us]
+    print()
+    print("%d frames over the %.2fms budget" % (len(slow), budget_us / 1000))
+    for frame in slow:
+        # The phase that took the most time in that frame
+        worst = max(range(1, len(header) - 1), key=lambda col: frame[col])
+        print("  frame %d: %.2fms, %s %.2fms" % (frame[0], frame[-1] / 1000, header[worst], frame[worst] / 1000))
+
+
+def usage():
+    print("guiprof - summarizes an OPL GUI profiler dump")
+    print("Usage: guiprof [-r rate] guiprof.csv")
+    print("  -r Refresh rate used for the frame budget (default: 60)")
+
+
+def main():
+    try:
+        optlist, args = gnu_getopt(sys.argv[1:], "r:h")
+    except GetoptError as err:
+        print(str(err))
+        usage()
+        sys.exit(-1)
+
+    rate = 60.0
+    for o, a in optlist:
+        if o == '-r':
+            rate = float(a)
+        elif o == '-h':
+            usage()
+            sys.exit(0)
+
+    if len(args) != 1:
+        usage()
+        sys.exit(-1)
+
+    header, frames = load(args[0])
+    if not frames:
+        print("%s: no frames" % args[0])
+        sys.exit(-1)
+
+    summarize(header, frames, 1000000.0 / rate)
+
+
+if __name__ == "__main__":
+    main()
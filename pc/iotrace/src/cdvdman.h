@@ -0,0 +1,11 @@
+/*
+  Stand-in for cdvdman.h of the PS2SDK, for building the sector reader of cdvdman on the PC.
+*/
+
+#ifndef __CDVDMAN_H__
+#define __CDVDMAN_H__
+
+#define SCECdErNO  0x00
+#define SCECdErEOM 0x32
+
+#endif
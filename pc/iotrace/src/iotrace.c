@@ -0,0 +1,335 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Replays an I/O trace, recorded by cdvdman of OPL built with IO_TRACE=1, against the disc image it was recorded with.
+  The image may be an ISO, a ZSO or the first part (.00) of a split (USBLD) image.
+
+  Reports the recorded latencies per caller and the seek pattern, then reads every traced request again
+  through the sector reader of cdvdman (zsoread.c, built with the ZSO reader and its sector cache) to measure
+  the throughput of this PC and the hit rate of the sector cache.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tamtypes.h"
+#include "iotrace.h"
+#include "zso.h"
+#include "device.h"
+#include "zsoread.h"
+
+#define PROGRAM_NAME "iotrace"
+#define PROGRAM_VER  "0.1"
+
+#ifdef _WIN32
+#define fseeko fseeko64
+#endif
+
+#define SECTOR_SIZE   2048
+#define PART_SECTORS  0x80000 // Sectors in each part of a split image (1GB)
+#define MAX_PARTS     10      // ISO_MAX_PARTS
+#define IOPCORE_COMPAT_ACCU_READS 0x0008
+
+static const char *callerNames[IOTRACE_CALLER_COUNT] = {
+    "sceCdRead",
+    "readee",
+    "stream",
+    "ioops",
+    "search"};
+
+// The disc image
+static FILE *parts[MAX_PARTS];
+static int numParts;
+
+// Statistics of the device reads done by the replay
+static u64 deviceReads, deviceSectors;
+static u8 maxSectorCache;
+
+//-----------------------------------------------------------------------
+// The device of cdvdman, reading the image
+//-----------------------------------------------------------------------
+int DeviceReadSectors(u64 lsn, void *buffer, unsigned int sectors)
+{
+    u8 *p = buffer;
+
+    deviceReads++;
+    deviceSectors += sectors;
+
+    while (sectors > 0) {
+        unsigned int part = lsn / PART_SECTORS, n;
+        u64 offset = lsn % PART_SECTORS;
+
+        if (numParts == 1) {
+            part = 0;
+            offset = lsn;
+            n = sectors;
+        } else {
+            n = PART_SECTORS - offset;
+            if (n > sectors)
+                n = sectors;
+        }
+
+        if (part >= numParts || fseeko(parts[part], offset * SECTOR_SIZE, SEEK_SET) != 0 || fread(p, SECTOR_SIZE, n, parts[part]) != n)
+            return -1;
+
+        p += n * SECTOR_SIZE;
+        lsn += n;
+        sectors -= n;
+    }
+
+    return 0;
+}
+
+void *ziso_alloc(u32 size)
+{
+    void *p;
+
+    // Aligned, so that zso.c does not align the pointer itself: it would truncate it to 32 bits.
+#ifdef _WIN32
+    p = _aligned_malloc(size, 64);
+#else
+    if (posix_memalign(&p, 64, size) != 0)
+        p = NULL;
+#endif
+    return p;
+}
+
+static int (*DeviceReadSectorsPtr)(u64 lsn, void *buffer, unsigned int sectors) = &DeviceReadSectors;
+
+//-----------------------------------------------------------------------
+static int openImage(const char *path, int cacheSize)
+{
+    char partPath[1024];
+    u8 sector[SECTOR_SIZE], *sectorCache;
+    size_t len = strlen(path);
+
+    // A split image is given by its first part, the others only differ in the extension.
+    if (len > 3 && strcmp(&path[len - 3], ".00") == 0 && len < sizeof(partPath)) {
+        strcpy(partPath, path);
+        for (numParts = 0; numParts < MAX_PARTS; numParts++) {
+            sprintf(&partPath[len - 2], "%02x", numParts);
+            if ((parts[numParts] = fopen(partPath, "rb")) == NULL)
+                break;
+        }
+    } else {
+        parts[0] = fopen(path, "rb");
+        numParts = parts[0] != NULL ? 1 : 0;
+    }
+
+    if (numParts == 0 || DeviceReadSectors(0, sector, 1) != 0)
+        return -1;
+
+    // Like ProbeZSO() of cdvdman
+    if (*(u32 *)sector == ZSO_MAGIC) {
+        ziso_init((ZISO_header *)sector, *(u32 *)(sector + sizeof(ZISO_header)));
+        if (cacheSize > 0 && (sectorCache = malloc(cacheSize * SECTOR_SIZE)) != NULL) {
+            ZSOSetSectorCache(sectorCache, cacheSize);
+            maxSectorCache = cacheSize;
+        }
+        DeviceReadSectorsPtr = &DeviceReadSectorsCompressed;
+    }
+
+    return 0;
+}
+
+static struct iotrace_record *loadTrace(const char *path, struct iotrace_header *header)
+{
+    struct iotrace_record *records, *ring;
+    FILE *file;
+    u32 i, first;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    records = NULL;
+    if (fread(header, sizeof(*header), 1, file) == 1 && header->magic == IOTRACE_MAGIC && header->version == IOTRACE_VERSION &&
+        header->record_size == sizeof(struct iotrace_record) && header->count <= IOTRACE_ENTRIES) {
+        ring = malloc(sizeof(struct iotrace_record) * IOTRACE_ENTRIES);
+        records = malloc(sizeof(struct iotrace_record) * (header->count + 1));
+        if (ring != NULL && records != NULL && fread(ring, sizeof(struct iotrace_record), header->count, file) == header->count) {
+            // Unroll the ring: once it wrapped around, the oldest record is the next one to be overwritten.
+            first = header->dropped != 0 ? header->next : 0;
+            for (i = 0; i < header->count; i++)
+                records[i] = ring[(first + i) % IOTRACE_ENTRIES];
+        } else {
+            free(records);
+            records = NULL;
+        }
+        free(ring);
+    }
+
+    fclose(file);
+    return records;
+}
+
+static double ticksToMs(u64 ticks)
+{
+    return (double)(ticks << IOTRACE_TIME_SHIFT) * 1000.0 / IOTRACE_CLOCK;
+}
+
+static void printCallers(const struct iotrace_record *records, u32 count)
+{
+    u64 reads[IOTRACE_CALLER_COUNT] = {0}, sectors[IOTRACE_CALLER_COUNT] = {0}, latency[IOTRACE_CALLER_COUNT] = {0};
+    u32 maxLatency[IOTRACE_CALLER_COUNT] = {0}, errors[IOTRACE_CALLER_COUNT] = {0};
+    u64 totalSectors = 0, totalLatency = 0;
+    u32 i, c;
+
+    for (i = 0; i < count; i++) {
+        c = records[i].caller & IOTRACE_CALLER_MASK;
+        if (c >= IOTRACE_CALLER_COUNT)
+            continue;
+        reads[c]++;
+        sectors[c] += records[i].sectors;
+        latency[c] += records[i].latency;
+        if (records[i].latency > maxLatency[c])
+            maxLatency[c] = records[i].latency;
+        if (records[i].caller & IOTRACE_ERROR)
+            errors[c]++;
+        totalSectors += records[i].sectors;
+        totalLatency += records[i].latency;
+    }
+
+    printf("\nRecorded reads:\n");
+    printf("%-10s %8s %10s %9s %9s %9s %8s %7s\n", "Caller", "Reads", "Sectors", "MB", "Avg ms", "Max ms", "MB/s", "Errors");
+    for (c = 0; c < IOTRACE_CALLER_COUNT; c++) {
+        if (reads[c] == 0)
+            continue;
+        printf("%-10s %8llu %10llu %9.2f %9.3f %9.3f %8.2f %7u\n", callerNames[c], (unsigned long long)reads[c], (unsigned long long)sectors[c],
+               sectors[c] * SECTOR_SIZE / 1048576.0, ticksToMs(latency[c]) / reads[c], ticksToMs(maxLatency[c]),
+               latency[c] ? sectors[c] * SECTOR_SIZE / 1048576.0 / (ticksToMs(latency[c]) / 1000.0) : 0.0, errors[c]);
+    }
+    printf("Total: %llu sectors in %.1f ms of reading, %.2f MB/s while busy.\n", (unsigned long long)totalSectors, ticksToMs(totalLatency),
+           totalLatency ? totalSectors * SECTOR_SIZE / 1048576.0 / (ticksToMs(totalLatency) / 1000.0) : 0.0);
+    if (count > 0)
+        printf("The trace covers %.1f s.\n", ticksToMs(records[count - 1].time - records[0].time) / 1000.0);
+}
+
+static void printSeeks(const struct iotrace_record *records, u32 count)
+{
+    // Distance from the end of the previous read, in sectors
+    static const u32 limits[] = {16, 256, 4096, 65536, 0xFFFFFFFF};
+    static const char *names[] = {"< 16", "< 256", "< 4096", "< 65536", ">= 65536"};
+    u32 forward[5] = {0}, backward[5] = {0}, sequential = 0, i, j, distance;
+    u64 next = 0;
+
+    for (i = 0; i < count; i++) {
+        if (i > 0) {
+            if (records[i].lsn == next)
+                sequential++;
+            else {
+                distance = records[i].lsn > next ? records[i].lsn - next : next - records[i].lsn;
+                for (j = 0; distance >= limits[j] && j < 4; j++)
+                    ;
+                if (records[i].lsn > next)
+                    forward[j]++;
+                else
+                    backward[j]++;
+            }
+        }
+        next = (u64)records[i].lsn + records[i].sectors;
+    }
+
+    printf("\nSeeks (distance from the end of the previous read, in sectors):\n");
+    printf("  sequential: %u (%.1f%%)\n", sequential, count > 1 ? sequential * 100.0 / (count - 1) : 0.0);
+    for (j = 0; j < 5; j++)
+        printf("  %-9s forward %6u backward %6u\n", names[j], forward[j], backward[j]);
+}
+
+static void replay(const struct iotrace_record *records, u32 count)
+{
+    struct timespec start, end;
+    u64 sectors = 0, failed = 0;
+    u32 i, maxSectors = 0;
+    double ms;
+    u8 *buffer;
+
+    for (i = 0; i < count; i++) {
+        if (records[i].sectors > maxSectors)
+            maxSectors = records[i].sectors;
+    }
+    if ((buffer = malloc((u64)maxSectors * SECTOR_SIZE + SECTOR_SIZE)) == NULL)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++) {
+        if (records[i].caller & IOTRACE_ERROR)
+            continue; // Failed on the PS2 as well, likely beyond the end of the disc.
+        if (DeviceReadSectorsPtr(records[i].lsn, buffer, records[i].sectors) != 0)
+            failed++;
+        sectors += records[i].sectors;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(buffer);
+
+    ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("\nReplay: %llu sectors in %.1f ms, %.2f MB/s", (unsigned long long)sectors, ms, ms > 0 ? sectors * SECTOR_SIZE / 1048576.0 / (ms / 1000.0) : 0.0);
+    if (failed)
+        printf(", %llu reads failed", (unsigned long long)failed);
+    printf(".\n");
+    printf("Device: %llu reads, %llu sectors (%.2fx the requested sectors).\n", (unsigned long long)deviceReads, (unsigned long long)deviceSectors,
+           sectors ? (double)deviceSectors / sectors : 0.0);
+    if (DeviceReadSectorsPtr == &DeviceReadSectorsCompressed) {
+        if (maxSectorCache > 0)
+            printf("ZSO sector cache of %u sectors: %u hits, %u misses (%.1f%% hit rate).\n", maxSectorCache, zso_cache_hits, zso_cache_misses,
+                   zso_cache_hits + zso_cache_misses ? zso_cache_hits * 100.0 / (zso_cache_hits + zso_cache_misses) : 0.0);
+        else
+            printf("ZSO sector cache disabled.\n");
+    }
+}
+
+//-----------------------------------------------------------------------
+static void printUsage(void)
+{
+    printf("%s version %s - replays an I/O trace of Open PS2 Loader\n", PROGRAM_NAME, PROGRAM_VER);
+    printf("Usage: %s [-c CACHE_SECTORS] TRACE.iot IMAGE\n", PROGRAM_NAME);
+    printf("  IMAGE is the ISO or ZSO, or the first part (.00) of a split image.\n");
+    printf("  -c sets the size of the ZSO sector cache (0-255). Default: the size used when recording.\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct iotrace_header header;
+    struct iotrace_record *records;
+    int argi = 1, cacheSize = -1;
+
+    if (argc > 2 && strcmp(argv[1], "-c") == 0) {
+        cacheSize = atoi(argv[2]);
+        argi += 2;
+    }
+
+    if (argc - argi != 2 || cacheSize > 255) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    if ((records = loadTrace(argv[argi], &header)) == NULL) {
+        fprintf(stderr, "Error: %s is not a valid trace. Was the game left with IGR or exit?\n", argv[argi]);
+        return EXIT_FAILURE;
+    }
+
+    if (cacheSize < 0)
+        cacheSize = header.zso_cache;
+
+    if (openImage(argv[argi + 1], cacheSize) != 0) {
+        fprintf(stderr, "Error: cannot read %s.\n", argv[argi + 1]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %u records", argv[argi], header.count);
+    if (header.dropped)
+        printf(" (the %u oldest were dropped)", header.dropped);
+    printf(", %s, %s image", header.media == 0x12 ? "CD" : "DVD", DeviceReadSectorsPtr == &DeviceReadSectorsCompressed ? "ZSO" : "ISO");
+    if (header.flags & IOPCORE_COMPAT_ACCU_READS)
+        printf(", accurate reads (mode 4)");
+    printf(".\n");
+
+    printCallers(records, header.count);
+    printSeeks(records, header.count);
+    replay(records, header.count);
+
+    free(records);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,10 @@
+/*
+  Stand-in for sysclib.h of the PS2SDK, for building the sector reader of cdvdman on the PC.
+*/
+
+#ifndef __SYSCLIB_H__
+#define __SYSCLIB_H__
+
+#include <string.h>
+
+#endif
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+
+# Compresses an IOP module for embedding into OPL, to be decompressed by the EE core before it gets loaded.
+#
+# Output: an 8-byte header (u32 magic "LZ4M", u32 uncompressed size), followed by a raw LZ4 block.
+# The header is described by irxlz4_header_t in ee_core/include/modules.h.
+#
+# Only the Python standard library is required.
+
+import struct
+import sys
+
+IRXLZ4_MAGIC = 0x4D345A4C  # "LZ4M"
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+LAST_LITERALS = 5  # The last 5 bytes are always literals
+MF_LIMIT = 12      # The last match must start at least 12 bytes before the end
+HASH_LOG = 16
+MAX_CHAIN = 64
+
+
+def hash4(data, pos):
+    return ((struct.unpack_from('<I', data, pos)[0] * 2654435761) & 0xFFFFFFFF) >> (32 - HASH_LOG)
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def write_sequence(out, literals, match_length):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_length is not None:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        write_length(out, lit_len - 15)
+    out += literals
+
+
+def compress_block(data):
+    out = bytearray()
+    size = len(data)
+    anchor = 0
+
+    if size >= MF_LIMIT + 1:
+        head = {}
+        prev = [0] * size
+        match_limit = size - LAST_LITERALS
+        pos = 0
+
+        while pos < size - MF_LIMIT:
+            seq = data[pos:pos + MIN_MATCH]
+            key = hash4(data, pos)
+
+            # Walk the hash chain for the longest match within the window
+            best_len = 0
+            best_pos = 0
+            cand = head.get(key, -1)
+            chain = 0
+            while cand >= 0 and pos - cand <= MAX_OFFSET and chain < MAX_CHAIN:
+                if data[cand:cand + MIN_MATCH] == seq:
+                    length = MIN_MATCH
+                    while pos + length < match_limit and data[cand + length] == data[pos + length]:
+                        length += 1
+                    if length > best_len:
+                        best_len = length
+                        best_pos = cand
+                cand = prev[cand]
+                chain += 1
+
+            prev[pos] = head.get(key, -1)
+            head[key] = pos
+
+            if best_len < MIN_MATCH:
+                pos += 1
+                continue
+
+            write_sequence(out, data[anchor:pos], best_len)
+            out += struct.pack('<H', pos - best_pos)
+            if best_len - MIN_MATCH >= 15:
+                write_length(out, best_len - MIN_MATCH - 15)
+
+            # Index the matched bytes, so that the following data can refer to them
+            end = pos + best_len
+            pos += 1
+            while pos < end and pos < size - MF_LIMIT:
+                key = hash4(data, pos)
+                prev[pos] = head.get(key, -1)
+                head[key] = pos
+                pos += 1
+            pos = end
+            anchor = pos
+
+    write_sequence(out, data[anchor:], None)
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("irxlz4 - compresses an IOP module for the EE core")
+        print("Usage: irxlz4 module.irx output")
+        sys.exit(-1)
+
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+
+    block = compress_block(data)
+    with open(sys.argv[2], 'wb') as f:
+        f.write(struct.pack('<II', IRXLZ4_MAGIC, len(data)))
+        f.write(block)
+
+    print("%s: %d -> %d bytes" % (sys.argv[1], len(data), len(block) + 8))
+
+
+if __name__ == "__main__":
+    main()
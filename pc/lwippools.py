@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+# Recommends sizes for the heap and pools of the in-game lwIP stack (SMSTCPIP).
+#
+# Build OPL with LWIP_POOL_STATS=1 and an in-game TTY, play the games to size for and capture the TTY output.
+# SMSTCPIP then periodically prints one line per pool (see modules/network/SMSTCPIP/stats.c):
+#   lwip: <name> used <used>/<avail> peak <max> fail <err> exhausted <ms> ms size <bytes>
+# This script reads one or more of these logs and suggests the lwipopts.h settings of the in-game driver:
+#   - a pool that never ran out is sized to its peak, plus headroom.
+#   - a pool that ran out (an allocation failed) is grown, because its real demand is unknown. Measure again after rebuilding.
+# The time that each pool spent exhausted is shown, as a hint of how often the stack had to wait or drop packets.
+# With --budget, the headroom is dropped from the pools that never ran out, until the total fits.
+#
+# Only the Python standard library is required.
+
+import argparse
+import re
+import sys
+
+LINE_RE = re.compile(r'lwip: (\w+) used (\d+)/(\d+) peak (\d+) fail (\d+) exhausted (\d+) ms size (\d+)')
+
+# Pool name -> lwipopts.h setting, and the elements that only the POOL_STATS build adds.
+SETTINGS = {
+    'HEAP': ('MEM_SIZE', 0),
+    'PBUF_POOL': ('PBUF_POOL_SIZE', 0),
+    'PBUF': ('MEMP_NUM_PBUF', 0),
+    'RAW_PCB': ('MEMP_NUM_RAW_PCB', 0),
+    'UDP_PCB': ('MEMP_NUM_UDP_PCB', 0),
+    'TCP_PCB': ('MEMP_NUM_TCP_PCB', 0),
+    'TCP_PCB_LISTEN': ('MEMP_NUM_TCP_PCB_LISTEN', 0),
+    'TCP_SEG': ('MEMP_NUM_TCP_SEG (TCP_SND_QUEUELEN)', 0),
+    'NETBUF': ('MEMP_NUM_NETBUF', 0),
+    'NETCONN': ('MEMP_NUM_NETCONN', 0),
+    'API_MSG': ('MEMP_NUM_API_MSG', 0),
+    'TCPIP_MSG': ('MEMP_NUM_TCPIP_MSG', 0),
+    'SYS_TIMEOUT': ('MEMP_NUM_SYS_TIMEOUT', 1),  # The statistics timer
+}
+
+HEAP_ALIGN = 16
+
+
+class Pool:
+    def __init__(self, name, avail, size):
+        self.name = name
+        self.avail = avail
+        self.size = size
+        self.peak = 0
+        self.fail = 0
+        self.exhausted = 0
+
+    def ran_out(self):
+        # A pool can be exhausted without failing: all its elements were in use, but none more was requested.
+        return self.fail > 0
+
+
+def parse_logs(paths):
+    pools = {}
+    for path in paths:
+        # The totals are cumulative within a session, so keep the highest of each.
+        with open(path, 'r', errors='replace') as f:
+            for line in f:
+                m = LINE_RE.search(line)
+                if m is None:
+                    continue
+                name = m.group(1)
+                avail, peak, fail, exhausted, size = (int(m.group(i)) for i in range(3, 8))
+                pool = pools.get(name)
+                if pool is None or pool.avail != avail or pool.size != size:
+                    if pool is not None:
+                        print("Warning: %s changed from %d x %d to %d x %d bytes, using the latest." % (name, pool.avail, pool.size, avail, size))
+                    pool = pools[name] = Pool(name, avail, size)
+                pool.peak = max(pool.peak, peak)
+                pool.fail = max(pool.fail, fail)
+                pool.exhausted = max(pool.exhausted, exhausted)
+    return pools
+
+
+def recommend(pool, headroom, heap_headroom, growth):
+    if pool.name == 'HEAP':
+        # The heap peak is an offset, round it up to whole blocks.
+        if pool.ran_out():
+            want = int(pool.avail * growth)
+        else:
+            want = pool.peak * (100 + heap_headroom) // 100
+        return (want + HEAP_ALIGN - 1) // HEAP_ALIGN * HEAP_ALIGN
+
+    if pool.ran_out():
+        return max(pool.avail + 1, int(pool.avail * growth + 0.5))
+    return max(pool.peak + headroom, 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Recommends sizes for the in-game lwIP heap and pools of OPL, from SMSTCPIP statistics logs.")
+    parser.add_argument('logs', nargs='+', help="TTY logs of OPL built with LWIP_POOL_STATS=1")
+    parser.add_argument('--headroom', type=int, default=1, help="elements added to the peak of each pool (default: 1)")
+    parser.add_argument('--heap-headroom', type=int, default=25, help="percentage added to the heap peak (default: 25)")
+    parser.add_argument('--growth', type=float, default=2.0, help="factor to grow pools that ran out by (default: 2)")
+    parser.add_argument('--budget', type=int, default=0, help="memory budget for the heap and pools in bytes")
+    args = parser.parse_args()
+
+    pools = parse_logs(args.logs)
+    if not pools:
+        sys.exit("No lwIP statistics found. Was SMSTCPIP built with POOL_STATS=1?")
+
+    names = sorted(pools, key=lambda n: (n != 'HEAP', n != 'PBUF_POOL', n))
+    counts = {name: recommend(pools[name], args.headroom, args.heap_headroom, args.growth) for name in names}
+
+    def total(sizes):
+        return sum(sizes[name] * pools[name].size for name in names)
+
+    if args.budget > 0:
+        # Drop the headroom of the largest elements first, but never go below the peak.
+        for name in sorted(names, key=lambda n: -pools[n].size):
+            if total(counts) <= args.budget:
+                break
+            pool = pools[name]
+            if not pool.ran_out():
+                counts[name] = max(pool.peak, 1)
+
+    print("%-15s %7s %7s %6s %10s %7s %7s" % ("Pool", "Size", "Peak", "Fails", "Exhausted", "Now", "Advice"))
+    for name in names:
+        pool = pools[name]
+        print("%-15s %7d %7d %6d %8d ms %7d %7d%s" % (name, pool.size, pool.peak, pool.fail, pool.exhausted, pool.avail, counts[name],
+                                                     " (ran out, measure again)" if pool.ran_out() else ""))
+
+    current = sum(pools[name].avail * pools[name].size for name in names)
+    print("\nMemory: %d bytes now, %d bytes recommended." % (current, total(counts)))
+    if args.budget > 0 and total(counts) > args.budget:
+        print("The recommendation does not fit into the budget of %d bytes." % args.budget)
+
+    print("\nlwipopts.h, in-game settings:")
+    for name in names:
+        setting, reserved = SETTINGS.get(name, (name, 0))
+        value = counts[name] - reserved
+        print("  %s %s" % (setting, ("0x%X" % value) if name == 'HEAP' else value))
+
+
+if __name__ == "__main__":
+    main()
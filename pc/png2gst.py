@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+
+# Converts PNG art/theme images into OPL's pre-converted GS texture container (.gst).
+#
+# OPL prefers a .gst file over the .png next to it, so converted images are loaded
+# with plain reads instead of being decoded by libpng on the EE. The pixel data is
+# laid out exactly like src/textures.c leaves a decoded PNG in memory:
+#   - RGBA          -> PSM_CT32, alpha halved to the GS range (0x80 = opaque)
+#   - RGB           -> PSM_CT24, tightly packed
+#   - 8-bit palette -> PSM_T8 with a 256 entry CT32 CLUT (CSM1 ordering)
+#   - 4-bit palette -> PSM_T4 with a 16 entry CT32 CLUT, nibbles swapped
+#   - 1/2-bit palette images are expanded to RGB/RGBA, as libpng does for OPL.
+# Greyscale images are not supported by OPL and are skipped.
+#
+# Requires Python 3 and Pillow:
+#   pip install pillow
+
+import os
+import struct
+import sys
+import zlib
+
+from getopt import gnu_getopt, GetoptError
+from multiprocessing import Pool
+
+from PIL import Image
+
+GST_MAGIC = 0x31545347
+GST_VERSION = 1
+GST_HEADER_SIZE = 128
+
+# OPL only looks for .gst files in the folders that hold this file
+GST_DIR_MARKER = 'png2gst.txt'
+
+GS_PSM_CT32 = 0x00
+GS_PSM_CT24 = 0x01
+GS_PSM_T8 = 0x13
+GS_PSM_T4 = 0x14
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+PNG_COLOR_TYPE_PALETTE = 3
+
+MAX_DIMENSION = 1024
+MAX_SIZE = 720 * 512 * 4
+
+
+class SkipImage(Exception):
+    pass
+
+
+def read_png_chunks(path):
+    chunks = {}
+    with open(path, 'rb') as f:
+        if f.read(8) != PNG_SIGNATURE:
+            raise SkipImage("not a PNG file")
+        while True:
+            header = f.read(8)
+            if len(header) < 8:
+                break
+            length, ctype = struct.unpack('>I4s', header)
+            data = f.read(length)
+            f.read(4)  # CRC
+            if ctype in (b'IHDR', b'PLTE', b'tRNS') and ctype not in chunks:
+                chunks[ctype] = data
+            if ctype == b'IEND':
+                break
+    if b'IHDR' not in chunks:
+        raise SkipImage("missing IHDR")
+    return chunks
+
+
+def build_clut(chunks, entries):
+    palette = chunks.get(b'PLTE', b'')
+    trans = chunks.get(b'tRNS', b'')
+    count = min(len(palette) // 3, entries)
+    clut = []
+    for i in range(count):
+        alpha = (trans[i] >> 1) if i < len(trans) else 0x80
+        clut.append(palette[i * 3:i * 3 + 3] + bytes([alpha]))
+    clut += [bytes(4)] * (entries - count)
+
+    if entries == 256:
+        # The GS reads 8-bit CLUTs in CSM1 order, swap the 2nd and 3rd row of every block.
+        for i in range(count):
+            if (i & 0x18) == 8:
+                clut[i], clut[i + 8] = clut[i + 8], clut[i]
+
+    return b''.join(clut)
+
+
+def texture_size(width, height, psm):
+    if psm == GS_PSM_CT32:
+        return width * height * 4
+    if psm == GS_PSM_CT24:
+        return width * height * 3
+    if psm == GS_PSM_T8:
+        return width * height
+    return (width * height) >> 1
+
+
+def convert_image(path):
+    chunks = read_png_chunks(path)
+    width, height, depth, color_type = struct.unpack('>IIBB', chunks[b'IHDR'][:10])
+
+    image = Image.open(path)
+    image.load()
+    clut = b''
+
+    if color_type == PNG_COLOR_TYPE_PALETTE and depth in (4, 8):
+        indices = image.tobytes()
+        if depth == 8:
+            psm = GS_PSM_T8
+            pixels = indices
+            clut = build_clut(chunks, 256)
+        else:
+            psm = GS_PSM_T4
+            half = width // 2
+            packed = bytearray(texture_size(width, height, psm))
+            for y in range(height):
+                row = indices[y * width:(y + 1) * width]
+                for x in range(half):
+                    # First pixel in the low nibble, as expected by the GS.
+                    packed[y * half + x] = (row[x * 2] & 0x0F) | ((row[x * 2 + 1] & 0x0F) << 4)
+            pixels = bytes(packed)
+            clut = build_clut(chunks, 16)
+    elif color_type in (2, 6) or color_type == PNG_COLOR_TYPE_PALETTE:
+        has_alpha = color_type == 6 or (color_type == PNG_COLOR_TYPE_PALETTE and b'tRNS' in chunks)
+        if has_alpha:
+            psm = GS_PSM_CT32
+            rgba = bytearray(image.convert('RGBA').tobytes())
+            for i in range(3, len(rgba), 4):
+                rgba[i] >>= 1
+            pixels = bytes(rgba)
+        else:
+            psm = GS_PSM_CT24
+            pixels = image.convert('RGB').tobytes()
+    else:
+        raise SkipImage("unsupported colour type %d" % color_type)
+
+    if width > MAX_DIMENSION or height > MAX_DIMENSION or texture_size(width, height, psm) > MAX_SIZE:
+        raise SkipImage("too large (%dx%d)" % (width, height))
+
+    header = struct.pack('<IHHHHBBHII', GST_MAGIC, GST_VERSION, GST_HEADER_SIZE, width, height,
+                         psm, GS_PSM_CT32 if clut else 0, 0, len(pixels), len(clut))
+    header += bytes(GST_HEADER_SIZE - len(header))
+
+    return header + pixels + clut
+
+
+def convert_file(job):
+    src, dst = job
+    try:
+        data = convert_image(src)
+    except SkipImage as e:
+        return (src, "skipped: %s" % e)
+    except (OSError, zlib.error, struct.error) as e:
+        return (src, "failed: %s" % e)
+
+    tmp = dst + ".tmp"
+    with open(tmp, 'wb') as f:
+        f.write(data)
+    os.replace(tmp, dst)
+    return (src, None)
+
+
+def collect_jobs(paths, force):
+    jobs = []
+    for path in paths:
+        if os.path.isdir(path):
+            names = sorted(os.listdir(path))
+            files = [os.path.join(path, n) for n in names]
+        else:
+            files = [path]
+
+        for src in files:
+            base, ext = os.path.splitext(src)
+            if ext.lower() != '.png' or not os.path.isfile(src):
+                continue
+            dst = base + '.gst'
+            if not force and os.path.exists(dst) and os.path.getmtime(dst) >= os.path.getmtime(src):
+                continue
+            jobs.append((src, dst))
+    return jobs
+
+
+def write_markers(paths):
+    folders = set(path if os.path.isdir(path) else os.path.dirname(path) for path in paths)
+    for folder in sorted(folders):
+        marker = os.path.join(folder, GST_DIR_MARKER)
+        if os.path.exists(marker) or not any(n.lower().endswith('.gst') for n in os.listdir(folder or '.')):
+            continue
+        with open(marker, 'w') as f:
+            f.write("Images of this folder were converted by png2gst.py\n")
+
+
+def usage():
+    print("png2gst - converts PNG images into pre-converted GS textures for OPL")
+    print("Usage: png2gst [-f] [-j jobs] ART_DIR|FILE.png ...")
+    print("  -f Convert even if an up-to-date .gst file exists")
+    print("  -j Number of worker processes (default: all cores)")
+
+
+def main():
+    try:
+        optlist, args = gnu_getopt(sys.argv[1:], "fj:h")
+    except GetoptError as err:
+        print(str(err))
+        usage()
+        sys.exit(-1)
+
+    force = False
+    workers = os.cpu_count()
+    for o, a in optlist:
+        if o == '-f':
+            force = True
+        elif o == '-j':
+            workers = int(a)
+        elif o == '-h':
+            usage()
+            sys.exit(0)
+
+    if not args:
+        usage()
+        sys.exit(-1)
+
+    jobs = collect_jobs(args, force)
+    converted = 0
+    with Pool(workers) as pool:
+        for src, error in pool.imap_unordered(convert_file, jobs, chunksize=8):
+            if error:
+                print("%s: %s" % (src, error))
+            else:
+                converted += 1
+
+    write_markers(args)
+    print("Converted %d of %d image(s)" % (converted, len(jobs)))
+
+
+if __name__ == "__main__":
+    main()
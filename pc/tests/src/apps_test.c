@@ -0,0 +1,305 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Benchmarks the apps index of src/appsindex.c over a generated APPS folder, and checks that it lists the same apps
+  as parsing every title.cfg.
+
+  The first scan has no index, so it parses every title.cfg, as every refresh of the Apps tab did before the index.
+  The next scans only stat the title.cfg files. Then some apps are edited, removed and added, and only those
+  must be parsed again. Apps whose folder name is too long for the index are parsed at every scan, and index files
+  of an older version are ignored.
+
+  Usage: apps_test [app count]
+*/
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "include/opl.h"
+#include "include/appsupport.h"
+#include "include/appsindex.h"
+
+#define DEFAULT_APPS 500
+#define NOT_APPS     20 // Folders without title.cfg
+#define EDITED       10
+#define REMOVED      5
+#define ADDED        5
+#define LONG_NAMES   100 // Every 100th app has a folder name too long for the index
+
+static int parses;
+
+// Stand-in for the config module: title.cfg files are read with stdio, like configRead does through the io functions
+config_set_t *configAlloc(int type, config_set_t *configSet, char *fileName)
+{
+    configSet = calloc(1, sizeof(config_set_t));
+    configSet->type = type;
+    configSet->filename = strdup(fileName);
+
+    return configSet;
+}
+
+int configRead(config_set_t *configSet)
+{
+    char line[512], *sep;
+    FILE *file;
+
+    parses++;
+
+    if ((file = fopen(configSet->filename, "r")) == NULL)
+        return 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        struct config_value_t *value;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        if ((sep = strchr(line, '=')) == NULL)
+            continue;
+        *sep = '\0';
+
+        value = calloc(1, sizeof(struct config_value_t));
+        snprintf(value->key, sizeof(value->key), "%s", line);
+        snprintf(value->val, sizeof(value->val), "%s", sep + 1);
+        if (configSet->tail)
+            configSet->tail->next = value;
+        else
+            configSet->head = value;
+        configSet->tail = value;
+    }
+
+    fclose(file);
+    return 1;
+}
+
+int configGetStr(config_set_t *configSet, const char *key, const char **value)
+{
+    struct config_value_t *val;
+
+    for (val = configSet->head; val != NULL; val = val->next) {
+        if (!strcmp(val->key, key)) {
+            *value = val->val;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void configFree(config_set_t *configSet)
+{
+    struct config_value_t *val, *next;
+
+    for (val = configSet->head; val != NULL; val = next) {
+        next = val->next;
+        free(val);
+    }
+
+    free(configSet->filename);
+    free(configSet);
+}
+
+static char appsPath[256], indexPath[256];
+static int appCount;
+static int *version; // Per generated app, 0 if removed
+static char *seen;
+static int listed, errors;
+
+static void appFolder(int id, char *path, int size)
+{
+    if (id % LONG_NAMES == LONG_NAMES - 1)
+        snprintf(path, size, "%s/APP_%04d_%.*s", appsPath, id, APP_FOLDER_MAX, "A_FOLDER_NAME_LONGER_THAN_THE_FOLDERS_OF_THE_INDEX_CAN_HOLD______");
+    else
+        snprintf(path, size, "%s/APP_%04d", appsPath, id);
+}
+
+// Present apps whose folder name is too long for the index
+static int longApps(void)
+{
+    int i, count = 0;
+
+    for (i = LONG_NAMES - 1; i < appCount + ADDED; i += LONG_NAMES) {
+        if (version[i] != 0)
+            count++;
+    }
+
+    return count;
+}
+
+static void writeApp(int id)
+{
+    char path[512];
+    FILE *file;
+
+    appFolder(id, path, sizeof(path));
+    mkdir(path, 0755);
+    strcat(path, "/" APP_TITLE_CONFIG_FILE);
+    file = fopen(path, "w");
+    // Each version is longer, so that the size changes even within the same second
+    fprintf(file, "title=Application %d%.*s\nboot=APP_%04d.ELF\nargv1=-v%d\n", id, version[id], "++++++++++++++++", id, version[id]);
+    fclose(file);
+}
+
+static void removeApp(int id)
+{
+    char path[512];
+
+    appFolder(id, path, sizeof(path));
+    strcat(path, "/" APP_TITLE_CONFIG_FILE);
+    unlink(path);
+    appFolder(id, path, sizeof(path));
+    rmdir(path);
+    version[id] = 0;
+}
+
+static int checkApp(const char *path, const char *title, const char *boot, const char *argv1, void *arg)
+{
+    char expected[128];
+    int id;
+
+    if (sscanf(strrchr(path, '/'), "/APP_%d", &id) != 1 || id < 0 || id >= appCount + ADDED || version[id] == 0 || seen[id]) {
+        printf("Unexpected app %s\n", path);
+        errors++;
+        return 1;
+    }
+    seen[id] = 1;
+
+    snprintf(expected, sizeof(expected), "Application %d%.*s", id, version[id], "++++++++++++++++");
+    if (strcmp(title, expected))
+        errors++;
+    snprintf(expected, sizeof(expected), "APP_%04d.ELF", id);
+    if (strcmp(boot, expected))
+        errors++;
+    snprintf(expected, sizeof(expected), "-v%d", version[id]);
+    if (strcmp(argv1, expected))
+        errors++;
+
+    listed++;
+    return 0;
+}
+
+// The apps whose folder name is too long for the index are parsed in addition to expectedParses
+static int scan(const char *name, int expectedParses)
+{
+    struct timeval start, end;
+    int i, count, missing = 0;
+
+    expectedParses += longApps();
+    memset(seen, 0, appCount + ADDED);
+    listed = 0;
+    parses = 0;
+
+    gettimeofday(&start, NULL);
+    count = appsIndexScan(&checkApp, NULL, appsPath, indexPath, 0);
+    gettimeofday(&end, NULL);
+
+    for (i = 0; i < appCount + ADDED; i++) {
+        if (version[i] != 0 && !seen[i])
+            missing++;
+    }
+
+    printf("%-16s %4d apps, %4d title.cfg parsed, %7.2f ms\n", name, count, parses,
+           (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0);
+
+    if (count != listed || missing || parses != expectedParses) {
+        printf("%s: %d missing apps, %d parses instead of %d\n", name, missing, parses, expectedParses);
+        errors++;
+    }
+
+    return errors;
+}
+
+static void cleanup(void)
+{
+    char path[512];
+    int i;
+
+    for (i = 0; i < appCount + ADDED; i++) {
+        if (version[i])
+            removeApp(i);
+    }
+    for (i = 0; i < NOT_APPS; i++) {
+        snprintf(path, sizeof(path), "%s/DATA_%02d", appsPath, i);
+        rmdir(path);
+    }
+    unlink(indexPath);
+    rmdir(appsPath);
+}
+
+int main(int argc, char **argv)
+{
+    app_index_entry_t *entries;
+    char path[512];
+    FILE *file;
+    int i, size;
+
+    appCount = argc > 1 ? atoi(argv[1]) : DEFAULT_APPS;
+    if (appCount < EDITED + REMOVED) {
+        printf("Usage: %s [app count, at least %d]\n", argv[0], EDITED + REMOVED);
+        return 1;
+    }
+
+    strcpy(appsPath, "/tmp/apps_test.XXXXXX");
+    if (mkdtemp(appsPath) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(indexPath, sizeof(indexPath), "%s/%s", appsPath, APP_INDEX_FILE);
+
+    version = calloc(appCount + ADDED, sizeof(int));
+    seen = calloc(appCount + ADDED, 1);
+
+    for (i = 0; i < appCount; i++) {
+        version[i] = 1;
+        writeApp(i);
+    }
+    for (i = 0; i < NOT_APPS; i++) {
+        snprintf(path, sizeof(path), "%s/DATA_%02d", appsPath, i);
+        mkdir(path, 0755);
+    }
+
+    scan("No index", appCount - longApps());
+    scan("Index", 0);
+    scan("Index again", 0);
+
+    for (i = 0; i < EDITED; i++) {
+        version[i * 7 % appCount]++;
+        writeApp(i * 7 % appCount);
+    }
+    for (i = 0; i < REMOVED; i++)
+        removeApp(appCount - 1 - i * 3);
+    for (i = 0; i < ADDED; i++) {
+        version[appCount + i] = 1;
+        writeApp(appCount + i);
+    }
+
+    scan("Changed apps", EDITED + ADDED);
+    scan("Index", 0);
+
+    unlink(indexPath);
+    scan("Index deleted", appCount - REMOVED + ADDED - longApps());
+    scan("Index", 0);
+
+    // An index of the previous version: the same entries, without header
+    file = fopen(indexPath, "rb");
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, size % sizeof(app_index_entry_t), SEEK_SET);
+    entries = malloc(size);
+    size = fread(entries, 1, size, file);
+    fclose(file);
+    file = fopen(indexPath, "wb");
+    fwrite(entries, 1, size, file);
+    fclose(file);
+    free(entries);
+    scan("Old index", appCount - REMOVED + ADDED - longApps());
+    scan("Index", 0);
+
+    cleanup();
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
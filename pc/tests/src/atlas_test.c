@@ -0,0 +1,280 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Packs the glyphs of a font into the glyph atlases of src/atlas.c, as fntsys does, and reports the occupancy.
+
+  The first pass places every glyph, opening as many atlases as needed. The second pass streams the glyph set
+  through the ATLAS_MAX atlases fntsys has per font, evicting the least recently used glyphs when they are full.
+  After each pass, every live glyph is checked to be inside its atlas, not overlapping another one and holding
+  its pixels, and the rest of the atlas to be cleared.
+
+  Usage: atlas_test <font file> | -cjk <glyph count>
+  -cjk packs synthetic full-width glyphs (the sizes of a CJK font at the default size) instead of a font file.
+*/
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "include/opl.h"
+#include "include/atlas.h"
+#include "include/fntsys.h"
+
+// As in fntsys.c
+#define ATLAS_MAX    4
+#define ATLAS_WIDTH  256
+#define ATLAS_HEIGHT 256
+#define MAX_ATLASES  256 // First pass
+
+typedef struct
+{
+    int width, height;
+    u8 *pixels;
+
+    atlas_t *atlas;
+    struct atlas_allocation_t *allocation;
+    unsigned int lastUse;
+} glyph_t;
+
+static glyph_t *glyphs;
+static int glyphCount;
+
+static atlas_t *atlases[MAX_ATLASES];
+static int atlasCount;
+
+static int loadFont(const char *path)
+{
+    FT_Library library;
+    FT_Face face;
+    FT_ULong charcode;
+    FT_UInt gindex;
+    int capacity = 1024;
+
+    if (FT_Init_FreeType(&library) || FT_New_Face(library, path, 0, &face)) {
+        fprintf(stderr, "Can't open the font %s\n", path);
+        return -1;
+    }
+
+    FT_Set_Char_Size(face, FNTSYS_DEFAULT_SIZE * 64, FNTSYS_DEFAULT_SIZE * 64, 72, 72);
+
+    glyphs = malloc(capacity * sizeof(glyph_t));
+    for (charcode = FT_Get_First_Char(face, &gindex); gindex != 0; charcode = FT_Get_Next_Char(face, charcode, &gindex)) {
+        FT_Bitmap *bitmap = &face->glyph->bitmap;
+        glyph_t *glyph;
+        int y;
+
+        if (FT_Load_Char(face, charcode, FT_LOAD_RENDER) || bitmap->width == 0 || bitmap->rows == 0)
+            continue;
+
+        if (glyphCount == capacity) {
+            capacity *= 2;
+            glyphs = realloc(glyphs, capacity * sizeof(glyph_t));
+        }
+
+        glyph = &glyphs[glyphCount++];
+        memset(glyph, 0, sizeof(glyph_t));
+        glyph->width = bitmap->width;
+        glyph->height = bitmap->rows;
+        glyph->pixels = malloc(glyph->width * glyph->height);
+        for (y = 0; y < glyph->height; y++)
+            memcpy(&glyph->pixels[y * glyph->width], &bitmap->buffer[y * bitmap->pitch], glyph->width);
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    return glyphCount;
+}
+
+static int makeCjkGlyphs(int count)
+{
+    int i, p;
+
+    glyphs = malloc(count * sizeof(glyph_t));
+    for (i = 0; i < count; i++) {
+        glyph_t *glyph = &glyphs[i];
+
+        memset(glyph, 0, sizeof(glyph_t));
+        glyph->width = FNTSYS_DEFAULT_SIZE - 3 + rand() % 3;
+        glyph->height = FNTSYS_DEFAULT_SIZE - 4 + rand() % 5;
+        glyph->pixels = malloc(glyph->width * glyph->height);
+        for (p = 0; p < glyph->width * glyph->height; p++)
+            glyph->pixels[p] = 1 + rand() % 255;
+    }
+
+    return glyphCount = count;
+}
+
+static void atlasesFree(void)
+{
+    int i;
+
+    for (i = 0; i < atlasCount; i++)
+        atlasFree(atlases[i]);
+    atlasCount = 0;
+
+    for (i = 0; i < glyphCount; i++) {
+        glyphs[i].atlas = NULL;
+        glyphs[i].allocation = NULL;
+    }
+}
+
+static int place(glyph_t *glyph, int maxAtlases)
+{
+    int i;
+
+    for (i = 0; i < maxAtlases; i++) {
+        if (i == atlasCount) {
+            atlases[i] = atlasNew(ATLAS_WIDTH, ATLAS_HEIGHT, GS_PSM_T8);
+            atlasCount++;
+        }
+
+        glyph->allocation = atlasPlace(atlases[i], glyph->width, glyph->height, glyph->pixels);
+        if (glyph->allocation) {
+            glyph->atlas = atlases[i];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int evictOldest(void)
+{
+    glyph_t *oldest = NULL;
+    int i;
+
+    for (i = 0; i < glyphCount; i++) {
+        if (glyphs[i].allocation && (!oldest || glyphs[i].lastUse < oldest->lastUse))
+            oldest = &glyphs[i];
+    }
+
+    if (!oldest)
+        return 0;
+
+    atlasRelease(oldest->atlas, oldest->allocation);
+    oldest->atlas = NULL;
+    oldest->allocation = NULL;
+
+    return 1;
+}
+
+static int check(const char *pass)
+{
+    static u8 owner[ATLAS_WIDTH * ATLAS_HEIGHT];
+    int a, i, x, y, errors = 0;
+
+    for (a = 0; a < atlasCount; a++) {
+        const u8 *mem = (const u8 *)atlases[a]->surface.Mem;
+
+        memset(owner, 0, sizeof(owner));
+
+        for (i = 0; i < glyphCount; i++) {
+            glyph_t *glyph = &glyphs[i];
+            struct atlas_allocation_t *al = glyph->allocation;
+
+            if (glyph->atlas != atlases[a])
+                continue;
+
+            if (!al->used || al->x < 0 || al->y < 0 || al->x + al->w > ATLAS_WIDTH || al->y + al->h > ATLAS_HEIGHT || al->w <= glyph->width || al->h <= glyph->height) {
+                printf("%s: glyph %d has a bad allocation %d,%d %dx%d\n", pass, i, al->x, al->y, al->w, al->h);
+                return 1;
+            }
+
+            for (y = al->y; y < al->y + al->h; y++) {
+                for (x = al->x; x < al->x + al->w; x++) {
+                    if (owner[y * ATLAS_WIDTH + x]++)
+                        errors++;
+                }
+            }
+
+            for (y = 0; y < glyph->height; y++) {
+                if (memcmp(&mem[(al->y + y) * ATLAS_WIDTH + al->x], &glyph->pixels[y * glyph->width], glyph->width))
+                    errors++;
+            }
+        }
+
+        // Pixels not covered by a glyph bitmap (padding, released space) must be cleared
+        for (i = 0; i < glyphCount; i++) {
+            glyph_t *glyph = &glyphs[i];
+
+            if (glyph->atlas == atlases[a]) {
+                for (y = 0; y < glyph->height; y++)
+                    memset(&owner[(glyph->allocation->y + y) * ATLAS_WIDTH + glyph->allocation->x], 0xFF, glyph->width);
+            }
+        }
+        for (i = 0; i < ATLAS_WIDTH * ATLAS_HEIGHT; i++) {
+            if (owner[i] != 0xFF && mem[i] != 0)
+                errors++;
+        }
+    }
+
+    if (errors)
+        printf("%s: %d overlapping, damaged or stale pixels\n", pass, errors);
+
+    return errors != 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int use = 0;
+    int i, round, failed = 0, evictions = 0, occupancy = 0;
+
+    if (argc == 3 && !strcmp(argv[1], "-cjk")) {
+        srand(1);
+        makeCjkGlyphs(atoi(argv[2]));
+    } else if (argc == 2) {
+        if (loadFont(argv[1]) < 0)
+            return 1;
+    } else {
+        printf("Usage: %s <font file> | -cjk <glyph count>\n", argv[0]);
+        return 1;
+    }
+
+    // Every glyph at once
+    for (i = 0; i < glyphCount; i++) {
+        if (!place(&glyphs[i], MAX_ATLASES))
+            failed++;
+    }
+
+    for (i = 0; i < atlasCount; i++)
+        occupancy += atlasOccupancy(atlases[i]);
+
+    printf("%d glyphs in %d atlases, %d%% occupancy (last atlas %d%%), %d not placed\n", glyphCount, atlasCount,
+           atlasCount > 1 ? (occupancy - atlasOccupancy(atlases[atlasCount - 1])) / (atlasCount - 1) : occupancy,
+           atlasOccupancy(atlases[atlasCount - 1]), failed);
+
+    if (failed || check("Pack"))
+        return 1;
+
+    atlasesFree();
+
+    // Text-like use of the whole set through the atlases of one font, twice
+    for (round = 0; round < 2 * glyphCount; round++) {
+        glyph_t *glyph = &glyphs[rand() % 4 == 0 ? rand() % 64 % glyphCount : rand() % glyphCount];
+
+        glyph->lastUse = ++use;
+        if (glyph->allocation)
+            continue;
+
+        while (!place(glyph, ATLAS_MAX)) {
+            if (!evictOldest()) {
+                failed++;
+                break;
+            }
+            evictions++;
+        }
+    }
+
+    for (occupancy = 0, i = 0; i < atlasCount; i++)
+        occupancy += atlasOccupancy(atlases[i]);
+
+    printf("LRU over %d atlases: %d evictions, %d%% occupancy, %d not placed\n", atlasCount, evictions, occupancy / atlasCount, failed);
+
+    if (failed || check("LRU"))
+        return 1;
+
+    atlasesFree();
+
+    return 0;
+}
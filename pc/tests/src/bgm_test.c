@@ -0,0 +1,676 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Plays the background music through the real BGM threads of src/sound.c and checks that audsrv receives the exact
+  samples libvorbisfile decodes from the file, looping, both while decoding and from the PCM cache.
+
+  The EE threads and semaphores are emulated with pthreads, one running at a time, and audsrv_play_audio() records
+  what it is given.
+  The plays are:
+  - Stopped before the end of the stream: no cache must be left.
+  - Decoded to the end: the cache must be complete and hold the decoded PCM.
+  - From the cache, the Ogg file being replaced by garbage of the same size, which only the cache can play.
+  - With the cache header of an interrupted write: the file is decoded, and cached again.
+  Then audsrv lets the I/O thread run while it plays, like the IOP does, so that the ring stays filled. Decoding and
+  from the cache, the plays must not count any underrun: as they are, with the reads that go back to the start of the
+  stream made slow (fseek), and with the first fill made slow. Reads made slow in the middle of the stream (fread) let
+  the ring empty, and each of them must count one underrun.
+
+  Usage: bgm_test [Ogg file]
+  Without libvorbisfile, the test builds with a stand-in decoder (stubs/vorbisfile) and generates its own stream.
+*/
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <audsrv.h>
+#include <vorbis/vorbisfile.h>
+
+#include "include/opl.h"
+#include "include/sound.h"
+
+#define MAX_THREADS 4
+#define MAX_SEMAS   4
+
+#define BGM_CACHE_HEADER_SIZE 20
+
+int gEnableSFX, gEnableBGM, gSFXVolume, gBootSndVolume, gBGMVolume, gBGMCache;
+char gDefaultBGMPath[128];
+
+void *_gp;
+
+// Built into the OPL binary from the files of audio/
+unsigned char boot_adp[1], cancel_adp[1], confirm_adp[1], cursor_adp[1], message_adp[1], transition_adp[1], bd_connect_adp[1], bd_disconnect_adp[1];
+unsigned int size_boot_adp, size_cancel_adp, size_confirm_adp, size_cursor_adp, size_message_adp, size_transition_adp, size_bd_connect_adp, size_bd_disconnect_adp;
+
+/*--    EE kernel    ---------------------------------------------------------------------------------------------------*/
+
+/* One thread runs at a time, as on the EE: cpu is held while running and only released while blocked.
+   The BGM threads count on it, the BGM thread not being interrupted by its I/O thread. */
+static pthread_mutex_t cpu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+
+typedef struct
+{
+    int used;
+    void (*func)(void *arg);
+    void *arg;
+    pthread_t thread;
+    int started;
+    int finished;
+    int sleeping;
+    int waitSema; // Semaphore waited for, -1 if none
+    int yielding;
+    int stalled;
+    int wakeups;
+} thread_t;
+
+static thread_t threads[MAX_THREADS]; // 0 is the main thread
+static __thread int currentThread;
+
+static int semaCount[MAX_SEMAS];
+static int semaUsed[MAX_SEMAS];
+
+static void *threadStart(void *arg)
+{
+    thread_t *thread = arg;
+
+    pthread_mutex_lock(&cpu);
+    currentThread = thread - threads;
+    thread->func(thread->arg);
+    thread->finished = 1;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&cpu);
+
+    return NULL;
+}
+
+s32 CreateThread(ee_thread_t *thread)
+{
+    int id;
+
+    for (id = 1; id < MAX_THREADS; id++) {
+        if (!threads[id].used) {
+            memset(&threads[id], 0, sizeof(thread_t));
+            threads[id].used = 1;
+            threads[id].func = thread->func;
+            threads[id].waitSema = -1;
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+s32 StartThread(s32 thread_id, void *args)
+{
+    threads[thread_id].arg = args;
+    threads[thread_id].started = 1;
+    return pthread_create(&threads[thread_id].thread, NULL, &threadStart, &threads[thread_id]) == 0 ? 0 : -1;
+}
+
+// Only deleted once they returned, as OPL does
+s32 DeleteThread(s32 thread_id)
+{
+    if (threads[thread_id].started) {
+        pthread_mutex_unlock(&cpu);
+        pthread_join(threads[thread_id].thread, NULL);
+        pthread_mutex_lock(&cpu);
+    }
+    threads[thread_id].used = 0;
+
+    return 0;
+}
+
+s32 GetThreadId(void)
+{
+    return currentThread;
+}
+
+// A thread that yields waits for the others, unless they stall: the thread that stalls is waited for by none
+static int canRun(int id)
+{
+    thread_t *thread = &threads[id];
+
+    if (!thread->started || thread->finished || thread->stalled)
+        return 0;
+    if (thread->yielding)
+        return threads[currentThread].stalled;
+    if (thread->sleeping)
+        return thread->wakeups > 0;
+    if (thread->waitSema >= 0)
+        return semaCount[thread->waitSema] > 0;
+
+    return 1;
+}
+
+static void waitOthers(void)
+{
+    int id;
+
+    pthread_cond_broadcast(&changed);
+    for (id = 1; id < MAX_THREADS; id++) {
+        if (id != currentThread && canRun(id)) {
+            pthread_cond_wait(&changed, &cpu);
+            id = 0;
+        }
+    }
+}
+
+// Lets the other threads run until they are all blocked
+static void yieldThread(void)
+{
+    threads[currentThread].yielding = 1;
+    waitOthers();
+    threads[currentThread].yielding = 0;
+}
+
+// Blocks the thread until the others are blocked, even those that yield
+static void stallThread(void)
+{
+    threads[currentThread].stalled = 1;
+    waitOthers();
+    threads[currentThread].stalled = 0;
+}
+
+s32 SleepThread(void)
+{
+    threads[currentThread].sleeping = 1;
+    pthread_cond_broadcast(&changed);
+    while (threads[currentThread].wakeups == 0)
+        pthread_cond_wait(&changed, &cpu);
+    threads[currentThread].sleeping = 0;
+    threads[currentThread].wakeups--;
+
+    return 0;
+}
+
+s32 WakeupThread(s32 thread_id)
+{
+    threads[thread_id].wakeups++;
+    pthread_cond_broadcast(&changed);
+
+    return 0;
+}
+
+s32 iWakeupThread(s32 thread_id)
+{
+    return WakeupThread(thread_id);
+}
+
+s32 CreateSema(ee_sema_t *sema)
+{
+    int id;
+
+    for (id = 0; id < MAX_SEMAS; id++) {
+        if (!semaUsed[id]) {
+            semaUsed[id] = 1;
+            semaCount[id] = sema->init_count;
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+s32 DeleteSema(s32 sema_id)
+{
+    semaUsed[sema_id] = 0;
+    return 0;
+}
+
+s32 SignalSema(s32 sema_id)
+{
+    semaCount[sema_id]++;
+    pthread_cond_broadcast(&changed);
+
+    return sema_id;
+}
+
+static void readStarted(void);
+
+s32 WaitSema(s32 sema_id)
+{
+    // Only the I/O thread waits, before each read
+    if (currentThread != 0)
+        readStarted();
+
+    threads[currentThread].waitSema = sema_id;
+    pthread_cond_broadcast(&changed);
+    while (semaCount[sema_id] == 0)
+        pthread_cond_wait(&changed, &cpu);
+    threads[currentThread].waitSema = -1;
+    semaCount[sema_id]--;
+
+    return sema_id;
+}
+
+s32 PollSema(s32 sema_id)
+{
+    if (semaCount[sema_id] == 0)
+        return -1;
+
+    semaCount[sema_id]--;
+    return sema_id;
+}
+
+// The other threads run until the alarm
+s32 SetAlarm(u16 time, void (*callback)(s32 alarm_id, u16 time, void *common), void *common)
+{
+    pthread_mutex_unlock(&cpu);
+    usleep(1000);
+    pthread_mutex_lock(&cpu);
+    callback(0, time, common);
+
+    return 0;
+}
+
+/*--    audsrv    ------------------------------------------------------------------------------------------------------*/
+
+static char *played;
+static size_t playedSize, playedCapacity;
+static int playedChannels, playedRate;
+
+int audsrv_init(void)
+{
+    return 0;
+}
+
+int audsrv_quit(void)
+{
+    return 0;
+}
+
+const char *audsrv_get_error_string(void)
+{
+    return "";
+}
+
+int audsrv_set_format(struct audsrv_fmt_t *fmt)
+{
+    playedChannels = fmt->channels;
+    playedRate = fmt->freq;
+    return 0;
+}
+
+int audsrv_set_volume(int volume)
+{
+    return 0;
+}
+
+static int pacedAudio; // Lets the I/O thread run while the audio plays
+
+int audsrv_wait_audio(int bytes)
+{
+    if (pacedAudio)
+        yieldThread();
+
+    return 0;
+}
+
+int audsrv_play_audio(const char *chunk, int bytes)
+{
+    if (playedSize + bytes > playedCapacity) {
+        playedCapacity = (playedSize + bytes) * 2;
+        played = realloc(played, playedCapacity);
+    }
+    memcpy(&played[playedSize], chunk, bytes);
+    playedSize += bytes;
+    pthread_cond_broadcast(&changed);
+
+    return bytes;
+}
+
+int audsrv_stop_audio(void)
+{
+    return 0;
+}
+
+int audsrv_adpcm_init(void)
+{
+    return 0;
+}
+
+int audsrv_adpcm_set_volume(int ch, int volume)
+{
+    return 0;
+}
+
+int audsrv_load_adpcm(audsrv_adpcm_t *adpcm, void *buffer, int size)
+{
+    return 0;
+}
+
+int audsrv_ch_play_adpcm(int ch, audsrv_adpcm_t *adpcm)
+{
+    return 0;
+}
+
+/*--    Slow I/O    ----------------------------------------------------------------------------------------------------*/
+
+/* The I/O thread seeks to go back to the start of the stream, both in the cache and in the Ogg file (through the
+   callbacks of vorbisfile), and reads the rest of the time. A slow call lets the BGM thread play all the ring. */
+static int slowSeeks, slowReads, slowFirstRead; // Seeks or every slowReads reads made slow, or the reads before the first part is played
+static int readCount, slowInRead, seekInRead;
+static int expectedUnderruns; // Reads made slow in the middle of the stream
+
+int __real_fseek(FILE *stream, long offset, int whence);
+size_t __real_fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
+
+// The previous read is done and queued
+static void readStarted(void)
+{
+    if (slowInRead && !seekInRead)
+        expectedUnderruns++;
+
+    slowInRead = 0;
+    seekInRead = 0;
+}
+
+int __wrap_fseek(FILE *stream, long offset, int whence)
+{
+    if (currentThread != 0) {
+        seekInRead = 1;
+        if (slowSeeks)
+            stallThread();
+    }
+
+    return __real_fseek(stream, offset, whence);
+}
+
+size_t __wrap_fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    if (currentThread != 0) {
+        if (slowFirstRead && playedSize == 0) {
+            stallThread();
+        } else if (slowReads && playedSize > 0 && !slowInRead && ++readCount % slowReads == 0) {
+            // Once per read at most, after parts were queued
+            slowInRead = 1;
+            stallThread();
+        }
+    }
+
+    return __real_fread(ptr, size, nmemb, stream);
+}
+
+/*--    Themes    ------------------------------------------------------------------------------------------------------*/
+
+int thmGetGuiValue(void)
+{
+    return 0; // The default theme, which plays gDefaultBGMPath
+}
+
+char *thmGetFilePath(int themeID)
+{
+    return NULL;
+}
+
+/*--    Test    --------------------------------------------------------------------------------------------------------*/
+
+static char *reference;
+static long referenceSize;
+static int referenceChannels;
+static long referenceRate;
+static char cachePath[256];
+static int errors;
+
+// Decodes the whole file directly with libvorbisfile
+static int decodeReference(const char *path)
+{
+    OggVorbis_File vf;
+    vorbis_info *vi;
+    FILE *file;
+    long capacity = 1024 * 1024, ret;
+    int bitStream;
+
+    if ((file = fopen(path, "rb")) == NULL || ov_open_callbacks(file, &vf, NULL, 0, OV_CALLBACKS_DEFAULT) < 0) {
+        printf("Can't decode %s\n", path);
+        return -1;
+    }
+
+    vi = ov_info(&vf, -1);
+    referenceChannels = vi->channels;
+    referenceRate = vi->rate;
+
+    reference = malloc(capacity);
+    while ((ret = ov_read(&vf, &reference[referenceSize], capacity - referenceSize, 0, 2, 1, &bitStream)) != 0) {
+        if (ret < 0) {
+            printf("Decoding error %ld in %s\n", ret, path);
+            return -1;
+        }
+
+        referenceSize += ret;
+        if (referenceSize == capacity) {
+            capacity *= 2;
+            reference = realloc(reference, capacity);
+        }
+    }
+
+    ov_clear(&vf);
+
+    return 0;
+}
+
+#ifdef BGM_TEST_STANDIN
+// 2.5 seconds of a stereo sweep, for the stand-in decoder
+static void writeStandinStream(const char *path)
+{
+    bgm_standin_header_t header;
+    FILE *file;
+    s16 frame[2];
+    int i;
+
+    memcpy(header.magic, OV_STANDIN_MAGIC, sizeof(header.magic));
+    header.channels = 2;
+    header.rate = 44100;
+
+    file = fopen(path, "wb");
+    fwrite(&header, 1, sizeof(header), file);
+    for (i = 0; i < 44100 * 5 / 2; i++) {
+        frame[0] = (s16)(i * 37);
+        frame[1] = (s16)(i * i / 7 + i);
+        fwrite(frame, 1, sizeof(frame), file);
+    }
+    fclose(file);
+}
+#endif
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+/* Plays until at least minSize bytes reached audsrv, and checks they are the decoded stream from its start, looping.
+   With paced audio, the underruns must be those of the reads made slow in the middle of the stream. */
+static void play(const char *name, size_t minSize)
+{
+    int depth, minDepth, underruns;
+    size_t offset, chunk;
+
+    playedSize = 0;
+    readCount = 0;
+    slowInRead = 0;
+    seekInRead = 0;
+    expectedUnderruns = 0;
+
+    gEnableBGM = 1;
+    bgmStart();
+    if (!isBgmPlaying()) {
+        printf("%s: BGM not started\n", name);
+        errors++;
+        return;
+    }
+
+    while (playedSize < minSize)
+        pthread_cond_wait(&changed, &cpu);
+
+    bgmGetRingStats(&depth, &minDepth, &underruns);
+    bgmStop();
+
+    printf("%-16s %8zu bytes played, minimum ring depth %d, %d underruns\n", name, playedSize, minDepth, underruns);
+    if (pacedAudio && underruns != expectedUnderruns) {
+        printf("%s: %d underruns instead of %d\n", name, underruns, expectedUnderruns);
+        errors++;
+    }
+
+    check(name, playedChannels == referenceChannels && playedRate == referenceRate);
+    for (offset = 0; offset < playedSize; offset += chunk) {
+        chunk = referenceSize - offset % referenceSize;
+        if (chunk > playedSize - offset)
+            chunk = playedSize - offset;
+
+        if (memcmp(&played[offset], &reference[offset % referenceSize], chunk)) {
+            printf("%s: the samples differ from the decoded stream near byte %zu\n", name, offset);
+            errors++;
+            return;
+        }
+    }
+}
+
+// Checks that the cache is complete and holds the decoded stream
+static void checkCache(const char *name)
+{
+    u32 header[BGM_CACHE_HEADER_SIZE / 4];
+    char *pcm;
+    FILE *file;
+    int ok;
+
+    if ((file = fopen(cachePath, "rb")) == NULL) {
+        printf("%s: no cache\n", name);
+        errors++;
+        return;
+    }
+
+    pcm = malloc(referenceSize + 1);
+    ok = fread(header, 1, sizeof(header), file) == sizeof(header) && header[4] == referenceSize &&
+         fread(pcm, 1, referenceSize + 1, file) == referenceSize && !memcmp(pcm, reference, referenceSize);
+    fclose(file);
+    free(pcm);
+
+    check(name, ok);
+}
+
+static void copyFile(const char *from, const char *to)
+{
+    char buffer[4096];
+    FILE *in = fopen(from, "rb"), *out = fopen(to, "wb");
+    size_t size;
+
+    while ((size = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        fwrite(buffer, 1, size, out);
+
+    fclose(in);
+    fclose(out);
+}
+
+int main(int argc, char **argv)
+{
+    char dir[64], savedPath[128];
+    struct stat st;
+    FILE *file;
+    u32 header[BGM_CACHE_HEADER_SIZE / 4];
+    char *garbage;
+
+    // A broken ring or cache can keep the threads spinning
+    alarm(60);
+
+    pthread_mutex_lock(&cpu);
+
+    strcpy(dir, "/tmp/bgm_test.XXXXXX");
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(gDefaultBGMPath, sizeof(gDefaultBGMPath), "%s/bgm.ogg", dir);
+    snprintf(cachePath, sizeof(cachePath), "%s/bgm.pcm", dir);
+    snprintf(savedPath, sizeof(savedPath), "%s/saved.ogg", dir);
+
+    if (argc > 1) {
+        copyFile(argv[1], gDefaultBGMPath);
+    } else {
+#ifdef BGM_TEST_STANDIN
+        writeStandinStream(gDefaultBGMPath);
+#else
+        printf("bgm_test: skipped, give an Ogg file to play\n");
+        rmdir(dir);
+        return 0;
+#endif
+    }
+
+    if (decodeReference(gDefaultBGMPath) != 0 || referenceSize == 0)
+        return 1;
+    stat(gDefaultBGMPath, &st);
+    copyFile(gDefaultBGMPath, savedPath);
+
+    printf("%ld bytes of PCM, %d channels at %ld Hz\n", referenceSize, referenceChannels, referenceRate);
+
+    gBGMCache = 1;
+    audioInit();
+
+    play("Stopped early", referenceSize / 4);
+    check("No cache when stopped early", access(cachePath, F_OK) != 0);
+
+    play("Decoded", referenceSize * 2 + 12345);
+    checkCache("Complete cache");
+
+    // Same size, so that the cache is still valid for it
+    garbage = malloc(st.st_size);
+    memset(garbage, 0x55, st.st_size);
+    file = fopen(gDefaultBGMPath, "wb");
+    fwrite(garbage, 1, st.st_size, file);
+    fclose(file);
+    free(garbage);
+
+    play("From the cache", referenceSize * 2 + 12345);
+
+    // A cache written up to the end, but whose header was not completed
+    copyFile(savedPath, gDefaultBGMPath);
+    file = fopen(cachePath, "r+b");
+    fread(header, 1, sizeof(header), file);
+    header[4] = 0;
+    fseek(file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), file);
+    fclose(file);
+
+    play("Incomplete cache", referenceSize + 54321);
+    checkCache("Cache written again");
+
+    pacedAudio = 1;
+    gBGMCache = 0;
+    play("Paced", referenceSize * 2 + 12345);
+    slowSeeks = 1;
+    play("Slow loop", referenceSize * 2 + 12345);
+    slowSeeks = 0;
+    slowFirstRead = 1;
+    play("Slow first read", referenceSize / 2);
+    slowFirstRead = 0;
+    slowReads = 7;
+    play("Slow reads", referenceSize * 2 + 12345);
+    check("Slow reads underruns", expectedUnderruns > 0);
+    slowReads = 0;
+
+    gBGMCache = 1;
+    play("Paced, cache", referenceSize * 2 + 12345);
+    slowSeeks = 1;
+    play("Slow loop, cache", referenceSize * 2 + 12345);
+    slowSeeks = 0;
+    slowReads = 3;
+    play("Slow reads, cache", referenceSize * 2 + 12345);
+    check("Slow reads underruns, cache", expectedUnderruns > 0);
+    slowReads = 0;
+
+    audioEnd();
+
+    unlink(cachePath);
+    unlink(savedPath);
+    unlink(gDefaultBGMPath);
+    rmdir(dir);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
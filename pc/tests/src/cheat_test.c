@@ -0,0 +1,393 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Fuzzes the cheat program compiler of the frontend (src/cheatman.c) against the code handler of the EE core.
+
+  Random code lists are set through set_cheats_list(), as for a game. Each list is then run for a few frames on two
+  images of the EE RAM: once by CodeHandler, through rawCodeHandler() below, a C port of ee_core/src/cheat_engine.S,
+  and once by CheatProgramHandler() of ee_core/src/cheat_prog.c, over the program compiled from the list.
+  Both images must be identical after every frame. The lists that the compiler leaves to the code handler are
+  counted, but not run.
+
+  Usage: cheat_test [list count] [seed]
+*/
+
+#include "include/cheatman.h"
+#include "include/cheat_api.h"
+
+#define DEFAULT_LISTS 20000
+#define FRAMES        3
+#define MAX_LINES     40
+#define BASE          0x100000 // Where the codes write
+#define WINDOW        0x1000   // Around BASE, compared after every frame
+
+int gCheatSource;
+
+u8 *cheatRam;
+u32 codelist[MAX_CODES * 2 + 8];
+u32 numcodes;
+
+// The code list of CodeHandler, as SetupCheats() builds it, without the hooks
+static u32 rawList[MAX_CODES * 2 + 8];
+static u32 rawCount;
+
+config_set_t *configGetByType(int type)
+{
+    return NULL;
+}
+
+int configGetInt(config_set_t *configSet, const char *key, int *value)
+{
+    return 0;
+}
+
+/*
+ * rawCodeHandler - C port of CodeHandler of cheat_engine.S, register for register.
+ *
+ * Like the code handler, it converts E codes into D codes in the code list the first time they run.
+ */
+static void rawCodeHandler(void)
+{
+    u32 *t2, t4, t5, t6, a0, a1, a2, a3, at, type;
+    s32 count;
+    int skip;
+
+    for (t4 = 0; t4 < rawCount; t4++) {
+        t2 = &rawList[t4 * 2];
+        a0 = t2[0];
+        if (a0 == 0)
+            continue;
+
+        type = a0 >> 28;
+        a0 &= 0x01FFFFFF;
+        a1 = t2[1];
+
+    again:
+        switch (type) {
+            case 0:
+                CHEAT_MEM8(a0) = a1;
+                break;
+            case 1:
+                CHEAT_MEM16(a0) = a1;
+                break;
+            case 2:
+                CHEAT_MEM32(a0) = a1;
+                break;
+            case 3:
+                t6 = a0 >> 20;
+                at = t6 & 1;
+                a0 &= 0xFFFF;
+                a1 &= 0x01FFFFFF;
+                t6 &= 6;
+                a2 = t6 & 2;
+                if (t6 == 0)
+                    t5 = CHEAT_MEM8(a1);
+                else if (a2)
+                    t5 = CHEAT_MEM16(a1);
+                else {
+                    t5 = CHEAT_MEM32(a1);
+                    a0 = t2[2];
+                    t4++;
+                }
+                t5 = at ? t5 - a0 : t5 + a0;
+                if (t6 == 0)
+                    CHEAT_MEM8(a1) = t5;
+                else if (a2)
+                    CHEAT_MEM16(a1) = t5;
+                else
+                    CHEAT_MEM32(a1) = t5;
+                break;
+            case 4:
+                a2 = t2[2];
+                a3 = t2[3];
+                count = a1 >> 16;
+                a1 = (a1 & 0xFFFF) << 2;
+                do {
+                    CHEAT_MEM32(a0) = a2;
+                    a2 += a3;
+                    a0 += a1;
+                } while (--count > 0);
+                t4++;
+                break;
+            case 5:
+                a2 = t2[2];
+                count = a1;
+                do {
+                    CHEAT_MEM8(a2) = CHEAT_MEM8(a0);
+                    a2++;
+                    a0++;
+                } while (--count > 0);
+                t4++;
+                break;
+            case 6:
+                t5 = CHEAT_MEM32(a0) & 0x3FFFFFFC;
+                if (t5 != 0) {
+                    a2 = t2[2] >> 16;
+                    t5 += t2[3];
+                    if (a2 == 0)
+                        CHEAT_MEM8(t5) = a1;
+                    else if (a2 == 1)
+                        CHEAT_MEM16(t5) = a1;
+                    else
+                        CHEAT_MEM32(t5) = a1;
+                }
+                t4++;
+                break;
+            case 7:
+                t6 = a1 >> 20;
+                at = t6 & 1;
+                t6 &= 6;
+                t5 = at ? CHEAT_MEM16(a0) : CHEAT_MEM8(a0);
+                if (t6 == 0)
+                    t5 |= a1;
+                else if (t6 == 2)
+                    t5 &= a1;
+                else
+                    t5 ^= a1;
+                if (at)
+                    CHEAT_MEM16(a0) = t5;
+                else
+                    CHEAT_MEM8(a0) = t5;
+                break;
+            case 0xC:
+                if (CHEAT_MEM32(a0) != a1)
+                    return;
+                break;
+            case 0xD:
+                a3 = (a1 >> 16) & 1;
+                t6 = (a1 >> 20) & 7;
+                a2 = a1 >> 24;
+                if (a2 == 0)
+                    a2 = 1;
+                if (a3) {
+                    t5 = CHEAT_MEM8(a0);
+                    a1 &= 0xFF;
+                } else {
+                    t5 = CHEAT_MEM16(a0);
+                    a1 &= 0xFFFF;
+                }
+                switch (t6) {
+                    case 0:
+                        skip = t5 != a1;
+                        break;
+                    case 1:
+                        skip = t5 == a1;
+                        break;
+                    case 2:
+                        skip = !(t5 < a1);
+                        break;
+                    case 3:
+                        skip = !(a1 < t5);
+                        break;
+                    case 4:
+                        skip = (t5 & a1) != 0;
+                        break;
+                    case 5:
+                        skip = (t5 & a1) == 0;
+                        break;
+                    case 6:
+                        skip = (t5 | a1) != 0;
+                        break;
+                    default:
+                        skip = (t5 | a1) == 0;
+                }
+                if (skip)
+                    t4 += a2;
+                break;
+            case 0xE:
+                a2 = (a0 & 0xFFFF) | ((a1 >> 28) << 20) | ((a0 >> 24) << 16) | ((a0 >> 16) << 24);
+                a0 = a1 & 0x01FFFFFF;
+                t2[0] = 0xD0000000 | a0;
+                t2[1] = a2;
+                a1 = a2;
+                type = 0xD;
+                goto again;
+            default: // Hooks, and the types without a handler
+                break;
+        }
+    }
+}
+
+// Builds the code list of CodeHandler from the list of the frontend, as SetupCheats() of ee_core/src/cheat_api.c
+static void setupRawCodes(const u32 *list)
+{
+    u32 addr, val;
+    int i, k, nextCodeCanBeHook;
+
+    k = 0;
+    nextCodeCanBeHook = 1;
+    for (i = 0; i < MAX_CHEATLIST; i += 2) {
+        addr = list[i];
+        val = list[i + 1];
+        if (addr == 0 && val == 0)
+            break;
+
+        if (!((addr & 0xfe000000) == 0x90000000 && nextCodeCanBeHook)) {
+            rawList[k++] = addr;
+            rawList[k++] = val;
+        }
+        nextCodeCanBeHook = !((addr & 0xf0000000) == 0x40000000 || (addr & 0xf0000000) == 0x30000000);
+    }
+    memset(&rawList[k], 0, 8 * sizeof(u32));
+    rawCount = k / 2;
+}
+
+static u32 rnd(void)
+{
+    return (u32)rand() << 16 ^ (u32)rand();
+}
+
+// An address around BASE, so that the codes write over each other
+static u32 randomAddr(int align)
+{
+    return (BASE + rnd() % 64) & ~(align - 1);
+}
+
+// Fills the first cheat with a random list of codes of every type, with many constant writes
+static int randomCheat(code_t *codes)
+{
+    u32 mode;
+    int count, lines, i, type;
+
+    count = 0;
+    lines = 1 + rnd() % MAX_LINES;
+    for (i = 0; i < lines; i++) {
+        type = rnd() % 3 == 0 ? rnd() % 3 : rnd() % 16;
+
+        switch (type) {
+            case 0:
+                codes[count].addr = randomAddr(1);
+                codes[count++].val = rnd();
+                break;
+            case 1:
+                codes[count].addr = 0x10000000 | randomAddr(2);
+                codes[count++].val = rnd();
+                break;
+            case 2:
+                codes[count].addr = 0x20000000 | randomAddr(4);
+                codes[count++].val = rnd();
+                break;
+            case 3:
+                mode = rnd() % 8;
+                codes[count].addr = 0x30000000 | mode << 20 | (rnd() & 0xFFFF);
+                codes[count++].val = randomAddr((mode & 6) == 4 ? 4 : ((mode & 6) != 0 ? 2 : 1));
+                if ((mode & 6) == 4) {
+                    codes[count].addr = rnd();
+                    codes[count++].val = 0;
+                }
+                break;
+            case 4:
+                codes[count].addr = 0x40000000 | randomAddr(4);
+                codes[count++].val = (rnd() % 4) << 16 | rnd() % 3;
+                codes[count].addr = rnd();
+                codes[count++].val = rnd() % 5;
+                break;
+            case 5:
+                codes[count].addr = 0x50000000 | randomAddr(1);
+                codes[count++].val = rnd() % 8;
+                codes[count].addr = randomAddr(1);
+                codes[count++].val = 0;
+                break;
+            case 6:
+                codes[count].addr = 0x60000000 | randomAddr(4);
+                codes[count++].val = rnd();
+                codes[count].addr = (rnd() % 4) << 16;
+                codes[count++].val = rnd() % 32;
+                break;
+            case 7:
+                codes[count].addr = 0x70000000 | randomAddr(2);
+                codes[count++].val = (rnd() % 8) << 20 | (rnd() & 0xFFFF);
+                break;
+            case 0xC:
+                codes[count].addr = 0xC0000000 | randomAddr(4);
+                codes[count++].val = rnd() % 4 ? rnd() : 0;
+                break;
+            case 0xD:
+                codes[count].addr = 0xD0000000 | randomAddr(2);
+                codes[count++].val = (rnd() % 5) << 24 | (rnd() % 8) << 20 | (rnd() % 2) << 16 | rnd() % 4;
+                break;
+            case 0xE:
+                codes[count].addr = 0xE0000000 | (rnd() % 2) << 24 | (rnd() % 5) << 16 | rnd() % 4;
+                codes[count++].val = (rnd() % 8) << 28 | randomAddr(2);
+                break;
+            default: // Hooks, and the types without a handler
+                codes[count].addr = (u32)type << 28 | randomAddr(4);
+                codes[count++].val = rnd();
+        }
+    }
+
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    int lists = argc > 1 ? atoi(argv[1]) : DEFAULT_LISTS;
+    int list, frame, size, compiled, wordsIn, wordsOut, i;
+    u8 *rawRam, *progRam, init[WINDOW];
+    const u32 *program;
+
+    srand(argc > 2 ? atoi(argv[2]) : 1);
+
+    rawRam = calloc(1, CHEAT_RAM_SIZE);
+    progRam = calloc(1, CHEAT_RAM_SIZE);
+    if (rawRam == NULL || progRam == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    compiled = 0;
+    wordsIn = 0;
+    wordsOut = 0;
+    for (list = 0; list < lists; list++) {
+        memset(&gCheats[0], 0, sizeof(gCheats[0]));
+        randomCheat(gCheats[0].codes);
+        gCheats[0].enabled = 1;
+        set_cheats_list();
+
+        setupRawCodes(GetCheatsList());
+        if ((program = GetCheatsProgram(&size)) == NULL)
+            continue;
+
+        compiled++;
+        wordsIn += rawCount * 2;
+        wordsOut += size;
+        memcpy(codelist, program, size * sizeof(u32));
+        numprogwords = size;
+
+        // Random memory, where some words are pointers for the pointer writes
+        for (i = 0; i < WINDOW; i++)
+            init[i] = rnd();
+        for (i = WINDOW / 2; i < WINDOW / 2 + 64; i += 4) {
+            if (rnd() % 2)
+                *(u32 *)&init[i] = BASE + rnd() % 48;
+        }
+        memcpy(rawRam + BASE - WINDOW / 2, init, WINDOW);
+        memcpy(progRam + BASE - WINDOW / 2, init, WINDOW);
+
+        for (frame = 0; frame < FRAMES; frame++) {
+            cheatRam = rawRam;
+            rawCodeHandler();
+            cheatRam = progRam;
+            CheatProgramHandler();
+
+            if (memcmp(rawRam + BASE - WINDOW / 2, progRam + BASE - WINDOW / 2, WINDOW)) {
+                printf("List %d, frame %d: the program does not write what the codes do\n", list, frame);
+                for (i = 0; i < (int)rawCount * 2; i += 2)
+                    printf("%08X %08X\n", rawList[i], rawList[i + 1]);
+                return 1;
+            }
+        }
+    }
+
+    // Most lists must compile, else the program is hardly checked
+    if (compiled < lists / 2) {
+        printf("Only %d lists of %d compiled\n", compiled, lists);
+        return 1;
+    }
+
+    printf("cheats: %d lists of %d compiled into %d program words instead of %d code words, identical over %d frames\n",
+           compiled, lists, wordsOut, wordsIn, FRAMES);
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Connects and disconnects DualShock 3 pads on the USB driver of pademu (modules/pademu/ds34usb.c), over a fake USBD
+  which holds the transfers until the test completes them.
+
+  USBD may not call back for the transfers aborted by a disconnection, so they are dropped here. The driver must then
+  not keep serving the last report of the pad, must read again when the port is reconnected, and must not keep the
+  LED/rumble commands of the other pads blocked, even when the callback of the aborted command comes in late.
+*/
+
+#include <stdio.h>
+
+#include "types.h"
+#include "thbase.h"
+#include "usbd.h"
+#include "ds34common.h"
+#include "ds34usb.h"
+#include "padreport.h"
+
+#define MAX_TRANSFERS 16
+
+typedef struct
+{
+    int endp;
+    int control; // Control transfer, else interrupt
+    u8 *data;
+    sceUsbdDoneCallback callback;
+    void *arg;
+} transfer_t;
+
+typedef struct
+{
+    UsbDeviceDescriptor device;
+    struct
+    {
+        UsbConfigDescriptor config;
+        UsbInterfaceDescriptor interface;
+        UsbEndpointDescriptor endpoints[2];
+    } __attribute__((packed)) config;
+} descriptors_t;
+
+static UsbDriver *driver;
+static descriptors_t descriptors;
+static transfer_t transfers[MAX_TRANSFERS];
+static int transferCount;
+static sceUsbdDoneCallback configCallback;
+static void *configArg;
+static int errors;
+
+void GetSystemTime(iop_sys_clock_t *sys_clock)
+{
+    sys_clock->lo = 0;
+    sys_clock->hi = 0;
+}
+
+int DelayThread(int usec)
+{
+    return 0;
+}
+
+int UsbRegisterDriver(UsbDriver *usbDriver)
+{
+    driver = usbDriver;
+    return USB_RC_OK;
+}
+
+// Every device is a DS3, the endpoints of device n are 10n (control), 10n+1 (interrupt in) and 10n+2 (interrupt out)
+void *UsbGetDeviceStaticDescriptor(int devId, void *data, u8 type)
+{
+    switch (type) {
+        case USB_DT_DEVICE:
+            return &descriptors.device;
+        case USB_DT_CONFIG:
+            return &descriptors.config.config;
+        case USB_DT_ENDPOINT:
+            return &descriptors.config.endpoints[0];
+    }
+
+    return NULL;
+}
+
+int UsbOpenEndpoint(int devId, UsbEndpointDescriptor *desc)
+{
+    return devId * 10;
+}
+
+int UsbOpenEndpointAligned(int devId, UsbEndpointDescriptor *desc)
+{
+    return devId * 10 + ((desc->bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_IN ? 1 : 2);
+}
+
+// The transfers of a closed endpoint are dropped, without calling back
+int UsbCloseEndpoint(int id)
+{
+    int i, j;
+
+    for (i = 0, j = 0; i < transferCount; i++) {
+        if (transfers[i].endp != id)
+            transfers[j++] = transfers[i];
+    }
+    transferCount = j;
+
+    return USB_RC_OK;
+}
+
+static int queue(int endp, int control, void *data, void *callback, void *arg)
+{
+    transfer_t *transfer;
+
+    if (callback == NULL) // Nothing to complete
+        return USB_RC_OK;
+
+    if (transferCount == MAX_TRANSFERS) {
+        printf("Too many pending transfers\n");
+        errors++;
+        return -1;
+    }
+
+    transfer = &transfers[transferCount++];
+    transfer->endp = endp;
+    transfer->control = control;
+    transfer->data = data;
+    transfer->callback = callback;
+    transfer->arg = arg;
+
+    return USB_RC_OK;
+}
+
+int UsbControlTransfer(int epID, int reqtyp, int req, int val, int index, int leng, void *dataptr, void *doneCB, void *arg)
+{
+    return queue(epID, 1, dataptr, doneCB, arg);
+}
+
+int UsbInterruptTransfer(int epID, void *dataptr, int len, void *doneCB, void *arg)
+{
+    return queue(epID, 0, dataptr, doneCB, arg);
+}
+
+int UsbSetDeviceConfiguration(int epID, int configuration, void *doneCB, void *arg)
+{
+    configCallback = doneCB;
+    configArg = arg;
+    return USB_RC_OK;
+}
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static int pending(int endp, int control)
+{
+    int i, count = 0;
+
+    for (i = 0; i < transferCount; i++) {
+        if (transfers[i].endp == endp && transfers[i].control == control)
+            count++;
+    }
+
+    return count;
+}
+
+// Removes a pending transfer, to complete it
+static int take(int endp, int control, transfer_t *transfer)
+{
+    int i;
+
+    for (i = 0; i < transferCount; i++) {
+        if (transfers[i].endp == endp && transfers[i].control == control) {
+            *transfer = transfers[i];
+            transfers[i] = transfers[--transferCount];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void connect(int devId)
+{
+    UsbEndpointDescriptor *endpoint;
+    int i;
+
+    memset(&descriptors, 0, sizeof(descriptors));
+    descriptors.device.idVendor = DS34_VID;
+    descriptors.device.idProduct = DS3_PID;
+    descriptors.config.config.bLength = sizeof(UsbConfigDescriptor);
+    descriptors.config.config.bConfigurationValue = 1;
+    descriptors.config.interface.bLength = sizeof(UsbInterfaceDescriptor);
+    descriptors.config.interface.bNumEndpoints = 2;
+    for (i = 0; i < 2; i++) {
+        endpoint = &descriptors.config.endpoints[i];
+        endpoint->bLength = sizeof(UsbEndpointDescriptor);
+        endpoint->bmAttributes = USB_ENDPOINT_XFER_INT;
+        endpoint->bEndpointAddress = i == 0 ? USB_DIR_IN | 1 : USB_DIR_OUT | 2;
+    }
+
+    check("Probe", driver->probe(devId) == 1);
+    check("Connect", driver->connect(devId) == 0);
+
+    // USBD calls back once the configuration is set
+    configCallback(USB_RC_OK, 0, configArg);
+}
+
+// Sends a DS3 report on the pending read of the device, Cross pressed if pressed
+static void report(int devId, int pressed)
+{
+    struct ds3report *ds3;
+    transfer_t transfer;
+
+    if (!take(devId * 10 + 1, 0, &transfer)) {
+        printf("No read pending on device %d\n", devId);
+        errors++;
+        return;
+    }
+
+    memset(transfer.data, 0, MAX_BUFFER_SIZE);
+    transfer.data[0] = PS3_01_REPORT_ID;
+    ds3 = (struct ds3report *)&transfer.data[2];
+    ds3->Cross = pressed;
+    ds3->PressureCross = pressed ? 0xFF : 0;
+    ds3->LeftStickX = ds3->LeftStickY = ds3->RightStickX = ds3->RightStickY = 0x80;
+
+    transfer.callback(USB_RC_OK, PS3_01_REPORT_LEN, transfer.arg);
+}
+
+// Completes the pending LED/rumble command of the device
+static void commandDone(int devId)
+{
+    transfer_t transfer;
+
+    if (take(devId * 10, 1, &transfer))
+        transfer.callback(USB_RC_OK, 0, transfer.arg);
+}
+
+static int isNeutral(const struct ds2report *ds2)
+{
+    return ds2->nButtonState == 0xFFFF && ds2->RightStickX == 0x7F && ds2->RightStickY == 0x7F && ds2->LeftStickX == 0x7F && ds2->LeftStickY == 0x7F && ds2->PressureCross == 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct ds2report ds2;
+    transfer_t staleCommand;
+
+    check("Init", ds34usb_init(0x03, 0) == 1);
+
+    // Two pads, each with its LED command sent once configured
+    connect(1);
+    connect(2);
+    check("Running", (ds34usb_get_status(0) & DS34USB_STATE_RUNNING) && (ds34usb_get_status(1) & DS34USB_STATE_RUNNING));
+    commandDone(1);
+    commandDone(2);
+
+    // The SIO2 polls start the reads
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 1);
+    check("Reads started", pending(11, 0) == 1 && pending(21, 0) == 1);
+
+    report(1, 1);
+    report(2, 0);
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Pad 0 reports Cross", ds2.nCross == 0 && ds2.PressureCross == 0xFF);
+    commandDone(1);
+    commandDone(2);
+
+    // Pad 0 sends a rumble command, then is unplugged before it completes: USBD drops its transfers
+    ds34usb_set_rumble(0xFF, 0x01, 0);
+    report(1, 1);
+    check("Pad 0 command sent", take(10, 1, &staleCommand));
+    driver->disconnect(1);
+    UsbCloseEndpoint(10);
+
+    check("Pad 0 disconnected", ds34usb_get_status(0) == DS34USB_STATE_DISCONNECTED);
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Pad 0 report released", isNeutral(&ds2));
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Pad 0 report still released", isNeutral(&ds2));
+
+    // The commands of pad 1 are not blocked by the dropped command of pad 0
+    ds34usb_set_rumble(0xFF, 0x01, 1);
+    report(2, 0);
+    check("Pad 1 command sent", pending(20, 1) == 1);
+
+    // The late callback of the dropped command must not free the buffer pad 1 is sending from
+    staleCommand.callback(USB_RC_OK, 0, staleCommand.arg);
+    ds34usb_set_rumble(0x00, 0x00, 1);
+    report(2, 0);
+    check("Pad 1 command not overwritten", pending(20, 1) == 1);
+    commandDone(2);
+    report(2, 0);
+    check("Pad 1 next command sent", pending(20, 1) == 1);
+    commandDone(2);
+
+    // Plugged again, pad 0 reads again from the first SIO2 poll
+    connect(3);
+    check("Pad 0 running", ds34usb_get_status(0) & DS34USB_STATE_RUNNING);
+    commandDone(3);
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Pad 0 read started", pending(31, 0) == 1);
+    report(3, 1);
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Pad 0 reports Cross again", ds2.nCross == 0);
+
+    // All the pads released on reset
+    ds34usb_reset();
+    ds34usb_get_data((u8 *)&ds2, sizeof(ds2), 0);
+    check("Reset report", isNeutral(&ds2));
+
+    if (errors)
+        printf("%d errors\n", errors);
+    else
+        printf("ds34usb: disconnection and reconnection OK\n");
+
+    return errors != 0;
+}
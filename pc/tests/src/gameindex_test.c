@@ -0,0 +1,305 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Merges random streams of device scans into the game index (src/gameindex.c): games added at any position, removed,
+  renamed, the list cleared and the device removed. After each scan, the games of the device seen through
+  gameIndexNext must be those of its list, sorted by name, and the devices of each game must be those holding a copy.
+
+  The allocations of the index are counted (the binary is linked with --wrap), and made to fail one after the other
+  while a device is scanned: the scan must then leave the device out of the index, without leaking anything.
+*/
+
+#include "include/opl.h"
+#include "include/gameindex.h"
+
+#define DEVICES   MODE_COUNT
+#define MAX_GAMES 200
+#define STARTUPS  150
+#define EVENTS    20000
+
+typedef struct
+{
+    char name[16];
+    char startup[8];
+} game_t;
+
+typedef struct
+{
+    game_t games[MAX_GAMES];
+    int count;
+} device_t;
+
+static device_t devices[DEVICES];
+static item_list_t lists[DEVICES];
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+/*--    Allocations    -------------------------------------------------------------------------------------------------*/
+
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+static int allocations;     // Blocks of the index not freed yet
+static int failAllocation;  // Number of the allocation to fail, -1 to never fail
+static int allocationCount; // Allocations since failAllocation was set
+
+void *__wrap_malloc(size_t size)
+{
+    void *ptr;
+
+    if (allocationCount++ == failAllocation)
+        return NULL;
+
+    if ((ptr = __real_malloc(size)) != NULL)
+        allocations++;
+
+    return ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr != NULL)
+        allocations--;
+
+    __real_free(ptr);
+}
+
+char *__wrap_strdup(const char *s)
+{
+    char *copy;
+
+    if ((copy = __wrap_malloc(strlen(s) + 1)) != NULL)
+        strcpy(copy, s);
+
+    return copy;
+}
+
+/*--    Devices    -----------------------------------------------------------------------------------------------------*/
+
+static char *itemGetName(item_list_t *support, int id)
+{
+    return ((device_t *)support->priv)->games[id].name;
+}
+
+static char *itemGetStartup(item_list_t *support, int id)
+{
+    return ((device_t *)support->priv)->games[id].startup;
+}
+
+static void deviceAdd(device_t *device)
+{
+    game_t *game;
+    int id = rand() % (device->count + 1);
+
+    memmove(&device->games[id + 1], &device->games[id], (device->count - id) * sizeof(game_t));
+    device->count++;
+
+    game = &device->games[id];
+    sprintf(game->startup, "S%03d", rand() % STARTUPS);
+    // Names differing only by case, and copies of a game under several names
+    sprintf(game->name, "%c%c%d", 'A' + rand() % 26, "aAbB"[rand() % 4], rand() % 50);
+}
+
+static void deviceRemove(device_t *device)
+{
+    int id = rand() % device->count;
+
+    memmove(&device->games[id], &device->games[id + 1], (device->count - id - 1) * sizeof(game_t));
+    device->count--;
+}
+
+static void deviceRename(device_t *device)
+{
+    sprintf(device->games[rand() % device->count].name, "%c%d", 'a' + rand() % 26, rand() % 50);
+}
+
+// Compares the games of the device seen through the index with its list
+static int checkDevice(int mode)
+{
+    device_t *device = &devices[mode];
+    game_location_t *location = NULL;
+    char seen[MAX_GAMES];
+    const char *previous = NULL;
+    int count = 0;
+
+    memset(seen, 0, sizeof(seen));
+    while ((location = gameIndexNext(location, mode)) != NULL) {
+        if (location->id < 0 || location->id >= device->count || seen[location->id]++) {
+            printf("Device %d: game %d is not in the list\n", mode, location->id);
+            return -1;
+        }
+        if (strcmp(location->name, device->games[location->id].name) || strcmp(location->entry->startup, device->games[location->id].startup)) {
+            printf("Device %d: game %d is %s %s instead of %s %s\n", mode, location->id, location->entry->startup, location->name,
+                   device->games[location->id].startup, device->games[location->id].name);
+            return -1;
+        }
+        if (previous != NULL && strcasecmp(previous, location->name) > 0) {
+            printf("Device %d: %s is after %s\n", mode, location->name, previous);
+            return -1;
+        }
+        previous = location->name;
+        count++;
+    }
+
+    if (count != device->count) {
+        printf("Device %d: %d games instead of %d\n", mode, count, device->count);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void checkGameDevices(void)
+{
+    char startup[8];
+    unsigned int expected;
+    int i, mode, id;
+
+    for (i = 0; i < STARTUPS; i++) {
+        sprintf(startup, "S%03d", i);
+
+        expected = 0;
+        for (mode = 0; mode < DEVICES; mode++) {
+            for (id = 0; id < devices[mode].count; id++) {
+                if (!strcmp(devices[mode].games[id].startup, startup))
+                    expected |= 1 << mode;
+            }
+        }
+
+        if (gameIndexGetDevices(startup) != expected) {
+            printf("%s: devices 0x%x instead of 0x%x\n", startup, gameIndexGetDevices(startup), expected);
+            errors++;
+        }
+    }
+}
+
+/*--    Tests    -------------------------------------------------------------------------------------------------------*/
+
+static void testEvents(void)
+{
+    device_t *device;
+    int i, mode, changes;
+
+    for (i = 0; i < EVENTS; i++) {
+        mode = rand() % DEVICES;
+        device = &devices[mode];
+
+        switch (rand() % 6) {
+            case 0:
+            case 1:
+                if (device->count < MAX_GAMES)
+                    deviceAdd(device);
+                break;
+            case 2:
+                if (device->count > 0)
+                    deviceRemove(device);
+                break;
+            case 3:
+                if (device->count > 0)
+                    deviceRename(device);
+                break;
+            case 4:
+                if (rand() % 20 == 0)
+                    device->count = 0;
+                break;
+            case 5:
+                if (rand() % 30 == 0)
+                    gameIndexRemoveDevice(mode);
+                break;
+        }
+
+        if ((changes = gameIndexUpdate(&lists[mode], device->count)) < 0 || checkDevice(mode) != 0) {
+            printf("Event %d: changes %d\n", i, changes);
+            errors++;
+            return;
+        }
+    }
+
+    // Devices removed last are scanned again
+    for (mode = 0; mode < DEVICES; mode++)
+        gameIndexUpdate(&lists[mode], devices[mode].count);
+    checkGameDevices();
+
+    for (mode = 0; mode < DEVICES; mode++)
+        check("Unchanged scan", gameIndexUpdate(&lists[mode], devices[mode].count) == 0);
+}
+
+static void testOutOfMemory(void)
+{
+    int mode, result, fail;
+
+    for (mode = 0; mode < DEVICES; mode++) {
+        gameIndexRemoveDevice(mode);
+        devices[mode].count = 0;
+    }
+    check("Empty index", allocations == 0);
+
+    // Device 0 holds some of the games of device 1: new games and games already in the index
+    while (devices[1].count < 40)
+        deviceAdd(&devices[1]);
+    memcpy(devices[0].games, &devices[1].games[20], 20 * sizeof(game_t));
+    devices[0].count = 20;
+
+    for (fail = 0;; fail++) {
+        check("Device 0", gameIndexUpdate(&lists[0], devices[0].count) >= 0);
+
+        failAllocation = fail;
+        allocationCount = 0;
+        result = gameIndexUpdate(&lists[1], devices[1].count);
+        failAllocation = -1;
+        if (allocationCount <= fail)
+            break; // All the allocations of the scan made
+
+        if (result != -1 || gameIndexNext(NULL, 1) != NULL) {
+            printf("Allocation %d: changes %d\n", fail, result);
+            errors++;
+        }
+        check("Index after the failed scan", checkDevice(0) == 0);
+
+        gameIndexRemoveDevice(0);
+        if (allocations != 0) {
+            printf("Allocation %d: %d blocks leaked\n", fail, allocations);
+            errors++;
+            break;
+        }
+    }
+
+    check("Scan", result >= 0 && checkDevice(1) == 0);
+    checkGameDevices();
+
+    gameIndexRemoveDevice(0);
+    gameIndexRemoveDevice(1);
+    check("Index removed", allocations == 0);
+    printf("%d allocations made to fail\n", fail);
+}
+
+int main(int argc, char **argv)
+{
+    int mode;
+
+    srand(1);
+    failAllocation = -1;
+
+    for (mode = 0; mode < DEVICES; mode++) {
+        lists[mode].mode = mode;
+        lists[mode].itemGetName = &itemGetName;
+        lists[mode].itemGetStartup = &itemGetStartup;
+        lists[mode].priv = &devices[mode];
+    }
+
+    testEvents();
+    testOutOfMemory();
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
@@ -0,0 +1,521 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Runs the compatibility update of OPL (compatUpdate() of src/compatupd.c) through the HTTP client module
+  (modules/network/httpclient/httpclient.c) against a stub server on the loopback interface, for 500 titles.
+  The connections to the compatibility list server are redirected to the stub server, and the settings of the titles
+  are kept by stand-ins for the config functions, to be checked.
+
+  The server answers each request after a simulated round trip, according to the number of the title, with:
+  - 304 Not Modified, without a body.
+  - A body with a Content-Length, the header name in mixed or upper case.
+  - A chunked body, with chunk extensions and a trailer.
+  - Informational responses (100 Continue, 103 Early Hints) before the final response.
+  - A body with a Content-Length, then closing the connection: the client connects again and sends the requests that
+    were not answered again.
+  The responses are sent in small fragments, so that lines and bodies are split across receives.
+  The title code selects the connections that are lost before the response: once (DROP_) or each time (FAIL_).
+
+  The time of the update is compared with the one of sending one request at a time with HttpSendGetRequest(),
+  as the update did before the requests were pipelined.
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "types.h"
+#include "ps2ip.h"
+#include "httpclient.h"
+#include "include/opl.h"
+#include "include/iosupport.h"
+#include "include/compatupd.h"
+
+#include <libcdvd.h>
+#include <osd_config.h>
+#include <fileXio_rpc.h>
+
+#define TITLES       500
+#define KINDS        6
+#define FRAGMENT     13
+#define MAX_BODY     512
+#define LATENCY_USEC 1000 // Round trip to the server
+#define HOST_NAME    "127.0.0.1"
+
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_usec - start->tv_usec) / 1000.0;
+}
+
+static int body(int request, char *buffer)
+{
+    int length, extra;
+
+    length = sprintf(buffer, "Key%d=Value%d\nLong=", request, request);
+    extra = request * 7 % 300;
+    memset(&buffer[length], 'x', extra);
+    length += extra;
+    buffer[length++] = '\n';
+
+    return length;
+}
+
+/*--    Server    ------------------------------------------------------------------------------------------------------*/
+
+static int serverSend(int sock, const char *data, int length)
+{
+    int i, amount;
+
+    for (i = 0; i < length; i += amount) {
+        amount = length - i < FRAGMENT ? length - i : FRAGMENT;
+        if (send(sock, &data[i], amount, MSG_NOSIGNAL) != amount)
+            return -1;
+    }
+
+    return 0;
+}
+
+// Returns 0 if the connection is to be closed
+static int serverRespond(int sock, int request)
+{
+    char response[4096], content[MAX_BODY];
+    int length, contentLength, i, size;
+
+    contentLength = body(request, content);
+    length = 0;
+
+    switch (request % KINDS) {
+        case 0:
+            length = sprintf(response, "HTTP/1.1 304 Not Modified\r\nDate: Sat, 01 Jan 2000 00:00:00 GMT\r\n\r\n");
+            break;
+        case 1:
+            length = sprintf(response, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nContent-Type: text/plain\r\n\r\n", contentLength);
+            memcpy(&response[length], content, contentLength);
+            length += contentLength;
+            break;
+        case 2:
+            length = sprintf(response, "HTTP/1.1 200 OK\r\ntransfer-encoding: Chunked\r\n\r\n");
+            for (i = 0; i < contentLength; i += size) {
+                size = contentLength - i < 17 ? contentLength - i : 17;
+                length += sprintf(&response[length], "%x;ext=1\r\n", size);
+                memcpy(&response[length], &content[i], size);
+                length += size;
+                length += sprintf(&response[length], "\r\n");
+            }
+            length += sprintf(&response[length], "0\r\nX-Trailer: y\r\n\r\n");
+            break;
+        case 3:
+            length = sprintf(response, "HTTP/1.1 200 OK\r\nCONTENT-LENGTH: %d\r\n\r\n", contentLength);
+            memcpy(&response[length], content, contentLength);
+            length += contentLength;
+            break;
+        case 4:
+            length = sprintf(response, "HTTP/1.1 100 Continue\r\n\r\n"
+                                       "HTTP/1.1 103 Early Hints\r\nLink: </style.css>; rel=preload\r\n\r\n"
+                                       "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n",
+                             contentLength);
+            memcpy(&response[length], content, contentLength);
+            length += contentLength;
+            break;
+        case 5:
+            length = sprintf(response, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", contentLength);
+            memcpy(&response[length], content, contentLength);
+            length += contentLength;
+            break;
+    }
+
+    if (serverSend(sock, response, length) < 0)
+        return 0;
+
+    return request % KINDS != 5;
+}
+
+// Titles whose first request was dropped, in the process of the server
+static char dropped[TITLES];
+
+static void serverConnection(int sock)
+{
+    char buffer[4096], prefix[8], *end, *code;
+    struct timeval received;
+    int length = 0, result, request, wait;
+
+    while (1) {
+        buffer[length] = '\0';
+        while ((end = strstr(buffer, "\r\n\r\n")) == NULL) {
+            if ((result = recv(sock, &buffer[length], sizeof(buffer) - 1 - length, 0)) <= 0)
+                return;
+            gettimeofday(&received, NULL);
+            length += result;
+            buffer[length] = '\0';
+        }
+
+        end += 4;
+        if ((code = strstr(buffer, "code=")) == NULL || code > end || sscanf(code, "code=%4s_%d", prefix, &request) != 2 || request < 0 || request >= TITLES)
+            return;
+
+        // The connection is lost before the response: each time, or once for the title
+        if (strcmp(prefix, "FAIL") == 0)
+            return;
+        if (strcmp(prefix, "DROP") == 0 && !dropped[request]) {
+            dropped[request] = 1;
+            return;
+        }
+
+        // The response leaves once the round trip from the last receive has elapsed
+        if ((wait = LATENCY_USEC - (int)(elapsed(&received) * 1000)) > 0)
+            usleep(wait);
+
+        if (!serverRespond(sock, request))
+            return;
+
+        length -= end - buffer;
+        memmove(buffer, end, length);
+    }
+}
+
+static void server(int listener)
+{
+    char buffer[256];
+    int sock, one = 1;
+
+    while ((sock = accept(listener, NULL, NULL)) >= 0) {
+        // Each fragment is sent at once, instead of waiting for the acknowledgement of the previous one
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        serverConnection(sock);
+        // Closed once the client closed its side: with requests left unread, closing would reset the connection
+        shutdown(sock, SHUT_WR);
+        while (recv(sock, buffer, sizeof(buffer), 0) > 0)
+            ;
+        close(sock);
+    }
+
+    exit(0);
+}
+
+/*--    Titles    ------------------------------------------------------------------------------------------------------*/
+
+static char titleCodes[TITLES][16];
+static int merged[TITLES], written[TITLES];
+static int configs, badBodies;
+static char lastBody[MAX_BODY];
+static int lastLength;
+
+// All the titles are answered, but the ones listed that are given the prefix
+static void setTitles(const char *prefix, const int *ids, int count)
+{
+    int i;
+
+    for (i = 0; i < TITLES; i++)
+        sprintf(titleCodes[i], "SLUS_%05d", i);
+    for (i = 0; i < count; i++)
+        sprintf(titleCodes[ids[i]], "%s_%05d", prefix, ids[i]);
+
+    memset(merged, 0, sizeof(merged));
+    memset(written, 0, sizeof(written));
+    badBodies = 0;
+}
+
+static int titlesGetCount(item_list_t *itemList)
+{
+    return TITLES;
+}
+
+static char *titlesGetStartup(item_list_t *itemList, int id)
+{
+    return titleCodes[id];
+}
+
+static config_set_t *titlesGetConfig(item_list_t *itemList, int id)
+{
+    config_set_t *config;
+
+    if ((config = configAlloc(0, NULL, NULL)) != NULL)
+        config->uid = id;
+
+    return config;
+}
+
+static item_list_t titles = {
+    .mode = ETH_MODE,
+    .itemGetCount = &titlesGetCount,
+    .itemGetStartup = &titlesGetStartup,
+    .itemGetConfig = &titlesGetConfig,
+};
+
+// Checks that the titles before the first one not updated got the settings of their response, once
+static void checkTitles(const char *name, int updated)
+{
+    int i, expected, failed = 0;
+
+    for (i = 0; i < TITLES; i++) {
+        expected = i < updated && i % KINDS != 0;
+        if (merged[i] != expected || written[i] != expected) {
+            if (!failed)
+                printf("%s: title %d merged %d times and written %d times\n", name, i, merged[i], written[i]);
+            failed = 1;
+        }
+    }
+
+    check(name, !failed);
+    check(name, badBodies == 0);
+    check(name, configs == 0);
+}
+
+/*--    Stand-ins    ---------------------------------------------------------------------------------------------------*/
+
+config_set_t *configAlloc(int type, config_set_t *configSet, char *fileName)
+{
+    config_set_t *config;
+
+    if ((config = calloc(1, sizeof(config_set_t))) != NULL)
+        configs++;
+
+    return config;
+}
+
+void configFree(config_set_t *configSet)
+{
+    free(configSet);
+    configs--;
+}
+
+// The body is kept to be checked when it is merged into the settings of its title
+int configReadBuffer(config_set_t *configSet, const void *buffer, int size)
+{
+    lastLength = size < MAX_BODY ? size : MAX_BODY;
+    memcpy(lastBody, buffer, lastLength);
+    return 1;
+}
+
+void configMerge(config_set_t *dest, const config_set_t *source)
+{
+    char expected[MAX_BODY];
+    int length;
+
+    length = body(dest->uid, expected);
+    if (lastLength != length || memcmp(lastBody, expected, length) != 0)
+        badBodies++;
+    merged[dest->uid]++;
+}
+
+int configWrite(config_set_t *configSet)
+{
+    written[configSet->uid]++;
+    return 1;
+}
+
+int configSetInt(config_set_t *configSet, const char *key, const int value)
+{
+    return 1;
+}
+
+// No title has a source: all are updated
+int configGetInt(config_set_t *configSet, const char *key, int *value)
+{
+    return 0;
+}
+
+int configGetStat(config_set_t *configSet, iox_stat_t *stat)
+{
+    return 0;
+}
+
+void configConvertToGmtTime(sceCdCLOCK *time)
+{
+}
+
+static u16 serverPort;
+static int connections;
+
+// The connections to the compatibility list server go to the stub server
+int __real_HttpEstabConnection(char *server, u16 port);
+
+int __wrap_HttpEstabConnection(char *server, u16 port)
+{
+    connections++;
+    return __real_HttpEstabConnection(HOST_NAME, serverPort);
+}
+
+/*--    Update    ------------------------------------------------------------------------------------------------------*/
+
+// Connections that the server closed after a response, before the title given
+static int closedBefore(int title)
+{
+    int i, closed;
+
+    for (i = 0, closed = 0; i < title; i++) {
+        if (i % KINDS == 5)
+            closed++;
+    }
+
+    return closed;
+}
+
+static double runUpdate(void)
+{
+    struct timeval start;
+
+    CompatUpdateComplete = 0;
+    CompatUpdateStopFlag = 0;
+    CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_WIP;
+    connections = 0;
+
+    gettimeofday(&start, NULL);
+    compatUpdate(&titles, 0, NULL, 0);
+    return elapsed(&start);
+}
+
+// The update before the requests were pipelined: one request at a time, connecting again once the server closed the connection
+static double runOldUpdate(void)
+{
+    char output[MAX_BODY], uri[64];
+    config_set_t *config, *downloadedConfig;
+    struct timeval start;
+    int i, sock, result;
+    u16 length;
+    s8 mode;
+
+    gettimeofday(&start, NULL);
+    if ((sock = HttpEstabConnection(OPL_COMPAT_HTTP_HOST, OPL_COMPAT_HTTP_PORT)) < 0) {
+        printf("One request at a time: no connection\n");
+        errors++;
+        return 0;
+    }
+
+    for (i = 0, mode = HTTP_CMODE_PERSISTENT; i < TITLES; i++) {
+        if (mode == HTTP_CMODE_CLOSED) {
+            HttpCloseConnection(sock);
+            mode = HTTP_CMODE_PERSISTENT;
+            if ((sock = HttpEstabConnection(OPL_COMPAT_HTTP_HOST, OPL_COMPAT_HTTP_PORT)) < 0)
+                break;
+        }
+
+        config = titlesGetConfig(&titles, i);
+        sprintf(uri, OPL_COMPAT_HTTP_URI, titleCodes[i], 2);
+        length = sizeof(output);
+        if ((result = HttpSendGetRequest(sock, OPL_USER_AGENT, OPL_COMPAT_HTTP_HOST, &mode, NULL, uri, output, &length)) == 200) {
+            downloadedConfig = configAlloc(0, NULL, NULL);
+            configReadBuffer(downloadedConfig, output, length);
+            configMerge(config, downloadedConfig);
+            configFree(downloadedConfig);
+            configWrite(config);
+        }
+        configFree(config);
+
+        if (result < 0) {
+            printf("One request at a time: title %d failed with %d\n", i, result);
+            errors++;
+            break;
+        }
+    }
+
+    if (sock >= 0)
+        HttpCloseConnection(sock);
+
+    return elapsed(&start);
+}
+
+static void testUpdate(void)
+{
+    double time, oldTime;
+
+    setTitles(NULL, NULL, 0);
+    time = runUpdate();
+    check("Update status", CompatUpdateStatus == OPL_COMPAT_UPDATE_STAT_DONE);
+    check("Update progress", CompatUpdateComplete == TITLES);
+    check("Update connections", connections == 1 + closedBefore(TITLES - 1));
+    checkTitles("Update titles", TITLES);
+
+    setTitles(NULL, NULL, 0);
+    oldTime = runOldUpdate();
+    checkTitles("One request at a time", TITLES);
+
+    printf("%d titles, %d ms round trip:\n", TITLES, LATENCY_USEC / 1000);
+    printf("    compatUpdate():           %7.2f ms\n", time);
+    printf("    one request at a time:    %7.2f ms\n", oldTime);
+    check("Update time", time < oldTime);
+}
+
+// Connections lost with requests in the pipeline: the requests after the last response are sent again
+static void testDroppedConnections(void)
+{
+    static const int drops[] = {50, 51, 204, 299, TITLES - 1};
+    int count = sizeof(drops) / sizeof(drops[0]);
+
+    setTitles("DROP", drops, count);
+    runUpdate();
+    check("Dropped connections status", CompatUpdateStatus == OPL_COMPAT_UPDATE_STAT_DONE);
+    check("Dropped connections progress", CompatUpdateComplete == TITLES);
+    check("Dropped connections", connections == 1 + closedBefore(TITLES - 1) + count);
+    checkTitles("Dropped connections titles", TITLES);
+}
+
+// The connection is lost at each attempt: the update stops after the retries, with the titles before it updated
+static void testLostServer(void)
+{
+    static const int fail[] = {100};
+
+    setTitles("FAIL", fail, 1);
+    runUpdate();
+    check("Lost server status", CompatUpdateStatus == OPL_COMPAT_UPDATE_STAT_CONN_ERROR);
+    check("Lost server progress", CompatUpdateComplete == fail[0] + 1);
+    check("Lost server connections", connections == 1 + closedBefore(fail[0]) + OPL_COMPAT_HTTP_RETRIES - 1);
+    checkTitles("Lost server titles", fail[0]);
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    int listener, status;
+    pid_t pid;
+
+    alarm(60);
+    // Requests sent on a connection that the server closed fail, as on the PS2
+    signal(SIGPIPE, SIG_IGN);
+
+    // The server listens on any free port of the loopback interface
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 5) != 0 || getsockname(listener, (struct sockaddr *)&addr, &addrLength) != 0) {
+        perror("Server");
+        return 1;
+    }
+
+    if ((pid = fork()) == 0)
+        server(listener);
+    close(listener);
+
+    serverPort = ntohs(addr.sin_port);
+    testUpdate();
+    testDroppedConnections();
+    testLostServer();
+
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
@@ -0,0 +1,164 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Checks the curves of the disc drive timing model of cdvdman (modules/iopcore/cdvdman/mediatiming.c), which paces
+  the reads of IOPCORE_COMPAT_ACCU_READS.
+
+  For CDs and DVDs: the rate at the start of the disc is the one of the former flat model, then grows with the radius.
+  Sequential reads and reads just ahead of the pick-up cost no seek, other reads cost a seek that grows with the
+  distance. On dual-layer DVDs, layer 1 runs back from the outer radius and jumping to it costs a focus jump.
+  The curves are printed, for tuning the profiles.
+*/
+
+#include <stdio.h>
+
+#include "types.h"
+#include "mediatiming.h"
+
+#define TICKS_PER_MS 36864 // IOP clock
+#define CD_SECTORS   360000
+#define DVD_SECTORS  2295104
+#define LAYER1_START 2000000
+#define SAMPLES      16
+
+static struct cdvdman_settings_common settings;
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static double ms(u32 ticks)
+{
+    return (double)ticks / TICKS_PER_MS;
+}
+
+// Leaves the pick-up at lsn, on the layer of the sector before it
+static void moveTo(u32 lsn)
+{
+    MediaTimingRead(&settings, lsn - 1, 1);
+}
+
+// Ticks per sector of a sequential read at lsn
+static u32 sectorTicks(u32 lsn)
+{
+    moveTo(lsn);
+    return MediaTimingRead(&settings, lsn, 16) / 16;
+}
+
+static double rate(u32 sectorTicks)
+{
+    return 2048.0 * TICKS_PER_MS * 1000 / sectorTicks / 1024;
+}
+
+static void testMedia(const char *name, u8 media, u32 sectors, u32 innerTicks, double outerRate, double fullSeek)
+{
+    char test[64];
+    u32 lsn, ticks, previous, seek, gap;
+    int i, monotonic;
+
+    settings.media = media;
+    settings.layer1_start = 0;
+    printf("%s\n", name);
+
+    // The rate grows with the radius
+    previous = 0xFFFFFFFF;
+    monotonic = 1;
+    for (i = 0; i <= SAMPLES; i++) {
+        lsn = 16 + (u32)((u64)(sectors - 32) * i / SAMPLES);
+        ticks = sectorTicks(lsn);
+        monotonic &= ticks <= previous;
+        previous = ticks;
+        if (i % 4 == 0)
+            printf("  LSN %7u: %4.0f KB/s\n", lsn, rate(ticks));
+    }
+    sprintf(test, "%s: rate grows with the radius", name);
+    check(test, monotonic);
+    sprintf(test, "%s: inner rate", name);
+    ticks = sectorTicks(16);
+    check(test, ticks >= innerTicks * 99 / 100 && ticks <= innerTicks);
+    sprintf(test, "%s: outer rate", name);
+    check(test, rate(previous) > outerRate * 0.95 && rate(previous) < outerRate * 1.05);
+
+    // Just ahead of the pick-up: waits for the sectors in between, without seeking
+    moveTo(1000);
+    ticks = MediaTimingRead(&settings, 1000, 16);
+    gap = MediaTimingRead(&settings, 1036, 16);
+    printf("  16 sectors: %.2f ms, 20 sectors ahead: %.2f ms\n", ms(ticks), ms(gap));
+    sprintf(test, "%s: read ahead", name);
+    check(test, gap > ticks && gap < ticks * 3);
+
+    // Seeks grow with the distance, forwards and backwards
+    monotonic = 1;
+    previous = 0;
+    for (i = 1; i <= SAMPLES; i++) {
+        moveTo(1000);
+        seek = MediaTimingRead(&settings, 1000 + (u32)((u64)(sectors - 2000) * i / SAMPLES), 1);
+        monotonic &= seek >= previous;
+        previous = seek;
+        if (i == SAMPLES / 3)
+            printf("  Seek over a third: %.1f ms\n", ms(seek));
+    }
+    printf("  Full seek: %.1f ms\n", ms(seek));
+    sprintf(test, "%s: seeks grow with the distance", name);
+    check(test, monotonic);
+    sprintf(test, "%s: full seek", name);
+    check(test, ms(seek) > fullSeek && ms(seek) < fullSeek + 40);
+
+    moveTo(1000);
+    seek = MediaTimingRead(&settings, 990, 1);
+    printf("  10 sectors back: %.1f ms\n", ms(seek));
+    sprintf(test, "%s: seek back", name);
+    check(test, ms(seek) >= 20 && ms(seek) < 40);
+
+    // Long reads saturate rather than wrap around
+    moveTo(1000);
+    ticks = MediaTimingRead(&settings, 1000, 0x8000);
+    moveTo(1000);
+    sprintf(test, "%s: long reads", name);
+    check(test, MediaTimingRead(&settings, 1000, 0xFFFF) >= ticks && MediaTimingRead(&settings, 0, 0xFFFFFFFF) == 0xFFFFFFFF);
+}
+
+static void testDualLayer(void)
+{
+    u32 end0, start1, end1, sequential, jump;
+
+    settings.media = 0x14;
+    settings.layer1_start = LAYER1_START;
+    printf("DVD-9, layer 1 at LSN %u\n", LAYER1_START);
+
+    // Layer 1 starts at the outer radius, where layer 0 ends, and runs back to the inner radius
+    end0 = sectorTicks(LAYER1_START - 16);
+    start1 = sectorTicks(LAYER1_START + 16);
+    end1 = sectorTicks(2 * LAYER1_START - 32);
+    printf("  End of layer 0: %.0f KB/s, start of layer 1: %.0f KB/s, end of layer 1: %.0f KB/s\n", rate(end0), rate(start1), rate(end1));
+    check("DVD-9: layer 1 starts at the outer radius", start1 >= end0 * 99 / 100 && start1 <= end0 * 101 / 100);
+    check("DVD-9: layer 1 ends at the inner radius", end1 > start1 * 2);
+
+    // Reading on past the end of layer 0 takes a focus jump, at the same radius
+    moveTo(LAYER1_START - 16);
+    sequential = MediaTimingRead(&settings, LAYER1_START - 16, 16);
+    jump = MediaTimingRead(&settings, LAYER1_START, 16);
+    printf("  Across the layers: %.1f ms\n", ms(jump));
+    check("DVD-9: layer jump", ms(jump - sequential) >= 60 + 20);
+
+    moveTo(LAYER1_START + 16);
+    check("DVD-9: sequential on layer 1", MediaTimingRead(&settings, LAYER1_START + 16, 16) <= sequential * 101 / 100);
+}
+
+int main(int argc, char **argv)
+{
+    testMedia("CD", 0x12, CD_SECTORS, 81920, 2088, 200);
+    testMedia("DVD", 0x14, DVD_SECTORS, 33512, 5316, 230);
+    testDualLayer();
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
@@ -0,0 +1,309 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Drives the pademu SIO2 command state machine (modules/pademu/pademu_cmd.c) through a fake controller driver.
+
+  DS3 and DS4 reports, laid out as the controllers send them, are translated by ds34common.c and handed over
+  through the report slot of padreport.c, as ds34usb/ds34bt do. The libpad initialization sequence
+  (config mode, analog lock, actuator alignment, pressure mode) and the polls that follow are checked byte for byte,
+  along with the report slot (new/repeated/reset reports) and the latency histogram.
+*/
+
+#include <stdio.h>
+
+#include "types.h"
+#include "thbase.h"
+#include "ds34common.h"
+#include "pademu_cmd.h"
+#include "padreport.h"
+
+#define MODEL_PS2 3 // As in ds34usb.h
+#define ANY       -1
+
+static pad_report_t reports[MAX_PORTS];
+static u8 analog[MAX_PORTS];
+static int status = PAD_STATE_RUNNING;
+static int modeCalls;
+static u8 lastLrum, lastRrum;
+static int lastMode, lastLock;
+static u32 clockTicks;
+static int errors;
+
+void GetSystemTime(iop_sys_clock_t *sys_clock)
+{
+    sys_clock->lo = clockTicks;
+    sys_clock->hi = 0;
+}
+
+static int fakeGetStatus(int port)
+{
+    return status;
+}
+
+static int fakeGetData(u8 *dst, int size, int port)
+{
+    padReportRead(&reports[port], dst, size, port);
+    return analog[port];
+}
+
+static void fakeSetRumble(u8 lrum, u8 rrum, int port)
+{
+    lastLrum = lrum;
+    lastRrum = rrum;
+}
+
+static void fakeSetMode(int mode, int lock, int port)
+{
+    modeCalls++;
+    lastMode = mode;
+    lastLock = lock;
+}
+
+static int fakeGetModel(int port)
+{
+    return MODEL_PS2;
+}
+
+static const pademu_driver_t fakeDriver = {fakeGetStatus, fakeGetData, fakeSetRumble, fakeSetMode, fakeGetModel};
+
+// Sends a SIO2 command and compares the reply with expected, where ANY entries are not checked
+static void transfer(const char *name, int port, const u8 *in, int size, const int *expected)
+{
+    u8 out[32];
+    int i;
+
+    pademu_cmd(port, (u8 *)in, out, size);
+
+    for (i = 0; i < size; i++) {
+        if (expected[i] != ANY && out[i] != expected[i]) {
+            printf("%s: byte %d is 0x%02x instead of 0x%02x\n", name, i, out[i], expected[i]);
+            errors++;
+            return;
+        }
+    }
+}
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static void publishDs2(int port, const struct ds2report *ds2)
+{
+    padReportPublish(&reports[port], (const u8 *)ds2);
+}
+
+static void neutral(struct ds2report *ds2)
+{
+    memset(ds2, 0, sizeof(*ds2));
+    ds2->nButtonState = 0xFFFF;
+    ds2->RightStickX = ds2->RightStickY = ds2->LeftStickX = ds2->LeftStickY = 0x7F;
+}
+
+static void testInitSequence(int port)
+{
+    struct ds2report ds2;
+
+    neutral(&ds2);
+    padReportReset(&reports[port], (const u8 *)&ds2);
+
+    // Digital poll
+    {
+        static const u8 in[] = {0x01, 0x42, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, DIGITAL_MODE, 0x5A, 0xFF, 0xFF};
+        transfer("Digital poll", port, in, sizeof(in), out);
+    }
+
+    // Enter config mode: answered like a poll
+    {
+        static const u8 in[] = {0x01, 0x43, 0x00, 0x01, 0x00};
+        static const int out[] = {0xFF, DIGITAL_MODE, 0x5A, 0xFF, 0xFF};
+        transfer("Enter config", port, in, sizeof(in), out);
+    }
+
+    // Analog mode, locked
+    {
+        static const u8 in[] = {0x01, 0x44, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        transfer("Set mode", port, in, sizeof(in), out);
+        check("Set mode reaches the driver", modeCalls == 1 && lastMode == 1 && lastLock == 3);
+    }
+
+    // Model and mode
+    {
+        static const u8 in[] = {0x01, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, MODEL_PS2, 0x02, 0x01, 0x02, 0x01, 0x00};
+        transfer("Query model", port, in, sizeof(in), out);
+    }
+
+    // Actuators: small motor in byte 3, large motor in byte 4 of the polls
+    {
+        static const u8 in[] = {0x01, 0x4D, 0x00, 0x00, 0x01, 0xFF, 0xFF, 0xFF, 0xFF};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        transfer("Set act align", port, in, sizeof(in), out);
+    }
+
+    // Pressure mode
+    {
+        static const u8 in[] = {0x01, 0x4F, 0x00, 0xFF, 0xFF, 0x03, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5A};
+        transfer("Set button info", port, in, sizeof(in), out);
+    }
+
+    // Button mask, now that the pad is not digital
+    {
+        static const u8 in[] = {0x01, 0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, 0xFF, 0xFF, 0x03, 0x00, 0x00, 0x5A};
+        transfer("Query mask", port, in, sizeof(in), out);
+    }
+
+    // Exit config mode
+    {
+        static const u8 in[] = {0x01, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        static const int out[] = {0xFF, CONFIG_MODE, 0x5A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        transfer("Exit config", port, in, sizeof(in), out);
+    }
+
+    // Pressure mode poll: every poll sends the motor bytes at the aligned positions
+    {
+        static const u8 in[21] = {0x01, 0x42, 0x00, 0x01, 0xC0};
+        static const int out[21] = {0xFF, ANALOGP_MODE, 0x5A, 0xFF, 0xFF, 0x7F, 0x7F, 0x7F, 0x7F};
+        transfer("Pressure poll", port, in, sizeof(in), out);
+        check("Rumble reaches the driver", lastRrum == 0x01 && lastLrum == 0xC0);
+    }
+}
+
+static void testDs3(int port)
+{
+    struct ds3report ds3;
+    struct ds2report ds2;
+
+    memset(&ds3, 0, sizeof(ds3));
+    ds3.Cross = 1;
+    ds3.R1 = 1;
+    ds3.Start = 1;
+    ds3.LeftStickX = 0x10;
+    ds3.LeftStickY = 0xF0;
+    ds3.RightStickX = 0x80;
+    ds3.RightStickY = 0x81;
+    ds3.PressureCross = 0xC8;
+    ds3.PressureR1 = 0x40;
+
+    translate_pad_ds3(&ds3, &ds2, 0);
+    publishDs2(port, &ds2);
+
+    {
+        static const u8 in[21] = {0x01, 0x42};
+        static const int out[21] = {0xFF, ANALOGP_MODE, 0x5A,
+                                    0xF7, 0xB7,             // Start, Cross and R1, active low
+                                    0x80, 0x81, 0x10, 0xF0, // Right stick, left stick
+                                    0x00, 0x00, 0x00, 0x00, // Right, left, up, down
+                                    0x00, 0x00, 0xC8, 0x00, // Triangle, circle, cross, square
+                                    0x00, 0x40, 0x00, 0x00}; // L1, R1, L2, R2
+        transfer("DS3 report", port, in, sizeof(in), out);
+    }
+}
+
+static void testDs4(int port)
+{
+    struct ds4report ds4;
+    struct ds2report ds2;
+
+    memset(&ds4, 0, sizeof(ds4));
+    ds4.ReportID = 0x01;
+    ds4.Dpad = DS4DpadDirectionNE;
+    ds4.Triangle = 1;
+    ds4.Share = 1;
+    ds4.L2 = 1;
+    ds4.PressureL2 = 0x99;
+    ds4.LeftStickX = 0x80;
+    ds4.LeftStickY = 0x80;
+    ds4.RightStickX = 0x00;
+    ds4.RightStickY = 0xFF;
+
+    translate_pad_ds4(&ds4, &ds2, 1);
+    publishDs2(port, &ds2);
+
+    {
+        static const u8 in[21] = {0x01, 0x42};
+        static const int out[21] = {0xFF, ANALOGP_MODE, 0x5A,
+                                    0xCE, 0xEE,             // Select, up and right; triangle and L2
+                                    0x00, 0xFF, 0x80, 0x80, // Right stick, left stick
+                                    0xFF, 0x00, 0xFF, 0x00, // Right, left, up, down
+                                    0xFF, 0x00, 0x00, 0x00, // Triangle, circle, cross, square
+                                    0x00, 0x00, 0x99, 0x00}; // L1, R1, L2, R2
+        transfer("DS4 report", port, in, sizeof(in), out);
+    }
+}
+
+static void testReportSlot(int port)
+{
+    struct ds2report ds2;
+    u8 data[PAD_REPORT_SIZE];
+    u32 before[PAD_LATENCY_BUCKETS], histogram[PAD_LATENCY_BUCKETS];
+    int i;
+
+    neutral(&ds2);
+    ds2.nCross = 0;
+
+    pademu_get_latency(port, before);
+
+    clockTicks = 1000;
+    publishDs2(port, &ds2);
+    clockTicks += 3 * 9216; // 0.75 ms later
+
+    check("New report", padReportRead(&reports[port], data, sizeof(data), port) == 1 && !memcmp(data, &ds2, sizeof(data)));
+    check("Repeated report", padReportRead(&reports[port], data, sizeof(data), port) == 0 && !memcmp(data, &ds2, sizeof(data)));
+
+    // The polls of the previous tests were counted too
+    pademu_get_latency(port, histogram);
+    for (i = 0; i < PAD_LATENCY_BUCKETS; i++)
+        histogram[i] -= before[i];
+    check("Latency histogram", histogram[2] == 1 && histogram[0] + histogram[1] + histogram[3] == 0);
+
+    // A disconnected pad reports all buttons released, without counting it as a new report
+    neutral(&ds2);
+    padReportReset(&reports[port], (const u8 *)&ds2);
+    check("Reset report", padReportRead(&reports[port], data, sizeof(data), port) == 0 && !memcmp(data, &ds2, sizeof(data)));
+}
+
+static void testDisconnected(int port)
+{
+    static const u8 in[21] = {0x01, 0x42, 0x00, 0xFF, 0xFF};
+    static const int out[21] = {0};
+
+    status = 0;
+    transfer("Disconnected", port, in, sizeof(in), out);
+    check("Disconnected pad keeps no actuator alignment", pad[port].lrum == 2 && pad[port].rrum == 2);
+    status = PAD_STATE_RUNNING;
+}
+
+int main(int argc, char **argv)
+{
+    int port;
+
+    check("Report slot size", sizeof(struct ds2report) == PAD_REPORT_SIZE);
+
+    pademu_setup(0x03, 0x03, &fakeDriver);
+
+    for (port = 0; port < 2; port++) {
+        modeCalls = 0;
+
+        testInitSequence(port);
+        testDs3(port);
+        testDs4(port);
+        testReportSlot(port);
+        testDisconnected(port);
+    }
+
+    if (errors)
+        printf("%d errors\n", errors);
+    else
+        printf("pademu: SIO2 sequences, DS3/DS4 reports and report slot OK\n");
+
+    return errors != 0;
+}
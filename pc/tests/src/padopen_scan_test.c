@@ -0,0 +1,421 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Checks the single pass search of the EE core for PadOpen (scan_patterns_with_mask() of ee_core/src/patterns.c)
+  against the search it replaces: find_pattern_with_mask() called again for every pattern, every match and the J/JAL
+  calls to every match, as Install_PadOpen_Hook() still does when the scan results overflow.
+
+  The memory images are built at the addresses of the EE RAM, so that J/JAL instructions reach them. They hold
+  random words and J/JAL calls around copies of every padopen_patterns entry: at the edges of the memory,
+  overlapping each other, more matches and calls than the scan results can hold, and without the first pattern.
+  Self-overlapping and unanchored patterns are checked too.
+  The time of both searches is printed for a memory image of a game.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "ee_core/include/util.h"
+#include "ee_core/include/padpatterns.h"
+
+#define MEM_START 0x00100000
+#define MEM_END   0x01f00000
+#define PATTERNS  7 // NB_PADOPEN_PATTERN
+#define MAX_REF   4096
+#define TEST_WORDS 0x10000 // Memory of the tests other than the game
+
+// In the order of Install_PadOpen_Hook()
+static const scan_pattern_t padopenPatterns[PATTERNS] = {
+    {padPortOpenpattern0, padPortOpenpattern0_mask, sizeof(padPortOpenpattern0)},
+    {pad2CreateSocketpattern0, pad2CreateSocketpattern0_mask, sizeof(pad2CreateSocketpattern0)},
+    {pad2CreateSocketpattern1, pad2CreateSocketpattern1_mask, sizeof(pad2CreateSocketpattern1)},
+    {pad2CreateSocketpattern2, pad2CreateSocketpattern2_mask, sizeof(pad2CreateSocketpattern2)},
+    {padPortOpenpattern1, padPortOpenpattern1_mask, sizeof(padPortOpenpattern1)},
+    {padPortOpenpattern2, padPortOpenpattern2_mask, sizeof(padPortOpenpattern2)},
+    {padPortOpenpattern3, padPortOpenpattern3_mask, sizeof(padPortOpenpattern3)}};
+
+static u32 *mem;
+static int memWords; // The whole EE RAM for a game, less for the other tests
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_usec - start->tv_usec) / 1000.0;
+}
+
+/*--    Memory images    -----------------------------------------------------------------------------------------------*/
+
+static u32 randomWord(void)
+{
+    return ((u32)rand() << 16) ^ (u32)rand();
+}
+
+static u32 jump(int word, int link)
+{
+    return (link ? 0x0c000000 : 0x08000000) | ((u32)(MEM_START + word * 4) >> 2);
+}
+
+// Random words, with J/JAL instructions every so often, most of them to random addresses within the memory
+static void fillRandom(void)
+{
+    int i;
+
+    for (i = 0; i < memWords; i++)
+        mem[i] = rand() % 16 == 0 ? jump(rand() % memWords, rand() & 1) : randomWord();
+}
+
+// A copy of the pattern, with random bits where its mask is clear
+static void putPattern(const scan_pattern_t *pattern, int word)
+{
+    unsigned int j;
+
+    for (j = 0; j < pattern->len / 4; j++)
+        mem[word + j] = pattern->pattern[j] | (randomWord() & ~pattern->mask[j]);
+}
+
+// J/JAL calls to the word, at random places
+static void putCalls(int target, int count)
+{
+    while (count-- > 0)
+        mem[rand() % memWords] = jump(target, rand() & 1);
+}
+
+/*--    Reference    ---------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    u32 *hits[SCAN_MAX_PATTERNS][MAX_REF];
+    int hitCount[SCAN_MAX_PATTERNS];
+    int callCount; // Calls to a location where a pattern matches
+    int overflow;
+} reference_t;
+
+static reference_t ref;
+
+// Every match of the pattern, as the multi-pass search of Install_PadOpen_Hook() finds them
+static int findHits(const scan_pattern_t *pattern, u32 **hits)
+{
+    u32 *ptr;
+    int count = 0;
+
+    ptr = find_pattern_with_mask(mem, memWords * 4, pattern->pattern, pattern->mask, pattern->len);
+    while (ptr && count < MAX_REF) {
+        hits[count++] = ptr;
+        ptr += pattern->len / 4;
+        ptr = find_pattern_with_mask(ptr, MEM_START + memWords * 4 - (u32)(uintptr_t)ptr, pattern->pattern, pattern->mask, pattern->len);
+    }
+
+    return count;
+}
+
+// Every J/JAL call to the location, as Install_PadOpen_Hook() finds them
+static int findCalls(u32 *target, u32 **calls)
+{
+    u32 pattern[1], mask[1], *ptr;
+    int count = 0;
+
+    pattern[0] = 0x08000000 | (0x03ffffff & ((u32)(uintptr_t)target >> 2));
+    mask[0] = 0xfbffffff;
+
+    ptr = find_pattern_with_mask(mem, memWords * 4, pattern, mask, sizeof(pattern));
+    while (ptr && count < MAX_REF) {
+        calls[count++] = ptr;
+        ptr++;
+        ptr = find_pattern_with_mask(ptr, MEM_START + memWords * 4 - (u32)(uintptr_t)ptr, pattern, mask, sizeof(pattern));
+    }
+
+    return count;
+}
+
+static void referenceSearch(const scan_pattern_t *patterns, int count)
+{
+    unsigned int target;
+    u32 word;
+    int p, i;
+
+    memset(&ref, 0, sizeof(ref));
+    for (p = 0; p < count; p++) {
+        ref.hitCount[p] = findHits(&patterns[p], ref.hits[p]);
+        if (ref.hitCount[p] > SCAN_MAX_HITS)
+            ref.overflow = 1;
+    }
+
+    // The scan collects the calls to any location where a pattern matches, even one that overlaps a previous match
+    for (i = 0; i < memWords; i++) {
+        word = mem[i];
+        if ((word >> 27) != 1)
+            continue;
+
+        target = (word & 0x03ffffff) - (MEM_START >> 2);
+        if (target >= (unsigned int)memWords)
+            continue;
+
+        for (p = 0; p < count; p++) {
+            if (patterns[p].len <= (memWords - target) * 4 && find_pattern_with_mask(&mem[target], patterns[p].len, patterns[p].pattern, patterns[p].mask, patterns[p].len)) {
+                ref.callCount++;
+                break;
+            }
+        }
+    }
+    if (ref.callCount > SCAN_MAX_CALLS)
+        ref.overflow = 1;
+}
+
+/*--    Tests    -------------------------------------------------------------------------------------------------------*/
+
+// Compares the scan with the reference search over the current memory image
+static void compareScan(const char *name, const scan_pattern_t *patterns, int count)
+{
+    static u32 *calls[MAX_REF];
+    scan_result_t result;
+    int p, h, c, n, callCount, found;
+
+    referenceSearch(patterns, count);
+    scan_patterns_with_mask(mem, memWords * 4, patterns, count, SCAN_CALLS, &result);
+
+    for (p = 0; p < count; p++) {
+        n = ref.hitCount[p] < SCAN_MAX_HITS ? ref.hitCount[p] : SCAN_MAX_HITS;
+        if (result.hitCount[p] != n || memcmp(result.hits[p], ref.hits[p], n * sizeof(u32 *)) != 0) {
+            printf("%s: pattern %d: %d matches instead of %d\n", name, p, result.hitCount[p], ref.hitCount[p]);
+            errors++;
+        }
+    }
+
+    if (result.overflow != ref.overflow || (!ref.overflow && result.callCount != ref.callCount)) {
+        printf("%s: %d calls, overflow %d instead of %d calls, overflow %d\n", name, result.callCount, result.overflow, ref.callCount, ref.overflow);
+        errors++;
+    }
+
+    // The calls to each match, as patched by Install_PadOpen_Hook()
+    for (p = 0; p < count; p++) {
+        for (h = 0; h < result.hitCount[p]; h++) {
+            n = findCalls(ref.hits[p][h], calls);
+
+            for (c = 0, callCount = 0; c < result.callCount; c++) {
+                if (result.targets[c] != ref.hits[p][h])
+                    continue;
+
+                // Without overflow, the calls of the scan and the search are the same. Otherwise, the scan keeps some of them.
+                found = ref.overflow ? 0 : callCount < n && calls[callCount] == result.calls[c];
+                while (ref.overflow && !found && callCount < n)
+                    found = calls[callCount++] == result.calls[c];
+                if (!ref.overflow)
+                    callCount++;
+
+                if (!found || (u32)(uintptr_t)result.calls[c] < MEM_START) {
+                    printf("%s: call at %p to pattern %d at %p not found by the search\n", name, result.calls[c], p, ref.hits[p][h]);
+                    errors++;
+                    return;
+                }
+            }
+
+            if (!ref.overflow && callCount != n) {
+                printf("%s: %d calls to pattern %d at %p instead of %d\n", name, callCount, p, ref.hits[p][h], n);
+                errors++;
+            }
+        }
+    }
+}
+
+// Without hooking, the scan stops at the first match of the first pattern
+static void compareStopOnFirst(const char *name, const scan_pattern_t *patterns, int count)
+{
+    scan_result_t result, full;
+    int p, hits;
+
+    referenceSearch(patterns, count);
+    hits = scan_patterns_with_mask(mem, memWords * 4, patterns, count, SCAN_STOP_ON_FIRST, &result);
+
+    if (ref.hitCount[0] > 0) {
+        check(name, result.hitCount[0] == 1 && result.hits[0][0] == ref.hits[0][0] && result.callCount == 0);
+
+        // The other patterns only have the matches found before it
+        for (p = 1; p < count; p++) {
+            check(name, memcmp(result.hits[p], ref.hits[p], result.hitCount[p] * sizeof(u32 *)) == 0);
+            hits -= result.hitCount[p];
+        }
+        check(name, hits == 1);
+    } else {
+        scan_patterns_with_mask(mem, memWords * 4, patterns, count, 0, &full);
+        check(name, memcmp(result.hits, full.hits, sizeof(full.hits)) == 0 && memcmp(result.hitCount, full.hitCount, sizeof(full.hitCount)) == 0);
+    }
+}
+
+static void testGame(void)
+{
+    static u32 *calls[MAX_REF];
+    struct timeval start;
+    scan_result_t result;
+    double scanTime, searchTime;
+    int p, h, word;
+
+    // One PadOpen of each libpad version, called from a few places
+    fillRandom();
+    for (p = 0; p < PATTERNS; p++) {
+        word = memWords / 8 * (p + 1) + rand() % 1000;
+        putPattern(&padopenPatterns[p], word);
+        putCalls(word, 1 + rand() % 4);
+    }
+    compareScan("Game", padopenPatterns, PATTERNS);
+    compareStopOnFirst("Game, without hooking", padopenPatterns, PATTERNS);
+
+    // Hooking: every match of every pattern, and the calls to each of them
+    gettimeofday(&start, NULL);
+    scan_patterns_with_mask(mem, memWords * 4, padopenPatterns, PATTERNS, SCAN_CALLS, &result);
+    scanTime = elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for (p = 0; p < PATTERNS; p++) {
+        ref.hitCount[p] = findHits(&padopenPatterns[p], ref.hits[p]);
+        for (h = 0; h < ref.hitCount[p]; h++)
+            findCalls(ref.hits[p][h], calls);
+    }
+    searchTime = elapsed(&start);
+
+    printf("Hooking:         scan %7.2f ms, search %7.2f ms\n", scanTime, searchTime);
+
+    // Without hooking: the first match of the first pattern found
+    gettimeofday(&start, NULL);
+    scan_patterns_with_mask(mem, memWords * 4, padopenPatterns, PATTERNS, SCAN_STOP_ON_FIRST, &result);
+    scanTime = elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for (p = 0; p < PATTERNS; p++) {
+        if (find_pattern_with_mask(mem, memWords * 4, padopenPatterns[p].pattern, padopenPatterns[p].mask, padopenPatterns[p].len))
+            break;
+    }
+    searchTime = elapsed(&start);
+
+    printf("Without hooking: scan %7.2f ms, search %7.2f ms\n", scanTime, searchTime);
+}
+
+static void testEdges(void)
+{
+    int p, last;
+
+    for (p = 0; p < PATTERNS; p++) {
+        last = memWords - padopenPatterns[p].len / 4;
+
+        fillRandom();
+        putPattern(&padopenPatterns[p], 0);
+        putPattern(&padopenPatterns[(p + 1) % PATTERNS], last + padopenPatterns[p].len / 4 - padopenPatterns[(p + 1) % PATTERNS].len / 4);
+        // Calls from the first and the last word
+        mem[0 + padopenPatterns[p].len / 4] = jump(0, 1);
+        mem[memWords - padopenPatterns[(p + 1) % PATTERNS].len / 4 - 1] = jump(memWords - padopenPatterns[(p + 1) % PATTERNS].len / 4, 0);
+        compareScan("Edges", padopenPatterns, PATTERNS);
+        compareStopOnFirst("Edges, without hooking", padopenPatterns, PATTERNS);
+    }
+
+    // A pattern cut by the end of the memory
+    fillRandom();
+    putPattern(&padopenPatterns[0], memWords - padopenPatterns[0].len / 4);
+    memmove(&mem[memWords - padopenPatterns[0].len / 4 + 1], &mem[memWords - padopenPatterns[0].len / 4], padopenPatterns[0].len - 8);
+    compareScan("Cut", padopenPatterns, PATTERNS);
+}
+
+static void testOverlaps(void)
+{
+    // Patterns made of repeated words, whose copies overlap, and patterns without a fully masked word
+    static const u32 repeated[] = {0x27bdffe0, 0x27bdffe0, 0x27bdffe0};
+    static const u32 repeatedMask[] = {0xffffffff, 0xffffffff, 0xffffffff};
+    static const u32 pair[] = {0x27bdffe0, 0xffbf0000};
+    static const u32 pairMask[] = {0xffffffff, 0xffff0000};
+    static const u32 loose[] = {0x03e00000, 0x00000000};
+    static const u32 looseMask[] = {0xffe00000, 0xff000000};
+    static const scan_pattern_t patterns[] = {
+        {repeated, repeatedMask, sizeof(repeated)},
+        {pair, pairMask, sizeof(pair)},
+        {loose, looseMask, sizeof(loose)}};
+    int i, j, p, q, word;
+
+    // Copies of the PadOpen patterns written over each other
+    for (i = 0; i < 50; i++) {
+        fillRandom();
+        for (j = 0; j < 4; j++) {
+            p = rand() % PATTERNS;
+            q = rand() % PATTERNS;
+            word = rand() % (memWords - 200);
+            putPattern(&padopenPatterns[p], word);
+            putPattern(&padopenPatterns[q], word + 1 + rand() % (padopenPatterns[p].len / 4));
+            putPattern(&padopenPatterns[p], word + 1 + rand() % (padopenPatterns[p].len / 4));
+            putCalls(word, 2);
+            putCalls(word + 1 + rand() % 8, 2);
+        }
+        compareScan("Overlaps", padopenPatterns, PATTERNS);
+        compareStopOnFirst("Overlaps, without hooking", padopenPatterns, PATTERNS);
+    }
+
+    // Runs of the repeated word, of every length
+    for (i = 0; i < 20; i++) {
+        fillRandom();
+        for (j = 0; j < 7; j++) {
+            word = memWords / 8 * (j + 1);
+            for (p = 0; p < 1 + j + i % 3; p++)
+                mem[word + p] = repeated[0];
+            mem[word + p] = pair[1] | (randomWord() & 0xffff);
+            putCalls(word + rand() % 3, 1);
+        }
+        mem[memWords - 1] = repeated[0];
+        mem[memWords - 2] = repeated[0];
+        compareScan("Repeated words", patterns, 3);
+        compareStopOnFirst("Repeated words, without hooking", patterns, 3);
+    }
+}
+
+static void testOverflow(void)
+{
+    int i, word;
+
+    // More matches than the scan results hold
+    fillRandom();
+    for (i = 0; i < SCAN_MAX_HITS + 4; i++)
+        putPattern(&padopenPatterns[2], memWords / 16 * (i + 1));
+    compareScan("Matches overflow", padopenPatterns, PATTERNS);
+
+    // More calls than the scan results hold
+    fillRandom();
+    word = memWords / 2;
+    putPattern(&padopenPatterns[5], word);
+    putCalls(word, SCAN_MAX_CALLS + 8);
+    compareScan("Calls overflow", padopenPatterns, PATTERNS);
+    check("Calls overflow", ref.overflow);
+}
+
+int main(int argc, char **argv)
+{
+    mem = mmap((void *)MEM_START, MEM_END - MEM_START, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mem != (u32 *)MEM_START) {
+        perror("EE memory");
+        return 1;
+    }
+
+    srand(1);
+    memWords = (MEM_END - MEM_START) / 4;
+    testGame();
+
+    memWords = TEST_WORDS;
+    testEdges();
+    testOverlaps();
+    testOverflow();
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
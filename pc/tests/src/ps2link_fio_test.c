@@ -0,0 +1,466 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Serves the host file requests of ps2link (modules/debug/ps2link/net_fio.c) over a loopback connection, as the
+  ps2client of the PC does, with the files of a directory of the PC.
+
+  pko_file_serv() runs on a thread and accepts the connection of the host, which is a child process. Random reads,
+  seeks and writes on two files must return what the files of the PC hold, through the read-ahead and the pipelined
+  writes, and the file written must end up identical. The result of each large write is the host's: a short write and
+  a failing write are returned by the write itself, not by the next request. Small writes are buffered, so a failure
+  of the host to write them is returned by the next write or the close of the file.
+
+  Then large reads, small reads and small writes are timed. bin/ps2link_fio_sync_test is the same test with net_fio.c
+  built without read-ahead, pipelined writes and write buffer, each request waiting for its reply as before them, so
+  that both timings can be compared.
+
+  Usage: ps2link_fio_test [directory for the files, bin/ps2link by default]
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/tcp.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "thbase.h"
+#include "ps2ip.h"
+#include "modules/debug/ps2link/hostlink.h"
+#include "modules/debug/ps2link/net_fio.h"
+
+#define FILE_SIZE        300000
+#define HOST_PACKET_SIZE 4096
+#define OPERATIONS       5000
+#define MAX_READ         12000
+#define FULL_SIZE        10000 // Bytes the host accepts for the file named "full"
+#define PS2_RDONLY       0x0001
+#define PS2_WRONLY       0x0002
+#define PS2_RDWR         0x0003
+#define PS2_CREAT        0x0200
+#define PS2_TRUNC        0x0400
+#define LARGE_READ       65536
+#define SMALL_READ       100
+#define SMALL_WRITE      32
+#define SPEED_PASSES     10 // Of the large reads
+
+#ifdef PKO_WRITEBUF_SIZE // Only defined for the build without write buffer
+#define FIO_PATH "one at a time"
+#else
+#define FIO_PATH "pipelined"
+#endif
+
+static char dir[256];
+static int errors;
+
+// pko_file_serv() only returns if it cannot listen
+int ExitDeleteThread(void)
+{
+    return 0;
+}
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+/*--    Host    --------------------------------------------------------------------------------------------------------*/
+
+static int hostRecv(int sock, void *buf, int bytes)
+{
+    int left, len;
+
+    for (left = bytes; left > 0; left -= len) {
+        if ((len = read(sock, (char *)buf + bytes - left, left)) <= 0)
+            return -1;
+    }
+
+    return bytes;
+}
+
+static void hostReply(int sock, unsigned int cmd, int retval)
+{
+    pko_pkt_file_rly reply;
+
+    reply.cmd = htonl(cmd);
+    reply.len = htons(sizeof(reply));
+    reply.retval = htonl(retval);
+    write(sock, &reply, sizeof(reply));
+}
+
+static int hostOpen(const char *path, int flags)
+{
+    char hostPath[512];
+    int mode;
+
+    snprintf(hostPath, sizeof(hostPath), "%s/%s", dir, path);
+    mode = (flags & PS2_RDWR) == PS2_RDWR ? O_RDWR : (flags & PS2_WRONLY ? O_WRONLY : O_RDONLY);
+    if (flags & PS2_CREAT)
+        mode |= O_CREAT;
+    if (flags & PS2_TRUNC)
+        mode |= O_TRUNC;
+
+    return open(hostPath, mode, 0644);
+}
+
+// As ps2client: the requests are served in order, and errors are returned as -errno
+static void host(int sock)
+{
+    static char packet[HOST_PACKET_SIZE], data[HOST_PACKET_SIZE];
+    pko_pkt_hdr *header = (pko_pkt_hdr *)packet;
+    pko_pkt_read_rly readReply;
+    int fd, nbytes, result, fullFd = -1;
+    off_t offset;
+
+    while (hostRecv(sock, packet, sizeof(pko_pkt_hdr)) > 0) {
+        if (hostRecv(sock, packet + sizeof(pko_pkt_hdr), ntohs(header->len) - sizeof(pko_pkt_hdr)) < 0)
+            break;
+
+        switch (ntohl(header->cmd)) {
+            case PKO_OPEN_CMD: {
+                pko_pkt_open_req *req = (pko_pkt_open_req *)packet;
+                result = hostOpen(req->path, ntohl(req->flags));
+                if (result >= 0 && strcmp(req->path, "full") == 0)
+                    fullFd = result;
+                hostReply(sock, PKO_OPEN_RLY, result < 0 ? -errno : result);
+                break;
+            }
+            case PKO_CLOSE_CMD: {
+                pko_pkt_close_req *req = (pko_pkt_close_req *)packet;
+                if (ntohl(req->fd) == fullFd)
+                    fullFd = -1;
+                result = close(ntohl(req->fd));
+                hostReply(sock, PKO_CLOSE_RLY, result < 0 ? -errno : result);
+                break;
+            }
+            case PKO_LSEEK_CMD: {
+                pko_pkt_lseek_req *req = (pko_pkt_lseek_req *)packet;
+                offset = lseek(ntohl(req->fd), (int)ntohl(req->offset), ntohl(req->whence));
+                hostReply(sock, PKO_LSEEK_RLY, offset < 0 ? -errno : (int)offset);
+                break;
+            }
+            case PKO_READ_CMD: {
+                pko_pkt_read_req *req = (pko_pkt_read_req *)packet;
+                char *buf;
+
+                nbytes = ntohl(req->nbytes);
+                buf = malloc(nbytes > 0 ? nbytes : 1);
+                result = read(ntohl(req->fd), buf, nbytes);
+                readReply.cmd = htonl(PKO_READ_RLY);
+                readReply.len = htons(sizeof(readReply));
+                readReply.retval = htonl(result < 0 ? -errno : result);
+                readReply.nbytes = htonl(result < 0 ? 0 : result);
+                write(sock, &readReply, sizeof(readReply));
+                if (result > 0)
+                    write(sock, buf, result);
+                free(buf);
+                break;
+            }
+            case PKO_WRITE_CMD: {
+                pko_pkt_write_req *req = (pko_pkt_write_req *)packet;
+
+                fd = ntohl(req->fd);
+                nbytes = ntohl(req->nbytes);
+                if (hostRecv(sock, data, nbytes) < 0)
+                    return;
+                // A full disk: short, then failing writes
+                if (fd == fullFd) {
+                    offset = lseek(fd, 0, SEEK_CUR);
+                    if (offset >= FULL_SIZE) {
+                        hostReply(sock, PKO_WRITE_RLY, -ENOSPC);
+                        break;
+                    }
+                    if (offset + nbytes > FULL_SIZE)
+                        nbytes = FULL_SIZE - offset;
+                }
+                result = write(fd, data, nbytes);
+                hostReply(sock, PKO_WRITE_RLY, result < 0 ? -errno : result);
+                break;
+            }
+            default:
+                printf("Host: unknown request %08x\n", ntohl(header->cmd));
+                return;
+        }
+    }
+}
+
+static pid_t startHost(void)
+{
+    struct sockaddr_in addr;
+    pid_t pid;
+    int sock, i, nodelay = 1;
+
+    if ((pid = fork()) != 0)
+        return pid;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(PKO_PORT);
+
+    // Until pko_file_serv() listens
+    for (i = 0; i < 500; i++) {
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            // The replies are sent in pieces, which must not wait for the acknowledgement of the previous one
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+            host(sock);
+            exit(0);
+        }
+        close(sock);
+        usleep(10000);
+    }
+
+    printf("Host: cannot connect to port %d\n", PKO_PORT);
+    exit(1);
+}
+
+/*--    Tests    -------------------------------------------------------------------------------------------------------*/
+
+static void *fileServ(void *arg)
+{
+    pko_file_serv(NULL);
+    return NULL;
+}
+
+static char reference[FILE_SIZE], written[FILE_SIZE];
+
+static int writeFile(const char *name, const char *buf, int size)
+{
+    char path[512];
+    FILE *file;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if ((file = fopen(path, "wb")) == NULL)
+        return -1;
+    fwrite(buf, 1, size, file);
+    fclose(file);
+
+    return 0;
+}
+
+static int compareFile(const char *name, const char *buf, int size)
+{
+    static char contents[FILE_SIZE + 1];
+    char path[512];
+    FILE *file;
+    int len;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if ((file = fopen(path, "rb")) == NULL)
+        return 0;
+    len = fread(contents, 1, sizeof(contents), file);
+    fclose(file);
+
+    return len == size && memcmp(contents, buf, size) == 0;
+}
+
+// Waits for the host to connect
+static int connectHost(void)
+{
+    int fd, i;
+
+    for (i = 0; i < 500; i++) {
+        if ((fd = pko_open_file("reference", PS2_RDONLY)) >= 0)
+            return fd;
+        usleep(10000);
+    }
+
+    return -1;
+}
+
+// A reads and seeks the reference, B is read and written over its copy
+static void testRandom(int a)
+{
+    static char buf[MAX_READ];
+    int b, posA = 0, posB = 0, i, n, result, offset;
+
+    b = pko_open_file("written", PS2_RDWR);
+    check("Open", a >= 0 && b >= 0);
+    if (a < 0 || b < 0)
+        return;
+
+    for (i = 0; i < OPERATIONS; i++) {
+        int action = rand() % 10;
+
+        n = rand() % 3 == 0 ? rand() % MAX_READ : rand() % 700;
+        if (action < 5) {
+            result = pko_read_file(a, buf, n);
+            if (result != (posA + n > FILE_SIZE ? FILE_SIZE - posA : n) || memcmp(buf, &reference[posA], result) != 0) {
+                printf("Operation %d: read of %d bytes at %d returned %d\n", i, n, posA, result);
+                errors++;
+                return;
+            }
+            posA += result;
+        } else if (action < 6) {
+            offset = rand() % FILE_SIZE;
+            if ((result = pko_lseek_file(a, offset - posA, SEEK_CUR)) != offset) {
+                printf("Operation %d: seek to %d returned %d\n", i, offset, result);
+                errors++;
+                return;
+            }
+            posA = offset;
+        } else if (action < 8) {
+            result = pko_read_file(b, buf, n);
+            if (result != (posB + n > FILE_SIZE ? FILE_SIZE - posB : n) || memcmp(buf, &written[posB], result) != 0) {
+                printf("Operation %d: read of %d bytes at %d of the written file returned %d\n", i, n, posB, result);
+                errors++;
+                return;
+            }
+            posB += result;
+        } else {
+            if (posB + n > FILE_SIZE)
+                n = FILE_SIZE - posB;
+            memcpy(&written[posB], &reference[(posB + i) % (FILE_SIZE - n)], n);
+            if ((result = pko_write_file(b, &written[posB], n)) != n) {
+                printf("Operation %d: write of %d bytes at %d returned %d\n", i, n, posB, result);
+                errors++;
+                return;
+            }
+            posB += n;
+        }
+
+        if (posA >= FILE_SIZE)
+            posA = pko_lseek_file(a, 0, SEEK_SET);
+        if (posB >= FILE_SIZE)
+            posB = pko_lseek_file(b, 0, SEEK_SET);
+    }
+
+    check("Close", pko_close_file(b) == 0);
+    check("Written file", compareFile("written", written, FILE_SIZE));
+}
+
+static void testWriteErrors(int a)
+{
+    int fd;
+
+    // Writes to a file opened for reading fail at once, and do not fail the next request
+    check("Failing write", pko_write_file(a, reference, 5000) < 0);
+    check("Read after a failing write", pko_lseek_file(a, 0, SEEK_SET) == 0 && pko_read_file(a, written, 100) == 100 && memcmp(written, reference, 100) == 0);
+    check("Close after a failing write", pko_close_file(a) == 0);
+
+    // A full disk: the write that fills it is short, the next one fails, the close succeeds
+    fd = pko_open_file("full", PS2_WRONLY | PS2_CREAT | PS2_TRUNC);
+    check("Open full", fd >= 0);
+    check("Write before full", pko_write_file(fd, reference, FULL_SIZE / 2) == FULL_SIZE / 2);
+    check("Short write", pko_write_file(fd, reference, FULL_SIZE) == FULL_SIZE - FULL_SIZE / 2);
+#ifdef PKO_WRITEBUF_SIZE
+    check("Write when full", pko_write_file(fd, reference, 100) == -ENOSPC);
+    check("Close full", pko_close_file(fd) == 0);
+#else
+    // Buffered: the seek sends the write, whose failure is returned by the next write, then by the close
+    check("Write when full", pko_write_file(fd, reference, 100) == 100);
+    check("Seek when full", pko_lseek_file(fd, 0, SEEK_CUR) == FULL_SIZE);
+    check("Write after a failing write", pko_write_file(fd, reference, 100) == -ENOSPC);
+    check("Write when full again", pko_write_file(fd, reference, 100) == 100);
+    check("Close full", pko_close_file(fd) == -ENOSPC);
+#endif
+}
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_usec - start->tv_usec) / 1000.0;
+}
+
+static void testSpeed(void)
+{
+    static char buf[LARGE_READ];
+    struct timeval start;
+    int fd, i, pos, result;
+
+    fd = pko_open_file("reference", PS2_RDONLY);
+    check("Open for the large reads", fd >= 0);
+    gettimeofday(&start, NULL);
+    for (i = 0; i < SPEED_PASSES; i++) {
+        pko_lseek_file(fd, 0, SEEK_SET);
+        for (pos = 0; (result = pko_read_file(fd, buf, LARGE_READ)) > 0; pos += result) {
+            if (memcmp(buf, &reference[pos], result) != 0)
+                break;
+        }
+        if (pos != FILE_SIZE) {
+            printf("Large reads: stopped at %d\n", pos);
+            errors++;
+            break;
+        }
+    }
+    printf("Large reads, %-13s %7.2f ms\n", FIO_PATH, elapsed(&start));
+
+    gettimeofday(&start, NULL);
+    pko_lseek_file(fd, 0, SEEK_SET);
+    for (pos = 0; (result = pko_read_file(fd, buf, SMALL_READ)) > 0; pos += result) {
+        if (memcmp(buf, &reference[pos], result) != 0)
+            break;
+    }
+    printf("Small reads, %-13s %7.2f ms\n", FIO_PATH, elapsed(&start));
+    check("Small reads", pos == FILE_SIZE);
+    check("Close after the reads", pko_close_file(fd) == 0);
+
+    fd = pko_open_file("small", PS2_WRONLY | PS2_CREAT | PS2_TRUNC);
+    check("Open for the small writes", fd >= 0);
+    gettimeofday(&start, NULL);
+    for (pos = 0; pos < FILE_SIZE; pos += SMALL_WRITE) {
+        if (pko_write_file(fd, &reference[pos], SMALL_WRITE) != SMALL_WRITE)
+            break;
+    }
+    check("Close after the writes", pko_close_file(fd) == 0);
+    printf("Small writes, %-12s %7.2f ms\n", FIO_PATH, elapsed(&start));
+    check("Small writes", pos == FILE_SIZE && compareFile("small", reference, FILE_SIZE));
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thread;
+    pid_t pid;
+    int status, i, a;
+
+    alarm(60);
+    signal(SIGPIPE, SIG_IGN);
+
+    snprintf(dir, sizeof(dir), "%s", argc > 1 ? argv[1] : "bin/ps2link");
+    mkdir(dir, 0755);
+
+    srand(1);
+    for (i = 0; i < FILE_SIZE; i++)
+        reference[i] = rand();
+    memcpy(written, reference, FILE_SIZE);
+    if (writeFile("reference", reference, FILE_SIZE) < 0 || writeFile("written", written, FILE_SIZE) < 0) {
+        perror(dir);
+        return 1;
+    }
+
+    pthread_create(&thread, NULL, &fileServ, NULL);
+    pid = startHost();
+
+    if ((a = connectHost()) < 0) {
+        printf("No host\n");
+        kill(pid, SIGKILL);
+        return 1;
+    }
+
+    testRandom(a);
+    testWriteErrors(a);
+    testSpeed();
+
+    // The host closes the connection first, so that the port of pko_file_serv() is free for the next run
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+    check("Host", WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+    pko_close_socket();
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
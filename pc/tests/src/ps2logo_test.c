@@ -0,0 +1,107 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Checks the unscrambling of the PS2 logo by cdvdman (modules/iopcore/cdvdman/ps2logo.c), which works a word at a
+  time on aligned buffers, against the byte algorithm of ps2logo.
+
+  Random reads of a scrambled disc, at every alignment of the buffer, must return the sectors of the logo unscrambled
+  and leave the sectors after it, and the bytes around the buffer, as they are. A disc whose first byte is 0 has no
+  scrambled logo.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "ps2logo.h"
+
+#define LOGO_SECTORS 12
+#define DISC_SECTORS 40
+#define READS        100000
+#define GUARD        8
+
+static u8 disc[DISC_SECTORS * 2048], expected[DISC_SECTORS * 2048];
+static u8 buffer[GUARD + DISC_SECTORS * 2048 + GUARD];
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+// ps2logo: the key is the first byte, XORed with the first pixel, which is black
+static void unscramble(u8 *logo, u8 key)
+{
+    int i;
+
+    for (i = 0; i < LOGO_SECTORS * 2048; i++) {
+        logo[i] ^= key;
+        logo[i] = (logo[i] << 3) | (logo[i] >> 5);
+    }
+}
+
+// Returns 0 if the read returned the expected sectors
+static int readSectors(u32 lsn, unsigned int sectors, int alignment)
+{
+    u8 *buf = &buffer[GUARD + alignment];
+    int i;
+
+    memset(buffer, 0xEE, sizeof(buffer));
+    memcpy(buf, &disc[lsn * 2048], sectors * 2048);
+    PS2LogoRead(lsn, sectors, buf);
+
+    if (memcmp(buf, &expected[lsn * 2048], sectors * 2048) != 0) {
+        printf("LSN %u, %u sectors at +%d: not unscrambled\n", lsn, sectors, alignment);
+        return -1;
+    }
+
+    for (i = 0; i < (int)sizeof(buffer); i++) {
+        if ((i < GUARD + alignment || i >= GUARD + alignment + sectors * 2048) && buffer[i] != 0xEE) {
+            printf("LSN %u, %u sectors at +%d: byte %d around the buffer changed\n", lsn, sectors, alignment, i - GUARD - alignment);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    u32 lsn, sectors;
+    int i;
+
+    srand(3);
+    for (i = 0; i < (int)sizeof(disc); i++)
+        disc[i] = rand();
+    disc[0] = 0x5A;
+
+    memcpy(expected, disc, sizeof(disc));
+    unscramble(expected, disc[0]);
+
+    // The key is taken from the first sector, read first
+    for (i = 0; i < READS; i++) {
+        lsn = i == 0 ? 0 : rand() % (LOGO_SECTORS + 8);
+        sectors = 1 + rand() % (DISC_SECTORS - lsn);
+
+        if (readSectors(lsn, sectors, rand() % 4) != 0) {
+            errors++;
+            break;
+        }
+    }
+
+    // No logo
+    disc[0] = 0;
+    memcpy(expected, disc, sizeof(disc));
+    for (i = 0; i < 4; i++)
+        check("Disc without logo", readSectors(0, LOGO_SECTORS + 1, i) == 0);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
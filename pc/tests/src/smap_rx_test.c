@@ -0,0 +1,283 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Lends the receive buffers of the in-game SMAP driver (modules/network/smap-ingame/rxbuf.c) to the pbuf functions of
+  SMSTCPIP (modules/network/SMSTCPIP/pbuf.c), as HandleRxIntr() and the stack do.
+
+  The buffers must come back to the free list whatever the order the stack frees them in, through references and
+  chains, and never be lent twice. Once they are all held, frames must fall back to the pbuf pool, then be dropped.
+  A random run of frames received, referenced, chained and freed checks that no buffer is damaged while it is held.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "thbase.h"
+#include "smstcpip.h"
+#include "main.h"
+
+#define FRAMES      200000
+#define MAX_HELD    32
+#define POOL_PBUFS  4 // PBUF_POOL_SIZE of the in-game SMSTCPIP
+#define ETH_HLEN    14
+
+struct SmapDriverData SmapDriverData;
+
+void pbuf_init(void);
+
+// Only used by pbuf.c for PBUF_RAM and PBUF_REF pbufs, which the driver does not allocate
+void *mem_malloc(u32 size)
+{
+    return malloc(size);
+}
+
+void mem_free(void *mem)
+{
+    free(mem);
+}
+
+void *mem_realloc(void *mem, u32 size)
+{
+    return mem;
+}
+
+void *memp_malloc(int type)
+{
+    return NULL;
+}
+
+void memp_free(int type, void *mem)
+{
+}
+
+void *mips_memcpy(void *dest, const void *src, size_t n)
+{
+    return memcpy(dest, src, n);
+}
+
+typedef struct
+{
+    struct pbuf *pbuf;
+    u8 fill; // Byte written over the whole frame when it was received
+    u16 length;
+} held_t;
+
+static held_t held[MAX_HELD];
+static int heldCount;
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+static struct pbuf *receive(u16 length, u8 fill)
+{
+    struct pbuf *p = SmapRxBufferAlloc(&SmapDriverData, (length + 3) & ~3);
+
+    if (p != NULL)
+        memset(p->payload, fill, length);
+
+    return p;
+}
+
+static int isHeld(struct pbuf *p, int except)
+{
+    int i;
+
+    for (i = 0; i < heldCount; i++) {
+        if (i != except && held[i].pbuf == p)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int isIntact(const held_t *frame)
+{
+    const u8 *payload = frame->pbuf->payload;
+    int i;
+
+    for (i = 0; i < frame->length; i++) {
+        if (payload[i] != frame->fill)
+            return 0;
+    }
+
+    return 1;
+}
+
+static void testExhaustion(void)
+{
+    struct pbuf *p[SMAP_RX_BUFFERS + POOL_PBUFS + 1];
+    int i, j, ok = 1;
+
+    for (i = 0; i < SMAP_RX_BUFFERS; i++) {
+        p[i] = receive(MAX_FRAME_SIZE, i);
+        ok &= p[i] != NULL && p[i]->flags == PBUF_FLAG_CUSTOM && p[i]->ref == 1 && p[i]->next == NULL;
+        ok &= p[i] != NULL && (u8 *)p[i]->payload == (u8 *)p[i] + sizeof(struct pbuf_custom);
+        for (j = 0; j < i; j++)
+            ok &= p[i] != p[j];
+    }
+    check("Receive buffers", ok);
+    if (!ok)
+        return;
+
+    for (i = 0; i < SMAP_RX_BUFFERS; i++) {
+        held[0].pbuf = p[i];
+        held[0].fill = i;
+        held[0].length = MAX_FRAME_SIZE;
+        ok &= isIntact(&held[0]);
+    }
+    check("Receive buffers do not overlap", ok);
+
+    for (i = SMAP_RX_BUFFERS; i < SMAP_RX_BUFFERS + POOL_PBUFS; i++) {
+        p[i] = receive(60, i);
+        ok &= p[i] != NULL && p[i]->flags == PBUF_FLAG_POOL;
+    }
+    check("Pool fallback", ok && SmapDriverData.RxBufferExhausted == POOL_PBUFS && SmapDriverData.RxDropped == 0);
+
+    p[i] = receive(60, i);
+    check("Dropped frame", p[i] == NULL && SmapDriverData.RxBufferExhausted == POOL_PBUFS + 1 && SmapDriverData.RxDropped == 1);
+
+    // Freed out of order, every other one first
+    for (i = 0; i < SMAP_RX_BUFFERS + POOL_PBUFS; i += 2)
+        ok &= pbuf_free(p[i]) == 1;
+    for (i = 1; i < SMAP_RX_BUFFERS + POOL_PBUFS; i += 2)
+        ok &= pbuf_free(p[i]) == 1;
+    check("Freed", ok);
+
+    SmapDriverData.RxBufferExhausted = 0;
+    SmapDriverData.RxDropped = 0;
+    for (i = 0; i < SMAP_RX_BUFFERS; i++) {
+        p[i] = receive(MAX_FRAME_SIZE, i);
+        ok &= p[i] != NULL && p[i]->flags == PBUF_FLAG_CUSTOM;
+    }
+    for (i = 0; i < SMAP_RX_BUFFERS; i++)
+        pbuf_free(p[i]);
+    check("All buffers returned", ok && SmapDriverData.RxBufferExhausted == 0);
+}
+
+static void testHeaders(void)
+{
+    struct pbuf *p = receive(MAX_FRAME_SIZE, 0);
+    void *frame = p->payload;
+
+    // ethernet_input() hides the Ethernet header, and the stack may reveal it again
+    check("Hide the header", pbuf_header(p, -ETH_HLEN) == 0 && (u8 *)p->payload == (u8 *)frame + ETH_HLEN && p->len == ((MAX_FRAME_SIZE + 3) & ~3) - ETH_HLEN);
+    check("Reveal the header", pbuf_header(p, ETH_HLEN) == 0 && p->payload == frame);
+    check("Nothing before the frame", pbuf_header(p, 1) == 1 && p->payload == frame);
+
+    pbuf_free(p);
+}
+
+static void testReferences(void)
+{
+    struct pbuf *p, *q, *r;
+
+    p = receive(100, 1);
+    pbuf_ref(p);
+    check("Still referenced", pbuf_free(p) == 0);
+    check("Last reference", pbuf_free(p) == 1);
+    check("Returned", receive(100, 1) == p);
+    pbuf_free(p);
+
+    // A reassembled packet: the chain holds its tail
+    p = receive(100, 1);
+    q = receive(100, 2);
+    r = receive(100, 3);
+    pbuf_chain(p, q);
+    pbuf_free(q);
+    pbuf_chain(p, r);
+    pbuf_free(r);
+    check("Chain", p->tot_len == 3 * 100 && p->next == q && q->next == r);
+    check("Chain freed", pbuf_free(p) == 3);
+}
+
+// Frames received, queued by the stack, referenced and freed in random order
+static void testRandom(void)
+{
+    int frame, i, lent = 0;
+
+    srand(1);
+    for (frame = 0; frame < FRAMES; frame++) {
+        int action = rand() % 8;
+
+        if (action < 3 && heldCount < MAX_HELD) {
+            held_t *f = &held[heldCount];
+
+            f->length = 60 + rand() % (MAX_FRAME_SIZE - 59);
+            f->fill = frame;
+            if ((f->pbuf = receive(f->length, f->fill)) == NULL)
+                continue;
+
+            if (f->pbuf->flags == PBUF_FLAG_CUSTOM)
+                lent++;
+            if (isHeld(f->pbuf, heldCount)) {
+                printf("Frame %d: buffer lent twice\n", frame);
+                errors++;
+                return;
+            }
+            heldCount++;
+        } else if (action < 4 && heldCount > 0) {
+            // Another reference, such as the ARP queue or a socket holding it
+            i = rand() % heldCount;
+            pbuf_ref(held[i].pbuf);
+            held[heldCount] = held[i];
+            if (heldCount < MAX_HELD)
+                heldCount++;
+            else
+                pbuf_free(held[i].pbuf);
+        } else if (heldCount > 0) {
+            i = rand() % heldCount;
+            if (!isIntact(&held[i])) {
+                printf("Frame %d: buffer overwritten while held\n", frame);
+                errors++;
+                return;
+            }
+
+            pbuf_free(held[i].pbuf);
+            held[i] = held[--heldCount];
+        }
+    }
+
+    while (heldCount > 0)
+        pbuf_free(held[--heldCount].pbuf);
+
+    printf("%d frames: %d in receive buffers, %u in the pbuf pool, %u dropped\n", FRAMES, lent,
+           SmapDriverData.RxBufferExhausted - SmapDriverData.RxDropped, SmapDriverData.RxDropped);
+}
+
+int main(int argc, char **argv)
+{
+    pbuf_init();
+    SmapRxBufferInit();
+
+    // The other tests would chain a buffer lent twice to itself
+    testExhaustion();
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+
+    testHeaders();
+    testReferences();
+    testRandom();
+
+    // Nothing leaked: every buffer and pool pbuf can be taken again
+    SmapDriverData.RxBufferExhausted = 0;
+    SmapDriverData.RxDropped = 0;
+    for (heldCount = 0; heldCount < SMAP_RX_BUFFERS + POOL_PBUFS; heldCount++)
+        held[heldCount].pbuf = receive(60, 0);
+    check("No leak", SmapDriverData.RxDropped == 0 && receive(60, 0) == NULL);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
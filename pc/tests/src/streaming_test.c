@@ -0,0 +1,604 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Streams through the real stream buffer of cdvdman (modules/iopcore/cdvdman/streaming.c), with its fill thread, and
+  a drive that completes its reads from a thread of its own, the way the read thread of cdvdman.c does.
+
+  The IOP threads, semaphores and event flags are emulated with pthreads, one running at a time, and each sector the
+  drive reads holds its own LSN, so that the stream is checked sector by sector.
+  The streams are:
+  - Read sequentially in blocking and non-blocking mode, into IOP and EE memory, across the end of the buffer.
+  - Left to fill, so that the free banks are read together.
+  - Competing with the game's own reads, which keep the drive busy.
+  - Read with a blocking read larger than the whole buffer.
+  - Seeking to a buffered sector, which keeps the buffer, and to a sector that is not buffered.
+  - Paused, during which the drive must not be used, then resumed where it stopped.
+  - Read by a game at a steady rate, from a drive whose reads take a time per sector, with slow reads from time to
+    time: the game faster than the drive must wait for data (StUnderruns), the game slower than the drive must not,
+    unless a slow read takes longer than the buffer lasts. The longest read (StFillTicksMax) must include the slow
+    reads.
+*/
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "internal.h"
+
+// internal.h replaces memcpy with the one of the IOP kernel, which the test provides
+#undef memcpy
+
+#define MAX_THREADS  4
+#define MAX_SEMAS    4
+#define STREAM_LSN   1000
+#define BUFMAX       80 // Sectors
+#define BANKMAX      5
+#define BANKSIZE     (BUFMAX / BANKMAX)
+#define READ_USEC    200 // The time the drive takes for each read, by default
+#define GAME_LSN     50
+#define GAME_SECTORS 8
+#define EE_ADDR      0x80000000
+
+cdvdman_status_t cdvdman_stat;
+
+/*--    IOP kernel    --------------------------------------------------------------------------------------------------*/
+
+/* One thread runs at a time, as on the IOP: cpu is held while running and only released while blocked.
+   CpuSuspendIntr() is then not needed, as nothing interrupts the running thread. */
+static pthread_mutex_t cpu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+
+typedef struct
+{
+    void (*func)(void *arg);
+    void *arg;
+    pthread_t thread;
+} thread_t;
+
+static thread_t threads[MAX_THREADS];
+static int threadCount;
+
+static int semaCount[MAX_SEMAS], semaMax[MAX_SEMAS];
+static int semaUsed;
+
+static u32 eventBits;
+
+static void *threadStart(void *arg)
+{
+    thread_t *thread = arg;
+
+    pthread_mutex_lock(&cpu);
+    thread->func(thread->arg);
+    pthread_mutex_unlock(&cpu);
+
+    return NULL;
+}
+
+int CreateThread(iop_thread_t *thread)
+{
+    if (threadCount >= MAX_THREADS)
+        return -1;
+
+    threads[threadCount].func = thread->thread;
+    return threadCount++;
+}
+
+int StartThread(int thid, void *arg)
+{
+    threads[thid].arg = arg;
+    return pthread_create(&threads[thid].thread, NULL, &threadStart, &threads[thid]) == 0 ? 0 : -1;
+}
+
+int DelayThread(int usec)
+{
+    pthread_mutex_unlock(&cpu);
+    usleep(usec);
+    pthread_mutex_lock(&cpu);
+
+    return 0;
+}
+
+void GetSystemTime(iop_sys_clock_t *sys_clock)
+{
+    struct timespec now;
+    u64 ticks;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ticks = (u64)now.tv_sec * 36864000 + now.tv_nsec / 1000 * 36864 / 1000;
+    sys_clock->lo = (u32)ticks;
+    sys_clock->hi = (u32)(ticks >> 32);
+}
+
+int CreateSema(iop_sema_t *sema)
+{
+    if (semaUsed >= MAX_SEMAS)
+        return -1;
+
+    semaCount[semaUsed] = sema->initial;
+    semaMax[semaUsed] = sema->max;
+    return semaUsed++;
+}
+
+// Signals beyond the maximum count are lost, as on the IOP
+int SignalSema(int sema)
+{
+    if (semaCount[sema] < semaMax[sema])
+        semaCount[sema]++;
+    pthread_cond_broadcast(&changed);
+
+    return 0;
+}
+
+int WaitSema(int sema)
+{
+    while (semaCount[sema] == 0)
+        pthread_cond_wait(&changed, &cpu);
+    semaCount[sema]--;
+
+    return 0;
+}
+
+// There is only the event flag of cdvdman
+int SetEventFlag(int ef, u32 bits)
+{
+    eventBits |= bits;
+    pthread_cond_broadcast(&changed);
+
+    return 0;
+}
+
+int ClearEventFlag(int ef, u32 bits)
+{
+    eventBits &= bits;
+    return 0;
+}
+
+int WaitEventFlag(int ef, u32 bits, int mode, u32 *resbits)
+{
+    while ((eventBits & bits) != bits)
+        pthread_cond_wait(&changed, &cpu);
+    if (resbits != NULL)
+        *resbits = eventBits;
+
+    return 0;
+}
+
+void *mips_memcpy(void *dest, const void *src, size_t n)
+{
+    return memcpy(dest, src, n);
+}
+
+// The transfers to the EE complete at once
+int sceSifSetDma(SifDmaTransfer_t *dmat, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        memcpy(dmat[i].dest, dmat[i].src, dmat[i].size);
+
+    return 1;
+}
+
+int sceSifDmaStat(int trid)
+{
+    return -1;
+}
+
+/*--    cdvdman    -----------------------------------------------------------------------------------------------------*/
+
+unsigned char sync_flag;
+
+static StmCallback_t Stm0Callback;
+static int driveSema;
+
+// What the drive was asked for
+static int streamReads, streamReadsMax, streamReadsUnaligned, gameReads;
+static u32 streamReadLsn;
+
+// The time the drive takes for a read: per read and per sector, longer for one in every spikeEvery reads of the stream
+static int readUsec = READ_USEC, sectorUsec, spikeEvery, spikeUsec;
+
+void SetStm0Callback(StmCallback_t callback)
+{
+    Stm0Callback = callback;
+}
+
+int sceCdSync(int mode)
+{
+    if (!sync_flag)
+        return 0;
+
+    if ((mode == 1) || (mode == 17))
+        return 1;
+
+    while (sync_flag)
+        WaitEventFlag(cdvdman_stat.intr_ef, 1, WEF_AND, NULL);
+
+    return 0;
+}
+
+int sceCdGetError(void)
+{
+    return cdvdman_stat.err;
+}
+
+int cdvdman_AsyncRead(u32 lsn, u32 sectors, u16 sector_size, void *buf, u8 caller)
+{
+    if (sync_flag)
+        return 0;
+
+    ClearEventFlag(cdvdman_stat.intr_ef, ~1);
+    sync_flag = 1;
+
+    cdvdman_stat.cdread_lba = lsn;
+    cdvdman_stat.cdread_sectors = sectors;
+    cdvdman_stat.sector_size = sector_size;
+    cdvdman_stat.cdread_caller = caller;
+    cdvdman_stat.cdread_buf = buf;
+
+    if (caller == IOTRACE_CALLER_STREAM) {
+        streamReads++;
+        streamReadLsn = lsn;
+        if (sectors > streamReadsMax)
+            streamReadsMax = sectors;
+        if (sectors % BANKSIZE != 0)
+            streamReadsUnaligned++;
+        // Not written past the buffer: the stream then fails the checks rather than the test crashing
+        if ((u8 *)buf + sectors * 2048 > (u8 *)cdvdman_stat.StreamingData.StIOP_bufaddr + BUFMAX * 2048) {
+            streamReadsUnaligned++;
+            cdvdman_stat.cdread_sectors = 0;
+        }
+    } else
+        gameReads++;
+
+    SignalSema(driveSema);
+
+    return 1;
+}
+
+// Each sector is filled with its LSN
+static void fillSectors(u32 *buf, u32 lsn, u32 sectors)
+{
+    u32 i, j;
+
+    for (i = 0; i < sectors; i++, lsn++) {
+        for (j = 0; j < 2048 / 4; j++)
+            *buf++ = lsn;
+    }
+}
+
+static u32 checkSectors(const u32 *buf, u32 lsn, u32 sectors)
+{
+    u32 i, j;
+
+    for (i = 0; i < sectors; i++, lsn++) {
+        for (j = 0; j < 2048 / 4; j++) {
+            if (*buf++ != lsn)
+                return i;
+        }
+    }
+
+    return sectors;
+}
+
+// As the read thread of cdvdman.c
+static void driveThread(void *arg)
+{
+    int usec;
+
+    while (1) {
+        WaitSema(driveSema);
+
+        usec = readUsec + cdvdman_stat.cdread_sectors * sectorUsec;
+        if (spikeEvery && cdvdman_stat.cdread_caller == IOTRACE_CALLER_STREAM && streamReads % spikeEvery == 0)
+            usec += spikeUsec;
+        DelayThread(usec);
+        fillSectors(cdvdman_stat.cdread_buf, cdvdman_stat.cdread_lba, cdvdman_stat.cdread_sectors);
+
+        sync_flag = 0;
+        SetEventFlag(cdvdman_stat.intr_ef, 9);
+        if (Stm0Callback != NULL)
+            Stm0Callback();
+    }
+}
+
+/*--    Tests    -------------------------------------------------------------------------------------------------------*/
+
+static u8 *iopBuffer, *streamBuffer, *gameBuffer;
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+// The EE and IOP addresses are 32-bit, and EE buffers are passed with bit 31 set
+static void *alloc32(size_t size)
+{
+    void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+    if (buffer == MAP_FAILED || ((u64)(uintptr_t)buffer + size) > EE_ADDR) {
+        printf("No memory below 2GB\n");
+        exit(1);
+    }
+
+    return buffer;
+}
+
+// Lets the stream fill the buffer
+static void waitFull(void)
+{
+    int i;
+
+    for (i = 0; i < 1000 && (cdvdman_stat.StreamingData.StStreamed < BUFMAX || cdvdman_stat.StreamingData.StIsReading); i++)
+        DelayThread(READ_USEC);
+}
+
+static int streamRead(u32 sectors, void *buffer, u32 mode, int ee)
+{
+    u32 error;
+
+    return sceCdStRead(sectors, (u32 *)(uintptr_t)((u32)(uintptr_t)buffer | (ee ? EE_ADDR : 0)), mode, &error);
+}
+
+// Reads the stream from lsn in reads of 1 to 40 sectors
+static void testSequential(const char *name, u32 lsn, u32 total, u32 mode, int ee)
+{
+    u32 sectors, done, got, tries;
+
+    for (done = 0; done < total; done += got) {
+        sectors = 1 + rand() % 40;
+        if (sectors > total - done)
+            sectors = total - done;
+
+        for (got = 0, tries = 0; got == 0 && tries < 1000; tries++) {
+            if ((got = streamRead(sectors, iopBuffer, mode, ee)) == 0)
+                DelayThread(READ_USEC / 2);
+        }
+
+        if (got == 0 || got > sectors || (mode && got != sectors)) {
+            printf("%s: %u sectors read instead of %u\n", name, got, sectors);
+            errors++;
+            return;
+        }
+        if (checkSectors((u32 *)iopBuffer, lsn + done, got) != got) {
+            printf("%s: LSN %u: sector %u instead\n", name, lsn + done, *(u32 *)(iopBuffer + checkSectors((u32 *)iopBuffer, lsn + done, got) * 2048));
+            errors++;
+            return;
+        }
+    }
+}
+
+static void testMergedReads(void)
+{
+    sceCdStStart(STREAM_LSN, NULL);
+    streamReadsMax = 0;
+    streamReadsUnaligned = 0;
+
+    waitFull();
+    check("Full buffer", sceCdStStat() == BUFMAX);
+
+    // The game takes a little at a time: the banks it frees are read together once half the buffer is free
+    testSequential("Merged reads", STREAM_LSN, BUFMAX * 20, 1, 0);
+    printf("Largest read: %d sectors\n", streamReadsMax);
+    check("Merged reads", streamReadsMax > BANKSIZE && streamReadsMax <= BUFMAX && streamReadsUnaligned == 0);
+}
+
+static void testGameReads(void)
+{
+    u32 lsn = STREAM_LSN, got;
+    int i, reads = gameReads;
+
+    sceCdStStart(lsn, NULL);
+    for (i = 0; i < 50; i++) {
+        // The game's read is retried until the drive is free, and the stream must then go on
+        while (!cdvdman_AsyncRead(GAME_LSN + i, GAME_SECTORS, 2048, gameBuffer, IOTRACE_CALLER_CDREAD))
+            DelayThread(READ_USEC / 4);
+        got = streamRead(1 + i % 24, iopBuffer, 1, 0);
+        if (got != 1 + i % 24 || checkSectors((u32 *)iopBuffer, lsn, got) != got) {
+            printf("Game reads: stream damaged at LSN %u\n", lsn);
+            errors++;
+            return;
+        }
+        lsn += got;
+
+        sceCdSync(0);
+        if (checkSectors((u32 *)gameBuffer, GAME_LSN + i, GAME_SECTORS) != GAME_SECTORS) {
+            printf("Game reads: game read %d damaged\n", i);
+            errors++;
+            return;
+        }
+    }
+
+    check("Game reads", gameReads == reads + 50);
+    testSequential("After the game reads", lsn, BUFMAX * 4, 1, 0);
+}
+
+static void testLargeRead(void)
+{
+    u32 got;
+
+    sceCdStStart(STREAM_LSN, NULL);
+    got = streamRead(BUFMAX * 3 + 7, iopBuffer, 1, 1);
+    check("Read larger than the buffer", got == BUFMAX * 3 + 7 && checkSectors((u32 *)iopBuffer, STREAM_LSN, got) == got);
+}
+
+static void testSeek(void)
+{
+    u32 buffered, lsn;
+    int reads;
+
+    sceCdStStart(STREAM_LSN, NULL);
+    waitFull();
+
+    // Forward, within the buffer: nothing is read again
+    buffered = cdvdman_stat.StreamingData.Stlsn - cdvdman_stat.StreamingData.StStreamed;
+    lsn = buffered + BANKSIZE + 5;
+    reads = streamReads;
+    check("Seek within the buffer", sceCdStSeek(lsn) == 1 && streamReads == reads);
+    testSequential("Seek within the buffer", lsn, BUFMAX, 1, 0);
+    check("Seek within the buffer, next read", streamReadLsn >= buffered + BUFMAX);
+
+    // Back, out of the buffer
+    check("Seek back", sceCdStSeek(STREAM_LSN) == 1);
+    testSequential("Seek back", STREAM_LSN, BUFMAX, 1, 0);
+
+    // Far ahead
+    check("Seek ahead", sceCdStSeek(STREAM_LSN + 100000) == 1);
+    testSequential("Seek ahead", STREAM_LSN + 100000, BUFMAX, 0, 1);
+}
+
+static void testPause(void)
+{
+    u32 lsn = STREAM_LSN, got;
+    int i, reads;
+
+    sceCdStStart(lsn, NULL);
+    for (i = 0; i < 20; i++) {
+        // Paused with or without a read in progress
+        DelayThread(i % 2 ? READ_USEC / 2 : READ_USEC * 4);
+        check("Pause", sceCdStPause() == 1);
+        reads = streamReads;
+
+        DelayThread(READ_USEC * 4);
+        check("No read while paused", streamReads == reads && !sync_flag);
+
+        // The sectors that were buffered can still be read
+        while ((got = streamRead(BUFMAX, iopBuffer, 0, 0)) > 0) {
+            if (checkSectors((u32 *)iopBuffer, lsn, got) != got) {
+                printf("Pause %d: buffered sectors damaged at LSN %u\n", i, lsn);
+                errors++;
+                return;
+            }
+            lsn += got;
+        }
+        check("No read while paused", streamReads == reads);
+
+        check("Resume", sceCdStResume() == 1);
+        testSequential("Resume", lsn, BANKSIZE * 2 + i, 1, 0);
+        lsn += BANKSIZE * 2 + i;
+    }
+
+    // Paused and resumed at once, while the drive still reads for the stream
+    for (i = 0; i < 20; i++) {
+        sceCdStPause();
+        sceCdStResume();
+        testSequential("Pause and resume", lsn, 7, 1, 0);
+        lsn += 7;
+    }
+}
+
+typedef struct
+{
+    const char *name;
+    u32 sectors;    // Read by the game at once
+    int usec;       // Between the reads of the game
+    int sectorUsec; // Of the drive
+    int spikeEvery;
+    int spikeUsec;
+    int underruns; // Whether the game must wait for data
+} rate_test_t;
+
+/* The drive reads a bank of 16 sectors in 0.52ms (31 sectors per ms), the whole buffer in 1.8ms (44 sectors per ms).
+   At 10 sectors per ms, the buffer lasts the game 8ms. */
+static const rate_test_t rateTests[] = {
+    {"Game faster than the drive", 8, 100, 20, 0, 0, 1},
+    {"Game slower than the drive", 4, 400, 20, 0, 0, 0},
+    {"Slow reads within the buffer", 4, 400, 20, 10, 3000, 0},
+    {"Slow reads beyond the buffer", 4, 400, 20, 10, 20000, 1}};
+
+static void testRates(void)
+{
+    const rate_test_t *test;
+    u32 lsn, got;
+    int i, j;
+
+    for (i = 0; i < (int)(sizeof(rateTests) / sizeof(rateTests[0])); i++) {
+        test = &rateTests[i];
+        sectorUsec = test->sectorUsec;
+        spikeEvery = test->spikeEvery;
+        spikeUsec = test->spikeUsec;
+
+        sceCdStStart(STREAM_LSN, NULL);
+        waitFull();
+
+        lsn = STREAM_LSN;
+        for (j = 0; j < 100; j++) {
+            got = streamRead(test->sectors, iopBuffer, 1, 0);
+            if (got != test->sectors || checkSectors((u32 *)iopBuffer, lsn, got) != got) {
+                printf("%s: stream damaged at LSN %u\n", test->name, lsn);
+                errors++;
+                break;
+            }
+            lsn += got;
+            DelayThread(test->usec);
+        }
+
+        printf("%-28s %3u underruns, longest read %6.2f ms\n", test->name, cdvdman_stat.StreamingData.StUnderruns,
+               cdvdman_stat.StreamingData.StFillTicksMax / 36864.0);
+        check(test->name, (cdvdman_stat.StreamingData.StUnderruns != 0) == test->underruns);
+        check(test->name, cdvdman_stat.StreamingData.StFillTicksMax >= (u32)(readUsec + test->spikeUsec) * 36864 / 1000);
+    }
+
+    sectorUsec = 0;
+    spikeEvery = 0;
+    spikeUsec = 0;
+}
+
+int main(int argc, char **argv)
+{
+    iop_thread_t thread;
+    iop_sema_t sema;
+
+    // A deadlocked stream must not hang the tests
+    alarm(60);
+    pthread_mutex_lock(&cpu);
+
+    iopBuffer = alloc32(BUFMAX * 4 * 2048);
+    streamBuffer = alloc32(BUFMAX * 2048);
+    gameBuffer = alloc32(GAME_SECTORS * 2048);
+
+    sema.initial = 0;
+    sema.max = 1;
+    driveSema = CreateSema(&sema);
+    thread.thread = &driveThread;
+    StartThread(CreateThread(&thread), NULL);
+    SetEventFlag(cdvdman_stat.intr_ef, 9);
+
+    srand(1);
+    sceCdStInit(BUFMAX, BANKMAX, streamBuffer);
+
+    sceCdStStart(STREAM_LSN, NULL);
+    testSequential("Blocking", STREAM_LSN, BUFMAX * 10 + 3, 1, 0);
+    sceCdStStart(STREAM_LSN, NULL);
+    testSequential("Non-blocking", STREAM_LSN, BUFMAX * 10 + 3, 0, 0);
+    sceCdStStart(STREAM_LSN, NULL);
+    testSequential("Blocking to the EE", STREAM_LSN, BUFMAX * 10 + 3, 1, 1);
+    sceCdStStart(STREAM_LSN, NULL);
+    testSequential("Non-blocking to the EE", STREAM_LSN, BUFMAX * 10 + 3, 0, 1);
+
+    testMergedReads();
+    testGameReads();
+    testLargeRead();
+    testSeek();
+    testPause();
+    testRates();
+
+    sceCdStStop();
+    check("Stop", sceCdStStat() == 0 && !sync_flag);
+    printf("%d stream reads, %d game reads\n", streamReads, gameReads);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
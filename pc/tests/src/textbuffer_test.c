@@ -0,0 +1,457 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Checks the text files of src/textbuffer.c, which are read whole and split into lines in place, against the
+  readFileBuffer() they replaced, which read through a 4KB buffer refilled from the file.
+
+  Both read a corpus of files: LF, CR/LF and CR line endings, comments, blank lines, a UTF-8 BOM, no final line ending,
+  and lines longer than the old buffer. They must return the same lines, except that readFileBuffer() cut the long lines
+  into pieces of the size of its buffer, which must join into the lines of readTextLine(). The lines of
+  openTextBufferBuffer() must also be the same as those of openTextBuffer().
+  Then both parsers are timed, on the corpus and on a large config.
+
+  Usage: textbuffer_test [directory for the files, bin/textbuffer by default]
+*/
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "include/opl.h"
+#include "include/util.h"
+
+#define OLD_BUFFER_SIZE 4096 // Of the configs
+#define MAX_LINES       40000
+#define LARGE_LINES     20000 // Of the large config
+#define SPEED_PASSES    20
+
+static char dir[256];
+static int errors;
+
+static void check(const char *name, int condition)
+{
+    if (!condition) {
+        printf("%s: failed\n", name);
+        errors++;
+    }
+}
+
+// Stand-in for the one of src/util.c: the whole file with one read, followed by a NUL
+void *readFile(char *path, int align, int *size)
+{
+    struct stat st;
+    char *buffer;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return NULL;
+    fstat(fd, &st);
+    buffer = malloc(st.st_size + 1);
+    if (read(fd, buffer, st.st_size) != st.st_size) {
+        close(fd);
+        free(buffer);
+        return NULL;
+    }
+    close(fd);
+
+    buffer[st.st_size] = '\0';
+    *size = st.st_size;
+    return buffer;
+}
+
+/*--    readFileBuffer    ----------------------------------------------------------------------------------------------*/
+
+// As in src/util.c before the text buffer, for reading only
+typedef struct
+{
+    int fd;
+    char *buffer;
+    unsigned int size;
+    unsigned int available;
+    char *lastPtr;
+} old_file_buffer_t;
+
+static old_file_buffer_t *oldOpenFileBuffer(char *fpath, unsigned int size)
+{
+    old_file_buffer_t *fileBuffer = NULL;
+    unsigned char bom[3];
+
+    int fd = open(fpath, O_RDONLY);
+    if (fd >= 0) {
+        fileBuffer = (old_file_buffer_t *)malloc(sizeof(old_file_buffer_t));
+        fileBuffer->size = size;
+        fileBuffer->available = 0;
+        fileBuffer->buffer = (char *)malloc(size * sizeof(char));
+        fileBuffer->lastPtr = NULL;
+
+        // Check for and skip the UTF-8 BOM sequence.
+        if ((read(fd, bom, sizeof(bom)) != 3) ||
+            (bom[0] != 0xEF || bom[1] != 0xBB || bom[2] != 0xBF)) {
+            // Not BOM, so rewind.
+            lseek(fd, 0, SEEK_SET);
+        }
+        fileBuffer->fd = fd;
+    }
+
+    return fileBuffer;
+}
+
+static int oldReadFileBuffer(old_file_buffer_t *fileBuffer, char **outBuf)
+{
+    int lineSize = 0, readSize, length;
+    char *posLF = NULL;
+
+    while (1) {
+        // if lastPtr is set, then we continue the read from this point as reference
+        if (fileBuffer->lastPtr) {
+            // Calculate the remaining chars to the right of lastPtr
+            lineSize = fileBuffer->available - (fileBuffer->lastPtr - fileBuffer->buffer);
+            posLF = strchr(fileBuffer->lastPtr, '\n');
+        }
+
+        if (!posLF) { // We can come here either when the buffer is empty, or if the remaining chars don't have a LF
+
+            // if available, we shift the remaining chars to the left ...
+            if (lineSize) {
+                memmove(fileBuffer->buffer, fileBuffer->lastPtr, lineSize);
+            }
+
+            // ... and complete the buffer if we're not at EOF
+            if (fileBuffer->fd >= 0) {
+
+                // Load as many characters necessary to fill the buffer
+                length = fileBuffer->size - lineSize - 1;
+                readSize = read(fileBuffer->fd, fileBuffer->buffer + lineSize, length);
+                fileBuffer->buffer[lineSize + readSize] = '\0';
+
+                // Search again (from the lastly added chars only), the result will be "analyzed" in next if
+                posLF = strchr(fileBuffer->buffer + lineSize, '\n');
+
+                // Now update read context info
+                lineSize = lineSize + readSize;
+
+                // If buffer not full it means we are at EOF
+                if (fileBuffer->size != lineSize + 1) {
+                    close(fileBuffer->fd);
+                    fileBuffer->fd = -1;
+                }
+            }
+
+            fileBuffer->lastPtr = fileBuffer->buffer;
+            fileBuffer->available = lineSize;
+        }
+
+        if (posLF)
+            lineSize = posLF - fileBuffer->lastPtr;
+
+        // Check the previous char (on Windows there are CR/LF instead of single linux LF)
+        if (lineSize)
+            if (*(fileBuffer->lastPtr + lineSize - 1) == '\r')
+                lineSize--;
+
+        fileBuffer->lastPtr[lineSize] = '\0';
+        *outBuf = fileBuffer->lastPtr;
+
+        // If we are at EOF and no more chars available to scan, then we are finished
+        if (!lineSize && !fileBuffer->available && fileBuffer->fd == -1)
+            return 0;
+
+        if (fileBuffer->lastPtr[0] == '#') { // '#' for comment lines
+            if (posLF)
+                fileBuffer->lastPtr = posLF + 1;
+            else
+                fileBuffer->lastPtr = NULL;
+            continue;
+        }
+
+        // Either move the pointer to next chars, or set it to null to force a whole buffer read (if possible)
+        if (posLF)
+            fileBuffer->lastPtr = posLF + 1;
+        else {
+            fileBuffer->lastPtr = NULL;
+        }
+
+        return 1;
+    }
+}
+
+static void oldCloseFileBuffer(old_file_buffer_t *fileBuffer)
+{
+    if (fileBuffer->fd >= 0)
+        close(fileBuffer->fd);
+    free(fileBuffer->buffer);
+    free(fileBuffer);
+}
+
+/*--    Corpus    ------------------------------------------------------------------------------------------------------*/
+
+typedef struct
+{
+    const char *name;
+    const char *text;
+    int longLine; // Length of the lines of 'x' inserted in place of each '@'
+} corpus_t;
+
+/* Not in the corpus, but checked on readTextLine() only:
+   - A final comment without line ending, for which readFileBuffer() called memmove() with NULL.
+   - A comment longer than the old buffer, of which readFileBuffer() returned the pieces after the first. */
+static const corpus_t corpus[] = {
+    {"LF", "title=Test\nboot=TEST.ELF\nargv1=-v\n", 0},
+    {"CR/LF", "title=Test\r\nboot=TEST.ELF\r\nargv1=-v\r\n", 0},
+    {"CR", "title=Test\rboot=TEST.ELF\rargv1=-v\r", 0},
+    {"Mixed endings", "a=1\r\nb=2\nc=3\rd=4\r\n\r\n", 0},
+    {"Comments", "# Comment\na=1\n#b=2\n  # Not a comment\n#\nc=3\n", 0},
+    {"Blank lines", "\n\na=1\n\n\r\n\nb=2\n\n", 0},
+    {"No final line ending", "a=1\nb=2", 0},
+    {"CR/LF, no final LF", "a=1\r\nb=2\r", 0},
+    {"BOM", "\xEF\xBB\xBF" "a=1\nb=2\n", 0},
+    {"BOM only", "\xEF\xBB\xBF", 0},
+    {"Empty", "", 0},
+    {"Only line endings", "\n\r\n\n", 0},
+    {"Comment, then no final line ending", "#a\nb=2", 0},
+    {"Line as long as the old buffer", "a=1\n@\nb=2\n", OLD_BUFFER_SIZE - 1},
+    {"Longer line", "a=1\n@\nb=2\n", OLD_BUFFER_SIZE + 100},
+    {"Much longer lines", "a=1\n@\r\n@\nb=2\n@", 3 * OLD_BUFFER_SIZE + 7},
+    {"Lines across the old buffer", "@\n@\n@\n@\n@\n@\n", 1500}};
+
+static char *lines[2][MAX_LINES];
+static int lineCount[2];
+
+static void saveLine(int parser, const char *line)
+{
+    if (lineCount[parser] < MAX_LINES)
+        lines[parser][lineCount[parser]] = strdup(line);
+    lineCount[parser]++;
+}
+
+static void freeLines(int parser)
+{
+    int i;
+
+    for (i = 0; i < lineCount[parser] && i < MAX_LINES; i++)
+        free(lines[parser][i]);
+    lineCount[parser] = 0;
+}
+
+static void writeCorpus(FILE *file, const char *text, int longLine)
+{
+    const char *c;
+    int i;
+
+    for (c = text; *c; c++) {
+        if (*c == '@') {
+            for (i = 0; i < longLine; i++)
+                fputc('x', file);
+        } else
+            fputc(*c, file);
+    }
+}
+
+static void writeFile(const char *path, const char *text, int longLine)
+{
+    FILE *file;
+
+    file = fopen(path, "wb");
+    writeCorpus(file, text, longLine);
+    fclose(file);
+}
+
+static int readOld(char *path, int save)
+{
+    old_file_buffer_t *fileBuffer;
+    char *line;
+    int count = 0;
+
+    if ((fileBuffer = oldOpenFileBuffer(path, OLD_BUFFER_SIZE)) == NULL)
+        return -1;
+    while (oldReadFileBuffer(fileBuffer, &line)) {
+        if (save)
+            saveLine(0, line);
+        count++;
+    }
+    oldCloseFileBuffer(fileBuffer);
+
+    return count;
+}
+
+static int readNew(char *path, int save)
+{
+    text_buffer_t text;
+    char *line;
+    int count = 0, length;
+
+    if (!openTextBuffer(&text, path))
+        return -1;
+    while (readTextLine(&text, &line, &length)) {
+        if (save) {
+            if (length != strlen(line))
+                saveLine(1, "Wrong length");
+            else
+                saveLine(1, line);
+        }
+        count++;
+    }
+    closeTextBuffer(&text);
+
+    return count;
+}
+
+// The lines of readFileBuffer(), with the pieces of the long lines joined: a piece fills the buffer but its NUL
+static int joinOldLines(void)
+{
+    int i, j, length, piece;
+    char *joined;
+
+    for (i = 0, j = 0; i < lineCount[0]; i++, j++) {
+        lines[0][j] = lines[0][i];
+        piece = strlen(lines[0][i]);
+        while (piece == OLD_BUFFER_SIZE - 1 && i + 1 < lineCount[0]) {
+            piece = strlen(lines[0][++i]);
+            length = strlen(lines[0][j]);
+            joined = realloc(lines[0][j], length + piece + 1);
+            strcpy(joined + length, lines[0][i]);
+            lines[0][j] = joined;
+            free(lines[0][i]);
+        }
+    }
+    lineCount[0] = j;
+
+    return j;
+}
+
+static void compareLines(const char *name)
+{
+    int i;
+
+    if (lineCount[0] != lineCount[1]) {
+        printf("%s: %d lines instead of %d\n", name, lineCount[1], lineCount[0]);
+        errors++;
+        return;
+    }
+
+    for (i = 0; i < lineCount[0]; i++) {
+        if (strcmp(lines[0][i], lines[1][i]) != 0) {
+            printf("%s: line %d is \"%.40s\" instead of \"%.40s\"\n", name, i, lines[1][i], lines[0][i]);
+            errors++;
+            return;
+        }
+    }
+}
+
+static void testCorpus(void)
+{
+    text_buffer_t text;
+    char path[512], *buffer, *line;
+    int i, size, pieces;
+
+    snprintf(path, sizeof(path), "%s/corpus.txt", dir);
+    for (i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        writeFile(path, corpus[i].text, corpus[i].longLine);
+
+        readOld(path, 1);
+        pieces = lineCount[0];
+        joinOldLines();
+        readNew(path, 1);
+        printf("%-36s %3d lines, %3d of readFileBuffer()\n", corpus[i].name, lineCount[1], pieces);
+        compareLines(corpus[i].name);
+
+        // The same through a buffer, such as the built-in theme config
+        freeLines(0);
+        memcpy(lines[0], lines[1], sizeof(lines[1]));
+        lineCount[0] = lineCount[1];
+        lineCount[1] = 0;
+        size = -1;
+        buffer = readFile(path, 0, &size);
+        openTextBufferBuffer(&text, buffer, size);
+        while (readTextLine(&text, &line, NULL))
+            saveLine(1, line);
+        closeTextBuffer(&text);
+        compareLines(corpus[i].name);
+
+        freeLines(0);
+        freeLines(1);
+    }
+
+    writeFile(path, "a=1\n#b=2", 0);
+    readNew(path, 1);
+    check("Final comment", lineCount[1] == 1 && strcmp(lines[1][0], "a=1") == 0);
+    freeLines(1);
+
+    writeFile(path, "a=1\n#@\nb=2\n", 3 * OLD_BUFFER_SIZE);
+    readNew(path, 1);
+    check("Long comment", lineCount[1] == 2 && strcmp(lines[1][0], "a=1") == 0 && strcmp(lines[1][1], "b=2") == 0);
+    freeLines(1);
+
+    unlink(path);
+}
+
+/*--    Speed    -------------------------------------------------------------------------------------------------------*/
+
+static double elapsed(const struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_usec - start->tv_usec) / 1000.0;
+}
+
+static void timeFile(const char *name, char *path)
+{
+    struct timeval start;
+    double oldTime, newTime;
+    int i;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < SPEED_PASSES; i++)
+        readOld(path, 0);
+    oldTime = elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < SPEED_PASSES; i++)
+        readNew(path, 0);
+    newTime = elapsed(&start);
+
+    printf("%-22s readFileBuffer() %7.2f ms, readTextLine() %7.2f ms\n", name, oldTime / SPEED_PASSES, newTime / SPEED_PASSES);
+}
+
+static void testSpeed(void)
+{
+    char path[512];
+    FILE *file;
+    int i;
+
+    // The corpus many times over
+    snprintf(path, sizeof(path), "%s/corpus.txt", dir);
+    file = fopen(path, "wb");
+    for (i = 0; i < 100 * sizeof(corpus) / sizeof(corpus[0]); i++)
+        writeCorpus(file, corpus[i % (sizeof(corpus) / sizeof(corpus[0]))].text, corpus[i % (sizeof(corpus) / sizeof(corpus[0]))].longLine);
+    fclose(file);
+    timeFile("Corpus", path);
+
+    // A config of many short lines, as the game configs
+    file = fopen(path, "wb");
+    for (i = 0; i < LARGE_LINES; i++)
+        fprintf(file, i % 10 == 0 ? "# Section %d\r\n" : "$Key_%d=Value of the key\r\n", i);
+    fclose(file);
+    timeFile("Large config", path);
+
+    unlink(path);
+}
+
+int main(int argc, char **argv)
+{
+    snprintf(dir, sizeof(dir), "%s", argc > 1 ? argv[1] : "bin/textbuffer");
+    mkdir(dir, 0755);
+
+    testCorpus();
+    testSpeed();
+
+    rmdir(dir);
+
+    if (errors)
+        printf("%d errors\n", errors);
+
+    return errors != 0;
+}
@@ -0,0 +1,132 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Checks the memory card group lookup of src/vmc_groups.c, through the perfect hash generated by pc/vmcgroups.py,
+  against the linear search over the title ID lists it replaces (built with VMC_GROUPS_LINEAR).
+
+  Every string listed in src/vmc_groups.c is looked up, along with variants that are not listed: one character
+  changed, added or removed, lowercase, and random title IDs. Both lookups must return the same group, or the
+  title ID itself.
+
+  Usage: vmc_groups_test [path to vmc_groups.c]
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/vmc_groups.h"
+
+#define DEFAULT_SOURCE "../../src/vmc_groups.c"
+#define MAX_ID         64
+#define RANDOM_IDS     100000
+
+const char *getGroupIdForTitleIdLinear(const char *titleId);
+
+static int lookups, listed;
+static int errors;
+
+static void compare(const char *titleId)
+{
+    const char *expected = getGroupIdForTitleIdLinear(titleId);
+    const char *result = getGroupIdForTitleId(titleId);
+
+    lookups++;
+    if (expected != titleId)
+        listed++;
+
+    if (expected == titleId ? result == titleId : result != titleId && strcmp(result, expected) == 0)
+        return;
+
+    if (errors++ < 10)
+        printf("%s: %s instead of %s\n", titleId, result == titleId ? "not found" : result, expected == titleId ? "not found" : expected);
+}
+
+// The lookup is given the ID in a buffer of its own, as the callers do, not one of the strings of the lists
+static void compareVariants(const char *id)
+{
+    char variant[MAX_ID + 2];
+    int len = strlen(id), i;
+
+    strcpy(variant, id);
+    compare(variant);
+
+    for (i = 0; i < len; i++) {
+        strcpy(variant, id);
+        variant[i] = variant[i] == '9' ? '0' : variant[i] + 1;
+        compare(variant);
+        variant[i] = tolower((unsigned char)id[i]);
+        compare(variant);
+    }
+
+    strcpy(variant, id);
+    strcat(variant, "0");
+    compare(variant);
+
+    if (len > 0) {
+        strcpy(variant, id);
+        variant[len - 1] = '\0';
+        compare(variant);
+    }
+}
+
+static void compareRandom(void)
+{
+    static const char *prefixes[] = {"SLUS", "SLES", "SCUS", "SCES", "SLPS", "SLPM", "SCPS", "SLKA"};
+    char id[MAX_ID];
+    int i;
+
+    srand(1);
+    for (i = 0; i < RANDOM_IDS; i++) {
+        sprintf(id, "%s_%03d.%02d", prefixes[rand() % 8], rand() % 1000, rand() % 100);
+        compare(id);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : DEFAULT_SOURCE;
+    char line[256], id[MAX_ID];
+    char *start, *end;
+    FILE *source;
+    int strings = 0;
+
+    if ((source = fopen(path, "r")) == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    // Every string of the lists, including the group IDs themselves
+    while (fgets(line, sizeof(line), source) != NULL) {
+        for (start = strchr(line, '"'); start != NULL && (end = strchr(start + 1, '"')) != NULL; start = strchr(end + 1, '"')) {
+            if (end - start - 1 < MAX_ID) {
+                memcpy(id, start + 1, end - start - 1);
+                id[end - start - 1] = '\0';
+                compareVariants(id);
+                strings++;
+            }
+        }
+    }
+    fclose(source);
+
+    compareRandom();
+
+    if (getGroupIdForTitleId(NULL) != NULL) {
+        printf("NULL: not NULL\n");
+        errors++;
+    }
+
+    if (strings == 0 || listed == 0) {
+        printf("%s: no title IDs\n", path);
+        errors++;
+    }
+
+    if (errors)
+        printf("%d errors\n", errors);
+    else
+        printf("vmc_groups: %d lookups (%d strings listed, %d found in a group) identical to the linear search\n", lookups, strings, listed);
+
+    return errors != 0;
+}
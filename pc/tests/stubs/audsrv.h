@@ -0,0 +1,41 @@
+/*
+  Stand-in for the audsrv client API of the PS2SDK, for building the OPL sources on the PC.
+  The tests that play sounds provide these functions.
+*/
+
+#ifndef __AUDSRV_H__
+#define __AUDSRV_H__
+
+#include "tamtypes.h"
+
+typedef struct audsrv_fmt_t
+{
+    int freq;
+    int bits;
+    int channels;
+} audsrv_fmt_t;
+
+typedef struct audsrv_adpcm_t
+{
+    int pitch;
+    int loop;
+    int channel;
+    void *buffer;
+    int size;
+} audsrv_adpcm_t;
+
+int audsrv_init(void);
+int audsrv_quit(void);
+const char *audsrv_get_error_string(void);
+int audsrv_set_format(struct audsrv_fmt_t *fmt);
+int audsrv_set_volume(int volume);
+int audsrv_wait_audio(int bytes);
+int audsrv_play_audio(const char *chunk, int bytes);
+int audsrv_stop_audio(void);
+
+int audsrv_adpcm_init(void);
+int audsrv_adpcm_set_volume(int ch, int volume);
+int audsrv_load_adpcm(audsrv_adpcm_t *adpcm, void *buffer, int size);
+int audsrv_ch_play_adpcm(int ch, audsrv_adpcm_t *adpcm);
+
+#endif
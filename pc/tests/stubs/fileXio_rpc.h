@@ -0,0 +1,10 @@
+/*
+  Stand-in for the fileXio_rpc.h of the PS2SDK, for building the OPL sources on the PC: only iox_stat_t is used.
+*/
+
+#ifndef __FILEXIO_RPC_H__
+#define __FILEXIO_RPC_H__
+
+#include "iop/iox_stat.h"
+
+#endif
@@ -0,0 +1,22 @@
+/*
+  Stand-in for ee_core/include/cheat_api.h: the cheat engine of the EE core, without the rest of the EE core.
+
+  The cheat program runs against an image of the EE RAM, allocated by the test, instead of the RAM itself.
+*/
+
+#ifndef _CHEATAPI_H_
+#define _CHEATAPI_H_
+
+#include "tamtypes.h"
+#include "ee_core/include/cheat_engine.h"
+#include "ee_core/include/cheat_prog.h"
+
+#define CHEAT_RAM_SIZE 0x2000000
+
+extern u8 *cheatRam;
+
+#define CHEAT_MEM8(addr)  (*(u8 *)&cheatRam[(addr) & (CHEAT_RAM_SIZE - 1)])
+#define CHEAT_MEM16(addr) (*(u16 *)&cheatRam[(addr) & (CHEAT_RAM_SIZE - 2)])
+#define CHEAT_MEM32(addr) (*(u32 *)&cheatRam[(addr) & (CHEAT_RAM_SIZE - 4)])
+
+#endif
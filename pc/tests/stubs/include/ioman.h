@@ -0,0 +1,8 @@
+/*
+  Stand-in for include/ioman.h: the OPL sources built by the host tests do their I/O on the calling thread.
+*/
+
+#ifndef __IOMAN_H
+#define __IOMAN_H
+
+#endif
@@ -0,0 +1,80 @@
+/*
+  Stand-in for include/opl.h: the parts of the PS2SDK and gsKit used by the OPL sources built by the host tests.
+*/
+
+#ifndef __OPL_H
+#define __OPL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <malloc.h>
+#include <dirent.h>
+#include "tamtypes.h"
+#include "kernel.h"
+#include "include/config.h"
+
+#define GS_PSM_CT32  0x00
+#define GS_PSM_CT24  0x01
+#define GS_PSM_CT16  0x02
+#define GS_PSM_CT16S 0x0A
+#define GS_PSM_T8    0x13
+#define GS_PSM_T4    0x14
+
+#define GS_FILTER_NEAREST      0x00
+#define GS_CLUT_STORAGE_CSM1   0x00
+
+typedef struct
+{
+    u32 Width, Height;
+    u8 PSM, ClutPSM;
+    u8 TBW, ClutStorageMode;
+    u32 *Mem;
+    u32 *Clut;
+    u32 Vram;
+    u32 VramClut;
+    u32 Filter;
+} GSTEXTURE;
+
+static inline u32 gsKit_texture_size(int width, int height, int psm)
+{
+    switch (psm) {
+        case GS_PSM_T8:
+            return width * height;
+        case GS_PSM_T4:
+            return width * height / 2;
+        case GS_PSM_CT16:
+        case GS_PSM_CT16S:
+            return width * height * 2;
+        default:
+            return width * height * 4;
+    }
+}
+
+#define OPL_COMPAT_UPDATE_STAT_WIP        0
+#define OPL_COMPAT_UPDATE_STAT_DONE       1
+#define OPL_COMPAT_UPDATE_STAT_ERROR      -1
+#define OPL_COMPAT_UPDATE_STAT_CONN_ERROR -2
+#define OPL_COMPAT_UPDATE_STAT_ABORTED    -3
+
+// Settings, defined by the tests that use them
+extern int gEnableSFX;
+extern int gEnableBGM;
+extern int gSFXVolume;
+extern int gBootSndVolume;
+extern int gBGMVolume;
+extern char gDefaultBGMPath[128];
+extern int gBGMCache;
+extern int gCheatSource;
+
+#ifdef DEBUG
+#define LOG(...) printf(__VA_ARGS__)
+#else
+#define LOG(...)
+#endif
+
+#endif
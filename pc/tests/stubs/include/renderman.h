@@ -0,0 +1,12 @@
+/*
+  Stand-in for include/renderman.h: nothing is uploaded to the GS on the PC.
+*/
+
+#ifndef __RENDERMAN_H
+#define __RENDERMAN_H
+
+static inline void rmInvalidateTexture(GSTEXTURE *txt) {}
+static inline void rmUnloadTexture(GSTEXTURE *txt) {}
+static inline void rmWaitGS(void) {}
+
+#endif
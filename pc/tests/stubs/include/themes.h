@@ -0,0 +1,11 @@
+/*
+  Stand-in for include/themes.h: what the OPL sources built by the host tests use of the themes.
+*/
+
+#ifndef __THEMES_H
+#define __THEMES_H
+
+int thmGetGuiValue(void);
+char *thmGetFilePath(int themeID);
+
+#endif
@@ -0,0 +1,34 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  The tests provide the functions that the modules they build call.
+*/
+
+#ifndef __CDVDMAN_H__
+#define __CDVDMAN_H__
+
+#include "types.h"
+
+#define SCECdErNO 0x00
+
+#define SCECdStatPause 0x01
+
+typedef struct
+{
+    u8 trycount;
+    u8 spindlctrl;
+    u8 datapattern;
+    u8 pad;
+} sceCdRMode;
+
+int sceCdSync(int mode);
+int sceCdGetError(void);
+int sceCdStInit(u32 bufmax, u32 bankmax, void *buffer);
+int sceCdStStart(u32 lsn, sceCdRMode *mode);
+int sceCdStStat(void);
+int sceCdStStop(void);
+int sceCdStPause(void);
+int sceCdStResume(void);
+int sceCdStSeek(u32 lsn);
+int sceCdStRead(u32 sectors, u32 *buffer, u32 mode, u32 *error);
+
+#endif
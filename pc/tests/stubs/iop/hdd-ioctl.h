@@ -0,0 +1,11 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  Nothing of it is used by the modules the tests build.
+*/
+
+#ifndef __HDD_IOCTL_H__
+#define __HDD_IOCTL_H__
+
+#include "types.h"
+
+#endif
@@ -0,0 +1,22 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  The tests run the interrupt handlers themselves, so interrupts are never pending.
+*/
+
+#ifndef __INTRMAN_H__
+#define __INTRMAN_H__
+
+#include "types.h"
+
+static inline int CpuSuspendIntr(int *state)
+{
+    *state = 0;
+    return 0;
+}
+
+static inline int CpuResumeIntr(int state)
+{
+    return 0;
+}
+
+#endif
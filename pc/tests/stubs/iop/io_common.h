@@ -0,0 +1,28 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __IO_COMMON_H__
+#define __IO_COMMON_H__
+
+#include "types.h"
+
+typedef struct
+{
+    unsigned int mode;
+    unsigned int attr;
+    unsigned int size;
+    unsigned char ctime[8];
+    unsigned char atime[8];
+    unsigned char mtime[8];
+    unsigned int hisize;
+} io_stat_t;
+
+typedef struct
+{
+    io_stat_t stat;
+    char name[256];
+    void *unknown;
+} io_dirent_t;
+
+#endif
@@ -0,0 +1,27 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __IOMAN_H__
+#define __IOMAN_H__
+
+#include "types.h"
+
+typedef struct _iop_file
+{
+    int mode;
+    int unit;
+    struct _iop_device *device;
+    void *privdata;
+} iop_file_t;
+
+typedef struct _iop_device
+{
+    const char *name;
+    unsigned int type;
+    unsigned int version;
+    const char *desc;
+    void *ops;
+} iop_device_t;
+
+#endif
@@ -0,0 +1,34 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __IOX_STAT_H__
+#define __IOX_STAT_H__
+
+#include "types.h"
+
+typedef struct
+{
+    unsigned int mode;
+    unsigned int attr;
+    unsigned int size;
+    unsigned char ctime[8];
+    unsigned char atime[8];
+    unsigned char mtime[8];
+    unsigned int hisize;
+    unsigned int private_0;
+    unsigned int private_1;
+    unsigned int private_2;
+    unsigned int private_3;
+    unsigned int private_4;
+    unsigned int private_5;
+} iox_stat_t;
+
+typedef struct
+{
+    iox_stat_t stat;
+    char name[256];
+    void *unknown;
+} iox_dirent_t;
+
+#endif
@@ -0,0 +1,19 @@
+/*
+  Stand-in for the ps2ip.h of the IOP TCP/IP stack, for building IOP modules on the PC.
+  The sockets of the PC are used instead, with the names of the stack.
+*/
+
+#ifndef __PS2IP_H__
+#define __PS2IP_H__
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define disconnect  close
+#define closesocket close
+
+#endif
@@ -0,0 +1,22 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  The tests provide the DMA functions.
+*/
+
+#ifndef __SIFMAN_H__
+#define __SIFMAN_H__
+
+#include "types.h"
+
+typedef struct
+{
+    void *src;
+    void *dest;
+    int size;
+    int attr;
+} SifDmaTransfer_t;
+
+int sceSifSetDma(SifDmaTransfer_t *dmat, int count);
+int sceSifDmaStat(int trid);
+
+#endif
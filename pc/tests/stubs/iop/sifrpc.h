@@ -0,0 +1,10 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __SIFRPC_H__
+#define __SIFRPC_H__
+
+#include "types.h"
+
+#endif
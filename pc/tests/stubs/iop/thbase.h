@@ -0,0 +1,37 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  The tests provide GetSystemTime() and DelayThread(), so that they control the clock, and the threads of the modules
+  that create them.
+*/
+
+#ifndef __THBASE_H__
+#define __THBASE_H__
+
+#include "types.h"
+
+int DelayThread(int usec);
+
+typedef struct
+{
+    u32 lo;
+    u32 hi;
+} iop_sys_clock_t;
+
+void GetSystemTime(iop_sys_clock_t *sys_clock);
+
+#define TH_C 0x02000000
+
+typedef struct _iop_thread
+{
+    u32 attr;
+    u32 option;
+    void *thread;
+    u32 stacksize;
+    u32 priority;
+} iop_thread_t;
+
+int CreateThread(iop_thread_t *thread);
+int StartThread(int thid, void *arg);
+int ExitDeleteThread(void);
+
+#endif
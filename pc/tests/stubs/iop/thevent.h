@@ -0,0 +1,18 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  The tests that run threads provide the event flags.
+*/
+
+#ifndef __THEVENT_H__
+#define __THEVENT_H__
+
+#include "types.h"
+
+#define WEF_AND 0
+#define WEF_OR  1
+
+int SetEventFlag(int ef, u32 bits);
+int ClearEventFlag(int ef, u32 bits);
+int WaitEventFlag(int ef, u32 bits, int mode, u32 *resbits);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  Most tests run single threaded: the semaphores are never waited on.
+  The tests that run the threads of the modules define IOP_THREADS and provide the semaphores.
+*/
+
+#ifndef __THSEMAP_H__
+#define __THSEMAP_H__
+
+#include "types.h"
+
+#define IOP_MUTEX_UNLOCKED 1
+
+#ifdef IOP_THREADS
+typedef struct
+{
+    u32 attr;
+    u32 option;
+    int initial;
+    int max;
+} iop_sema_t;
+
+int CreateSema(iop_sema_t *sema);
+int WaitSema(int sema);
+int SignalSema(int sema);
+#else
+static inline int CreateMutex(int state)
+{
+    return 1;
+}
+
+static inline int WaitSema(int sema)
+{
+    return 0;
+}
+
+static inline int PollSema(int sema)
+{
+    return 0;
+}
+
+static inline int SignalSema(int sema)
+{
+    return 0;
+}
+#endif
+
+#endif
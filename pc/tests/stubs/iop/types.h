@@ -0,0 +1,10 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+#include "tamtypes.h"
+
+#endif
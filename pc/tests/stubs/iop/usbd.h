@@ -0,0 +1,101 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+  Only what the pad drivers use. The test provides the USBD functions, so that it controls the devices and
+  when the transfers complete.
+*/
+
+#ifndef __USBD_H__
+#define __USBD_H__
+
+#include "types.h"
+
+#define USB_RC_OK 0x000
+
+#define USB_DT_DEVICE   0x01
+#define USB_DT_CONFIG   0x02
+#define USB_DT_ENDPOINT 0x05
+
+#define USB_ENDPOINT_XFER_INT 3
+#define USB_ENDPOINT_DIR_MASK 0x80
+
+#define USB_DIR_OUT 0x00
+#define USB_DIR_IN  0x80
+
+#define USB_TYPE_CLASS      0x20
+#define USB_RECIP_INTERFACE 0x01
+
+#define USB_REQ_SET_REPORT 0x09
+
+typedef struct
+{
+    u8 bLength;
+    u8 bDescriptorType;
+    u16 bcdUSB;
+    u8 bDeviceClass;
+    u8 bDeviceSubClass;
+    u8 bDeviceProtocol;
+    u8 bMaxPacketSize0;
+    u16 idVendor;
+    u16 idProduct;
+    u16 bcdDevice;
+    u8 iManufacturer;
+    u8 iProduct;
+    u8 iSerialNumber;
+    u8 bNumConfigurations;
+} __attribute__((packed)) UsbDeviceDescriptor;
+
+typedef struct
+{
+    u8 bLength;
+    u8 bDescriptorType;
+    u8 wTotalLengthLB;
+    u8 wTotalLengthHB;
+    u8 bNumInterfaces;
+    u8 bConfigurationValue;
+    u8 iConfiguration;
+    u8 bmAttributes;
+    u8 maxPower;
+} UsbConfigDescriptor;
+
+typedef struct
+{
+    u8 bLength;
+    u8 bDescriptorType;
+    u8 bInterfaceNumber;
+    u8 bAlternateSetting;
+    u8 bNumEndpoints;
+    u8 bInterfaceClass;
+    u8 bInterfaceSubClass;
+    u8 bInterfaceProtocol;
+    u8 iInterface;
+} UsbInterfaceDescriptor;
+
+typedef struct
+{
+    u8 bLength;
+    u8 bDescriptorType;
+    u8 bEndpointAddress;
+    u8 bmAttributes;
+    u8 wMaxPacketSizeLB;
+    u8 wMaxPacketSizeHB;
+    u8 bInterval;
+} UsbEndpointDescriptor;
+
+typedef void (*sceUsbdDoneCallback)(int result, int count, void *arg);
+
+typedef struct _UsbDriver
+{
+    struct _UsbDriver *next, *prev;
+    char *name;
+    int (*probe)(int devId);
+    int (*connect)(int devId);
+    int (*disconnect)(int devId);
+} UsbDriver;
+
+int UsbRegisterDriver(UsbDriver *driver);
+void *UsbGetDeviceStaticDescriptor(int devId, void *data, u8 type);
+int UsbOpenEndpoint(int devId, UsbEndpointDescriptor *desc);
+int UsbOpenEndpointAligned(int devId, UsbEndpointDescriptor *desc);
+int UsbCloseEndpoint(int id);
+
+#endif
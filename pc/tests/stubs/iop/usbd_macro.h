@@ -0,0 +1,14 @@
+/*
+  Stand-in for the IOP headers of the PS2SDK, for building IOP modules on the PC.
+*/
+
+#ifndef __USBD_MACRO_H__
+#define __USBD_MACRO_H__
+
+#include "usbd.h"
+
+int UsbControlTransfer(int epID, int reqtyp, int req, int val, int index, int leng, void *dataptr, void *doneCB, void *arg);
+int UsbInterruptTransfer(int epID, void *dataptr, int len, void *doneCB, void *arg);
+int UsbSetDeviceConfiguration(int epID, int configuration, void *doneCB, void *arg);
+
+#endif
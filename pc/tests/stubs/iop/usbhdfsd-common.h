@@ -0,0 +1,16 @@
+/*
+  Stand-in for usbhdfsd-common.h of the PS2SDK: the fragment table of the BDM settings.
+*/
+
+#ifndef _USBHDFSD_COMMON_H
+#define _USBHDFSD_COMMON_H
+
+#include "types.h"
+
+typedef struct
+{
+    u64 sector;
+    u32 count;
+} __attribute__((packed)) bd_fragment_t;
+
+#endif
@@ -0,0 +1,50 @@
+/*
+  Stand-in for the EE kernel API of the PS2SDK, for building the OPL sources on the PC.
+  The tests that use threads, semaphores or alarms provide these functions.
+*/
+
+#ifndef __KERNEL_H__
+#define __KERNEL_H__
+
+#include "tamtypes.h"
+
+typedef struct
+{
+    int status;
+    void *func;
+    void *stack;
+    int stack_size;
+    void *gp_reg;
+    int initial_priority;
+    int current_priority;
+    u32 attr;
+    u32 option;
+} ee_thread_t;
+
+typedef struct
+{
+    int count;
+    int max_count;
+    int init_count;
+    int wait_threads;
+    u32 attr;
+    u32 option;
+} ee_sema_t;
+
+s32 CreateThread(ee_thread_t *thread);
+s32 DeleteThread(s32 thread_id);
+s32 StartThread(s32 thread_id, void *args);
+s32 GetThreadId(void);
+s32 SleepThread(void);
+s32 WakeupThread(s32 thread_id);
+s32 iWakeupThread(s32 thread_id);
+
+s32 CreateSema(ee_sema_t *sema);
+s32 DeleteSema(s32 sema_id);
+s32 SignalSema(s32 sema_id);
+s32 WaitSema(s32 sema_id);
+s32 PollSema(s32 sema_id);
+
+s32 SetAlarm(u16 time, void (*callback)(s32 alarm_id, u16 time, void *common), void *common);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+  Stand-in for the libcdvd.h of the PS2SDK, for building the OPL sources on the PC.
+*/
+
+#ifndef __LIBCDVD_H__
+#define __LIBCDVD_H__
+
+#include "tamtypes.h"
+
+typedef struct
+{
+    u8 stat;
+    u8 second;
+    u8 minute;
+    u8 hour;
+    u8 pad;
+    u8 day;
+    u8 month;
+    u8 year;
+} sceCdCLOCK;
+
+// BCD conversions of the clock fields
+#define btoi(b) ((b) / 16 * 10 + (b) % 16)
+#define itob(i) ((i) / 10 * 16 + (i) % 10)
+
+#endif
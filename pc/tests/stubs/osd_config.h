@@ -0,0 +1,13 @@
+/*
+  Stand-in for the osd_config.h of the PS2SDK, for building the OPL sources on the PC.
+  The tests that use it provide configConvertToGmtTime().
+*/
+
+#ifndef __OSD_CONFIG_H__
+#define __OSD_CONFIG_H__
+
+#include "libcdvd.h"
+
+void configConvertToGmtTime(sceCdCLOCK *time);
+
+#endif
@@ -0,0 +1,114 @@
+/*
+  Stand-in for libvorbisfile, used when it is not installed on the PC.
+
+  It "decodes" a raw stream instead of Vorbis: a bgm_standin_header_t, then the 16-bit PCM. Like ov_read() of
+  libvorbisfile, it returns the PCM in chunks of irregular sizes, of whole frames and never more than a packet.
+*/
+
+#ifndef _OV_FILE_H_
+#define _OV_FILE_H_
+
+#include <stdio.h>
+#include <string.h>
+#include "tamtypes.h"
+
+#define OV_STANDIN_MAGIC  "PCMSTUB"
+#define OV_STANDIN_PACKET 4096
+
+#define OV_EREAD      -128
+#define OV_ENOTVORBIS -132
+
+typedef struct
+{
+    char magic[8];
+    u32 channels;
+    u32 rate;
+} bgm_standin_header_t;
+
+typedef struct
+{
+    int channels;
+    long rate;
+} vorbis_info;
+
+typedef struct
+{
+    size_t (*read_func)(void *ptr, size_t size, size_t nmemb, void *datasource);
+    int (*seek_func)(void *datasource, s64 offset, int whence);
+    int (*close_func)(void *datasource);
+    long (*tell_func)(void *datasource);
+} ov_callbacks;
+
+typedef struct
+{
+    void *datasource;
+    ov_callbacks callbacks;
+    vorbis_info vi;
+    u32 packetSeed; // Draws the chunk sizes
+} OggVorbis_File;
+
+static int _ov_standin_seek(void *datasource, s64 offset, int whence)
+{
+    return fseek((FILE *)datasource, (long)offset, whence);
+}
+
+static int _ov_standin_close(void *datasource)
+{
+    return fclose((FILE *)datasource);
+}
+
+static ov_callbacks OV_CALLBACKS_DEFAULT = {(size_t(*)(void *, size_t, size_t, void *))fread, _ov_standin_seek, _ov_standin_close, (long (*)(void *))ftell};
+
+static inline int ov_open_callbacks(void *datasource, OggVorbis_File *vf, const char *initial, long ibytes, ov_callbacks callbacks)
+{
+    bgm_standin_header_t header;
+
+    memset(vf, 0, sizeof(*vf));
+    if (callbacks.read_func(&header, 1, sizeof(header), datasource) != sizeof(header) || memcmp(header.magic, OV_STANDIN_MAGIC, sizeof(header.magic)))
+        return OV_ENOTVORBIS;
+
+    vf->datasource = datasource;
+    vf->callbacks = callbacks;
+    vf->vi.channels = header.channels;
+    vf->vi.rate = header.rate;
+    vf->packetSeed = 1;
+
+    return 0;
+}
+
+static inline vorbis_info *ov_info(OggVorbis_File *vf, int link)
+{
+    return &vf->vi;
+}
+
+static inline int ov_pcm_seek(OggVorbis_File *vf, s64 pos)
+{
+    s64 offset = sizeof(bgm_standin_header_t) + pos * 2 * vf->vi.channels;
+
+    return vf->callbacks.seek_func(vf->datasource, offset, SEEK_SET) ? OV_EREAD : 0;
+}
+
+static inline long ov_read(OggVorbis_File *vf, char *buffer, int length, int bigendianp, int word, int sgned, int *bitstream)
+{
+    int frame = 2 * vf->vi.channels;
+    int chunk;
+
+    vf->packetSeed = vf->packetSeed * 1103515245 + 12345;
+    chunk = ((vf->packetSeed >> 16) % (OV_STANDIN_PACKET / frame) + 1) * frame;
+    if (chunk > length)
+        chunk = length;
+
+    *bitstream = 0;
+    return (long)vf->callbacks.read_func(buffer, 1, chunk, vf->datasource);
+}
+
+static inline int ov_clear(OggVorbis_File *vf)
+{
+    if (vf->datasource != NULL)
+        vf->callbacks.close_func(vf->datasource);
+    vf->datasource = NULL;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+
+# Generates the memory card group lookup table used by src/vmc_groups.c.
+#
+# The title ID lists in src/vmc_groups.c remain the source of truth. This script parses them and builds
+# a minimal perfect hash (hash and displace) over all title IDs, which maps a title ID straight to its group:
+#   bucket = hash(0, titleId) % buckets
+#   slot   = hash(seeds[bucket], titleId) % titles
+# where hash() is 32-bit FNV-1a with the seed XORed into the offset basis, and the upper half folded into the lower half.
+# Title IDs are stored as fixed 12-byte records, so that the lookup can verify the match.
+#
+# Just like the linear search it replaces, a title ID listed in several groups resolves to the first group.
+# Before writing the output, every title ID is checked against a linear search over the parsed lists.
+#
+# Only the Python standard library is required.
+
+import re
+import sys
+
+TITLE_ID_LEN = 12
+TITLES_PER_BUCKET = 4
+MAX_SEED = 0xFFFF
+
+FNV_OFFSET_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+LIST_RE = re.compile(r'static const char \*(\w+)\[\]\s*=\s*\{(.*?)\};', re.S)
+GROUP_RE = re.compile(r'\{\s*"([^"]+)"\s*,\s*(\w+)\s*,\s*\w+\s*\}')
+TABLE_RE = re.compile(r'allMemoryCardGroups\[\]\s*=\s*\{(.*?)\};', re.S)
+STRING_RE = re.compile(r'"([^"]*)"')
+
+
+def fnv1a(seed, key):
+    h = FNV_OFFSET_BASIS ^ seed
+    for c in key:
+        h ^= c
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    # The low bits of FNV-1a only depend on the low bits of the input, fold in the upper half.
+    return h ^ (h >> 16)
+
+
+def parse_groups(path):
+    with open(path, 'r') as f:
+        source = f.read()
+
+    lists = {}
+    for name, body in LIST_RE.findall(source):
+        lists[name] = STRING_RE.findall(body)
+
+    table = TABLE_RE.search(source)
+    if table is None:
+        raise ValueError("allMemoryCardGroups not found")
+
+    groups = []
+    for group_id, list_name in GROUP_RE.findall(table.group(1)):
+        if list_name not in lists:
+            raise ValueError("unknown title list %s" % list_name)
+        groups.append((group_id, lists[list_name]))
+    return groups
+
+
+def linear_lookup(groups, title_id):
+    for group_id, titles in groups:
+        if title_id in titles:
+            return group_id
+    return title_id
+
+
+def build_hash(keys):
+    count = len(keys)
+    num_buckets = (count + TITLES_PER_BUCKET - 1) // TITLES_PER_BUCKET
+    buckets = [[] for _ in range(num_buckets)]
+    for key in keys:
+        buckets[fnv1a(0, key) % num_buckets].append(key)
+
+    seeds = [0] * num_buckets
+    slots = [None] * count
+    # Place the largest buckets first, while most slots are still free.
+    for b in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        bucket = buckets[b]
+        if not bucket:
+            continue
+        for seed in range(MAX_SEED + 1):
+            positions = [fnv1a(seed, key) % count for key in bucket]
+            if len(set(positions)) == len(positions) and all(slots[p] is None for p in positions):
+                break
+        else:
+            raise ValueError("no seed found for bucket %d" % b)
+        seeds[b] = seed
+        for key, p in zip(bucket, positions):
+            slots[p] = key
+    return seeds, slots
+
+
+def hash_lookup(seeds, slots, title_id):
+    key = title_id.encode('ascii')
+    slot = fnv1a(seeds[fnv1a(0, key) % len(seeds)], key) % len(slots)
+    return slot if slots[slot] == key else None
+
+
+def write_header(path, group_ids, seeds, slots, slot_groups):
+    with open(path, 'w') as f:
+        f.write("#ifndef VMC_GROUPS_HASH_H\n#define VMC_GROUPS_HASH_H\n\n")
+        f.write("// THIS FILE WAS AUTO-GENERATED by pc/vmcgroups.py from src/vmc_groups.c.\n\n")
+        f.write("#define VMC_TITLE_ID_LEN %d\n" % TITLE_ID_LEN)
+        f.write("#define VMC_TITLE_COUNT %d\n" % len(slots))
+        f.write("#define VMC_HASH_BUCKETS %d\n\n" % len(seeds))
+
+        f.write("static const char *vmcGroupIds[%d] = {\n" % len(group_ids))
+        for group_id in group_ids:
+            f.write('    "%s",\n' % group_id)
+        f.write("};\n\n")
+
+        f.write("static const unsigned short int vmcHashSeeds[VMC_HASH_BUCKETS] = {\n")
+        for i in range(0, len(seeds), 12):
+            f.write("    %s,\n" % ", ".join("%d" % s for s in seeds[i:i + 12]))
+        f.write("};\n\n")
+
+        f.write("static const char vmcTitleIds[VMC_TITLE_COUNT][VMC_TITLE_ID_LEN] = {\n")
+        for key in slots:
+            f.write('    "%s",\n' % key.decode('ascii'))
+        f.write("};\n\n")
+
+        f.write("static const unsigned char vmcTitleGroups[VMC_TITLE_COUNT] = {\n")
+        for i in range(0, len(slot_groups), 16):
+            f.write("    %s,\n" % ", ".join("%d" % g for g in slot_groups[i:i + 16]))
+        f.write("};\n\n")
+
+        f.write("#endif // VMC_GROUPS_HASH_H\n")
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("vmcgroups - generates the memory card group lookup table for OPL")
+        print("Usage: vmcgroups src/vmc_groups.c include/vmc_groups_hash.h")
+        sys.exit(-1)
+
+    groups = parse_groups(sys.argv[1])
+    group_ids = [group_id for group_id, _ in groups]
+    if len(group_ids) > 256:
+        sys.exit("Too many groups: %d" % len(group_ids))
+
+    # The first group listing a title ID wins, as with the linear search.
+    title_groups = {}
+    for index, (_, titles) in enumerate(groups):
+        for title_id in titles:
+            if len(title_id) > TITLE_ID_LEN:
+                sys.exit("Title ID too long: %s" % title_id)
+            title_groups.setdefault(title_id.encode('ascii'), index)
+
+    seeds, slots = build_hash(sorted(title_groups))
+    slot_groups = [title_groups[key] for key in slots]
+
+    for _, titles in groups:
+        for title_id in titles:
+            slot = hash_lookup(seeds, slots, title_id)
+            if slot is None or group_ids[slot_groups[slot]] != linear_lookup(groups, title_id):
+                sys.exit("Lookup mismatch for %s" % title_id)
+
+    write_header(sys.argv[2], group_ids, seeds, slots, slot_groups)
+    print("%s: %d titles in %d groups, %d buckets" % (sys.argv[2], len(slots), len(group_ids), len(seeds)))
+
+
+if __name__ == "__main__":
+    main()
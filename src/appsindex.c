@@ -0,0 +1,224 @@
+#include "include/opl.h"
+#include "include/appsupport.h"
+#include "include/appsindex.h"
+#include <sys/stat.h>
+
+#define APP_INDEX_MAGIC   0x414c504f // "OPLA"
+#define APP_INDEX_VERSION 1          // Changed with app_index_entry_t
+
+typedef struct
+{
+    u32 magic;
+    u32 version;
+} app_index_header_t;
+
+struct app_index
+{
+    int count;
+    app_index_entry_t *entries;
+};
+
+static void loadAppsIndex(const char *path, struct app_index *index)
+{
+    app_index_header_t header;
+    FILE *file;
+    int size;
+
+    index->count = 0;
+    index->entries = NULL;
+
+    file = fopen(path, "rb");
+    if (file != NULL) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        rewind(file);
+
+        // Files of another version, or that are not an index, are ignored and written again
+        if (fread(&header, 1, sizeof(header), file) == sizeof(header) && header.magic == APP_INDEX_MAGIC && header.version == APP_INDEX_VERSION)
+            size -= sizeof(header);
+        else
+            size = 0;
+
+        if (size > 0 && size % sizeof(app_index_entry_t) == 0) {
+            index->entries = malloc(size);
+            if (index->entries != NULL) {
+                if (fread(index->entries, 1, size, file) == size) {
+                    index->count = size / sizeof(app_index_entry_t);
+                    LOG("APPS index %s: %d entries loaded.\n", path, index->count);
+                } else {
+                    LOG("APPS index %s: I/O error.\n", path);
+                    free(index->entries);
+                    index->entries = NULL;
+                }
+            }
+        }
+
+        fclose(file);
+    }
+}
+
+static void saveAppsIndex(const char *path, const app_index_entry_t *entries, int count)
+{
+    app_index_header_t header;
+    FILE *file;
+
+    if (count == 0) {
+        remove(path);
+        return;
+    }
+
+    LOG("APPS index %s: caching %d entries.\n", path, count);
+    file = fopen(path, "wb");
+    if (file != NULL) {
+        header.magic = APP_INDEX_MAGIC;
+        header.version = APP_INDEX_VERSION;
+
+        if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(entries, sizeof(app_index_entry_t), count, file) != count) {
+            fclose(file);
+            remove(path);
+            return;
+        }
+
+        fclose(file);
+    }
+}
+
+// Folders are usually listed in the same order every time, so try the entry at the same position first.
+static const app_index_entry_t *queryAppsIndex(const struct app_index *index, int hint, const char *folder)
+{
+    int i;
+
+    if (hint < index->count && strcmp(index->entries[hint].folder, folder) == 0)
+        return &index->entries[hint];
+
+    for (i = 0; i < index->count; i++) {
+        if (strcmp(index->entries[i].folder, folder) == 0)
+            return &index->entries[i];
+    }
+
+    return NULL;
+}
+
+static void parseAppConfig(const char *path, app_index_entry_t *entry)
+{
+    config_set_t *appConfig;
+    const char *title, *boot, *argv1;
+
+    entry->title[0] = '\0';
+    entry->boot[0] = '\0';
+    entry->argv1[0] = '\0';
+
+    appConfig = configAlloc(0, NULL, (char *)path);
+    if (appConfig != NULL) {
+        configRead(appConfig);
+
+        if (configGetStr(appConfig, APP_CONFIG_TITLE, &title) != 0 && configGetStr(appConfig, APP_CONFIG_BOOT, &boot) != 0) {
+            strncpy(entry->title, title, APP_TITLE_MAX);
+            entry->title[APP_TITLE_MAX] = '\0';
+            strncpy(entry->boot, boot, APP_BOOT_MAX);
+            entry->boot[APP_BOOT_MAX] = '\0';
+            if (configGetStr(appConfig, APP_CONFIG_ARGV1, &argv1) != 0) {
+                strncpy(entry->argv1, argv1, APP_ARGV1_MAX);
+                entry->argv1[APP_ARGV1_MAX] = '\0';
+            }
+        }
+
+        configFree(appConfig);
+    }
+}
+
+int appsIndexScan(int (*callback)(const char *path, const char *title, const char *boot, const char *argv1, void *arg), void *arg, char *appsPath, const char *indexPath, int exception)
+{
+    struct dirent *pdirent;
+    DIR *pdir;
+    int count, ret, listed, capacity, modified, complete;
+    struct app_index index;
+    const app_index_entry_t *cached;
+    app_index_entry_t *entries, *entry, *newEntries, uncached;
+    struct stat st;
+    char dir[128];
+    char path[128];
+
+    count = 0;
+    listed = 0;
+    capacity = 0;
+    modified = 0;
+    complete = 1;
+    entries = NULL;
+    if ((pdir = opendir(appsPath)) != NULL) {
+        loadAppsIndex(indexPath, &index);
+
+        while ((pdirent = readdir(pdir)) != NULL) {
+            if (exception && strchr(pdirent->d_name, '_') == NULL)
+                continue;
+
+            if (strcmp(pdirent->d_name, ".") == 0 || strcmp(pdirent->d_name, "..") == 0)
+                continue;
+
+            snprintf(dir, sizeof(dir), "%s/%s", appsPath, pdirent->d_name);
+            if (pdirent->d_type != DT_DIR)
+                continue;
+
+            // Folders without title.cfg are not apps
+            snprintf(path, sizeof(path), "%s/%s", dir, APP_TITLE_CONFIG_FILE);
+            if (stat(path, &st) != 0)
+                continue;
+
+            // Folder names too long for the index are parsed at every scan
+            if (strlen(pdirent->d_name) > APP_FOLDER_MAX) {
+                entry = &uncached;
+                parseAppConfig(path, entry);
+            } else {
+                if (listed == capacity) {
+                    capacity += 32;
+                    newEntries = realloc(entries, capacity * sizeof(app_index_entry_t));
+                    if (newEntries == NULL) {
+                        LOG("APPS unable to allocate memory.\n");
+                        complete = 0;
+                        break;
+                    }
+                    entries = newEntries;
+                }
+
+                entry = &entries[listed];
+                cached = queryAppsIndex(&index, listed, pdirent->d_name);
+                if (cached != NULL && cached->cfgSize == (u32)st.st_size && cached->cfgTime == (u32)st.st_mtime) {
+                    memcpy(entry, cached, sizeof(app_index_entry_t));
+                } else {
+                    memset(entry, 0, sizeof(app_index_entry_t));
+                    strcpy(entry->folder, pdirent->d_name);
+                    entry->cfgSize = (u32)st.st_size;
+                    entry->cfgTime = (u32)st.st_mtime;
+                    parseAppConfig(path, entry);
+                    modified = 1;
+                }
+                listed++;
+            }
+
+            if (entry->title[0] == '\0') {
+                LOG("APPS %s has no boot/title.\n", dir);
+                continue;
+            }
+
+            ret = callback(dir, entry->title, entry->boot, entry->argv1, arg);
+            if (ret == 0)
+                count++;
+            else if (ret < 0) { // Stopped because of unrecoverable error.
+                complete = 0;
+                break;
+            }
+        }
+
+        closedir(pdir);
+
+        // Folders that were removed leave the index with fewer entries
+        if (complete && (modified || listed != index.count))
+            saveAppsIndex(indexPath, entries, listed);
+
+        free(index.entries);
+        free(entries);
+    } else
+        LOG("APPS failed to open dir %s\n", appsPath);
+
+    return count;
+}
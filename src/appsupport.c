@@ -18,12 +18,9 @@ static int appItemCount = 0;
 
 static config_set_t *configApps;
 static app_info_t *appsList;
+static int appsListCapacity = 0;
 
-struct app_info_linked
-{
-    struct app_info_linked *next;
-    app_info_t app;
-};
+#define APP_LIST_GROWTH 32
 
 // forward declaration
 static item_list_t appItemList;
@@ -132,144 +129,99 @@ static int appNeedsUpdate(item_list_t *itemList)
     return update;
 }
 
-static int addAppsLegacyList(struct app_info_linked **appsLinkedList)
+// Appends an item to the apps list, which grows by several items at a time.
+static app_info_t *appAddItem(void)
+{
+    app_info_t *newList;
+
+    if (appItemCount == appsListCapacity) {
+        newList = realloc(appsList, (appsListCapacity + APP_LIST_GROWTH) * sizeof(app_info_t));
+        if (newList == NULL) {
+            LOG("APPSUPPORT unable to allocate memory.\n");
+            return NULL;
+        }
+
+        appsList = newList;
+        appsListCapacity += APP_LIST_GROWTH;
+    }
+
+    return &appsList[appItemCount++];
+}
+
+static void addAppsLegacyList(void)
 {
     struct config_value_t *cur;
-    struct app_info_linked *app;
-    int count;
+    app_info_t *app;
 
     configClear(configApps);
     configRead(configApps);
 
-    count = 0;
     cur = configApps->head;
     while (cur != NULL) {
-        if (*appsLinkedList == NULL) {
-            *appsLinkedList = malloc(sizeof(struct app_info_linked));
-            app = *appsLinkedList;
-            app->next = NULL;
-        } else {
-            app = malloc(sizeof(struct app_info_linked));
-            if (app != NULL) {
-                app->next = *appsLinkedList;
-                *appsLinkedList = app;
-            }
-        }
-
-        if (app == NULL) {
-            LOG("APPSUPPORT unable to allocate memory.\n");
+        app = appAddItem();
+        if (app == NULL)
             break;
-        }
 
-        strncpy(app->app.title, cur->key, APP_TITLE_MAX + 1);
-        app->app.title[APP_TITLE_MAX] = '\0';
+        strncpy(app->title, cur->key, APP_TITLE_MAX + 1);
+        app->title[APP_TITLE_MAX] = '\0';
 
         // Split the boot filename from the path.
         const char *elfname = appGetELFName(cur->val);
         if (elfname != cur->val) {
-            strncpy(app->app.boot, elfname, APP_BOOT_MAX + 1);
-            app->app.boot[APP_BOOT_MAX] = '\0';
+            strncpy(app->boot, elfname, APP_BOOT_MAX + 1);
+            app->boot[APP_BOOT_MAX] = '\0';
 
             int pathlen = (int)(elfname - cur->val) - 1;
             if (cur->val[pathlen] == ':') // Discard only '/'.
                 pathlen++;
             if (pathlen > APP_PATH_MAX)
                 pathlen = APP_PATH_MAX;
-            strncpy(app->app.path, cur->val, pathlen);
-            app->app.path[pathlen] = '\0';
+            strncpy(app->path, cur->val, pathlen);
+            app->path[pathlen] = '\0';
         } else {
             // Cannot split boot filename from the path, somehow.
-            strncpy(app->app.boot, cur->val, APP_BOOT_MAX + 1);
-            app->app.boot[APP_BOOT_MAX] = '\0';
-            strncpy(app->app.path, cur->val, APP_PATH_MAX + 1);
-            app->app.path[APP_BOOT_MAX] = '\0';
+            strncpy(app->boot, cur->val, APP_BOOT_MAX + 1);
+            app->boot[APP_BOOT_MAX] = '\0';
+            strncpy(app->path, cur->val, APP_PATH_MAX + 1);
+            app->path[APP_BOOT_MAX] = '\0';
         }
 
-        app->app.legacy = 1;
-        count++;
+        app->argv1[0] = '\0';
+        app->legacy = 1;
         cur = cur->next;
     }
-
-    return count;
 }
 
-static int appScanCallback(const char *path, config_set_t *appConfig, void *arg)
+static int appScanCallback(const char *path, const char *title, const char *boot, const char *argv1, void *arg)
 {
-    struct app_info_linked **appsLinkedList = (struct app_info_linked **)arg;
-    struct app_info_linked *app;
-    const char *title, *boot, *argv1;
-
-    if (configGetStr(appConfig, APP_CONFIG_TITLE, &title) != 0 && configGetStr(appConfig, APP_CONFIG_BOOT, &boot) != 0) {
-        if (*appsLinkedList == NULL) {
-            *appsLinkedList = malloc(sizeof(struct app_info_linked));
-            app = *appsLinkedList;
-            app->next = NULL;
-        } else {
-            app = malloc(sizeof(struct app_info_linked));
-            if (app != NULL) {
-                app->next = *appsLinkedList;
-                *appsLinkedList = app;
-            }
-        }
-
-        if (app == NULL) {
-            LOG("APPSUPPORT unable to allocate memory.\n");
-            return -1;
-        }
-
-        strncpy(app->app.title, title, APP_TITLE_MAX + 1);
-        app->app.title[APP_TITLE_MAX] = '\0';
-        strncpy(app->app.boot, boot, APP_BOOT_MAX + 1);
-        app->app.boot[APP_BOOT_MAX] = '\0';
-        strncpy(app->app.path, path, APP_PATH_MAX + 1);
-        app->app.path[APP_PATH_MAX] = '\0';
-        if (configGetStr(appConfig, APP_CONFIG_ARGV1, &argv1) != 0) {
-            strncpy(app->app.argv1, argv1, APP_ARGV1_MAX + 1);
-            app->app.argv1[APP_ARGV1_MAX] = '\0';
-        } else
-            app->app.argv1[0] = '\0';
-        app->app.legacy = 0;
-        return 0;
-    } else {
-        LOG("APPSUPPORT item has no boot/title.\n");
-        return 1;
-    }
-
-    return -1;
+    app_info_t *app;
+
+    app = appAddItem();
+    if (app == NULL)
+        return -1;
+
+    strncpy(app->title, title, APP_TITLE_MAX + 1);
+    app->title[APP_TITLE_MAX] = '\0';
+    strncpy(app->boot, boot, APP_BOOT_MAX + 1);
+    app->boot[APP_BOOT_MAX] = '\0';
+    strncpy(app->path, path, APP_PATH_MAX + 1);
+    app->path[APP_PATH_MAX] = '\0';
+    strncpy(app->argv1, argv1, APP_ARGV1_MAX + 1);
+    app->argv1[APP_ARGV1_MAX] = '\0';
+    app->legacy = 0;
+
+    return 0;
 }
 
 static int appUpdateItemList(item_list_t *itemList)
 {
-    struct app_info_linked *appsLinkedList, *appNext;
-
     appFreeList();
 
-    appsLinkedList = NULL;
-
     // Get legacy apps list first, so it is possible to use appGetConfigValue(id).
-    appItemCount += addAppsLegacyList(&appsLinkedList);
+    addAppsLegacyList();
 
     // Scan devices for apps.
-    appItemCount += oplScanApps(&appScanCallback, &appsLinkedList);
-
-    // Generate apps list
-    if (appItemCount > 0) {
-        appsList = malloc(appItemCount * sizeof(app_info_t));
-
-        if (appsList != NULL) {
-            int i;
-            for (i = 0; appsLinkedList != NULL; i++) { // appsLinkedList contains items in reverse order.
-                memcpy(&appsList[appItemCount - i - 1], &appsLinkedList->app, sizeof(app_info_t));
-
-                appNext = appsLinkedList->next;
-                free(appsLinkedList);
-                appsLinkedList = appNext;
-            }
-        } else {
-            LOG("APPSUPPORT unable to allocate memory.\n");
-            appItemCount = 0;
-        }
-    }
+    oplScanApps(&appScanCallback, NULL);
 
     LOG("APPSUPPORT %d apps loaded\n", appItemCount);
 
@@ -279,7 +231,9 @@ static int appUpdateItemList(item_list_t *itemList)
 static void appFreeList(void)
 {
     if (appsList != NULL) {
+        free(appsList);
         appsList = NULL;
+        appsListCapacity = 0;
         appItemCount = 0;
     }
 }
@@ -10,73 +10,132 @@
 #include "include/atlas.h"
 #include "include/renderman.h"
 
-static inline struct atlas_allocation_t *allocNew(int x, int y, size_t width, size_t height)
+// Shelf heights are rounded up to this, so that glyphs of similar height share shelves
+#define SHELF_ROUNDING 4
+
+static inline struct atlas_allocation_t *slotNew(atlas_t *atlas)
 {
-    struct atlas_allocation_t *al = (struct atlas_allocation_t *)malloc(sizeof(struct atlas_allocation_t));
+    struct atlas_allocation_t *slot = atlas->freeSlots;
 
-    al->x = x;
-    al->y = y;
-    al->w = width;
-    al->h = height;
+    if (slot)
+        atlas->freeSlots = slot->next;
 
-    al->leaf1 = NULL;
-    al->leaf2 = NULL;
+    return slot;
+}
 
-    return al;
+static inline void slotFree(atlas_t *atlas, struct atlas_allocation_t *slot)
+{
+    slot->next = atlas->freeSlots;
+    atlas->freeSlots = slot;
 }
 
-static inline void allocFree(struct atlas_allocation_t *alloc)
+/// Returns nonzero if the shelf has a released slot or tail space wide enough
+static int shelfHasRoom(atlas_t *atlas, struct atlas_shelf_t *shelf, int width)
 {
-    if (!alloc)
-        return;
+    struct atlas_allocation_t *slot;
 
-    // NOTE: If used on a tree component it
-    // would have to be ensured pointers to freed
-    // allocation are fixed
+    if (atlas->surface.Width - shelf->x >= width)
+        return 1;
 
-    allocFree(alloc->leaf1); // safe
-    allocFree(alloc->leaf2);
+    for (slot = shelf->slots; slot; slot = slot->next) {
+        if (!slot->used && slot->w >= width)
+            return 1;
+    }
 
-    free(alloc);
+    return 0;
 }
 
-#define ALLOC_FITS(alloc, width, height) \
-    ((alloc->w >= width) && (alloc->h >= height))
+static struct atlas_allocation_t *shelfPlace(atlas_t *atlas, int shelfId, int width)
+{
+    struct atlas_shelf_t *shelf = &atlas->shelves[shelfId];
+    struct atlas_allocation_t *slot, *last = NULL;
+
+    // reuse a released slot first (first fit), splitting off the unused width
+    for (slot = shelf->slots; slot; last = slot, slot = slot->next) {
+        if (!slot->used && slot->w >= width) {
+            if (slot->w > width) {
+                struct atlas_allocation_t *rest = slotNew(atlas);
+                if (rest) {
+                    *rest = *slot;
+                    rest->x += width;
+                    rest->w -= width;
+                    slot->w = width;
+                    slot->next = rest;
+                }
+            }
+
+            slot->used = 1;
+            return slot;
+        }
+    }
+
+    // take the never allocated space at the end of the shelf
+    if (atlas->surface.Width - shelf->x < width)
+        return NULL;
+
+    slot = slotNew(atlas);
+    if (!slot)
+        return NULL;
 
-#define ALLOC_ISFREE(alloc) \
-    ((!alloc->leaf1) && (!alloc->leaf2))
+    slot->x = shelf->x;
+    slot->y = shelf->y;
+    slot->w = width;
+    slot->h = shelf->h;
+    slot->used = 1;
+    slot->shelf = shelfId;
+    slot->next = NULL;
 
+    if (last)
+        last->next = slot;
+    else
+        shelf->slots = slot;
 
-static inline struct atlas_allocation_t *allocPlace(struct atlas_allocation_t *alloc, size_t width, size_t height)
+    shelf->x += width;
+
+    return slot;
+}
+
+static struct atlas_allocation_t *allocPlace(atlas_t *atlas, int width, int height)
 {
-    // do we fit?
-    if (!ALLOC_FITS(alloc, width, height))
-        return NULL;
+    int i, best = -1, bestWaste = 0;
 
-    if (ALLOC_ISFREE(alloc)) {
-        // extra space
-        size_t dx = alloc->w - width;
-        size_t dy = alloc->h - height;
-
-        // make the wider piece also longer - less wasted space
-        if (dx < dy) {
-            alloc->leaf1 = allocNew(alloc->x + width, alloc->y, dx, height);
-            alloc->leaf2 = allocNew(alloc->x, alloc->y + height, alloc->w, dy);
-        } else {
-            alloc->leaf1 = allocNew(alloc->x, alloc->y + height, width, dy);
-            alloc->leaf2 = allocNew(alloc->x + width, alloc->y, dx, alloc->h);
+    // best fit in height among the shelves with room, ignoring shelves that would waste too much
+    for (i = 0; i < atlas->shelfCount; i++) {
+        struct atlas_shelf_t *shelf = &atlas->shelves[i];
+        int waste = shelf->h - height;
+
+        if (waste < 0 || waste > height / 2 + SHELF_ROUNDING)
+            continue;
+
+        if ((best < 0 || waste < bestWaste) && shelfHasRoom(atlas, shelf, width)) {
+            best = i;
+            bestWaste = waste;
         }
+    }
 
-        return alloc;
-    } else {
-        // already occupied. Try children
-        struct atlas_allocation_t *p = allocPlace(alloc->leaf1, width, height);
-        if (p)
-            return p;
+    if (best >= 0)
+        return shelfPlace(atlas, best, width);
 
-        p = allocPlace(alloc->leaf2, width, height);
-        if (p)
-            return p;
+    // open a new shelf
+    if (atlas->shelfCount < ATLAS_MAX_SHELVES && atlas->shelfY + height <= atlas->surface.Height && width <= atlas->surface.Width) {
+        struct atlas_shelf_t *shelf = &atlas->shelves[atlas->shelfCount];
+
+        shelf->y = atlas->shelfY;
+        shelf->h = (height + SHELF_ROUNDING - 1) & ~(SHELF_ROUNDING - 1);
+        if (shelf->y + shelf->h > atlas->surface.Height)
+            shelf->h = atlas->surface.Height - shelf->y;
+        shelf->x = 0;
+        shelf->slots = NULL;
+
+        atlas->shelfY += shelf->h;
+
+        return shelfPlace(atlas, atlas->shelfCount++, width);
+    }
+
+    // out of space - accept any shelf that is high enough
+    for (i = 0; i < atlas->shelfCount; i++) {
+        if (atlas->shelves[i].h >= height && shelfHasRoom(atlas, &atlas->shelves[i], width))
+            return shelfPlace(atlas, i, width);
     }
 
     return NULL;
@@ -85,8 +144,15 @@ static inline struct atlas_allocation_t *allocPlace(struct atlas_allocation_t *a
 atlas_t *atlasNew(size_t width, size_t height, u8 psm)
 {
     atlas_t *atlas = (atlas_t *)malloc(sizeof(atlas_t));
+    int i;
+
+    atlas->shelfY = 0;
+    atlas->shelfCount = 0;
+    atlas->usedArea = 0;
 
-    atlas->allocation = allocNew(0, 0, width, height);
+    atlas->freeSlots = NULL;
+    for (i = ATLAS_MAX_SLOTS - 1; i >= 0; i--)
+        slotFree(atlas, &atlas->slotPool[i]);
 
     atlas->surface.Width = width;
     atlas->surface.Height = height;
@@ -115,9 +181,6 @@ void atlasFree(atlas_t *atlas)
     if (!atlas)
         return;
 
-    allocFree(atlas->allocation);
-    atlas->allocation = NULL;
-
     rmUnloadTexture(&atlas->surface);
     free(atlas->surface.Mem);
     atlas->surface.Mem = NULL;
@@ -156,13 +219,13 @@ static void atlasCopyData(atlas_t *atlas, struct atlas_allocation_t *al, size_t
     char *data = (char *)atlas->surface.Mem;
 
     // advance the pointer to the atlas position start (first pixel)
-    data += ps * (al->y * atlas->allocation->w + al->x);
+    data += ps * (al->y * atlas->surface.Width + al->x);
 
     size_t rowsize = width * ps;
 
     for (y = 0; y < height; ++y) {
         memcpy(data, src, rowsize);
-        data += ps * atlas->allocation->w;
+        data += ps * atlas->surface.Width;
         src += ps * width;
     }
 }
@@ -172,14 +235,81 @@ struct atlas_allocation_t *atlasPlace(atlas_t *atlas, size_t width, size_t heigh
     if (!surface)
         return NULL;
 
-    struct atlas_allocation_t *al = allocPlace(atlas->allocation, width + 1, height + 1);
+    struct atlas_allocation_t *al = allocPlace(atlas, width + 1, height + 1);
 
     if (!al)
         return NULL;
 
+    atlas->usedArea += al->w * al->h;
+
     atlasCopyData(atlas, al, width, height, surface);
 
     rmInvalidateTexture(&atlas->surface);
 
     return al;
 }
+
+static void atlasClearData(atlas_t *atlas, struct atlas_allocation_t *al)
+{
+    int y;
+    size_t ps = pixelSize(atlas->surface.PSM);
+    char *data = (char *)atlas->surface.Mem;
+
+    data += ps * (al->y * atlas->surface.Width + al->x);
+
+    for (y = 0; y < al->h; ++y) {
+        memset(data, 0, al->w * ps);
+        data += ps * atlas->surface.Width;
+    }
+}
+
+void atlasRelease(atlas_t *atlas, struct atlas_allocation_t *allocation)
+{
+    struct atlas_shelf_t *shelf = &atlas->shelves[allocation->shelf];
+    struct atlas_allocation_t *prev = NULL, *slot;
+
+    // the space may be taken by a smaller pixmap next time, so don't leave stale pixels behind
+    // (the GS may still be drawing the pixmap, in the previous frame)
+    rmWaitGS();
+    atlasClearData(atlas, allocation);
+    rmInvalidateTexture(&atlas->surface);
+
+    atlas->usedArea -= allocation->w * allocation->h;
+    allocation->used = 0;
+
+    for (slot = shelf->slots; slot != allocation; slot = slot->next)
+        prev = slot;
+
+    // merge with the released neighbours
+    if (allocation->next && !allocation->next->used) {
+        slot = allocation->next;
+        allocation->w += slot->w;
+        allocation->next = slot->next;
+        slotFree(atlas, slot);
+    }
+
+    if (prev && !prev->used) {
+        prev->w += allocation->w;
+        prev->next = allocation->next;
+        slotFree(atlas, allocation);
+        allocation = prev;
+        // find the predecessor of the merged slot, for the tail check below
+        for (prev = NULL, slot = shelf->slots; slot != allocation; slot = slot->next)
+            prev = slot;
+    }
+
+    // a released slot at the end of the shelf goes back to the tail space
+    if (!allocation->next) {
+        shelf->x = allocation->x;
+        if (prev)
+            prev->next = NULL;
+        else
+            shelf->slots = NULL;
+        slotFree(atlas, allocation);
+    }
+}
+
+int atlasOccupancy(atlas_t *atlas)
+{
+    return (atlas->usedArea * 100) / (atlas->surface.Width * atlas->surface.Height);
+}
@@ -464,6 +464,24 @@ void bdmLaunchGame(item_list_t *itemList, int id, config_set_t *configSet)
         close(fd);
     }
 
+#ifdef __IO_TRACE
+    //
+    // Add the I/O trace as fragfile[1] to fragment list
+    //
+    struct cdvdman_fragfile *trace_frag = &settings->fragfile[1];
+    trace_frag->frag_start = iTotalFragCount;
+    trace_frag->frag_count = 0;
+    if ((fd = sbCreateIoTrace(game, pDeviceData->bdmPrefix, "/")) >= 0) {
+        iop_fd = ps2sdk_get_iop_fd(fd);
+        int iFragCount = fileXioIoctl2(iop_fd, USBMASS_IOCTL_GET_FRAGLIST, NULL, 0, (void *)&settings->frags[iTotalFragCount], sizeof(bd_fragment_t) * (BDM_MAX_FRAGS - iTotalFragCount));
+        if (iFragCount > 0 && iTotalFragCount + iFragCount <= BDM_MAX_FRAGS) {
+            trace_frag->frag_count = iFragCount;
+            iTotalFragCount += iFragCount;
+        }
+        close(fd);
+    }
+#endif
+
     // Initialize layer 1 information.
     sbCreatePath(game, partname, pDeviceData->bdmPrefix, "/", 0);
     layer1_start = sbGetISO9660MaxLBA(partname);
@@ -25,11 +25,14 @@
 #include <unistd.h>
 #include "include/cheatman.h"
 #include "include/ioman.h"
+#include "../ee_core/include/cheat_prog.h"
 
 static int gEnableCheat; // Enables PS2RD Cheat Engine - 0 for Off, 1 for On
 static int gCheatMode;   // Cheat Mode - 0 Enable all cheats, 1 Cheats selected by user
 
 static u32 gCheatList[MAX_CHEATLIST]; // Store hooks/codes addr+val pairs
+static u32 gCheatProgram[MAX_CODES * 2]; // gCheatList compiled for the EE core, see cheat_prog.h
+static int gCheatProgramSize;            // Number of words in gCheatProgram, -1 if the list could not be compiled
 cheat_entry_t gCheats[MAX_CODES];
 
 void InitCheatsConfig(config_set_t *configSet)
@@ -63,6 +66,12 @@ const u32 *GetCheatsList(void)
     return gCheatList;
 }
 
+const u32 *GetCheatsProgram(int *size)
+{
+    *size = gCheatProgramSize;
+    return (gCheatProgramSize >= 0) ? gCheatProgram : NULL;
+}
+
 /*
  * make_code - Return a code object from string @s.
  */
@@ -380,6 +389,310 @@ int load_cheats(const char *cheatfile)
     return (gCheatMode == 0) ? 0 : 1;
 }
 
+/*
+ * code_lines - Return the number of lines taken by the code starting with @code.
+ */
+static int code_lines(const code_t *code)
+{
+    switch (code->addr >> 28) {
+        case 3:
+            return (((code->addr >> 20) & 6) == 4) ? 2 : 1;
+        case 4:
+        case 5:
+        case 6:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/*
+ * is_const_write - Return non-zero if @code is a constant write, which may be merged with others.
+ */
+static int is_const_write(const code_t *code)
+{
+    return code->addr != 0 && (code->addr >> 28) <= 2;
+}
+
+typedef struct
+{
+    u32 addr;
+    u16 seq;
+    u8 val;
+} cheat_byte_t;
+
+static int cheat_byte_cmp(const void *a, const void *b)
+{
+    const cheat_byte_t *x = a, *y = b;
+
+    if (x->addr != y->addr)
+        return (x->addr < y->addr) ? -1 : 1;
+    return (int)x->seq - (int)y->seq;
+}
+
+/*
+ * emit_op - Append an operation with @count operands to the cheat program.
+ * Return the offset of the operation, or -1 if there is no space left.
+ */
+static int emit_op(u32 header, const u32 *operands, int count)
+{
+    int pos = gCheatProgramSize;
+
+    if (pos + 1 + count > MAX_CODES * 2)
+        return -1;
+
+    gCheatProgram[pos] = header;
+    memcpy(&gCheatProgram[pos + 1], operands, count * sizeof(u32));
+    gCheatProgramSize += 1 + count;
+    return pos;
+}
+
+/*
+ * emit_run - Write @count consecutive words, starting at @addr.
+ */
+static int emit_run(u32 addr, const u32 *values, int count)
+{
+    u32 operands[MAX_CODES + 1];
+
+    if (count == 1)
+        return emit_op(CHEAT_OP_HEADER(CHEAT_OP_WRITE32, 0, addr), values, 1);
+
+    operands[0] = count;
+    memcpy(&operands[1], values, count * sizeof(u32));
+    return emit_op(CHEAT_OP_HEADER(CHEAT_OP_RUN32, 0, addr), operands, count + 1);
+}
+
+/*
+ * emit_writes - Merge the constant writes of @count lines into as few writes as possible, sorted by address.
+ * Later writes override earlier ones. Return 0 on success, -1 on failure.
+ */
+static int emit_writes(const code_t *codes, int count)
+{
+    static cheat_byte_t bytes[MAX_CODES * 4];
+    u32 run[MAX_CODES], runAddr, addr, word, value, operand;
+    int i, j, size, nbytes, nrun, mask;
+
+    nbytes = 0;
+    for (i = 0; i < count; i++) {
+        if (codes[i].addr == 0)
+            continue;
+
+        addr = codes[i].addr & CHEAT_ADDR_MASK;
+        size = 1 << (codes[i].addr >> 28);
+        if (addr & (size - 1)) // Misaligned, leave it to the code handler
+            return -1;
+
+        for (j = 0; j < size; j++) {
+            bytes[nbytes].addr = addr + j;
+            bytes[nbytes].seq = nbytes;
+            bytes[nbytes].val = codes[i].val >> (j * 8);
+            nbytes++;
+        }
+    }
+
+    qsort(bytes, nbytes, sizeof(cheat_byte_t), &cheat_byte_cmp);
+
+    runAddr = 0;
+    nrun = 0;
+    for (i = 0; i < nbytes;) {
+        // Collect the final value of every byte of this word.
+        word = bytes[i].addr & ~3;
+        value = 0;
+        mask = 0;
+        for (; i < nbytes && (bytes[i].addr & ~3) == word; i++) {
+            j = (bytes[i].addr & 3) * 8;
+            value = (value & ~(0xFF << j)) | ((u32)bytes[i].val << j);
+            mask |= 1 << (j / 8);
+        }
+
+        // Whole words that follow each other are written as a run.
+        if (nrun > 0 && (mask != 0xF || word != runAddr + nrun * 4)) {
+            if (emit_run(runAddr, run, nrun) < 0)
+                return -1;
+            nrun = 0;
+        }
+
+        if (mask == 0xF) {
+            if (nrun == 0)
+                runAddr = word;
+            run[nrun++] = value;
+            continue;
+        }
+
+        // Otherwise, write whole halfwords and the remaining bytes.
+        for (j = 0; j < 4; j++) {
+            if (!((mask >> j) & 1))
+                continue;
+
+            if (!(j & 1) && ((mask >> j) & 3) == 3) {
+                operand = (value >> (j * 8)) & 0xFFFF;
+                if (emit_op(CHEAT_OP_HEADER(CHEAT_OP_WRITE16, 0, word + j), &operand, 1) < 0)
+                    return -1;
+                j++;
+            } else {
+                operand = (value >> (j * 8)) & 0xFF;
+                if (emit_op(CHEAT_OP_HEADER(CHEAT_OP_WRITE8, 0, word + j), &operand, 1) < 0)
+                    return -1;
+            }
+        }
+    }
+
+    if (nrun > 0 && emit_run(runAddr, run, nrun) < 0)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * compile_cheats - Compile the code list, as the EE core will build it from @list, into a cheat program.
+ *
+ * Hook codes are left to the EE core. Constant writes between other codes are merged and sorted,
+ * everything else is pre-decoded into one operation per code. Conditional codes are resolved
+ * into the number of program words to skip.
+ * Return 0 on success, -1 if the list has to be left to the code handler.
+ */
+static int compile_cheats(const u32 *list)
+{
+    static code_t codes[MAX_CODES];
+    static u8 targets[MAX_CODES + 1];
+    static short int offsets[MAX_CODES + 1];
+    static short int fixups[MAX_CODES];
+    code_t code;
+    u32 operands[3], value, test;
+    int i, j, count, lines, nfixups, nextCodeCanBeHook, pos;
+
+    // Split off the hook codes, just like SetupCheats() in the EE core.
+    count = 0;
+    nextCodeCanBeHook = 1;
+    for (i = 0; i < MAX_CHEATLIST; i += 2) {
+        code.addr = list[i];
+        code.val = list[i + 1];
+        if (code.addr == 0 && code.val == 0)
+            break;
+
+        if (!((code.addr & 0xfe000000) == 0x90000000 && nextCodeCanBeHook)) {
+            if (count >= MAX_CODES)
+                return -1;
+            codes[count++] = code;
+        }
+        nextCodeCanBeHook = !((code.addr & 0xf0000000) == 0x40000000 || (code.addr & 0xf0000000) == 0x30000000);
+    }
+
+    // Find where conditional codes continue. They count lines, so they must not land within a code.
+    memset(targets, 0, sizeof(targets));
+    for (i = 0; i < count; i += lines) {
+        lines = code_lines(&codes[i]);
+        if (i + lines > count)
+            return -1;
+        targets[i] |= 2;
+
+        switch (codes[i].addr >> 28) {
+            case 0xD:
+                j = codes[i].val >> 24;
+                break;
+            case 0xE:
+                j = (codes[i].addr >> 16) & 0xFF;
+                break;
+            default:
+                continue;
+        }
+        j = i + 1 + (j == 0 ? 1 : j);
+        targets[j < count ? j : count] |= 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (targets[i] == 1)
+            return -1;
+    }
+
+    gCheatProgramSize = 0;
+    nfixups = 0;
+    for (i = 0; i < count; i += lines) {
+        offsets[i] = gCheatProgramSize;
+        code = codes[i];
+        lines = code_lines(&code);
+        pos = 0;
+
+        switch (code.addr >> 28) {
+            case 0:
+            case 1:
+            case 2:
+                if (code.addr == 0)
+                    break;
+                // Merge all following constant writes, up to where a conditional code continues.
+                for (lines = 1; i + lines < count && is_const_write(&codes[i + lines]) && !(targets[i + lines] & 1); lines++)
+                    offsets[i + lines] = gCheatProgramSize;
+                pos = emit_writes(&codes[i], lines);
+                break;
+            case 3:
+                j = (code.addr >> 20) & 6;
+                value = (j == 4) ? codes[i + 1].addr : (code.addr & 0xFFFF);
+                operands[0] = (code.addr & 0x00100000) ? -value : value;
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_INC, j == 0 ? CHEAT_SIZE_8 : (j == 4 ? CHEAT_SIZE_32 : CHEAT_SIZE_16), code.val), operands, 1);
+                break;
+            case 4:
+                operands[0] = code.val;
+                operands[1] = codes[i + 1].addr;
+                operands[2] = codes[i + 1].val;
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_SERIAL, 0, code.addr), operands, 3);
+                break;
+            case 5:
+                operands[0] = code.val;
+                operands[1] = codes[i + 1].addr;
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_COPY, 0, code.addr), operands, 2);
+                break;
+            case 6:
+                j = codes[i + 1].addr >> 16;
+                operands[0] = code.val;
+                operands[1] = codes[i + 1].val;
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_POINTER, j > CHEAT_SIZE_32 ? CHEAT_SIZE_32 : j, code.addr), operands, 2);
+                break;
+            case 7:
+                j = (code.val >> 20) & 7;
+                operands[0] = code.val & ((j & CHEAT_BOOL_16) ? 0xFFFF : 0xFF);
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_BOOL, (j & 6) == 6 ? (j & ~2) : j, code.addr), operands, 1);
+                break;
+            case 0xC:
+                pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_STOPNE, 0, code.addr), &code.val, 1);
+                break;
+            case 0xD:
+            case 0xE:
+                if ((code.addr >> 28) == 0xE) {
+                    // E-tnnvvvv taaaaaaa, the old form of D-aaaaaaa nnt0vvvv
+                    value = (code.addr & 0xFFFF) | ((code.val >> 28) << 20) | (((code.addr >> 24) & 1) << 16) | (((code.addr >> 16) & 0xFF) << 24);
+                    code.addr = code.val;
+                    code.val = value;
+                }
+                test = (code.val >> 20) & 7;
+                j = (code.val >> 16) & 1;
+                value = code.val & (j ? 0xFF : 0xFFFF);
+                operands[0] = CHEAT_IF_ARG(value, test, 0);
+                if ((pos = emit_op(CHEAT_OP_HEADER(CHEAT_OP_IF, j ? CHEAT_SIZE_8 : CHEAT_SIZE_16, code.addr), operands, 1)) >= 0) {
+                    j = code.val >> 24;
+                    j = i + 1 + (j == 0 ? 1 : j);
+                    // Keep the line to continue from, until the offsets of all lines are known.
+                    fixups[nfixups++] = pos;
+                    gCheatProgram[pos + 1] |= (u32)(j < count ? j : count) << 19;
+                }
+                break;
+            default: // Not supported by the code handler either
+                break;
+        }
+
+        if (pos < 0)
+            return -1;
+    }
+    offsets[count] = gCheatProgramSize;
+
+    // Turn the line indices of conditional codes into the number of words to skip.
+    for (i = 0; i < nfixups; i++) {
+        pos = fixups[i];
+        j = offsets[CHEAT_IF_SKIP(gCheatProgram[pos + 1])] - (pos + 2);
+        gCheatProgram[pos + 1] = (gCheatProgram[pos + 1] & 0x7FFFF) | (u32)j << 19;
+    }
+
+    return 0;
+}
+
 void set_cheats_list(void)
 {
     int cheatCount = 0;
@@ -410,4 +723,10 @@ void set_cheats_list(void)
         gCheatList[cheatCount - 2] = 0; // addr
         gCheatList[cheatCount - 1] = 0; // val
     }
+
+    if (compile_cheats(gCheatList) < 0) {
+        LOG("%s: Codes will be interpreted.\n", __FUNCTION__);
+        gCheatProgramSize = -1;
+    } else
+        LOG("%s: Compiled %d code words into %d program words.\n", __FUNCTION__, cheatCount, gCheatProgramSize);
 }
@@ -0,0 +1,264 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Compatibility update: downloads the settings of each game from the compatibility list server.
+  Also built on the PC by pc/tests/src/httpclient_test.c, against a stub server.
+*/
+
+#include "include/opl.h"
+#include "include/iosupport.h"
+#include "include/compatupd.h"
+#include "httpclient.h"
+
+#include <libcdvd.h>
+#include <osd_config.h>
+
+// FIXME: We should not need this function.
+//        Use newlib's 'stat' to get GMT time.
+#define NEWLIB_PORT_AWARE
+#include <fileXio_rpc.h> // iox_stat_t
+int configGetStat(config_set_t *configSet, iox_stat_t *stat);
+
+#define HTTP_IOBUF_SIZE 512
+
+unsigned int CompatUpdateComplete;
+unsigned char CompatUpdateStopFlag;
+short int CompatUpdateStatus;
+
+#define EOPLCONNERR 0x4000 // Special error code for connection errors.
+
+static int CompatAttemptConnection(void)
+{
+    unsigned char retries;
+    int HttpSocket;
+
+    for (retries = OPL_COMPAT_HTTP_RETRIES, HttpSocket = -1; !CompatUpdateStopFlag && retries > 0; retries--) {
+        if ((HttpSocket = HttpEstabConnection(OPL_COMPAT_HTTP_HOST, OPL_COMPAT_HTTP_PORT)) >= 0) {
+            break;
+        }
+    }
+
+    return HttpSocket;
+}
+
+typedef struct
+{
+    config_set_t *config; // NULL if the item has no config file
+    int id;
+    s8 send; // 0 if the item is skipped, so no request is sent for it
+    s8 hasMtime;
+    u8 mtime[6];
+    char uri[64];
+} compat_request_t;
+
+static void compatPrepareRequest(item_list_t *support, unsigned char mode, char device, config_set_t *configSet, int id, compat_request_t *req)
+{
+    sceCdCLOCK clock;
+    iox_stat_t stat;
+    int ConfigSource;
+
+    req->id = id;
+    req->send = 0;
+    req->config = configSet != NULL ? configSet : support->itemGetConfig(support, id);
+    if (req->config == NULL)
+        return;
+
+    ConfigSource = CONFIG_SOURCE_DEFAULT;
+    if ((mode & COMPAT_UPD_MODE_UPD_USR) || !configGetInt(req->config, CONFIG_ITEM_CONFIGSOURCE, &ConfigSource) || ConfigSource != CONFIG_SOURCE_USER) {
+        if (!(mode & COMPAT_UPD_MODE_NO_MTIME) && (ConfigSource == CONFIG_SOURCE_DLOAD) && configGetStat(req->config, &stat)) { // Only perform a stat operation for downloaded setting files.
+            if (!(mode & COMPAT_UPD_MODE_MTIME_GMT)) {
+                clock.second = itob(stat.mtime[1]);
+                clock.minute = itob(stat.mtime[2]);
+                clock.hour = itob(stat.mtime[3]);
+                clock.day = itob(stat.mtime[4]);
+                clock.month = itob(stat.mtime[5]);
+                clock.year = itob((stat.mtime[6] | ((unsigned short int)stat.mtime[7] << 8)) - 2000);
+                configConvertToGmtTime(&clock);
+
+                req->mtime[0] = btoi(clock.year);      // Year
+                req->mtime[1] = btoi(clock.month) - 1; // Month
+                req->mtime[2] = btoi(clock.day) - 1;   // Day
+                req->mtime[3] = btoi(clock.hour);      // Hour
+                req->mtime[4] = btoi(clock.minute);    // Minute
+                req->mtime[5] = btoi(clock.second);    // Second
+            } else {
+                req->mtime[0] = (stat.mtime[6] | ((unsigned short int)stat.mtime[7] << 8)) - 2000; // Year
+                req->mtime[1] = stat.mtime[5] - 1;                                                 // Month
+                req->mtime[2] = stat.mtime[4] - 1;                                                 // Day
+                req->mtime[3] = stat.mtime[3];                                                     // Hour
+                req->mtime[4] = stat.mtime[2];                                                     // Minute
+                req->mtime[5] = stat.mtime[1];                                                     // Second
+            }
+            req->hasMtime = 1;
+
+            LOG("CompatUpdate: LAST MTIME %04u/%02u/%02u %02u:%02u:%02u\n", (unsigned short int)req->mtime[0] + 2000, req->mtime[1] + 1, req->mtime[2] + 1, req->mtime[3], req->mtime[4], req->mtime[5]);
+        } else {
+            req->hasMtime = 0;
+        }
+
+        sprintf(req->uri, OPL_COMPAT_HTTP_URI, support->itemGetStartup(support, id), device);
+        req->send = 1;
+    }
+}
+
+// Sends the requests of the items from first to last (excluded). A failure is detected when the response is received.
+static void compatSendRequests(int HttpSocket, compat_request_t *requests, int first, int last)
+{
+    compat_request_t *req;
+
+    for (; first < last; first++) {
+        req = &requests[first % OPL_COMPAT_HTTP_PIPELINE];
+        if (req->config != NULL && req->send)
+            HttpQueueGetRequest(HttpSocket, OPL_USER_AGENT, OPL_COMPAT_HTTP_HOST, HTTP_CMODE_PERSISTENT, req->hasMtime ? req->mtime : NULL, req->uri);
+    }
+}
+
+void compatUpdate(item_list_t *support, unsigned char mode, config_set_t *configSet, int id)
+{
+    compat_request_t requests[OPL_COMPAT_HTTP_PIPELINE], *req;
+    config_set_t *downloadedConfig;
+    u16 length;
+    s8 ConnMode;
+    char *HttpBuffer;
+    int i, sent, count, HttpSocket, result, retries;
+    char device;
+
+    switch (support->mode) {
+        case BDM_MODE:
+            device = 3;
+            break;
+        case ETH_MODE:
+            mode |= COMPAT_UPD_MODE_MTIME_GMT;
+            device = 2;
+            break;
+        case HDD_MODE:
+            device = 1;
+            break;
+        default:
+            device = -1;
+    }
+
+    if (device < 0) {
+        LOG("CompatUpdate: unrecognized mode: %d\n", support->mode);
+        CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_ERROR;
+        return; // Shouldn't happen, but what if?
+    }
+
+    result = 0;
+    LOG("CompatUpdate: updating for: device %d game %d\n", device, configSet == NULL ? -1 : id);
+
+    if ((HttpBuffer = memalign(64, HTTP_IOBUF_SIZE)) != NULL) {
+        count = configSet != NULL ? 1 : support->itemGetCount(support);
+
+        if (count > 0) {
+            ConnMode = HTTP_CMODE_PERSISTENT;
+            if ((HttpSocket = CompatAttemptConnection()) >= 0) {
+                /* Update compatibility list. The requests are pipelined over a single connection:
+                   up to OPL_COMPAT_HTTP_PIPELINE requests are sent ahead, then the responses are received in order.
+                   If the connection is lost or closed by the server, the requests that were not answered are sent again over a new connection. */
+                for (i = 0, sent = 0, retries = OPL_COMPAT_HTTP_RETRIES; !CompatUpdateStopFlag && result >= 0 && i < count;) {
+                    for (; sent < count && sent - i < OPL_COMPAT_HTTP_PIPELINE; sent++) {
+                        compatPrepareRequest(support, mode, device, configSet, configSet != NULL ? id : sent, &requests[sent % OPL_COMPAT_HTTP_PIPELINE]);
+                        compatSendRequests(HttpSocket, requests, sent, sent + 1);
+                    }
+
+                    req = &requests[i % OPL_COMPAT_HTTP_PIPELINE];
+
+                    if (req->config != NULL) {
+                        if (req->send) {
+                            length = HTTP_IOBUF_SIZE;
+                            result = HttpGetResponse(HttpSocket, &ConnMode, HttpBuffer, &length);
+                            if (result >= 0) {
+                                if (result == 200) {
+                                    if ((downloadedConfig = configAlloc(0, NULL, NULL)) != NULL) {
+                                        configReadBuffer(downloadedConfig, HttpBuffer, length);
+                                        configMerge(req->config, downloadedConfig);
+                                        configFree(downloadedConfig);
+                                        configSetInt(req->config, CONFIG_ITEM_CONFIGSOURCE, CONFIG_SOURCE_DLOAD);
+                                        if (!configWrite(req->config))
+                                            result = -EIO;
+                                    } else
+                                        result = -ENOMEM;
+                                }
+                            } else {
+                                result |= EOPLCONNERR;
+
+                                HttpCloseConnection(HttpSocket);
+                                HttpSocket = -1;
+
+                                if (!CompatUpdateStopFlag && --retries > 0) {
+                                    LOG("CompatUpdate: Connection lost. Retrying.\n");
+
+                                    // Connection lost. Attempt to re-connect and send the requests again, starting from this one.
+                                    ConnMode = HTTP_CMODE_PERSISTENT;
+                                    if ((HttpSocket = CompatAttemptConnection()) >= 0) {
+                                        compatSendRequests(HttpSocket, requests, i, sent);
+                                        result = 0;
+                                        continue;
+                                    }
+                                    result = HttpSocket | EOPLCONNERR;
+                                }
+                            }
+
+                            LOG("CompatUpdate %d. %d, %s: %s %d\n", i + 1, device, support->itemGetStartup(support, req->id), ConnMode == HTTP_CMODE_CLOSED ? "CLOSED" : "PERSISTENT", result);
+                        } else {
+                            LOG("CompatUpdate: skipping %s\n", support->itemGetStartup(support, req->id));
+                        }
+
+                        if (configSet == NULL) // Do not free what is not ours.
+                            configFree(req->config);
+                        req->config = NULL;
+                    } else {
+                        // Can't do anything because the config file cannot be opened/created.
+                        LOG("CompatUpdate: skipping %s (no config)\n", support->itemGetStartup(support, req->id));
+                    }
+
+                    i++;
+                    CompatUpdateComplete++;
+                    retries = OPL_COMPAT_HTTP_RETRIES;
+
+                    if (HttpSocket >= 0 && ConnMode == HTTP_CMODE_CLOSED) {
+                        // The server did not serve the requests after this one.
+                        HttpCloseConnection(HttpSocket);
+                        HttpSocket = -1;
+                        if (result >= 0 && i < count) {
+                            ConnMode = HTTP_CMODE_PERSISTENT;
+                            if ((HttpSocket = CompatAttemptConnection()) >= 0)
+                                compatSendRequests(HttpSocket, requests, i, sent);
+                            else
+                                result = HttpSocket | EOPLCONNERR;
+                        }
+                    }
+                }
+
+                // Free the configs of the items that were not updated.
+                for (; i < sent; i++) {
+                    req = &requests[i % OPL_COMPAT_HTTP_PIPELINE];
+                    if (configSet == NULL && req->config != NULL)
+                        configFree(req->config);
+                }
+
+                if (HttpSocket >= 0)
+                    HttpCloseConnection(HttpSocket);
+            } else {
+                result = HttpSocket | EOPLCONNERR;
+            }
+        }
+
+        free(HttpBuffer);
+    } else {
+        result = -ENOMEM;
+    }
+
+    if (CompatUpdateStopFlag)
+        CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_ABORTED;
+    else {
+        if (result >= 0)
+            CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_DONE;
+        else {
+            CompatUpdateStatus = (result & EOPLCONNERR) ? OPL_COMPAT_UPDATE_STAT_CONN_ERROR : OPL_COMPAT_UPDATE_STAT_ERROR;
+        }
+    }
+    LOG("CompatUpdate: completed with status %d\n", CompatUpdateStatus);
+}
@@ -465,7 +465,7 @@ void configGetDiscIDBinary(config_set_t *configSet, void *dst)
     }
 }
 
-static int configReadFileBuffer(file_buffer_t *fileBuffer, config_set_t *configSet)
+static int configReadTextBuffer(text_buffer_t *text, config_set_t *configSet)
 {
     char *line;
     unsigned int lineno = 0;
@@ -473,7 +473,7 @@ static int configReadFileBuffer(file_buffer_t *fileBuffer, config_set_t *configS
     char prefix[CONFIG_KEY_NAME_LEN];
     memset(prefix, 0, sizeof(prefix));
 
-    while (readFileBuffer(fileBuffer, &line)) {
+    while (readTextLine(text, &line, NULL)) {
         lineno++;
 
         char key[CONFIG_KEY_NAME_LEN], val[CONFIG_KEY_VALUE_LEN];
@@ -509,39 +509,47 @@ static int configReadFileBuffer(file_buffer_t *fileBuffer, config_set_t *configS
 
 int configReadBuffer(config_set_t *configSet, const void *buffer, int size)
 {
+    text_buffer_t text;
+    char *copy;
     int ret;
-    file_buffer_t *fileBuffer = openFileBufferBuffer(0, buffer, size);
-    if (!fileBuffer) {
+
+    // The lines are split in place, so work on a copy.
+    copy = (char *)malloc(size + 1);
+    if (!copy) {
         configSet->modified = 0;
         return 0;
     }
+    memcpy(copy, buffer, size);
+    copy[size] = '\0';
+    openTextBufferBuffer(&text, copy, size);
 
-    ret = configReadFileBuffer(fileBuffer, configSet);
+    ret = configReadTextBuffer(&text, configSet);
 
-    closeFileBuffer(fileBuffer);
+    closeTextBuffer(&text);
     return ret;
 }
 
 int configRead(config_set_t *configSet)
 {
+    text_buffer_t text;
     int ret;
-    file_buffer_t *fileBuffer = openFileBuffer(configSet->filename, O_RDONLY, 0, 4096);
-    if (!fileBuffer) {
+
+    if (!openTextBuffer(&text, configSet->filename)) {
         LOG("CONFIG No file %s.\n", configSet->filename);
         configSet->modified = 0;
         return 0;
     }
 
-    ret = configReadFileBuffer(fileBuffer, configSet);
+    ret = configReadTextBuffer(&text, configSet);
 
-    closeFileBuffer(fileBuffer);
+    closeTextBuffer(&text);
     return ret;
 }
 
 int configWrite(config_set_t *configSet)
 {
     if (configSet->modified) {
-        file_buffer_t *fileBuffer = openFileBuffer(configSet->filename, O_WRONLY | O_CREAT | O_TRUNC, 0, 4096);
+        file_buffer_t *fileBuffer = openFileBuffer(configSet->filename, O_WRONLY | O_CREAT | O_TRUNC, 4096);
         if (fileBuffer) {
             char line[512];
 
@@ -701,6 +701,11 @@ static void ethLaunchGame(item_list_t *itemList, int id, config_set_t *configSet
     }
     settings->common.layer1_start = layer1_start;
 
+#ifdef __IO_TRACE
+    if ((result = sbCreateIoTrace(game, ethPrefix, "\\")) >= 0)
+        close(result);
+#endif
+
     if (configGetStrCopy(configSet, CONFIG_ITEM_ALTSTARTUP, filename, sizeof(filename)) == 0)
         strcpy(filename, game->startup);
     deinit(NO_EXCEPTION, ETH_MODE); // CAREFUL: deinit will call ethCleanUp, so ethGames/game will be freed
@@ -11,6 +11,7 @@
 #include "include/utf8.h"
 #include "include/util.h"
 #include "include/atlas.h"
+#include "include/gui.h"
 
 #include <sys/types.h>
 #include <ft2build.h>
@@ -38,7 +39,7 @@ static GSCLUT fontClut;
 static const float fDPI = 72.0f;
 
 /** Single entry in the glyph cache */
-typedef struct
+typedef struct fnt_glyph_cache_entry
 {
     int isValid;
     // size in pixels of the glyph
@@ -54,6 +55,10 @@ typedef struct
     // atlas allocation position
     struct atlas_allocation_t *allocation;
 
+    // frame the glyph was last rendered in
+    int lastUsed;
+    // neighbours in the font's LRU list of glyphs placed in the atlases
+    struct fnt_glyph_cache_entry *lruPrev, *lruNext;
 } fnt_glyph_cache_entry_t;
 
 /** A whole font definition */
@@ -79,6 +84,9 @@ typedef struct
     /// Texture atlases (default to NULL)
     atlas_t *atlases[ATLAS_MAX];
 
+    /// Glyphs placed in the atlases, most recently used first. Evicted from the tail when the atlases are full
+    fnt_glyph_cache_entry_t *lruHead, *lruTail;
+
     /// Pointer to data, if allocation takeover was selected (will be freed)
     void *dataPtr;
 } font_t;
@@ -88,7 +96,68 @@ typedef struct
 /// Array of font definitions
 static font_t fonts[FNT_MAX_COUNT];
 
-static rm_quad_t quad;
+/// Maximal count of glyphs gathered per atlas before they are queued for rendering
+#define FNT_BATCH_MAX 128
+
+/** Glyphs of one string that share an atlas, queued as a single sprite list */
+typedef struct
+{
+    /// Atlas surface of the gathered glyphs (NULL if the batch is unused)
+    GSTEXTURE *txt;
+    /// Count of gathered glyphs
+    int count;
+    /// Upper left and bottom right corners of the gathered glyphs
+    rm_tx_coord_t coords[FNT_BATCH_MAX * 2];
+} fnt_glyph_batch_t;
+
+static fnt_glyph_batch_t glyphBatches[ATLAS_MAX];
+static font_t *batchFont;
+static u64 batchColour;
+
+/// Count of laid out strings kept in the layout cache
+#define FNT_LAYOUT_CACHE_SIZE 32
+/// Maximal count of glyphs in a cached layout - longer strings are laid out every time
+#define FNT_LAYOUT_MAX_GLYPHS 128
+/// Maximal length of a cached string, in bytes
+#define FNT_LAYOUT_MAX_TEXT 127
+
+/** Glyph placement, relative to the (scaled) position the string was rendered at */
+typedef struct
+{
+    fnt_glyph_cache_entry_t *glyph;
+    short x, y;
+} fnt_layout_glyph_t;
+
+/** A laid out string. Only the placed glyphs are stored, so rendering it again is just a replay */
+typedef struct
+{
+    int id;
+    short aligned;
+    size_t width, height;
+    /// Native display extents and pixel aspect ratio the string was laid out for
+    int screenWidth, screenHeight;
+    float par;
+    u32 hash;
+    size_t length;
+    /// Pen advance after the last glyph
+    int advance;
+    /// Layout use stamp, for LRU replacement (0 = unused entry)
+    u32 lastUsed;
+    int count;
+    /// Copy of the string
+    char text[FNT_LAYOUT_MAX_TEXT + 1];
+    fnt_layout_glyph_t glyphs[FNT_LAYOUT_MAX_GLYPHS];
+} fnt_layout_t;
+
+/// Fixed pool, so that caching a layout never calls malloc
+static fnt_layout_t layoutCache[FNT_LAYOUT_CACHE_SIZE];
+static u32 layoutStamp;
+
+// Layout being recorded by the current fntRenderString call
+static int layoutRecording;
+static int layoutX, layoutY, layoutCount;
+static fnt_layout_glyph_t layoutGlyphs[FNT_LAYOUT_MAX_GLYPHS];
+
 static uint32_t codepoint, state;
 static fnt_glyph_cache_entry_t *glyph;
 static FT_Bool use_kerning;
@@ -99,6 +168,87 @@ static FT_Vector delta;
 
 #define GLYPH_PAGE_OK(font, page) ((pageid <= font->cacheMaxPageID) && (font->glyphCache[page]))
 
+static void fntFlushBatch(fnt_glyph_batch_t *batch)
+{
+    if (batch->count > 0) {
+        rmDrawQuadList(batch->txt, batchColour, batch->count, batch->coords);
+        batch->count = 0;
+    }
+}
+
+/** Drops all the cached layouts, as they point into the glyph caches */
+static void fntLayoutInvalidate(void)
+{
+    int i;
+
+    for (i = 0; i < FNT_LAYOUT_CACHE_SIZE; i++)
+        layoutCache[i].lastUsed = 0;
+}
+
+static u32 fntLayoutHash(const char *string, size_t *length)
+{
+    const char *str = string;
+    u32 hash = 2166136261u; // FNV-1a
+
+    for (; *str; ++str)
+        hash = (hash ^ (u8)*str) * 16777619u;
+
+    *length = str - string;
+    return hash;
+}
+
+static fnt_layout_t *fntLayoutFind(int id, short aligned, size_t width, size_t height, const char *string, u32 hash, size_t length)
+{
+    int i, screenWidth, screenHeight;
+    float par;
+
+    rmGetScreenExtentsNative(&screenWidth, &screenHeight);
+    par = rmGetPAR();
+
+    for (i = 0; i < FNT_LAYOUT_CACHE_SIZE; i++) {
+        fnt_layout_t *layout = &layoutCache[i];
+
+        if (layout->lastUsed && layout->hash == hash && layout->length == length && layout->id == id && layout->aligned == aligned &&
+            layout->width == width && layout->height == height && layout->screenWidth == screenWidth && layout->screenHeight == screenHeight &&
+            layout->par == par && !strcmp(layout->text, string)) {
+            layout->lastUsed = ++layoutStamp;
+            return layout;
+        }
+    }
+
+    return NULL;
+}
+
+static void fntLayoutStore(int id, short aligned, size_t width, size_t height, const char *string, u32 hash, size_t length, int advance)
+{
+    fnt_layout_t *layout = &layoutCache[0];
+    int i;
+
+    if (length > FNT_LAYOUT_MAX_TEXT)
+        return;
+
+    // take an unused entry, or replace the least recently used one
+    for (i = 1; i < FNT_LAYOUT_CACHE_SIZE && layout->lastUsed; i++) {
+        if (layoutCache[i].lastUsed < layout->lastUsed)
+            layout = &layoutCache[i];
+    }
+
+    memcpy(layout->text, string, length + 1);
+    memcpy(layout->glyphs, layoutGlyphs, layoutCount * sizeof(fnt_layout_glyph_t));
+
+    layout->id = id;
+    layout->aligned = aligned;
+    layout->width = width;
+    layout->height = height;
+    rmGetScreenExtentsNative(&layout->screenWidth, &layout->screenHeight);
+    layout->par = rmGetPAR();
+    layout->hash = hash;
+    layout->length = length;
+    layout->advance = advance;
+    layout->count = layoutCount;
+    layout->lastUsed = ++layoutStamp;
+}
+
 static void fntCacheFlushPage(fnt_glyph_cache_entry_t *page)
 {
     int i;
@@ -115,6 +265,9 @@ static void fntCacheFlush(font_t *font)
 {
     // Release all the glyphs from the cache
     int i;
+
+    fntLayoutInvalidate();
+
     for (i = 0; i <= font->cacheMaxPageID; ++i) {
         if (font->glyphCache[i]) {
             fntCacheFlushPage(font->glyphCache[i]);
@@ -126,6 +279,8 @@ static void fntCacheFlush(font_t *font)
     free(font->glyphCache);
     font->glyphCache = NULL;
     font->cacheMaxPageID = -1;
+    font->lruHead = NULL;
+    font->lruTail = NULL;
 
     // free all atlasses too, they're invalid now anyway
     int aid;
@@ -164,6 +319,8 @@ static int fntPrepareGlyphCachePage(font_t *font, int pageid)
         font->glyphCache[pageid][i].isValid = 0;
         font->glyphCache[pageid][i].atlas = NULL;
         font->glyphCache[pageid][i].allocation = NULL;
+        font->glyphCache[pageid][i].lruPrev = NULL;
+        font->glyphCache[pageid][i].lruNext = NULL;
     }
 
     return 1;
@@ -201,6 +358,8 @@ static void fntInitSlot(font_t *font)
     font->dataPtr = NULL;
     font->isValid = 0;
     font->fontSize = 0;
+    font->lruHead = NULL;
+    font->lruTail = NULL;
 
     int aid = 0;
     for (; aid < ATLAS_MAX; ++aid)
@@ -352,6 +511,67 @@ static atlas_t *fntNewAtlas()
     return atl;
 }
 
+static void fntLruUnlink(font_t *font, fnt_glyph_cache_entry_t *glyph)
+{
+    if (glyph->lruPrev)
+        glyph->lruPrev->lruNext = glyph->lruNext;
+    else
+        font->lruHead = glyph->lruNext;
+
+    if (glyph->lruNext)
+        glyph->lruNext->lruPrev = glyph->lruPrev;
+    else
+        font->lruTail = glyph->lruPrev;
+
+    glyph->lruPrev = NULL;
+    glyph->lruNext = NULL;
+}
+
+static void fntLruPushFront(font_t *font, fnt_glyph_cache_entry_t *glyph)
+{
+    glyph->lruPrev = NULL;
+    glyph->lruNext = font->lruHead;
+
+    if (font->lruHead)
+        font->lruHead->lruPrev = glyph;
+    else
+        font->lruTail = glyph;
+
+    font->lruHead = glyph;
+}
+
+/** Marks a placed glyph as used in this frame */
+static void fntGlyphTouch(font_t *font, fnt_glyph_cache_entry_t *glyph)
+{
+    glyph->lastUsed = guiFrameId;
+
+    if (font->lruHead != glyph) {
+        fntLruUnlink(font, glyph);
+        fntLruPushFront(font, glyph);
+    }
+}
+
+/** Releases the atlas space of the least recently used glyph.
+ * @return 0 if there is no glyph that can be evicted */
+static int fntEvictGlyph(font_t *font)
+{
+    fnt_glyph_cache_entry_t *glyph = font->lruTail;
+
+    // glyphs rendered in this frame are still referenced by the queued GS packets
+    if (!glyph || glyph->lastUsed == guiFrameId)
+        return 0;
+
+    fntLruUnlink(font, glyph);
+    atlasRelease(glyph->atlas, glyph->allocation);
+
+    // it will be rendered and placed again on the next use
+    glyph->isValid = 0;
+    glyph->allocation = NULL;
+    glyph->atlas = NULL;
+
+    return 1;
+}
+
 static int fntGlyphAtlasPlace(font_t *font, fnt_glyph_cache_entry_t *glyph)
 {
     FT_GlyphSlot slot = font->face->glyph;
@@ -381,7 +601,28 @@ static int fntGlyphAtlasPlace(font_t *font, fnt_glyph_cache_entry_t *glyph)
         }
     }
 
-    LOG("FNTSYS No atlas free\n", aid);
+    // All atlases are full. Evict the least recently used glyphs until the new one fits
+    int evicted = 0;
+    while (!glyph->allocation && fntEvictGlyph(font)) {
+        evicted++;
+
+        for (aid = 0; aid < ATLAS_MAX; aid++) {
+            glyph->allocation = atlasPlace(font->atlases[aid], slot->bitmap.width, slot->bitmap.rows, slot->bitmap.buffer);
+            if (glyph->allocation) {
+                glyph->atlas = font->atlases[aid];
+                break;
+            }
+        }
+    }
+
+    // cached layouts may refer to the evicted glyphs
+    if (evicted)
+        fntLayoutInvalidate();
+
+    if (glyph->allocation)
+        return 1;
+
+    LOG("FNTSYS No atlas free\n");
     return 0;
 }
 
@@ -430,6 +671,11 @@ static fnt_glyph_cache_entry_t *fntCacheGlyph(font_t *font, uint32_t gid)
     glyph->ox = slot->bitmap_left;
     glyph->oy = -slot->bitmap_top;
 
+    if (glyph->allocation) {
+        glyph->lastUsed = guiFrameId;
+        fntLruPushFront(font, glyph);
+    }
+
     glyph->isValid = 1;
 
     return glyph;
@@ -466,52 +712,77 @@ static void fntRenderGlyph(fnt_glyph_cache_entry_t *glyph, int pen_x, int pen_y)
 {
     // only if glyph has atlas placement
     if (glyph->allocation) {
-        /* TODO: Ineffective on many parts:
-         * 1. Usage of floats for UV - fixed point should suffice (and is used internally by GS for UV)
-         *
-         * 2. GS_SETREG_TEX0 for every quad - why? gsKit should only set texture if demanded
-         *    We should prepare a special fnt render method that would step over most of the
-         *    performance problems under - beginning with rmSetupQuad and continuing into gsKit
-         *    - this method would handle the preparation of the quads and GS upload itself,
-         *    without the use of prim_quad_texture and rmSetupQuad...
-         */
-        quad.ul.x = pen_x + glyph->ox;
+        fnt_glyph_batch_t *batch = NULL;
+        int i;
+
+        fntGlyphTouch(batchFont, glyph);
+
+        if (layoutRecording) {
+            if (layoutCount < FNT_LAYOUT_MAX_GLYPHS) {
+                layoutGlyphs[layoutCount].glyph = glyph;
+                layoutGlyphs[layoutCount].x = pen_x - layoutX;
+                layoutGlyphs[layoutCount].y = pen_y - layoutY;
+            }
+            layoutCount++;
+        }
+
+        // glyphs are grouped per atlas, so that the texture is only set once per string
+        for (i = 0; i < ATLAS_MAX; i++) {
+            if (glyphBatches[i].txt == &glyph->atlas->surface) {
+                batch = &glyphBatches[i];
+                break;
+            }
+            if (!batch && !glyphBatches[i].txt)
+                batch = &glyphBatches[i];
+        }
+
+        if (!batch)
+            return;
+
+        if (batch->count == FNT_BATCH_MAX)
+            fntFlushBatch(batch);
+
+        batch->txt = &glyph->atlas->surface;
+
+        rm_tx_coord_t *ul = &batch->coords[batch->count * 2];
+        rm_tx_coord_t *br = ul + 1;
+
+        ul->x = pen_x + glyph->ox;
         if (rmGetInterlacedFrameMode() == 0)
-            quad.ul.y = pen_y + glyph->oy;
+            ul->y = pen_y + glyph->oy;
         else
-            quad.ul.y = (float)pen_y + ((float)glyph->oy / 2.0f);
-        quad.ul.u = glyph->allocation->x;
-        quad.ul.v = glyph->allocation->y;
+            ul->y = (float)pen_y + ((float)glyph->oy / 2.0f);
+        ul->u = glyph->allocation->x;
+        ul->v = glyph->allocation->y;
 
-        quad.br.x = quad.ul.x + glyph->width;
+        br->x = ul->x + glyph->width;
         if (rmGetInterlacedFrameMode() == 0)
-            quad.br.y = quad.ul.y + glyph->height;
+            br->y = ul->y + glyph->height;
         else
-            quad.br.y = quad.ul.y + ((float)glyph->height / 2.0f);
-        quad.br.u = quad.ul.u + glyph->width;
-        quad.br.v = quad.ul.v + glyph->height;
-
-        quad.txt = &glyph->atlas->surface;
+            br->y = ul->y + ((float)glyph->height / 2.0f);
+        br->u = ul->u + glyph->width;
+        br->v = ul->v + glyph->height;
 
-        rmDrawQuad(&quad);
+        batch->count++;
     }
 }
 
-
-#ifndef __RTL
-int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t height, const char *string, u64 colour)
+/** Queues all the glyphs gathered since the last flush, one sprite list per atlas */
+static void fntFlushGlyphs(void)
 {
-    // wait for font lock to unlock
-    WaitSema(gFontSemaId);
-    font_t *font = &fonts[id];
-    SignalSema(gFontSemaId);
+    int i;
 
-    // Convert to native display resolution
-    x = rmScaleX(x);
-    y = rmScaleY(y);
-    width = rmScaleX(width);
-    height = rmScaleY(height);
+    for (i = 0; i < ATLAS_MAX; i++) {
+        fntFlushBatch(&glyphBatches[i]);
+        glyphBatches[i].txt = NULL;
+    }
+}
 
+#ifndef __RTL
+/** Lays out the string at the given native position, queueing the glyphs for rendering.
+ * @return The pen position after the last glyph */
+static int fntLayoutString(font_t *font, int id, int x, int y, short aligned, size_t width, size_t height, const char *string)
+{
     if (aligned & ALIGN_HCENTER) {
         if (width) {
             x -= min(fntCalcDimensions(id, string), width) >> 1;
@@ -526,8 +797,6 @@ int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t he
         y += rmScaleY(fonts[id].fontSize - 2);
     }
 
-    quad.color = colour;
-
     int pen_x = x;
     int xmax = x + width;
     int ymax = y + height;
@@ -538,10 +807,7 @@ int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t he
 
     // Note: We need to change this so that we'll accumulate whole word before doing a layout with it
     // for now this method breaks on any character - which is a bit ugly
-
-    // I don't want to do anything complicated though so I'd say
-    // we should instead have a dynamic layout routine that'll replace spaces with newlines as appropriate
-    // because that'll make the code run only once per N frames, not every frame
+    // The result is cached by fntRenderString, so this only runs again when the text or the box changes
 
     // cache glyphs and render as we go
     for (; *string; ++string) {
@@ -582,7 +848,7 @@ int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t he
         pen_x += glyph->shx >> 6;
     }
 
-    return rmUnScaleX(pen_x);
+    return pen_x;
 }
 
 #else
@@ -625,19 +891,8 @@ static void fntRenderSubRTL(font_t *font, const char *startRTL, const char *stri
     }
 }
 
-int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t height, const char *string, u64 colour)
+static int fntLayoutString(font_t *font, int id, int x, int y, short aligned, size_t width, size_t height, const char *string)
 {
-    // wait for font lock to unlock
-    WaitSema(gFontSemaId);
-    font_t *font = &fonts[id];
-    SignalSema(gFontSemaId);
-
-    // Convert to native display resolution
-    x = rmScaleX(x);
-    y = rmScaleY(y);
-    width = rmScaleX(width);
-    height = rmScaleY(height);
-
     if (aligned & ALIGN_HCENTER) {
         if (width) {
             x -= min(fntCalcDimensions(id, string), width) >> 1;
@@ -652,8 +907,6 @@ int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t he
         y += rmScaleY(fonts[id].fontSize - 2);
     }
 
-    quad.color = colour;
-
     int pen_x = x;
     int xmax = x + width;
     int ymax = y + height;
@@ -728,10 +981,56 @@ int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t he
         fntRenderSubRTL(font, startRTL, string, glyphRTL, pen_xRTL, y);
     }
 
-    return rmUnScaleX(pen_x);
+    return pen_x;
 }
 #endif
 
+int fntRenderString(int id, int x, int y, short aligned, size_t width, size_t height, const char *string, u64 colour)
+{
+    fnt_layout_t *layout;
+    size_t length;
+    int pen_x, i;
+
+    // wait for font lock to unlock
+    WaitSema(gFontSemaId);
+    font_t *font = &fonts[id];
+    SignalSema(gFontSemaId);
+
+    // Convert to native display resolution
+    x = rmScaleX(x);
+    y = rmScaleY(y);
+    width = rmScaleX(width);
+    height = rmScaleY(height);
+
+    batchFont = font;
+    batchColour = colour;
+
+    // Static text is laid out once, then only the placed glyphs are replayed
+    u32 hash = fntLayoutHash(string, &length);
+    layout = fntLayoutFind(id, aligned, width, height, string, hash, length);
+    if (layout) {
+        for (i = 0; i < layout->count; i++)
+            fntRenderGlyph(layout->glyphs[i].glyph, x + layout->glyphs[i].x, y + layout->glyphs[i].y);
+
+        pen_x = x + layout->advance;
+    } else {
+        layoutRecording = 1;
+        layoutX = x;
+        layoutY = y;
+        layoutCount = 0;
+
+        pen_x = fntLayoutString(font, id, x, y, aligned, width, height, string);
+
+        layoutRecording = 0;
+        if (layoutCount <= FNT_LAYOUT_MAX_GLYPHS)
+            fntLayoutStore(id, aligned, width, height, string, hash, length, pen_x - x);
+    }
+
+    fntFlushGlyphs();
+
+    return rmUnScaleX(pen_x);
+}
+
 void fntFitString(int id, char *string, size_t width)
 {
     size_t cw = 0;
@@ -0,0 +1,284 @@
+#include "include/opl.h"
+#include "include/gameindex.h"
+#include "include/ioman.h"
+
+#define GAME_INDEX_BUCKETS 256
+
+static game_entry_t *gIndexBuckets[GAME_INDEX_BUCKETS];
+static game_location_t *gIndexFirst; // All the locations, sorted by name
+static unsigned int gIndexScan;
+
+static unsigned int gameIndexHash(const char *startup)
+{
+    unsigned int hash = 5381;
+
+    while (*startup != '\0')
+        hash = hash * 33 + (unsigned char)*startup++;
+
+    return hash % GAME_INDEX_BUCKETS;
+}
+
+static game_entry_t *gameIndexFind(const char *startup)
+{
+    game_entry_t *entry;
+
+    for (entry = gIndexBuckets[gameIndexHash(startup)]; entry != NULL; entry = entry->nextInBucket) {
+        if (!strcmp(entry->startup, startup))
+            return entry;
+    }
+
+    return NULL;
+}
+
+static game_entry_t *gameIndexAddEntry(const char *startup)
+{
+    game_entry_t *entry;
+    unsigned int bucket = gameIndexHash(startup);
+
+    if ((entry = (game_entry_t *)malloc(sizeof(game_entry_t))) == NULL)
+        return NULL;
+
+    if ((entry->startup = strdup(startup)) == NULL) {
+        free(entry);
+        return NULL;
+    }
+    entry->devices = 0;
+    entry->locations = NULL;
+
+    entry->nextInBucket = gIndexBuckets[bucket];
+    gIndexBuckets[bucket] = entry;
+
+    return entry;
+}
+
+static void gameIndexRemoveEntry(game_entry_t *entry)
+{
+    game_entry_t **link = &gIndexBuckets[gameIndexHash(entry->startup)];
+
+    while (*link != entry)
+        link = &(*link)->nextInBucket;
+    *link = entry->nextInBucket;
+
+    free(entry->startup);
+    free(entry);
+}
+
+static void gameIndexUnlink(game_location_t *location)
+{
+    if (location->prev)
+        location->prev->next = location->next;
+    else
+        gIndexFirst = location->next;
+
+    if (location->next)
+        location->next->prev = location->prev;
+
+    location->prev = NULL;
+    location->next = NULL;
+}
+
+static void gameIndexDeleteLocation(game_location_t *location)
+{
+    game_entry_t *entry = location->entry;
+    game_location_t **link, *other;
+
+    gameIndexUnlink(location);
+
+    for (link = &entry->locations; *link != location; link = &(*link)->nextOnEntry)
+        ;
+    *link = location->nextOnEntry;
+
+    entry->devices = 0;
+    for (other = entry->locations; other != NULL; other = other->nextOnEntry)
+        entry->devices |= 1 << other->mode;
+
+    if (!entry->locations)
+        gameIndexRemoveEntry(entry);
+
+    free(location->name);
+    free(location);
+}
+
+/* Finds the location a game of the device had in the previous scans: the copy with the same name first,
+   then any copy not found yet in this scan, which was renamed. */
+static game_location_t *gameIndexMatch(game_entry_t *entry, short int mode, const char *name, unsigned int scan)
+{
+    game_location_t *location;
+
+    for (location = entry->locations; location != NULL; location = location->nextOnEntry) {
+        if (location->mode == mode && location->seen != scan && !strcmp(location->name, name))
+            return location;
+    }
+
+    for (location = entry->locations; location != NULL; location = location->nextOnEntry) {
+        if (location->mode == mode && location->seen != scan)
+            return location;
+    }
+
+    return NULL;
+}
+
+static int gameIndexCompare(const void *a, const void *b)
+{
+    const game_location_t *first = *(const game_location_t **)a;
+    const game_location_t *second = *(const game_location_t **)b;
+    int cmp;
+
+    if ((cmp = strcasecmp(first->name, second->name)) == 0)
+        cmp = first->id - second->id;
+
+    return cmp;
+}
+
+// Sorts the new locations, then merges them into the sorted list in a single pass.
+static void gameIndexInsert(game_location_t **locations, int count)
+{
+    game_location_t *prev = NULL, *next = gIndexFirst;
+    int i;
+
+    if (count == 0)
+        return;
+
+    qsort(locations, count, sizeof(game_location_t *), &gameIndexCompare);
+
+    for (i = 0; i < count; i++) {
+        game_location_t *location = locations[i];
+
+        while (next != NULL && strcasecmp(next->name, location->name) <= 0) {
+            prev = next;
+            next = next->next;
+        }
+
+        location->prev = prev;
+        location->next = next;
+        if (prev)
+            prev->next = location;
+        else
+            gIndexFirst = location;
+        if (next)
+            next->prev = location;
+
+        prev = location;
+    }
+}
+
+int gameIndexUpdate(item_list_t *support, int count)
+{
+    game_location_t **pending, *location, *next;
+    game_entry_t *entry;
+    short int mode = support->mode;
+    unsigned int scan = ++gIndexScan;
+    int i, pendingCount = 0, changes = 0;
+
+    pending = count > 0 ? (game_location_t **)malloc(count * sizeof(game_location_t *)) : NULL;
+    if (count > 0 && pending == NULL) {
+        gameIndexRemoveDevice(mode);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        char *startup = support->itemGetStartup(support, i);
+        char *name = support->itemGetName(support, i);
+
+        if ((entry = gameIndexFind(startup)) == NULL && (entry = gameIndexAddEntry(startup)) == NULL)
+            break;
+
+        if ((location = gameIndexMatch(entry, mode, name, scan)) != NULL) {
+            if (location->id != i) {
+                location->id = i;
+                changes |= GAME_INDEX_MOVED;
+            }
+
+            if (strcmp(location->name, name)) {
+                char *newName = strdup(name);
+                if (newName == NULL)
+                    break;
+
+                // Sorted again with the new games
+                gameIndexUnlink(location);
+                free(location->name);
+                location->name = newName;
+                pending[pendingCount++] = location;
+                changes |= GAME_INDEX_RENAMED;
+            }
+        } else {
+            if ((location = (game_location_t *)malloc(sizeof(game_location_t))) == NULL || (location->name = strdup(name)) == NULL) {
+                free(location);
+                // A game just added to the index, that has no location to be removed with
+                if (entry->locations == NULL)
+                    gameIndexRemoveEntry(entry);
+                break;
+            }
+            location->entry = entry;
+            location->mode = mode;
+            location->id = i;
+            location->prev = NULL;
+            location->next = NULL;
+
+            if (entry->devices & ~(1 << mode))
+                LOG("GAMEINDEX %s is also on devices 0x%x\n", entry->startup, entry->devices & ~(1 << mode));
+
+            location->nextOnEntry = entry->locations;
+            entry->locations = location;
+            entry->devices |= 1 << mode;
+
+            pending[pendingCount++] = location;
+            changes |= GAME_INDEX_ADDED;
+        }
+
+        location->seen = scan;
+    }
+
+    if (i < count) {
+        // Out of memory: drop the device, its page is built without the index.
+        gameIndexInsert(pending, pendingCount);
+        free(pending);
+        gameIndexRemoveDevice(mode);
+        return -1;
+    }
+
+    for (location = gIndexFirst; location != NULL; location = next) {
+        next = location->next;
+
+        if (location->mode == mode && location->seen != scan) {
+            gameIndexDeleteLocation(location);
+            changes |= GAME_INDEX_REMOVED;
+        }
+    }
+
+    gameIndexInsert(pending, pendingCount);
+    free(pending);
+
+    LOG("GAMEINDEX Mode %d: %d games, changes 0x%x\n", mode, count, changes);
+
+    return changes;
+}
+
+void gameIndexRemoveDevice(int mode)
+{
+    game_location_t *location, *next;
+
+    for (location = gIndexFirst; location != NULL; location = next) {
+        next = location->next;
+
+        if (location->mode == mode)
+            gameIndexDeleteLocation(location);
+    }
+}
+
+unsigned int gameIndexGetDevices(const char *startup)
+{
+    game_entry_t *entry = gameIndexFind(startup);
+
+    return entry != NULL ? entry->devices : 0;
+}
+
+game_location_t *gameIndexNext(game_location_t *location, int mode)
+{
+    location = location != NULL ? location->next : gIndexFirst;
+
+    while (location != NULL && location->mode != mode)
+        location = location->next;
+
+    return location;
+}
@@ -22,6 +22,7 @@
 #include "include/cheatman.h"
 #include "include/sound.h"
 #include "include/guigame.h"
+#include "include/guiprof.h"
 
 #include <limits.h>
 #include <stdlib.h>
@@ -60,6 +61,12 @@ static clock_t prevtime = 0;
 static clock_t curtime = 0;
 static float fps = 0.0f;
 
+// and the time spent building each frame, before waiting for the GS and vsync
+static u32 frameBuildStart;
+static float frameBuildTime = 0.0f;
+static float frameGSWait = 0.0f;
+static float frameVSyncWait = 0.0f;
+
 extern GSGLOBAL *gsGlobal;
 #endif
 
@@ -183,17 +190,30 @@ void guiUnlock(void)
 void guiStartFrame(void)
 {
     guiLock();
+#ifdef __DEBUG
+    frameBuildStart = cpu_ticks();
+#endif
     rmStartFrame();
     guiFrameId++;
 }
 
 void guiEndFrame(void)
 {
+#ifdef __DEBUG
+    float rawBuildTime = (float)(cpu_ticks() - frameBuildStart) / CPU_TICKS_PER_MSEC;
+
+    frameBuildTime = frameBuildTime * 0.9f + rawBuildTime / 10.0f; // Smooth frame time value
+#endif
     rmEndFrame();
 #ifdef __DEBUG
     // Measure time directly after vsync
     prevtime = curtime;
     curtime = clock();
+
+    rm_frame_pacing_t pacing;
+    rmGetFramePacing(&pacing);
+    frameGSWait = frameGSWait * 0.9f + (float)pacing.gsWait / CPU_TICKS_PER_MSEC / 10.0f;
+    frameVSyncWait = frameVSyncWait * 0.9f + (float)pacing.vsyncWait / CPU_TICKS_PER_MSEC / 10.0f;
 #endif
     guiUnlock();
 }
@@ -1283,6 +1303,7 @@ void guiDrawBGPlasma()
             dir = -dir;
     }
 
+    // Not waiting for the GS here: a frame that is still being drawn might get some of the new rows, which does not show.
     u32 *buf = gBackgroundTex.Mem + PLASMA_W * pery;
     int ymax = pery + PLASMA_ROWS_PER_FRAME;
 
@@ -1412,6 +1433,8 @@ static void guiDrawOverlays()
     if (busyAlpha > 0x00)
         guiDrawBusy(busyAlpha);
 
+    guiProfDrawHud();
+
 #ifdef __DEBUG
     char text[20];
     int x = screenWidth - 120;
@@ -1448,6 +1471,24 @@ static void guiDrawOverlays()
         fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, text, GS_SETREG_RGBA(0x60, 0x60, 0x60, 0x80));
         y += yadd;
     }
+
+    snprintf(text, sizeof(text), "%.2fms BUILD", frameBuildTime);
+    fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, text, GS_SETREG_RGBA(0x60, 0x60, 0x60, 0x80));
+    y += yadd;
+
+    snprintf(text, sizeof(text), "%.2fms GS %.2fms VSYNC", frameGSWait, frameVSyncWait);
+    fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, text, GS_SETREG_RGBA(0x60, 0x60, 0x60, 0x80));
+    y += yadd;
+
+    if (isBgmPlaying()) {
+        int depth, minDepth, underruns;
+
+        // BGM ring buffer: filled parts now / at worst, and underruns
+        bgmGetRingStats(&depth, &minDepth, &underruns);
+        snprintf(text, sizeof(text), "BGM %d/%d %dU", depth, minDepth, underruns);
+        fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, text, GS_SETREG_RGBA(0x60, 0x60, 0x60, 0x80));
+        y += yadd;
+    }
 #endif
 
     // Last Played Auto Start
@@ -1476,6 +1517,8 @@ static void guiReadPads()
         guiInactiveFrames = 0;
     else
         guiInactiveFrames++;
+
+    guiProfHandleInput();
 }
 
 // renders the screen and handles inputs. Also handles screen transitions between numerous
@@ -1568,24 +1611,33 @@ void guiMainLoop(void)
         bgmStart();
 
     while (!gTerminate) {
+        guiProfStartFrame();
+
         guiStartFrame();
+        guiProfMark(GPROF_START);
 
         // Read the pad states to prepare for input processing in the screen handler
         guiReadPads();
+        guiProfMark(GPROF_PADS);
 
         // handle inputs and render screen
         guiShow();
+        guiProfMark(GPROF_RENDER);
 
         // Render overlaying gui thingies :)
         guiDrawOverlays();
+        guiProfMark(GPROF_OVERLAYS);
 
         if (gEnableNotifications)
             guiShowNotifications();
+        guiProfMark(GPROF_NOTIFICATIONS);
 
         // handle deferred operations
         guiHandleDeferredOps();
+        guiProfMark(GPROF_DEFERRED);
 
         guiEndFrame();
+        guiProfMarkEndFrame();
 
         // if not transiting, handle input
         // done here so we can use renderman if needed
@@ -1594,6 +1646,7 @@ void guiMainLoop(void)
 
         if (gFrameHook)
             gFrameHook();
+        guiProfMark(GPROF_INPUT);
     }
 }
 
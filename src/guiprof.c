@@ -0,0 +1,173 @@
+#include "include/opl.h"
+#include "include/guiprof.h"
+#include "include/renderman.h"
+#include "include/fntsys.h"
+#include "include/themes.h"
+#include "include/config.h"
+#include "include/pad.h"
+
+#include <stdio.h>
+
+struct gprof_frame_t
+{
+    u32 frame;
+    u32 ticks[GPROF_COUNT];
+};
+
+static const char *gprofPhaseNames[GPROF_COUNT] = {"start", "pads", "render", "overlays", "notify", "deferred", "submit", "gswait", "vsync", "input"};
+
+static struct gprof_frame_t gprofHistory[GPROF_HISTORY];
+static struct gprof_frame_t gprofCurrent;
+static int gprofHead;  // Next record to write
+static int gprofCount; // Valid records
+static u32 gprofLastMark;
+static int gprofActive;
+static int gprofHudEnabled;
+
+void guiProfStartFrame(void)
+{
+    if (gprofActive) {
+        gprofHistory[gprofHead] = gprofCurrent;
+        gprofHead = (gprofHead + 1) % GPROF_HISTORY;
+        if (gprofCount < GPROF_HISTORY)
+            gprofCount++;
+    }
+
+    memset(gprofCurrent.ticks, 0, sizeof(gprofCurrent.ticks));
+    gprofCurrent.frame++;
+    gprofActive = 1;
+    gprofLastMark = cpu_ticks();
+}
+
+void guiProfMark(int phase)
+{
+    u32 now = cpu_ticks();
+
+    gprofCurrent.ticks[phase] += now - gprofLastMark;
+    gprofLastMark = now;
+}
+
+void guiProfMarkEndFrame(void)
+{
+    rm_frame_pacing_t pacing;
+    u32 now = cpu_ticks();
+    u32 elapsed = now - gprofLastMark;
+
+    rmGetFramePacing(&pacing);
+    if (pacing.gsWait + pacing.vsyncWait <= elapsed) {
+        gprofCurrent.ticks[GPROF_GS_WAIT] += pacing.gsWait;
+        gprofCurrent.ticks[GPROF_VSYNC_WAIT] += pacing.vsyncWait;
+        elapsed -= pacing.gsWait + pacing.vsyncWait;
+    }
+    gprofCurrent.ticks[GPROF_SUBMIT] += elapsed;
+    gprofLastMark = now;
+}
+
+static unsigned int guiProfTicksToUsec(u32 ticks)
+{
+    return (unsigned int)(((u64)ticks * 1000) / CPU_TICKS_PER_MSEC);
+}
+
+static void guiProfDumpCSV(void)
+{
+    char path[256];
+    FILE *file;
+    u32 total;
+    int i, j, index;
+
+    snprintf(path, sizeof(path), "%s/%s", configGetDir(), GPROF_CSV_FILE);
+
+    file = fopen(path, "w");
+    if (file == NULL) {
+        LOG("GUIPROF Unable to create %s\n", path);
+        return;
+    }
+
+    // Durations in microseconds, oldest frame first
+    fprintf(file, "frame");
+    for (i = 0; i < GPROF_COUNT; i++)
+        fprintf(file, ",%s", gprofPhaseNames[i]);
+    fprintf(file, ",total\n");
+
+    index = (gprofHead - gprofCount + GPROF_HISTORY) % GPROF_HISTORY;
+    for (i = 0; i < gprofCount; i++) {
+        fprintf(file, "%u", (unsigned int)gprofHistory[index].frame);
+
+        total = 0;
+        for (j = 0; j < GPROF_COUNT; j++) {
+            total += gprofHistory[index].ticks[j];
+            fprintf(file, ",%u", guiProfTicksToUsec(gprofHistory[index].ticks[j]));
+        }
+        fprintf(file, ",%u\n", guiProfTicksToUsec(total));
+
+        index = (index + 1) % GPROF_HISTORY;
+    }
+
+    fclose(file);
+    LOG("GUIPROF %d frames written to %s\n", gprofCount, path);
+}
+
+void guiProfHandleInput(void)
+{
+    if (getKeyOn(KEY_R3))
+        gprofHudEnabled = !gprofHudEnabled;
+
+    if (getKeyOn(KEY_L3))
+        guiProfDumpCSV();
+}
+
+static void guiProfDrawLine(int x, int y, const char *name, u32 min, u64 sum, u32 max)
+{
+    char text[64];
+
+    snprintf(text, sizeof(text), "%-9s %6.2f %6.2f %6.2f", name, (float)min / CPU_TICKS_PER_MSEC,
+             (float)sum / gprofCount / CPU_TICKS_PER_MSEC, (float)max / CPU_TICKS_PER_MSEC);
+    fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, text, GS_SETREG_RGBA(0x80, 0x80, 0x80, 0x80));
+}
+
+void guiProfDrawHud(void)
+{
+    u32 min[GPROF_COUNT + 1], max[GPROF_COUNT + 1];
+    u64 sum[GPROF_COUNT + 1];
+    u32 ticks, total;
+    int i, j;
+    int x = 20;
+    int y = 20;
+    int yadd = 15;
+
+    if (!gprofHudEnabled || gprofCount == 0)
+        return;
+
+    // The last entry is the whole frame
+    for (j = 0; j <= GPROF_COUNT; j++) {
+        min[j] = 0xFFFFFFFF;
+        max[j] = 0;
+        sum[j] = 0;
+    }
+
+    for (i = 0; i < gprofCount; i++) {
+        total = 0;
+        for (j = 0; j <= GPROF_COUNT; j++) {
+            ticks = j < GPROF_COUNT ? gprofHistory[i].ticks[j] : total;
+            total += ticks;
+
+            if (ticks < min[j])
+                min[j] = ticks;
+            if (ticks > max[j])
+                max[j] = ticks;
+            sum[j] += ticks;
+        }
+    }
+
+    rmDrawRect(x - 5, y - 5, 250, (GPROF_COUNT + 2) * yadd + 10, GS_SETREG_RGBA(0x00, 0x00, 0x00, 0x60));
+
+    fntRenderString(gTheme->fonts[0], x, y, ALIGN_LEFT, 0, 0, "ms           min    avg    max", GS_SETREG_RGBA(0x80, 0x80, 0x80, 0x80));
+    y += yadd;
+
+    for (j = 0; j < GPROF_COUNT; j++) {
+        guiProfDrawLine(x, y, gprofPhaseNames[j], min[j], sum[j], max[j]);
+        y += yadd;
+    }
+
+    guiProfDrawLine(x, y, "total", min[GPROF_COUNT], sum[GPROF_COUNT], max[GPROF_COUNT]);
+}
@@ -77,3 +77,50 @@ int HttpSendGetRequest(s32 HttpSocket, const char *UserAgent, const char *host,
 
     return result;
 }
+
+int HttpQueueGetRequest(s32 HttpSocket, const char *UserAgent, const char *host, s8 mode, const u8 *mtime, const char *uri)
+{
+    int result;
+
+    ((struct HttpClientSendGetArgs *)RpcTxBuffer)->socket = HttpSocket;
+    strncpy(((struct HttpClientSendGetArgs *)RpcTxBuffer)->UserAgent, UserAgent, HTTP_CLIENT_USER_AGENT_MAX - 1);
+    ((struct HttpClientSendGetArgs *)RpcTxBuffer)->UserAgent[HTTP_CLIENT_USER_AGENT_MAX - 1] = '\0';
+    strncpy(((struct HttpClientSendGetArgs *)RpcTxBuffer)->host, host, HTTP_CLIENT_SERVER_NAME_MAX - 1);
+    ((struct HttpClientSendGetArgs *)RpcTxBuffer)->host[HTTP_CLIENT_SERVER_NAME_MAX - 1] = '\0';
+    ((struct HttpClientSendGetArgs *)RpcTxBuffer)->mode = mode;
+    if (mtime != NULL) {
+        memcpy(((struct HttpClientSendGetArgs *)RpcTxBuffer)->mtime, mtime, sizeof(((struct HttpClientSendGetArgs *)RpcTxBuffer)->mtime));
+        ((struct HttpClientSendGetArgs *)RpcTxBuffer)->hasMtime = 1;
+    } else {
+        memset(((struct HttpClientSendGetArgs *)RpcTxBuffer)->mtime, 0, sizeof(((struct HttpClientSendGetArgs *)RpcTxBuffer)->mtime));
+        ((struct HttpClientSendGetArgs *)RpcTxBuffer)->hasMtime = 0;
+    }
+    strncpy(((struct HttpClientSendGetArgs *)RpcTxBuffer)->uri, uri, HTTP_CLIENT_URI_MAX - 1);
+    ((struct HttpClientSendGetArgs *)RpcTxBuffer)->uri[HTTP_CLIENT_URI_MAX - 1] = '\0';
+
+    if ((result = SifCallRpc(&SifRpcClient, HTTP_CLIENT_CMD_QUEUE_GET_REQ, 0, RpcTxBuffer, sizeof(struct HttpClientSendGetArgs), RpcRxBuffer, sizeof(s32), NULL, NULL)) >= 0)
+        result = *(s32 *)RpcRxBuffer;
+
+    return result;
+}
+
+int HttpGetResponse(s32 HttpSocket, s8 *mode, char *output, u16 *out_len)
+{
+    int result;
+
+    ((struct HttpClientGetResponseArgs *)RpcTxBuffer)->socket = HttpSocket;
+    ((struct HttpClientGetResponseArgs *)RpcTxBuffer)->mode = *mode;
+    ((struct HttpClientGetResponseArgs *)RpcTxBuffer)->output = output;
+    ((struct HttpClientGetResponseArgs *)RpcTxBuffer)->out_len = *out_len;
+
+    if (!IS_UNCACHED_SEG(output))
+        SifWriteBackDCache(output, *out_len);
+
+    if ((result = SifCallRpc(&SifRpcClient, HTTP_CLIENT_CMD_GET_RESPONSE, 0, RpcTxBuffer, sizeof(struct HttpClientGetResponseArgs), RpcRxBuffer, sizeof(struct HttpClientSendGetResult), NULL, NULL)) >= 0) {
+        result = ((struct HttpClientSendGetResult *)RpcRxBuffer)->result;
+        *mode = ((struct HttpClientSendGetResult *)RpcRxBuffer)->mode;
+        *out_len = ((struct HttpClientSendGetResult *)RpcRxBuffer)->out_len;
+    }
+
+    return result;
+}
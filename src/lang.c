@@ -6,9 +6,24 @@
 #include "include/themes.h"
 #include "include/sound.h"
 
+// Compiled language pack (lang_compiler.py --make_lng_bin), recognised by its magic in place of a text .lng file.
+// A header, followed by an offset table (relative to the blob) and a single blob of NUL terminated strings.
+#define LNG_PACK_MAGIC   0x4C4C504F // "OPLL"
+#define LNG_PACK_VERSION 1
+
+typedef struct
+{
+    u32 magic;
+    u16 version;
+    u16 reserved;
+    u32 count;
+    u32 blobSize;
+} lng_pack_header_t;
+
 static int guiLangID = 0;
 static char **lang_strs = internalEnglish;
-static int nValidEntries = LANG_STR_COUNT;
+// File buffer that holds all strings of the loaded language file, either a pack or a text file
+static void *lngPackBuffer = NULL;
 
 static int nLanguages = 0;
 static language_t languages[MAX_LANGUAGE_FILES];
@@ -20,16 +35,13 @@ char *_l(unsigned int id)
     return lang_strs[id];
 }
 
-static void lngFreeFromFile(char **lang_strs)
+static void lngFreeFromFile(char **lang_strs, void *packBuffer)
 {
     if (guiLangID == 0)
         return;
 
-    int strId = 0;
-    for (; strId < nValidEntries; strId++) {
-        free(lang_strs[strId]);
-        lang_strs[strId] = NULL;
-    }
+    // the strings live in the file buffer
+    free(packBuffer);
     free(lang_strs);
 }
 
@@ -52,25 +64,68 @@ static int lngLoadFont(const char *dir, const char *name)
     return -1;
 }
 
+/** Maps the strings of a compiled language pack, read whole into buffer. No string is copied.
+ * @return the count of strings read from the pack, or -1 if the pack is invalid */
+static int lngLoadPack(void *buffer, unsigned int size, char **newL)
+{
+    lng_pack_header_t *header = buffer;
+    u32 *offsets = (u32 *)(header + 1);
+    char *blob = (char *)(offsets + header->count);
+    int strId;
+
+    size -= sizeof(lng_pack_header_t);
+    if (header->version != LNG_PACK_VERSION || header->count > size / sizeof(u32) || header->blobSize == 0 ||
+        header->blobSize > size - header->count * sizeof(u32) || blob[header->blobSize - 1] != '\0') {
+        LOG("LANG Invalid language pack\n");
+        return -1;
+    }
+
+    for (strId = 0; strId < header->count && strId < LANG_STR_COUNT; strId++) {
+        if (offsets[strId] >= header->blobSize)
+            return -1;
+
+        newL[strId] = blob + offsets[strId];
+    }
+
+    return strId;
+}
+
 static int lngLoadFromFile(char *path, char *name)
 {
     char dir[128];
+    int size = -1;
+    int strId;
 
-    file_buffer_t *fileBuffer = openFileBuffer(path, O_RDONLY, 1, 1024);
-    if (fileBuffer) {
+    // read the whole file at once, it is either a compiled pack or a text file
+    char *buffer = readFile(path, -1, &size);
+    if (buffer) {
         // file exists, try to read it and load the custom lang
         char **curL = lang_strs;
+        void *curPack = lngPackBuffer;
         char **newL = (char **)calloc(LANG_STR_COUNT, sizeof(char *));
 
-        int strId = 0;
-        while (strId < LANG_STR_COUNT && readFileBuffer(fileBuffer, &newL[strId])) {
-            strId++;
+        if (size >= sizeof(lng_pack_header_t) && ((lng_pack_header_t *)buffer)->magic == LNG_PACK_MAGIC) {
+            strId = lngLoadPack(buffer, size, newL);
+            if (strId < 0) {
+                free(newL);
+                free(buffer);
+                return 0;
+            }
+        } else {
+            // The lines are split in place and are kept in the file buffer, like the strings of a pack.
+            text_buffer_t text;
+            openTextBufferBuffer(&text, buffer, size);
+
+            strId = 0;
+            while (strId < LANG_STR_COUNT && readTextLine(&text, &newL[strId], NULL)) {
+                strId++;
+            }
         }
-        closeFileBuffer(fileBuffer);
+
+        lngPackBuffer = buffer;
 
         LOG("LANG Loaded %d entries\n", strId);
 
-        int newEntries = strId;
         // if necessary complete lang with default internal
         while (strId < LANG_STR_COUNT) {
             LOG("LANG Default entry added: %s\n", internalEnglish[strId]);
@@ -78,10 +133,7 @@ static int lngLoadFromFile(char *path, char *name)
             strId++;
         }
         lang_strs = newL;
-        lngFreeFromFile(curL);
-
-        // remember how many entries were read from the file (for the free later)
-        nValidEntries = newEntries;
+        lngFreeFromFile(curL, curPack);
 
         int len = strlen(path) - strlen(name) - 9; // -4 for extension,  -5 for prefix
         memcpy(dir, path, len);
@@ -176,7 +228,7 @@ void lngInit(void)
 
 void lngEnd(void)
 {
-    lngFreeFromFile(lang_strs);
+    lngFreeFromFile(lang_strs, lngPackBuffer);
 
     int i = 0;
     for (; i < nLanguages; i++) {
@@ -193,6 +245,11 @@ int lngSetGuiValue(int langID)
 {
     if (langID != -1) {
         if (guiLangID != langID) {
+#ifdef __DEBUG
+            // How long the switch takes, theme reload included, reported in the debug log
+            u32 start = cpu_ticks();
+#endif
+
             bgmMute();
             if (langID != 0) {
                 language_t *currLang = &languages[langID - 1];
@@ -200,15 +257,23 @@ int lngSetGuiValue(int langID)
                     guiLangID = langID;
                     thmSetGuiValue(thmGetGuiValue(), 1);
                     bgmUnMute();
+#ifdef __DEBUG
+                    LOG("LANG Switched to %s in %u ms\n", currLang->name, (cpu_ticks() - start) / CPU_TICKS_PER_MSEC);
+#endif
                     return 1;
                 }
             }
+            lngFreeFromFile(lang_strs, lngPackBuffer);
             lang_strs = internalEnglish;
+            lngPackBuffer = NULL;
             guiLangID = 0;
             // lang switched back to internalEnglish, reload default font
             fntLoadDefault(NULL);
             thmSetGuiValue(thmGetGuiValue(), 1);
             bgmUnMute();
+#ifdef __DEBUG
+            LOG("LANG Switched to English in %u ms\n", (cpu_ticks() - start) / CPU_TICKS_PER_MSEC);
+#endif
         }
     }
     return 0;
@@ -17,6 +17,7 @@
 #include "include/system.h"
 #include "include/ioman.h"
 #include "include/sound.h"
+#include "include/gameindex.h"
 #include <assert.h>
 
 enum MENU_IDs {
@@ -145,6 +146,15 @@ static void _menuLoadConfig()
     if (!itemConfig) {
         item_list_t *list = selected_item->item->userdata;
         itemConfig = list->itemGetConfig(list, itemConfigId);
+
+        if (itemConfig && list->mode != APP_MODE) {
+            unsigned int devices = gameIndexGetDevices(list->itemGetStartup(list, itemConfigId));
+            int count = 0;
+
+            for (; devices != 0; devices &= devices - 1)
+                count++;
+            configSetInt(itemConfig, CONFIG_ITEM_DEVICES, count);
+        }
     }
     actionStatus = 0;
     SignalSema(menuSemaId);
@@ -14,6 +14,7 @@
 #include "include/textures.h"
 #include "include/pad.h"
 #include "include/texcache.h"
+#include "include/gameindex.h"
 #include "include/dia.h"
 #include "include/dialogs.h"
 #include "include/menusys.h"
@@ -30,16 +31,14 @@
 #include "include/ethsupport.h"
 #include "include/hddsupport.h"
 #include "include/appsupport.h"
+#include "include/appsindex.h"
 
 #include "include/cheatman.h"
 #include "include/sound.h"
 #include "include/xparam.h"
 
-// FIXME: We should not need this function.
-//        Use newlib's 'stat' to get GMT time.
 #define NEWLIB_PORT_AWARE
-#include <fileXio_rpc.h> // iox_stat_t
-int configGetStat(config_set_t *configSet, iox_stat_t *stat);
+#include <fileXio_rpc.h>
 
 #include <unistd.h>
 #ifdef PADEMU
@@ -74,10 +73,8 @@ int configGetStat(config_set_t *configSet, iox_stat_t *stat);
 static unsigned char shouldAppsUpdate;
 
 // Network support stuff.
-#define HTTP_IOBUF_SIZE 512
-static unsigned int CompatUpdateComplete, CompatUpdateTotal;
-static unsigned char CompatUpdateStopFlag, CompatUpdateFlags;
-static short int CompatUpdateStatus;
+static unsigned int CompatUpdateTotal;
+static unsigned char CompatUpdateFlags;
 
 static void clearIOModuleT(opl_io_module_t *mod)
 {
@@ -148,6 +145,7 @@ int gVMode; // 0 - Auto, 1 - PAL, 2 - NTSC
 int gXOff;
 int gYOff;
 int gOverscan;
+int gFrameQueue;
 int gSelectButton;
 int gHDDGameListCache;
 int gEnableSFX;
@@ -157,6 +155,7 @@ int gSFXVolume;
 int gBootSndVolume;
 int gBGMVolume;
 char gDefaultBGMPath[128];
+int gBGMCache;
 int gCheatSource;
 int gGSMSource;
 int gPadEmuSource;
@@ -502,56 +501,12 @@ int oplGetAppImage(const char *device, char *folder, int isRelative, char *value
     return -1;
 }
 
-static int scanApps(int (*callback)(const char *path, config_set_t *appConfig, void *arg), void *arg, char *appsPath, int exception)
-{
-    struct dirent *pdirent;
-    DIR *pdir;
-    int count, ret;
-    config_set_t *appConfig;
-    char dir[128];
-    char path[128];
-
-    count = 0;
-    if ((pdir = opendir(appsPath)) != NULL) {
-        while ((pdirent = readdir(pdir)) != NULL) {
-            if (exception && strchr(pdirent->d_name, '_') == NULL)
-                continue;
-
-            if (strcmp(pdirent->d_name, ".") == 0 || strcmp(pdirent->d_name, "..") == 0)
-                continue;
-
-            snprintf(dir, sizeof(dir), "%s/%s", appsPath, pdirent->d_name);
-            if (pdirent->d_type != DT_DIR)
-                continue;
-
-            snprintf(path, sizeof(path), "%s/%s", dir, APP_TITLE_CONFIG_FILE);
-            appConfig = configAlloc(0, NULL, path);
-            if (appConfig != NULL) {
-                configRead(appConfig);
-
-                ret = callback(dir, appConfig, arg);
-                configFree(appConfig);
-
-                if (ret == 0)
-                    count++;
-                else if (ret < 0) { // Stopped because of unrecoverable error.
-                    break;
-                }
-            }
-        }
-
-        closedir(pdir);
-    } else
-        LOG("APPS failed to open dir %s\n", appsPath);
-
-    return count;
-}
-
-int oplScanApps(int (*callback)(const char *path, config_set_t *appConfig, void *arg), void *arg)
+int oplScanApps(int (*callback)(const char *path, const char *title, const char *boot, const char *argv1, void *arg), void *arg)
 {
     int i, count;
     item_list_t *listSupport;
     char appsPath[64];
+    char indexPath[64];
 
     count = 0;
     for (i = 0; i < MODE_COUNT; i++) {
@@ -559,13 +514,16 @@ int oplScanApps(int (*callback)(const char *path, config_set_t *appConfig, void
         if ((listSupport != NULL) && (listSupport->enabled) && (listSupport->itemGetPrefix != NULL)) {
             char *prefix = listSupport->itemGetPrefix(listSupport);
             snprintf(appsPath, sizeof(appsPath), "%sAPPS", prefix);
-            count += scanApps(callback, arg, appsPath, 0);
+            snprintf(indexPath, sizeof(indexPath), "%s/%s", appsPath, APP_INDEX_FILE);
+            count += appsIndexScan(callback, arg, appsPath, indexPath, 0);
         }
     }
 
+    // The index of the apps on a memory card is kept in its OPL folder, as the root should only contain save folders.
     for (i = 0; i < 2; i++) {
         snprintf(appsPath, sizeof(appsPath), "mc%d:", i);
-        count += scanApps(callback, arg, appsPath, 1);
+        snprintf(indexPath, sizeof(indexPath), "mc%d:OPL/%s", i, APP_INDEX_FILE);
+        count += appsIndexScan(callback, arg, appsPath, indexPath, 1);
     }
 
     return count;
@@ -650,6 +608,26 @@ config_set_t *oplGetLegacyAppsInfo(char *name)
 // ----------------------------------------------------------
 // ----------------------- Updaters -------------------------
 // ----------------------------------------------------------
+static void appendMenuGame(opl_io_module_t *mdl, int id, const char *lastPlayed)
+{
+    struct gui_update_t *gup = guiOpCreate(GUI_OP_APPEND_MENU);
+
+    gup->menu.menu = &mdl->menuItem;
+    gup->menu.subMenu = &mdl->subMenu;
+
+    gup->submenu.icon_id = -1;
+    gup->submenu.id = id;
+    gup->submenu.text = mdl->support->itemGetName(mdl->support, id);
+    gup->submenu.text_id = -1;
+    gup->submenu.selected = 0;
+
+    if (lastPlayed && strcmp(lastPlayed, mdl->support->itemGetStartup(mdl->support, id)) == 0) {
+        gup->submenu.selected = 1; // Select Last Played Game
+    }
+
+    guiDeferUpdate(gup);
+}
+
 static void updateMenuFromGameList(opl_io_module_t *mdl)
 {
     guiExecDeferredOps();
@@ -666,31 +644,23 @@ static void updateMenuFromGameList(opl_io_module_t *mdl)
     // read the new game list
     struct gui_update_t *gup = NULL;
     int count = mdl->support->itemUpdate(mdl->support);
-    if (count > 0) {
-        int i;
-
-        for (i = 0; i < count; ++i) {
-
-            gup = guiOpCreate(GUI_OP_APPEND_MENU);
 
-            gup->menu.menu = &mdl->menuItem;
-            gup->menu.subMenu = &mdl->subMenu;
+    // Merge it into the game index, which keeps the games of each device sorted by name
+    int indexed = (mdl->support->mode != APP_MODE) && (gameIndexUpdate(mdl->support, count) >= 0);
 
-            gup->submenu.icon_id = -1;
-            gup->submenu.id = i;
-            gup->submenu.text = mdl->support->itemGetName(mdl->support, i);
-            gup->submenu.text_id = -1;
-            gup->submenu.selected = 0;
-
-            if (gRememberLastPlayed && temp && strcmp(temp, mdl->support->itemGetStartup(mdl->support, i)) == 0) {
-                gup->submenu.selected = 1; // Select Last Played Game
-            }
+    if (indexed && gAutosort) {
+        // Already sorted, no need for the GUI to sort it again
+        game_location_t *location = NULL;
+        while ((location = gameIndexNext(location, mdl->support->mode)) != NULL)
+            appendMenuGame(mdl, location->id, temp);
+    } else if (count > 0) {
+        int i;
 
-            guiDeferUpdate(gup);
-        }
+        for (i = 0; i < count; ++i)
+            appendMenuGame(mdl, i, temp);
     }
 
-    if (gAutosort) {
+    if (gAutosort && !indexed) {
         gup = guiOpCreate(GUI_OP_SORT);
         gup->menu.menu = &mdl->menuItem;
         gup->menu.subMenu = &mdl->subMenu;
@@ -903,6 +873,7 @@ static void _loadConfig()
             configGetInt(configOPL, CONFIG_OPL_XOFF, &gXOff);
             configGetInt(configOPL, CONFIG_OPL_YOFF, &gYOff);
             configGetInt(configOPL, CONFIG_OPL_OVERSCAN, &gOverscan);
+            configGetInt(configOPL, CONFIG_OPL_FRAME_QUEUE, &gFrameQueue);
 
             configGetInt(configOPL, CONFIG_OPL_BDM_CACHE, &bdmCacheSize);
             configGetInt(configOPL, CONFIG_OPL_HDD_CACHE, &hddCacheSize);
@@ -946,6 +917,7 @@ static void _loadConfig()
             configGetInt(configOPL, CONFIG_OPL_BOOT_SND_VOLUME, &gBootSndVolume);
             configGetInt(configOPL, CONFIG_OPL_BGM_VOLUME, &gBGMVolume);
             configGetStrCopy(configOPL, CONFIG_OPL_DEFAULT_BGM_PATH, gDefaultBGMPath, sizeof(gDefaultBGMPath));
+            configGetInt(configOPL, CONFIG_OPL_BGM_CACHE, &gBGMCache);
         }
     }
 
@@ -1076,6 +1048,7 @@ static void _saveConfig()
         configSetInt(configOPL, CONFIG_OPL_XOFF, gXOff);
         configSetInt(configOPL, CONFIG_OPL_YOFF, gYOff);
         configSetInt(configOPL, CONFIG_OPL_OVERSCAN, gOverscan);
+        configSetInt(configOPL, CONFIG_OPL_FRAME_QUEUE, gFrameQueue);
         configSetInt(configOPL, CONFIG_OPL_DISABLE_DEBUG, gEnableDebug);
         configSetInt(configOPL, CONFIG_OPL_PS2LOGO, gPS2Logo);
         configSetInt(configOPL, CONFIG_OPL_HDD_GAME_LIST_CACHE, gHDDGameListCache);
@@ -1106,6 +1079,7 @@ static void _saveConfig()
         configSetInt(configOPL, CONFIG_OPL_BOOT_SND_VOLUME, gBootSndVolume);
         configSetInt(configOPL, CONFIG_OPL_BGM_VOLUME, gBGMVolume);
         configSetStr(configOPL, CONFIG_OPL_DEFAULT_BGM_PATH, gDefaultBGMPath);
+        configSetInt(configOPL, CONFIG_OPL_BGM_CACHE, gBGMCache);
         configSetInt(configOPL, CONFIG_OPL_XSENSITIVITY, gXSensitivity);
         configSetInt(configOPL, CONFIG_OPL_YSENSITIVITY, gYSensitivity);
 
@@ -1229,189 +1203,6 @@ int saveConfig(int types, int showUI)
     return lscret;
 }
 
-#define COMPAT_UPD_MODE_UPD_USR   1 // Update all records, even those that were modified by the user.
-#define COMPAT_UPD_MODE_NO_MTIME  2 // Do not check the modified time-stamp.
-#define COMPAT_UPD_MODE_MTIME_GMT 4 // Modified time-stamp is in GMT, not JST.
-
-#define EOPLCONNERR 0x4000 // Special error code for connection errors.
-
-static int CompatAttemptConnection(void)
-{
-    unsigned char retries;
-    int HttpSocket;
-
-    for (retries = OPL_COMPAT_HTTP_RETRIES, HttpSocket = -1; !CompatUpdateStopFlag && retries > 0; retries--) {
-        if ((HttpSocket = HttpEstabConnection(OPL_COMPAT_HTTP_HOST, OPL_COMPAT_HTTP_PORT)) >= 0) {
-            break;
-        }
-    }
-
-    return HttpSocket;
-}
-
-static void compatUpdate(item_list_t *support, unsigned char mode, config_set_t *configSet, int id)
-{
-    sceCdCLOCK clock;
-    config_set_t *itemConfig, *downloadedConfig;
-    u16 length;
-    s8 ConnMode, hasMtime;
-    char *HttpBuffer;
-    int i, count, HttpSocket, result, retries, ConfigSource;
-    iox_stat_t stat;
-    u8 mtime[6];
-    char device, uri[64];
-    const char *startup;
-
-    switch (support->mode) {
-        case BDM_MODE:
-            device = 3;
-            break;
-        case ETH_MODE:
-            mode |= COMPAT_UPD_MODE_MTIME_GMT;
-            device = 2;
-            break;
-        case HDD_MODE:
-            device = 1;
-            break;
-        default:
-            device = -1;
-    }
-
-    if (device < 0) {
-        LOG("CompatUpdate: unrecognized mode: %d\n", support->mode);
-        CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_ERROR;
-        return; // Shouldn't happen, but what if?
-    }
-
-    result = 0;
-    LOG("CompatUpdate: updating for: device %d game %d\n", device, configSet == NULL ? -1 : id);
-
-    if ((HttpBuffer = memalign(64, HTTP_IOBUF_SIZE)) != NULL) {
-        count = configSet != NULL ? 1 : support->itemGetCount(support);
-
-        if (count > 0) {
-            ConnMode = HTTP_CMODE_PERSISTENT;
-            if ((HttpSocket = CompatAttemptConnection()) >= 0) {
-                // Update compatibility list.
-                for (i = 0; !CompatUpdateStopFlag && result >= 0 && i < count; i++, CompatUpdateComplete++) {
-                    startup = support->itemGetStartup(support, configSet != NULL ? id : i);
-
-                    if (ConnMode == HTTP_CMODE_CLOSED) {
-                        ConnMode = HTTP_CMODE_PERSISTENT;
-                        if ((HttpSocket = CompatAttemptConnection()) < 0) {
-                            result = HttpSocket | EOPLCONNERR;
-                            break;
-                        }
-                    }
-
-                    itemConfig = configSet != NULL ? configSet : support->itemGetConfig(support, i);
-                    if (itemConfig != NULL) {
-                        ConfigSource = CONFIG_SOURCE_DEFAULT;
-                        if ((mode & COMPAT_UPD_MODE_UPD_USR) || !configGetInt(itemConfig, CONFIG_ITEM_CONFIGSOURCE, &ConfigSource) || ConfigSource != CONFIG_SOURCE_USER) {
-                            if (!(mode & COMPAT_UPD_MODE_NO_MTIME) && (ConfigSource == CONFIG_SOURCE_DLOAD) && configGetStat(itemConfig, &stat)) { // Only perform a stat operation for downloaded setting files.
-                                if (!(mode & COMPAT_UPD_MODE_MTIME_GMT)) {
-                                    clock.second = itob(stat.mtime[1]);
-                                    clock.minute = itob(stat.mtime[2]);
-                                    clock.hour = itob(stat.mtime[3]);
-                                    clock.day = itob(stat.mtime[4]);
-                                    clock.month = itob(stat.mtime[5]);
-                                    clock.year = itob((stat.mtime[6] | ((unsigned short int)stat.mtime[7] << 8)) - 2000);
-                                    configConvertToGmtTime(&clock);
-
-                                    mtime[0] = btoi(clock.year);      // Year
-                                    mtime[1] = btoi(clock.month) - 1; // Month
-                                    mtime[2] = btoi(clock.day) - 1;   // Day
-                                    mtime[3] = btoi(clock.hour);      // Hour
-                                    mtime[4] = btoi(clock.minute);    // Minute
-                                    mtime[5] = btoi(clock.second);    // Second
-                                } else {
-                                    mtime[0] = (stat.mtime[6] | ((unsigned short int)stat.mtime[7] << 8)) - 2000; // Year
-                                    mtime[1] = stat.mtime[5] - 1;                                                 // Month
-                                    mtime[2] = stat.mtime[4] - 1;                                                 // Day
-                                    mtime[3] = stat.mtime[3];                                                     // Hour
-                                    mtime[4] = stat.mtime[2];                                                     // Minute
-                                    mtime[5] = stat.mtime[1];                                                     // Second
-                                }
-                                hasMtime = 1;
-
-                                LOG("CompatUpdate: LAST MTIME %04u/%02u/%02u %02u:%02u:%02u\n", (unsigned short int)mtime[0] + 2000, mtime[1] + 1, mtime[2] + 1, mtime[3], mtime[4], mtime[5]);
-                            } else {
-                                hasMtime = 0;
-                            }
-
-                            sprintf(uri, OPL_COMPAT_HTTP_URI, startup, device);
-                            for (retries = OPL_COMPAT_HTTP_RETRIES; !CompatUpdateStopFlag && retries > 0; retries--) {
-                                length = HTTP_IOBUF_SIZE;
-                                result = HttpSendGetRequest(HttpSocket, OPL_USER_AGENT, OPL_COMPAT_HTTP_HOST, &ConnMode, hasMtime ? mtime : NULL, uri, HttpBuffer, &length);
-                                if (result >= 0) {
-                                    if (result == 200) {
-                                        if ((downloadedConfig = configAlloc(0, NULL, NULL)) != NULL) {
-                                            configReadBuffer(downloadedConfig, HttpBuffer, length);
-                                            configMerge(itemConfig, downloadedConfig);
-                                            configFree(downloadedConfig);
-                                            configSetInt(itemConfig, CONFIG_ITEM_CONFIGSOURCE, CONFIG_SOURCE_DLOAD);
-                                            if (!configWrite(itemConfig))
-                                                result = -EIO;
-                                        } else
-                                            result = -ENOMEM;
-                                    }
-
-                                    break;
-                                } else
-                                    result |= EOPLCONNERR;
-
-                                HttpCloseConnection(HttpSocket);
-
-                                LOG("CompatUpdate: Connection lost. Retrying.\n");
-
-                                // Connection lost. Attempt to re-connect.
-                                ConnMode = HTTP_CMODE_PERSISTENT;
-                                if ((HttpSocket = CompatAttemptConnection()) < 0) {
-                                    result = HttpSocket | EOPLCONNERR;
-                                    break;
-                                }
-                            }
-
-                            LOG("CompatUpdate %d. %d, %s: %s %d\n", i + 1, device, startup, ConnMode == HTTP_CMODE_CLOSED ? "CLOSED" : "PERSISTENT", result);
-                        } else {
-                            LOG("CompatUpdate: skipping %s\n", startup);
-                        }
-
-                        if (configSet == NULL) // Do not free what is not ours.
-                            configFree(itemConfig);
-                    } else {
-                        // Can't do anything because the config file cannot be opened/created.
-                        LOG("CompatUpdate: skipping %s (no config)\n", startup);
-                    }
-
-                    if (ConnMode == HTTP_CMODE_CLOSED)
-                        HttpCloseConnection(HttpSocket);
-                }
-
-                if (ConnMode == HTTP_CMODE_PERSISTENT)
-                    HttpCloseConnection(HttpSocket);
-            } else {
-                result = HttpSocket | EOPLCONNERR;
-            }
-        }
-
-        free(HttpBuffer);
-    } else {
-        result = -ENOMEM;
-    }
-
-    if (CompatUpdateStopFlag)
-        CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_ABORTED;
-    else {
-        if (result >= 0)
-            CompatUpdateStatus = OPL_COMPAT_UPDATE_STAT_DONE;
-        else {
-            CompatUpdateStatus = (result & EOPLCONNERR) ? OPL_COMPAT_UPDATE_STAT_CONN_ERROR : OPL_COMPAT_UPDATE_STAT_ERROR;
-        }
-    }
-    LOG("CompatUpdate: completed with status %d\n", CompatUpdateStatus);
-}
-
 static void compatDeferredUpdate(void *data)
 {
     opl_io_module_t *mod = &list_support[*(short int *)data];
@@ -1615,6 +1406,7 @@ static void moduleCleanup(opl_io_module_t *mod, int exception, int modeSelected)
     }
 
     clearMenuGameList(mod);
+    gameIndexRemoveDevice(mod->support->mode);
 }
 
 void deinit(int exception, int modeSelected)
@@ -1730,6 +1522,7 @@ static void setDefaults(void)
     gBootSndVolume = 80;
     gBGMVolume = 70;
     gDefaultBGMPath[0] = '\0';
+    gBGMCache = 0;
     gXSensitivity = 1;
     gYSensitivity = 1;
 
@@ -1748,6 +1541,7 @@ static void setDefaults(void)
     gXOff = 0;
     gYOff = 0;
     gOverscan = 0;
+    gFrameQueue = 1;
 
     setDefaultColors();
 
@@ -1768,6 +1562,7 @@ static void init(void)
     configInit(NULL);
 
     rmInit();
+    texInit();
     lngInit();
     thmInit();
     guiInit();
@@ -1784,6 +1579,7 @@ static void init(void)
     // handler for deffered menu updates
     ioRegisterHandler(IO_MENU_UPDATE_DEFFERED, &menuDeferredUpdate);
     cacheInit();
+    thmInitLoader();
 
     gSelectButton = (InitConsoleRegionData() == CONSOLE_REGION_JAPAN) ? KEY_CIRCLE : KEY_CROSS;
 
@@ -18,9 +18,6 @@
 
 #define MAX_PADS 4
 
-// Cpu ticks per one milisecond
-#define CLOCKS_PER_MILISEC 147456
-
 // 200 ms per repeat
 #define DEFAULT_PAD_DELAY 200
 
@@ -331,7 +328,7 @@ int readPads()
     paddata = 0;
 
     // in ms.
-    u32 newtime = cpu_ticks() / CLOCKS_PER_MILISEC;
+    u32 newtime = cpu_ticks() / CPU_TICKS_PER_MSEC;
     time_since_last = newtime - curtime;
     curtime = newtime;
 
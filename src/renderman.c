@@ -23,6 +23,12 @@ static u8 hires = 0;
 static u8 guiWakeupCount;
 static int vsync_id = -1;
 
+// Frame queue state: the last frame sent to the GS, which is shown once the GS finished drawing it
+static u8 framePending;
+static u8 gsBusy;
+static int pendingBuffer;
+static rm_frame_pacing_t framePacing;
+
 #define NUM_RM_VMODES 14
 #define RM_VMODE_AUTO 0
 
@@ -87,6 +93,14 @@ const u64 gColFocus = GS_SETREG_RGBA(0xFF, 0xFF, 0xFF, 0x50);  // Alpha 0x50 ->
 const u64 gDefaultCol = GS_SETREG_RGBA(0x80, 0x80, 0x80, 0x80); // Special color for texture multiplication
 const u64 gDefaultAlpha = GS_SETREG_ALPHA(0, 1, 0, 1, 0);
 
+void rmWaitGS(void)
+{
+    if (gsBusy) {
+        gsKit_finish();
+        gsBusy = 0;
+    }
+}
+
 void rmInvalidateTexture(GSTEXTURE *txt)
 {
     gsKit_TexManager_invalidate(gsGlobal, txt);
@@ -94,9 +108,15 @@ void rmInvalidateTexture(GSTEXTURE *txt)
 
 void rmUnloadTexture(GSTEXTURE *txt)
 {
+    rmWaitGS();
     gsKit_TexManager_free(gsGlobal, txt);
 }
 
+void rmGetFramePacing(rm_frame_pacing_t *pacing)
+{
+    *pacing = framePacing;
+}
+
 void rmStartFrame(void)
 {
     if (hires == 0)
@@ -105,6 +125,32 @@ void rmStartFrame(void)
     order = 0;
 }
 
+// Waits for the GS to finish drawing the pending frame, then shows it on the next vsync
+static void rmShowPendingFrame(void)
+{
+    u32 start, end;
+
+    if (!framePending)
+        return;
+
+    start = cpu_ticks();
+    rmWaitGS();
+    end = cpu_ticks();
+    framePacing.gsWait = end - start;
+
+    if (!gsGlobal->FirstFrame) {
+        SleepThread();
+        guiWakeupCount = 0;
+
+        if (gsGlobal->DoubleBuffering == GS_SETTING_ON)
+            GS_SET_DISPFB2(gsGlobal->ScreenBuffer[pendingBuffer & 1] / 8192,
+                           gsGlobal->Width / 64, gsGlobal->PSM, 0, 0);
+    }
+    framePacing.vsyncWait = cpu_ticks() - end;
+
+    framePending = 0;
+}
+
 void rmEndFrame(void)
 {
     if (hires) {
@@ -112,22 +158,22 @@ void rmEndFrame(void)
         gsKit_hires_flip(gsGlobal);
     } else {
         gsKit_set_finish(gsGlobal);
-        gsKit_queue_exec(gsGlobal);
 
-        // Wait for draw ops to finish
-        gsKit_finish();
+        /* With a frame queue, the GS drew the previous frame while this one was being built.
+           Show it first: this frame draws to the buffer that is still on screen until then. */
+        if (gFrameQueue)
+            rmShowPendingFrame();
 
-        if (!gsGlobal->FirstFrame) {
-            SleepThread();
-            guiWakeupCount = 0;
+        gsKit_queue_exec(gsGlobal);
+        framePending = 1;
+        gsBusy = 1;
+        pendingBuffer = gsGlobal->ActiveBuffer;
 
-            if (gsGlobal->DoubleBuffering == GS_SETTING_ON) {
-                GS_SET_DISPFB2(gsGlobal->ScreenBuffer[gsGlobal->ActiveBuffer & 1] / 8192,
-                               gsGlobal->Width / 64, gsGlobal->PSM, 0, 0);
+        if (!gFrameQueue)
+            rmShowPendingFrame();
 
-                gsGlobal->ActiveBuffer ^= 1;
-            }
-        }
+        if (!gsGlobal->FirstFrame && gsGlobal->DoubleBuffering == GS_SETTING_ON)
+            gsGlobal->ActiveBuffer ^= 1;
 
         gsKit_setactive(gsGlobal);
     }
@@ -263,6 +309,9 @@ void rmGetScreenExtents(int *w, int *h)
 
 void rmEnd(void)
 {
+    rmWaitGS();
+    framePending = 0;
+
     if (hires) {
         gsKit_hires_deinit_global(gsGlobal);
     } else {
@@ -339,6 +388,39 @@ void rmDrawQuad(rm_quad_t *q)
     order++;
 }
 
+#define RM_QUAD_LIST_MAX 128
+
+void rmDrawQuadList(GSTEXTURE *txt, u64 color, int count, const rm_tx_coord_t *coords)
+{
+    static GSPRIMUVPOINTFLAT vertices[RM_QUAD_LIST_MAX * 2];
+    gs_rgbaq rgbaq = color_to_RGBAQ(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, (color >> 24) & 0xFF, 0.0f);
+    int i, batch;
+
+    if ((txt->PSM == GS_PSM_CT32) || (txt->Clut && txt->ClutPSM == GS_PSM_CT32)) {
+        gsGlobal->PrimAlphaEnable = GS_SETTING_ON;
+        gsKit_set_test(gsGlobal, GS_ATEST_ON);
+    } else {
+        gsGlobal->PrimAlphaEnable = GS_SETTING_OFF;
+        gsKit_set_test(gsGlobal, GS_ATEST_OFF);
+    }
+
+    gsKit_TexManager_bind(gsGlobal, txt);
+
+    while (count > 0) {
+        batch = (count > RM_QUAD_LIST_MAX) ? RM_QUAD_LIST_MAX : count;
+
+        for (i = 0; i < batch * 2; i++, coords++) {
+            vertices[i].xyz2 = vertex_to_XYZ2(gsGlobal, coords->x + fRenderXOff, coords->y + fRenderYOff, order);
+            vertices[i].uv = vertex_to_UV(txt, coords->u, coords->v);
+        }
+
+        gsKit_prim_list_sprite_texture_uv_flat_color(gsGlobal, txt, rgbaq, batch * 2, vertices);
+        count -= batch;
+    }
+
+    order++;
+}
+
 void rmDrawPixmap(GSTEXTURE *txt, int x, int y, short aligned, int w, int h, short scaled, u64 color)
 {
     rm_quad_t quad;
@@ -392,6 +474,16 @@ void rmDrawRect(int x, int y, int w, int h, u64 color)
     order++;
 }
 
+void rmDrawAlignedRect(int x, int y, short aligned, int w, int h, short scaled, u64 color)
+{
+    rm_quad_t quad;
+
+    rmSetupQuad(NULL, x, y, aligned, w, h, scaled, color, &quad);
+    gsGlobal->PrimAlphaEnable = GS_SETTING_ON;
+    gsKit_prim_sprite(gsGlobal, quad.ul.x + fRenderXOff, quad.ul.y + fRenderYOff, quad.br.x + fRenderXOff, quad.br.y + fRenderYOff, order, color);
+    order++;
+}
+
 void rmDrawLine(int x1, int y1, int x2, int y2, u64 color)
 {
     float fx1 = X_SCALE(x1) + fRenderXOff;
@@ -5,6 +5,7 @@
  */
 
 #include <audsrv.h>
+#include <sys/stat.h>
 #include <vorbis/vorbisfile.h>
 
 #include "include/sound.h"
@@ -248,6 +249,21 @@ void sfxPlay(int id)
 #define BGM_THREAD_BASE_PRIO  0x40
 #define BGM_THREAD_STACK_SIZE 0x1000
 
+// Decoded PCM cache, stored next to the Ogg file when gBGMCache is enabled
+#define BGM_CACHE_MAGIC    0x4D43504F // "OPCM"
+#define BGM_CACHE_VERSION  1
+#define BGM_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+typedef struct
+{
+    u32 magic;
+    u16 version;
+    u16 channels;
+    u32 rate;
+    u32 srcSize;  // Size of the Ogg file that was decoded
+    u32 dataSize; // Size of the 16-bit PCM data that follows, 0 until it is complete
+} bgm_cache_header_t;
+
 extern void *_gp;
 
 static int bgmThreadID, bgmIoThreadID;
@@ -257,22 +273,41 @@ static unsigned char rdPtr, wrPtr;
 static char bgmBuffer[BGM_RING_BUFFER_COUNT][BGM_RING_BUFFER_SIZE];
 static volatile unsigned char bgmThreadRunning, bgmIoThreadRunning;
 
+// Ring buffer statistics
+static volatile u32 bgmPartsQueued, bgmPartsPlayed;
+static u32 bgmUnderruns, bgmMinDepth;
+static u8 bgmLooped; // The last read of the I/O thread reached the end of the stream
+
 static u8 bgmThreadStack[BGM_THREAD_STACK_SIZE] __attribute__((aligned(16)));
 static u8 bgmIoThreadStack[BGM_THREAD_STACK_SIZE] __attribute__((aligned(16)));
 
 static OggVorbis_File *vorbisFile;
+static int bgmChannels, bgmRate;
+
+// Cache being played (bgmCacheIn) or written while the Ogg file is decoded for the first time (bgmCacheOut)
+static FILE *bgmCacheIn, *bgmCacheOut;
+static char bgmCachePath[256];
+static bgm_cache_header_t bgmCacheHeader;
+static u32 bgmCacheLeft;
 
 static void bgmThread(void *arg)
 {
+    u32 depth;
+
     bgmThreadRunning = 1;
 
     while (!terminateFlag) {
         SleepThread();
 
         while (PollSema(outSema) == outSema) {
+            depth = bgmPartsQueued - bgmPartsPlayed;
+            if (depth < bgmMinDepth)
+                bgmMinDepth = depth;
+
             audsrv_wait_audio(BGM_RING_BUFFER_SIZE);
             audsrv_play_audio(bgmBuffer[rdPtr], BGM_RING_BUFFER_SIZE);
             rdPtr = (rdPtr + 1) % BGM_RING_BUFFER_COUNT;
+            bgmPartsPlayed++;
 
             SignalSema(inSema);
         }
@@ -287,9 +322,96 @@ static void bgmThread(void *arg)
     bgmIsPlaying = 0;
 }
 
+static void bgmCacheAbort(void)
+{
+    if (bgmCacheOut != NULL) {
+        fclose(bgmCacheOut);
+        bgmCacheOut = NULL;
+        remove(bgmCachePath);
+    }
+}
+
+static void bgmCacheAppend(const char *buffer, int size)
+{
+    if (bgmCacheOut == NULL)
+        return;
+
+    if (bgmCacheHeader.dataSize + size > BGM_CACHE_MAX_SIZE || fwrite(buffer, 1, size, bgmCacheOut) != size) {
+        LOG("BGM: Unable to cache %s\n", bgmCachePath);
+        bgmCacheAbort();
+        return;
+    }
+
+    bgmCacheHeader.dataSize += size;
+}
+
+// Called once the whole stream was decoded: the header is written last, so an incomplete cache is never used.
+static void bgmCacheFinish(void)
+{
+    if (bgmCacheOut == NULL)
+        return;
+
+    if (bgmCacheHeader.dataSize == 0 || fseek(bgmCacheOut, 0, SEEK_SET) != 0 || fwrite(&bgmCacheHeader, 1, sizeof(bgmCacheHeader), bgmCacheOut) != sizeof(bgmCacheHeader)) {
+        bgmCacheAbort();
+        return;
+    }
+
+    fclose(bgmCacheOut);
+    bgmCacheOut = NULL;
+    LOG("BGM: Cached %u bytes of PCM to %s\n", bgmCacheHeader.dataSize, bgmCachePath);
+}
+
+static int bgmDecode(char *buffer, int size)
+{
+    int bitStream;
+
+    while (size > 0) {
+        int ret = ov_read(vorbisFile, buffer, size, 0, 2, 1, &bitStream);
+        if (ret > 0) {
+            bgmCacheAppend(buffer, ret);
+            buffer += ret;
+            size -= ret;
+        } else if (ret < 0) {
+            bgmCacheAbort();
+            return ret;
+        } else {
+            bgmLooped = 1;
+            bgmCacheFinish();
+            ov_pcm_seek(vorbisFile, 0);
+        }
+    }
+
+    return 0;
+}
+
+static int bgmReadCache(char *buffer, int size)
+{
+    int chunk;
+
+    while (size > 0) {
+        if (bgmCacheLeft == 0) {
+            // Loop
+            bgmLooped = 1;
+            if (fseek(bgmCacheIn, sizeof(bgm_cache_header_t), SEEK_SET) != 0)
+                return -EIO;
+            bgmCacheLeft = bgmCacheHeader.dataSize;
+        }
+
+        chunk = size < bgmCacheLeft ? size : bgmCacheLeft;
+        if (fread(buffer, 1, chunk, bgmCacheIn) != chunk)
+            return -EIO;
+
+        buffer += chunk;
+        size -= chunk;
+        bgmCacheLeft -= chunk;
+    }
+
+    return 0;
+}
+
 static void bgmIoThread(void *arg)
 {
-    int partsToRead, decodeTotal, bitStream, i;
+    int partsToRead, i, ret;
 
     bgmIoThreadRunning = 1;
     do {
@@ -299,22 +421,26 @@ static void bgmIoThread(void *arg)
         while ((wrPtr + partsToRead < BGM_RING_BUFFER_COUNT) && (PollSema(inSema) == inSema))
             partsToRead++;
 
-        decodeTotal = BGM_RING_BUFFER_SIZE;
-        int bufferPtr = 0;
-        do {
-            int ret = ov_read(vorbisFile, bgmBuffer[wrPtr] + bufferPtr, decodeTotal, 0, 2, 1, &bitStream);
-            if (ret > 0) {
-                bufferPtr += ret;
-                decodeTotal -= ret;
-            } else if (ret < 0) {
-                LOG("BGM: I/O error while reading.\n");
-                terminateFlag = 1;
-                break;
-            } else if (ret == 0)
-                ov_pcm_seek(vorbisFile, 0);
-        } while (decodeTotal > 0);
+        // The parts are contiguous, fill them all with one read.
+        bgmLooped = 0;
+        if (bgmCacheIn != NULL)
+            ret = bgmReadCache(bgmBuffer[wrPtr], partsToRead * BGM_RING_BUFFER_SIZE);
+        else
+            ret = bgmDecode(bgmBuffer[wrPtr], partsToRead * BGM_RING_BUFFER_SIZE);
+
+        if (ret < 0) {
+            LOG("BGM: I/O error while reading.\n");
+            terminateFlag = 1;
+            break;
+        }
+
+        /* Everything queued before the read was played while it ran, the I/O thread did not keep up.
+           The ring is still being filled for the first time, or emptied while the stream went back to its start, otherwise. */
+        if (bgmPartsQueued != 0 && bgmPartsQueued == bgmPartsPlayed && !bgmLooped && !terminateFlag && gEnableBGM)
+            bgmUnderruns++;
 
         wrPtr = (wrPtr + partsToRead) % BGM_RING_BUFFER_COUNT;
+        bgmPartsQueued += partsToRead;
         for (i = 0; i < partsToRead; i++)
             SignalSema(outSema);
         WakeupThread(bgmThreadID);
@@ -325,13 +451,49 @@ static void bgmIoThread(void *arg)
     WakeupThread(bgmThreadID);
 }
 
+static int bgmOpenCache(u32 srcSize)
+{
+    bgmCacheIn = fopen(bgmCachePath, "rb");
+    if (bgmCacheIn == NULL)
+        return -ENOENT;
+
+    if (fread(&bgmCacheHeader, 1, sizeof(bgmCacheHeader), bgmCacheIn) != sizeof(bgmCacheHeader) ||
+        bgmCacheHeader.magic != BGM_CACHE_MAGIC || bgmCacheHeader.version != BGM_CACHE_VERSION ||
+        bgmCacheHeader.srcSize != srcSize || bgmCacheHeader.dataSize == 0) {
+        LOG("BGM: Cache %s is outdated\n", bgmCachePath);
+        fclose(bgmCacheIn);
+        bgmCacheIn = NULL;
+        return -EINVAL;
+    }
+
+    bgmChannels = bgmCacheHeader.channels;
+    bgmRate = bgmCacheHeader.rate;
+    bgmCacheLeft = bgmCacheHeader.dataSize;
+
+    return 0;
+}
+
+static void bgmCreateCache(u32 srcSize)
+{
+    bgmCacheHeader.magic = BGM_CACHE_MAGIC;
+    bgmCacheHeader.version = BGM_CACHE_VERSION;
+    bgmCacheHeader.channels = bgmChannels;
+    bgmCacheHeader.rate = bgmRate;
+    bgmCacheHeader.srcSize = srcSize;
+    bgmCacheHeader.dataSize = 0;
+
+    bgmCacheOut = fopen(bgmCachePath, "wb");
+    if (bgmCacheOut != NULL && fwrite(&bgmCacheHeader, 1, sizeof(bgmCacheHeader), bgmCacheOut) != sizeof(bgmCacheHeader))
+        bgmCacheAbort();
+}
+
 static int bgmLoad(void)
 {
     FILE *bgmFile;
     char bgmPath[256];
-
-    vorbisFile = malloc(sizeof(OggVorbis_File));
-    memset(vorbisFile, 0, sizeof(OggVorbis_File));
+    struct stat st;
+    char *ext;
+    int useCache;
 
     int themeID = thmGetGuiValue();
     if (themeID != 0) {
@@ -340,6 +502,22 @@ static int bgmLoad(void)
     } else
         snprintf(bgmPath, sizeof(bgmPath), gDefaultBGMPath);
 
+    // Memory cards are too small and slow for uncompressed audio.
+    useCache = gBGMCache && strncmp(bgmPath, "mc", 2) && stat(bgmPath, &st) == 0;
+    if (useCache) {
+        snprintf(bgmCachePath, sizeof(bgmCachePath), "%s", bgmPath);
+        ext = strrchr(bgmCachePath, '.');
+        if (ext == NULL || strchr(ext, '/') != NULL)
+            ext = &bgmCachePath[strlen(bgmCachePath)];
+        snprintf(ext, sizeof(bgmCachePath) - (ext - bgmCachePath), ".pcm");
+
+        if (bgmOpenCache(st.st_size) == 0)
+            return 0;
+    }
+
+    vorbisFile = malloc(sizeof(OggVorbis_File));
+    memset(vorbisFile, 0, sizeof(OggVorbis_File));
+
     bgmFile = fopen(bgmPath, "rb");
     if (bgmFile == NULL) {
         LOG("BGM: Failed to open Ogg file %s\n", bgmPath);
@@ -351,6 +529,15 @@ static int bgmLoad(void)
         return -ENOENT;
     }
 
+    vorbis_info *vi = ov_info(vorbisFile, -1);
+    ov_pcm_seek(vorbisFile, 0);
+
+    bgmChannels = vi->channels;
+    bgmRate = vi->rate;
+
+    if (useCache)
+        bgmCreateCache(st.st_size);
+
     return 0;
 }
 
@@ -363,6 +550,10 @@ static int bgmInit(void)
     terminateFlag = 0;
     rdPtr = 0;
     wrPtr = 0;
+    bgmPartsQueued = 0;
+    bgmPartsPlayed = 0;
+    bgmUnderruns = 0;
+    bgmMinDepth = BGM_RING_BUFFER_COUNT;
     bgmThreadRunning = 0;
     bgmIoThreadRunning = 0;
 
@@ -432,10 +623,20 @@ static void bgmDeinit(void)
     DeleteThread(bgmThreadID);
     DeleteThread(bgmIoThreadID);
 
-    // Vorbisfile takes care of fclose.
-    ov_clear(vorbisFile);
-    free(vorbisFile);
-    vorbisFile = NULL;
+    // An incomplete cache is of no use.
+    bgmCacheAbort();
+
+    if (bgmCacheIn != NULL) {
+        fclose(bgmCacheIn);
+        bgmCacheIn = NULL;
+    }
+
+    if (vorbisFile != NULL) {
+        // Vorbisfile takes care of fclose.
+        ov_clear(vorbisFile);
+        free(vorbisFile);
+        vorbisFile = NULL;
+    }
 }
 
 static void bgmShutdownDelayCallback(s32 alarm_id, u16 time, void *common)
@@ -459,11 +660,8 @@ void bgmStart(void)
             return;
         }
 
-        vorbis_info *vi = ov_info(vorbisFile, -1);
-        ov_pcm_seek(vorbisFile, 0);
-
-        audsrvFmt.channels = vi->channels;
-        audsrvFmt.freq = vi->rate;
+        audsrvFmt.channels = bgmChannels;
+        audsrvFmt.freq = bgmRate;
         audsrvFmt.bits = 16;
 
         audsrv_set_format(&audsrvFmt);
@@ -499,6 +697,8 @@ void bgmStop(void)
         SleepThread();
     }
 
+    LOG("BGM: %u parts played, %u underruns, minimum ring depth %u\n", bgmPartsPlayed, bgmUnderruns, bgmMinDepth);
+
     bgmDeinit();
 
     LOG("BGM: stopped.\n");
@@ -511,6 +711,13 @@ int isBgmPlaying(void)
     return ret;
 }
 
+void bgmGetRingStats(int *depth, int *minDepth, int *underruns)
+{
+    *depth = bgmPartsQueued - bgmPartsPlayed;
+    *minDepth = bgmMinDepth;
+    *underruns = bgmUnderruns;
+}
+
 // HACK: BGM stutters while perfroming certain tasks, mute during these operations and unmute once completed.
 void bgmMute(void)
 {
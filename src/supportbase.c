@@ -6,6 +6,7 @@
 #include "include/supportbase.h"
 #include "include/ioman.h"
 #include "modules/iopcore/common/cdvd_config.h"
+#include "modules/iopcore/common/iotrace.h"
 #include "include/cheatman.h"
 #include "include/pggsm.h"
 #include "include/cheatman.h"
@@ -717,6 +718,37 @@ void sbCreatePath(const base_game_info_t *game, char *path, const char *prefix,
     sbCreatePath_name(game, path, prefix, sep, part, game->name);
 }
 
+#ifdef __IO_TRACE
+int sbCreateIoTrace(const base_game_info_t *game, const char *prefix, const char *sep)
+{
+    char path[256];
+    void *buffer;
+    int fd;
+
+    // <image>.iot, without the part number of split images.
+    if (game->format == GAME_FORMAT_USBLD) {
+        snprintf(path, sizeof(path), "%sul.%08X.%s.iot", prefix, USBA_crc32(game->name), game->startup);
+    } else {
+        sbCreatePath(game, path, prefix, sep, 0);
+        strncat(path, ".iot", sizeof(path) - strlen(path) - 1);
+    }
+
+    // cdvdman can only overwrite the file, so allocate all of it. Any previous trace is discarded.
+    if ((buffer = calloc(1, IOTRACE_FILE_SIZE)) == NULL)
+        return -ENOMEM;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd >= 0 && write(fd, buffer, IOTRACE_FILE_SIZE) != (int)IOTRACE_FILE_SIZE) {
+        close(fd);
+        fd = -EIO;
+    }
+    free(buffer);
+
+    LOG("sbCreateIoTrace: %s, result %d\n", path, fd);
+    return fd;
+}
+#endif
+
 void sbDelete(base_game_info_t **list, const char *prefix, const char *sep, int gamecount, int id)
 {
     int part;
@@ -22,6 +22,7 @@
 #include "include/renderman.h"
 #include "include/extern_irx.h"
 #include "../ee_core/include/modules.h"
+#include "../modules/isofs/lz4.h"
 #include "../ee_core/include/coreconfig.h"
 #include <osd_config.h>
 #include "include/pggsm.h"
@@ -459,13 +460,59 @@ static void *GetModStorageLocation(const char *startup, unsigned compatFlags)
     return ((void *)OPL_MOD_STORAGE);
 }
 
+static irxlz4_header_t *getIrxLz4Header(const irxptr_t *irx)
+{
+    irxlz4_header_t *header = (irxlz4_header_t *)irx->ptr;
+
+    if (GET_OPL_MOD_SIZE(irx->info) > sizeof(irxlz4_header_t) && header->magic == IRXLZ4_MAGIC)
+        return header;
+
+    return NULL;
+}
+
+/* Picks the size of the buffer that the EE core will decompress modules into.
+   Compressed modules larger than it are stored decompressed instead, so choose the size that needs the least module storage. */
+static unsigned int planIrxScratch(const irxptr_t *irxptr_tab, int first, int modcount)
+{
+    irxlz4_header_t *header, *other;
+    unsigned int best, bestCost, cost;
+    int i, j;
+
+    // Without a scratch buffer, every module is stored decompressed.
+    best = 0;
+    bestCost = 0;
+    for (i = first; i < modcount; i++) {
+        if ((header = getIrxLz4Header(&irxptr_tab[i])) != NULL)
+            bestCost += (header->size + 0xF) & ~0xF;
+    }
+
+    for (i = first; i < modcount; i++) {
+        if ((header = getIrxLz4Header(&irxptr_tab[i])) == NULL)
+            continue;
+
+        cost = (header->size + 0xF) & ~0xF;
+        for (j = first; j < modcount; j++) {
+            if ((other = getIrxLz4Header(&irxptr_tab[j])) != NULL)
+                cost += ((other->size > header->size ? other->size : GET_OPL_MOD_SIZE(irxptr_tab[j].info)) + 0xF) & ~0xF;
+        }
+
+        if (cost < bestCost) {
+            best = header->size;
+            bestCost = cost;
+        }
+    }
+
+    return best;
+}
+
 static unsigned int sendIrxKernelRAM(const char *startup, const char *mode_str, unsigned int modules, void *ModuleStorage, int size_cdvdman_irx, void **cdvdman_irx, int size_mcemu_irx, void **mcemu_irx)
 { // Send IOP modules that core must use to Kernel RAM
     irxtab_t *irxtable;
     irxptr_t *irxptr_tab;
+    irxlz4_header_t *lz4header;
     void *irxptr, *ioprp_image;
-    int i, modcount;
-    unsigned int curIrxSize, size_ioprp_image, total_size;
+    int i, modcount, result;
+    unsigned int curIrxSize, size_ioprp_image, total_size, scratchSize;
 
     if (!strcmp(mode_str, "BDM_USB_MODE"))
         modules |= CORE_IRX_USB;
@@ -598,15 +645,31 @@ static unsigned int sendIrxKernelRAM(const char *startup, const char *mode_str,
     irxptr = (void *)((((unsigned int)irxptr_tab + sizeof(irxptr_t) * modcount) + 0xF) & ~0xF);
 
 #ifdef __DECI2_DEBUG
+    scratchSize = planIrxScratch(irxptr_tab, 1, modcount);
     for (i = 1; i < modcount; i++) {
 #else
+    scratchSize = planIrxScratch(irxptr_tab, 0, modcount);
     for (i = 0; i < modcount; i++) {
 #endif
         curIrxSize = GET_OPL_MOD_SIZE(irxptr_tab[i].info);
 
         if (curIrxSize > 0) {
-            LOG("SYSTEM IRX %u address start: %p end: %p\n", GET_OPL_MOD_ID(irxptr_tab[i].info), irxptr, (void *)((u8 *)irxptr + curIrxSize));
-            memcpy(irxptr, irxptr_tab[i].ptr, curIrxSize);
+            lz4header = getIrxLz4Header(&irxptr_tab[i]);
+            if (lz4header != NULL && lz4header->size > scratchSize) {
+                // Too large for the scratch buffer, store it decompressed.
+                LOG("SYSTEM IRX %u address start: %p end: %p (decompressed)\n", GET_OPL_MOD_ID(irxptr_tab[i].info), irxptr, (void *)((u8 *)irxptr + lz4header->size));
+                result = LZ4_decompress_safe((const char *)(lz4header + 1), irxptr, curIrxSize - sizeof(irxlz4_header_t), lz4header->size);
+                if (result != lz4header->size) {
+                    LOG("SYSTEM IRX %u is corrupted\n", GET_OPL_MOD_ID(irxptr_tab[i].info));
+                    result = 0;
+                }
+                curIrxSize = result;
+                irxptr_tab[i].info = curIrxSize | SET_OPL_MOD_ID(GET_OPL_MOD_ID(irxptr_tab[i].info));
+            } else {
+                // Compressed modules that fit the scratch buffer are decompressed by the EE core, just before they are loaded.
+                LOG("SYSTEM IRX %u address start: %p end: %p\n", GET_OPL_MOD_ID(irxptr_tab[i].info), irxptr, (void *)((u8 *)irxptr + curIrxSize));
+                memcpy(irxptr, irxptr_tab[i].ptr, curIrxSize);
+            }
 
             irxptr_tab[i].ptr = irxptr;
             irxptr = (void *)((u8 *)irxptr + ((curIrxSize + 0xF) & ~0xF));
@@ -616,6 +679,11 @@ static unsigned int sendIrxKernelRAM(const char *startup, const char *mode_str,
         }
     }
 
+    irxtable->scratch = scratchSize > 0 ? irxptr : NULL;
+    irxtable->scratchSize = scratchSize;
+    total_size += ((scratchSize + 0xF) & ~0xF);
+    LOG("SYSTEM IRX scratch buffer: %u bytes\n", scratchSize);
+
     free(ioprp_image);
 
     LOG("SYSTEM IRX STORAGE %p - %p\n", ModuleStorage, (u8 *)ModuleStorage + total_size);
@@ -907,8 +975,11 @@ void sysLaunchLoaderElf(const char *filename, const char *mode_str, int size_cdv
     if (GetCheatsEnabled()) {
         set_cheats_list();
         config->gCheatList = GetCheatsList();
-    } else
+        config->gCheatProgram = (u32 *)GetCheatsProgram(&config->gCheatProgramSize);
+    } else {
         config->gCheatList = NULL;
+        config->gCheatProgram = NULL;
+    }
 
     sprintf(config->g_ps2_ip, "%u.%u.%u.%u", local_ip_address[0], local_ip_address[1], local_ip_address[2], local_ip_address[3]);
     sprintf(config->g_ps2_netmask, "%u.%u.%u.%u", local_netmask[0], local_netmask[1], local_netmask[2], local_netmask[3]);
@@ -0,0 +1,78 @@
+/*
+  Licenced under Academic Free License version 3.0
+  Review Open PS2 Loader README & LICENSE files for further details.
+
+  Text files, such as the configs and the language files, read whole into a single buffer and split into lines in place.
+  Also built on the PC by pc/tests/src/textbuffer_test.c.
+*/
+
+#include "include/opl.h"
+#include "include/util.h"
+
+/* Takes over buffer, which must hold size characters followed by a NUL (as returned by readFile).
+   The lines are split in place, so they remain valid for as long as the buffer. */
+void openTextBufferBuffer(text_buffer_t *text, char *buffer, unsigned int size)
+{
+    text->buffer = buffer;
+    text->next = buffer;
+    text->end = buffer + size;
+
+    // Skip the UTF-8 BOM sequence.
+    if (size >= 3 && buffer[0] == '\xEF' && buffer[1] == '\xBB' && buffer[2] == '\xBF')
+        text->next += 3;
+}
+
+/* Reads the whole file with a single read */
+int openTextBuffer(text_buffer_t *text, char *fpath)
+{
+    int size = -1;
+    char *buffer;
+
+    buffer = readFile(fpath, 1, &size);
+    if (buffer == NULL)
+        return 0;
+
+    openTextBufferBuffer(text, buffer, size);
+    return 1;
+}
+
+/* Returns the next line, without the line ending (LF or CR/LF). Lines that begin with '#' are comments and are skipped.
+   length may be NULL. */
+int readTextLine(text_buffer_t *text, char **line, int *length)
+{
+    char *start, *posLF;
+    int lineSize;
+
+    while (text->next < text->end) {
+        start = text->next;
+        posLF = memchr(start, '\n', text->end - start);
+        if (posLF) {
+            lineSize = posLF - start;
+            text->next = posLF + 1;
+        } else {
+            lineSize = text->end - start;
+            text->next = text->end;
+        }
+
+        // Check the previous char (on Windows there are CR/LF instead of single linux LF)
+        if (lineSize && start[lineSize - 1] == '\r')
+            lineSize--;
+        start[lineSize] = '\0';
+
+        if (start[0] == '#') // '#' for comment lines
+            continue;
+
+        *line = start;
+        if (length)
+            *length = lineSize;
+        return 1;
+    }
+
+    return 0;
+}
+
+void closeTextBuffer(text_buffer_t *text)
+{
+    free(text->buffer);
+    text->buffer = NULL;
+}
@@ -101,6 +101,43 @@ extern void *apps_case_png;
 // Not related to screen size, just to limit at some point
 static int maxSize = 720 * 512 * 4;
 
+// Pre-converted GS texture container, produced by pc/png2gst.py.
+// The header is followed by the pixel data and then the CLUT (if any), both stored exactly
+// as texReadPixels* leave them in EE RAM, so they can be read straight into the texture buffers.
+#define GST_MAGIC   0x31545347 // "GST1"
+#define GST_VERSION 1
+
+typedef struct
+{
+    u32 magic;
+    u16 version;
+    u16 headerSize;
+    u16 width;
+    u16 height;
+    u8 psm;
+    u8 clutPsm;
+    u16 reserved;
+    u32 dataSize;
+    u32 clutSize;
+    u8 padding[104]; // Pad to 128 bytes, so that the pixel data starts aligned within the file
+} gst_header_t;
+
+// Folders converted by png2gst.py hold this file. The others are PNG-only, so their images skip the .gst lookup (an extra open() per image, which is slow over SMB).
+#define GST_DIR_MARKER "png2gst.txt"
+
+// Folders whose marker was looked for, by hashes of their paths. Looked up by both the GUI and the io thread.
+#define GST_DIRS 8
+
+typedef struct
+{
+    u32 hash;
+    int converted;
+} gst_dir_t;
+
+static gst_dir_t gstDirs[GST_DIRS];
+static int gstDirsNext;
+static int gstDirsSemaId = -1;
+
 typedef struct
 {
     int id;
@@ -539,6 +576,70 @@ static int texLoadAll(GSTEXTURE *texture, const char *filePath, int texId)
     return texEnd(pngPtr, infoPtr, pFileBuffer, 0);
 }
 
+static int texLoadGst(GSTEXTURE *texture, int fd)
+{
+    gst_header_t header;
+    int clutSize;
+
+    texPrepare(texture);
+
+    if (read(fd, &header, sizeof(header)) != sizeof(header) || header.magic != GST_MAGIC || header.version != GST_VERSION || header.headerSize != sizeof(header))
+        return ERR_BAD_FILE;
+
+    switch (header.psm) {
+        case GS_PSM_CT32:
+        case GS_PSM_CT24:
+            if (header.clutPsm != 0)
+                return ERR_BAD_FILE;
+            clutSize = 0;
+            break;
+        case GS_PSM_T8:
+            clutSize = gsKit_texture_size_ee(16, 16, GS_PSM_CT32);
+            break;
+        case GS_PSM_T4:
+            clutSize = gsKit_texture_size_ee(8, 2, GS_PSM_CT32);
+            break;
+        default:
+            return ERR_BAD_DEPTH;
+    }
+
+    // The CLUT is always stored as CT32, like texReadPixels4/8 leave it
+    if (clutSize > 0 && header.clutPsm != GS_PSM_CT32)
+        return ERR_BAD_FILE;
+
+    texture->Width = header.width;
+    texture->Height = header.height;
+    texture->PSM = header.psm;
+
+    if (texSizeValidate(texture->Width, texture->Height, texture->PSM) < 0)
+        return ERR_BAD_DIMENSION;
+
+    if (header.dataSize != gsKit_texture_size_ee(texture->Width, texture->Height, texture->PSM) || header.clutSize != clutSize)
+        return ERR_BAD_FILE;
+
+    texture->Mem = memalign(128, header.dataSize);
+    if (!texture->Mem) {
+        LOG("TEXTURES GstReadData: Failed to allocate %d bytes\n", header.dataSize);
+        return ERR_BAD_FILE;
+    }
+
+    if (read(fd, texture->Mem, header.dataSize) != header.dataSize) {
+        texFree(texture);
+        return ERR_BAD_FILE;
+    }
+
+    if (clutSize > 0) {
+        texture->ClutPSM = header.clutPsm;
+        texture->Clut = memalign(128, clutSize);
+        if (!texture->Clut || read(fd, texture->Clut, clutSize) != clutSize) {
+            texFree(texture);
+            return ERR_BAD_FILE;
+        }
+    }
+
+    return 0;
+}
+
 static int texLoad(GSTEXTURE *texture, const char *filePath)
 {
     return texLoadAll(texture, filePath, -1);
@@ -549,23 +650,118 @@ int texLoadInternal(GSTEXTURE *texture, int texId)
     return texLoadAll(texture, NULL, texId);
 }
 
+void texInit(void)
+{
+    ee_sema_t sema;
+
+    sema.init_count = 1;
+    sema.max_count = 1;
+    sema.option = 0;
+    gstDirsSemaId = CreateSema(&sema);
+}
+
+// Returns the length of the folder part of the path
+static int texGstDirLength(const char *path)
+{
+    int i, length = 0;
+
+    for (i = 0; path[i] != '\0'; i++) {
+        if (path[i] == '/' || path[i] == '\\' || path[i] == ':')
+            length = i + 1;
+    }
+
+    return length;
+}
+
+static u32 texGstDirHash(const char *path, int length)
+{
+    u32 hash = 5381;
+    int i;
+
+    for (i = 0; i < length; i++)
+        hash = hash * 33 + (unsigned char)path[i];
+
+    return hash != 0 ? hash : 1;
+}
+
+// Returns 1 if the folder was converted by png2gst.py, 0 if not, -1 if it was not looked at yet
+static int texGstDirConverted(u32 dirHash)
+{
+    int i, converted = -1;
+
+    WaitSema(gstDirsSemaId);
+    for (i = 0; i < GST_DIRS; i++) {
+        if (gstDirs[i].hash == dirHash) {
+            converted = gstDirs[i].converted;
+            break;
+        }
+    }
+    SignalSema(gstDirsSemaId);
+
+    return converted;
+}
+
+static void texGstProbeDir(const char *path, int length, u32 dirHash)
+{
+    char markerPath[256];
+    int fd, converted;
+
+    snprintf(markerPath, sizeof(markerPath), "%.*s%s", length, path, GST_DIR_MARKER);
+    fd = open(markerPath, O_RDONLY);
+    converted = fd > 0;
+    if (converted)
+        close(fd);
+
+    WaitSema(gstDirsSemaId);
+    gstDirs[gstDirsNext].hash = dirHash;
+    gstDirs[gstDirsNext].converted = converted;
+    gstDirsNext = (gstDirsNext + 1) % GST_DIRS;
+    SignalSema(gstDirsSemaId);
+}
+
 int texDiscoverLoad(GSTEXTURE *texture, const char *path, int texId)
 {
     char filePath[256];
+    int dirLength, converted, fd;
+    u32 dirHash;
 
     LOG("texDiscoverLoad(%s)\n", path);
 
+    // Prefer the pre-converted GS texture if present, as it needs no decoding.
+    if (texId != -1)
+        snprintf(filePath, sizeof(filePath), "%s%s.%s", path, internalDefault[texId].name, "gst");
+    else
+        snprintf(filePath, sizeof(filePath), "%s.%s", path, "gst");
+
+    dirLength = texGstDirLength(filePath);
+    dirHash = texGstDirHash(filePath, dirLength);
+
+    converted = texGstDirConverted(dirHash);
+    if (converted != 0) {
+        fd = open(filePath, O_RDONLY);
+        if (fd > 0) {
+            int result = texLoadGst(texture, fd);
+            close(fd);
+            if (result >= 0)
+                return 0;
+
+            LOG("texDiscoverLoad: bad GS texture %s (%d), falling back to PNG\n", filePath, result);
+        } else if (converted < 0) // First miss in the folder: PNG-only, unless png2gst.py skipped some of its images
+            texGstProbeDir(filePath, dirLength, dirHash);
+    }
+
     if (texId != -1)
         snprintf(filePath, sizeof(filePath), "%s%s.%s", path, internalDefault[texId].name, "png");
     else
         snprintf(filePath, sizeof(filePath), "%s.%s", path, "png");
 
-    int fd = open(filePath, O_RDONLY);
+    fd = open(filePath, O_RDONLY);
     if (fd > 0) {
         // File found, load it
         close(fd);
+
         return (texLoad(texture, filePath) >= 0) ? 0 : ERR_BAD_FILE;
     }
 
     return ERR_BAD_FILE;
-}
\ No newline at end of file
+}
@@ -14,6 +14,13 @@
 #define HINT_HEIGHT    32
 #define DECORATOR_SIZE 20
 
+// Loading states of the theme images
+#define THM_IMAGE_LOADED   0
+#define THM_IMAGE_DEFERRED 1 // Not drawn yet
+#define THM_IMAGE_QUEUED   2 // Being loaded by the io worker
+#define THM_IMAGE_FAILED   3
+#define THM_IMAGE_ORPHANED 4 // Freed while queued, the io worker frees it once done
+
 extern const char conf_theme_OPL_cfg;
 extern u16 size_conf_theme_OPL_cfg;
 
@@ -26,6 +33,7 @@ static int guiThemeID = 0;
 static int nThemes = 0;
 static theme_file_t themes[THM_MAX_FILES];
 static const char **guiThemesNames = NULL;
+static int thmImageSemaId = -1;
 
 // Global data
 theme_t *gTheme;
@@ -332,7 +340,7 @@ static void findDuplicate(theme_element_t *first, const char *cachePattern, cons
     }
 }
 
-static void freeImageTexture(image_texture_t *texture)
+static void destroyImageTexture(image_texture_t *texture)
 {
     if (texture) {
         if (texture->source.Mem) {
@@ -348,28 +356,134 @@ static void freeImageTexture(image_texture_t *texture)
             free(texture->name);
             texture->name = NULL;
         }
+        if (texture->path) {
+            free(texture->path);
+            texture->path = NULL;
+        }
         free(texture);
     }
 }
 
+static void freeImageTexture(image_texture_t *texture)
+{
+    if (texture) {
+        WaitSema(thmImageSemaId);
+        if (texture->loadState == THM_IMAGE_QUEUED) {
+            // The io worker still uses it, leave it to the worker.
+            texture->loadState = THM_IMAGE_ORPHANED;
+            texture = NULL;
+        }
+        SignalSema(thmImageSemaId);
+
+        destroyImageTexture(texture);
+    }
+}
+
+typedef struct
+{
+    image_texture_t *texture;
+    u32 queued; // cpu_ticks() when queued
+} load_theme_image_request_t;
+
+// Io handled action...
+static void thmLoadImage(void *data)
+{
+    load_theme_image_request_t *req = data;
+    image_texture_t *texture = req->texture;
+    GSTEXTURE source;
+    int result = -1;
+
+    source.Mem = NULL;
+    source.Clut = NULL;
+
+    if (texture->loadState != THM_IMAGE_ORPHANED) {
+#ifdef __DEBUG
+        u32 start = cpu_ticks();
+#endif
+        result = texDiscoverLoad(&source, texture->path, -1);
+#ifdef __DEBUG
+        LOG("THEMES Image %s: %s, waited %u ms, loaded in %u ms\n", texture->path, result >= 0 ? "ok" : "failed",
+            (start - req->queued) / CPU_TICKS_PER_MSEC, (cpu_ticks() - start) / CPU_TICKS_PER_MSEC);
+#endif
+    }
+
+    WaitSema(thmImageSemaId);
+    if (texture->loadState == THM_IMAGE_ORPHANED) {
+        SignalSema(thmImageSemaId);
+        texFree(&source);
+        destroyImageTexture(texture);
+    } else {
+        if (result >= 0) {
+            texture->source = source;
+            texture->loadState = THM_IMAGE_LOADED;
+        } else {
+            texFree(&source);
+            texture->loadState = THM_IMAGE_FAILED;
+        }
+        SignalSema(thmImageSemaId);
+    }
+
+    free(req);
+}
+
+/* Returns the texture of an image, or NULL while it is not loaded.
+   The images of a theme on a device are queued to the io worker when first drawn, so the pages that are never shown are not loaded.
+   The io worker serves its requests in order: the images of the main menu are queued by thmLoad, ahead of the art of its first draw. */
+static GSTEXTURE *thmGetImage(image_texture_t *texture)
+{
+    if (!texture)
+        return NULL;
+
+    if (texture->loadState == THM_IMAGE_DEFERRED) {
+        load_theme_image_request_t *req = (load_theme_image_request_t *)malloc(sizeof(load_theme_image_request_t));
+        if (req) {
+            req->texture = texture;
+            req->queued = cpu_ticks();
+
+            texture->loadState = THM_IMAGE_QUEUED;
+            if (ioPutRequest(IO_THEME_LOAD_IMAGE, req) != IO_OK) {
+                // io is blocked, try again on the next draw
+                texture->loadState = THM_IMAGE_DEFERRED;
+                free(req);
+            }
+        }
+
+        return NULL;
+    }
+
+    if (texture->loadState == THM_IMAGE_LOADED && texture->source.Mem)
+        return &texture->source;
+
+    return NULL;
+}
+
+// Stands for an image that is still loading, in the rectangle of its element. Elements sized by their image have no rectangle yet.
+static void drawImagePlaceholder(image_texture_t *texture, int x, int y, short aligned, int w, int h, short scaled)
+{
+    if (texture && (texture->loadState == THM_IMAGE_DEFERRED || texture->loadState == THM_IMAGE_QUEUED) && w != DIM_UNDEF && h != DIM_UNDEF)
+        rmDrawAlignedRect(x, y, aligned, w, h, scaled, gColDarker);
+}
+
 static image_texture_t *initImageTexture(const char *themePath, config_set_t *themeConfig, const char *name, const char *imgName, int isOverlay)
 {
     image_texture_t *texture = (image_texture_t *)malloc(sizeof(image_texture_t));
     texture->name = NULL;
+    texture->path = NULL;
+    texture->source.Mem = NULL;
+    texture->source.Clut = NULL;
 
-    int texId = -1;
     int result = 0;
 
     if (themePath) {
-        char path[256];
-        snprintf(path, sizeof(path), "%s%s", themePath, imgName);
-        if (texDiscoverLoad(&texture->source, path, texId) >= 0)
-            ;
+        // Loaded on first draw, see thmGetImage
+        int length = strlen(themePath) + strlen(imgName) + 1;
+        texture->path = (char *)malloc(length * sizeof(char));
+        snprintf(texture->path, length, "%s%s", themePath, imgName);
+        texture->loadState = THM_IMAGE_DEFERRED;
         result = 1;
     } else {
-        texId = texLookupInternalTexId(imgName);
-        if (texLoadInternal(&texture->source, texId) >= 0)
-            ;
+        texLoadInternal(&texture->source, texLookupInternalTexId(imgName));
+        texture->loadState = THM_IMAGE_LOADED;
         result = 1;
     }
 
@@ -418,6 +532,10 @@ static image_texture_t *initImageInternalTexture(config_set_t *themeConfig, cons
 {
     image_texture_t *texture = (image_texture_t *)malloc(sizeof(image_texture_t));
     texture->name = NULL;
+    texture->path = NULL;
+    texture->source.Mem = NULL;
+    texture->source.Clut = NULL;
+    texture->loadState = THM_IMAGE_LOADED;
     int result;
 
     if ((result = texLookupInternalTexId(name)) >= 0) {
@@ -514,17 +632,43 @@ static mutable_image_t *initMutableImage(const char *themePath, config_set_t *th
     return mutableImage;
 }
 
+// Queues the images of the elements, as their first draw would
+static void queueMutableImages(theme_elems_t *elems)
+{
+    theme_element_t *elem;
+    mutable_image_t *mutableImage;
+
+    for (elem = elems->first; elem; elem = elem->next) {
+        if (elem->endElem == &endMutableImage && (mutableImage = (mutable_image_t *)elem->extended) != NULL) {
+            thmGetImage(mutableImage->defaultTexture);
+            thmGetImage(mutableImage->overlayTexture);
+        }
+    }
+}
+
 // StaticImage //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void drawStaticImage(struct menu_list *menu, struct submenu_list *item, config_set_t *config, struct theme_element *elem)
 {
     mutable_image_t *staticImage = (mutable_image_t *)elem->extended;
-    if (staticImage->overlayTexture) {
-        rmDrawOverlayPixmap(&staticImage->overlayTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
-                            &staticImage->defaultTexture->source, staticImage->overlayTexture->upperLeft_x, staticImage->overlayTexture->upperLeft_y, staticImage->overlayTexture->upperRight_x, staticImage->overlayTexture->upperRight_y,
+    GSTEXTURE *texture = thmGetImage(staticImage->defaultTexture);
+    GSTEXTURE *overlay = thmGetImage(staticImage->overlayTexture);
+
+    if (!texture) {
+        // Not loaded yet, the background shows the plasma meanwhile
+        if (elem->type == ELEM_TYPE_BACKGROUND)
+            guiDrawBGPlasma();
+        else
+            drawImagePlaceholder(staticImage->defaultTexture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled);
+        return;
+    }
+
+    if (overlay) {
+        rmDrawOverlayPixmap(overlay, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
+                            texture, staticImage->overlayTexture->upperLeft_x, staticImage->overlayTexture->upperLeft_y, staticImage->overlayTexture->upperRight_x, staticImage->overlayTexture->upperRight_y,
                             staticImage->overlayTexture->lowerLeft_x, staticImage->overlayTexture->lowerLeft_y, staticImage->overlayTexture->lowerRight_x, staticImage->overlayTexture->lowerRight_y);
     } else
-        rmDrawPixmap(&staticImage->defaultTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
+        rmDrawPixmap(texture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
 }
 
 static void initStaticImage(const char *themePath, config_set_t *themeConfig, theme_t *theme, theme_element_t *elem, const char *name, const char *imageName)
@@ -557,26 +701,29 @@ static void drawGameImage(struct menu_list *menu, struct submenu_list *item, con
     mutable_image_t *gameImage = (mutable_image_t *)elem->extended;
     if (item) {
         GSTEXTURE *texture = getGameImageTexture(gameImage->cache, menu->item->userdata, &item->item);
+        GSTEXTURE *overlay = thmGetImage(gameImage->overlayTexture);
         if (!texture || !texture->Mem) {
-            if (gameImage->defaultTexture)
-                texture = &gameImage->defaultTexture->source;
-            else {
+            texture = thmGetImage(gameImage->defaultTexture);
+            if (!texture) {
                 if (elem->type == ELEM_TYPE_BACKGROUND)
                     guiDrawBGPlasma();
+                else
+                    drawImagePlaceholder(gameImage->defaultTexture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled);
                 return;
             }
         }
 
-        if (gameImage->overlayTexture) {
-            rmDrawOverlayPixmap(&gameImage->overlayTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
+        if (overlay) {
+            rmDrawOverlayPixmap(overlay, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
                                 texture, gameImage->overlayTexture->upperLeft_x, gameImage->overlayTexture->upperLeft_y, gameImage->overlayTexture->upperRight_x, gameImage->overlayTexture->upperRight_y,
                                 gameImage->overlayTexture->lowerLeft_x, gameImage->overlayTexture->lowerLeft_y, gameImage->overlayTexture->lowerRight_x, gameImage->overlayTexture->lowerRight_y);
         } else
             rmDrawPixmap(texture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
 
     } else if (elem->type == ELEM_TYPE_BACKGROUND) {
-        if (gameImage->defaultTexture)
-            rmDrawPixmap(&gameImage->defaultTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
+        GSTEXTURE *texture = thmGetImage(gameImage->defaultTexture);
+        if (texture)
+            rmDrawPixmap(texture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
         else
             guiDrawBGPlasma();
     }
@@ -627,8 +774,9 @@ static void drawAttributeImage(struct menu_list *menu, struct submenu_list *item
                 int posZ = 0;
                 GSTEXTURE *texture = cacheGetTexture(attributeImage->cache, menu->item->userdata, &posZ, &attributeImage->currentUid, attributeImage->currentValue);
                 if (texture && texture->Mem) {
-                    if (attributeImage->overlayTexture) {
-                        rmDrawOverlayPixmap(&attributeImage->overlayTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
+                    GSTEXTURE *overlay = thmGetImage(attributeImage->overlayTexture);
+                    if (overlay) {
+                        rmDrawOverlayPixmap(overlay, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol,
                                             texture, attributeImage->overlayTexture->upperLeft_x, attributeImage->overlayTexture->upperLeft_y, attributeImage->overlayTexture->upperRight_x, attributeImage->overlayTexture->upperRight_y,
                                             attributeImage->overlayTexture->lowerLeft_x, attributeImage->overlayTexture->lowerLeft_y, attributeImage->overlayTexture->lowerRight_x, attributeImage->overlayTexture->lowerRight_y);
                     } else
@@ -639,8 +787,11 @@ static void drawAttributeImage(struct menu_list *menu, struct submenu_list *item
             }
         }
     }
-    if (attributeImage->defaultTexture)
-        rmDrawPixmap(&attributeImage->defaultTexture->source, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
+    GSTEXTURE *texture = thmGetImage(attributeImage->defaultTexture);
+    if (texture)
+        rmDrawPixmap(texture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled, gDefaultCol);
+    else
+        drawImagePlaceholder(attributeImage->defaultTexture, elem->posX, elem->posY, elem->aligned, elem->width, elem->height, elem->scaled);
 }
 
 static void initAttributeImage(const char *themePath, config_set_t *themeConfig, theme_t *theme, theme_element_t *elem, const char *name)
@@ -655,6 +806,67 @@ static void initAttributeImage(const char *themePath, config_set_t *themeConfig,
         LOG("THEMES AttributeImage %s: NO attribute, elem disabled !!\n", name);
 }
 
+// Fonts ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Loads a font slot of the theme the first time it is used, so the fonts no element uses are never loaded
+static int thmLoadFont(config_set_t *themeConfig, const char *themePath, theme_t *theme, int fntID)
+{
+    if (!themePath || (theme->fontsLoaded & (1 << fntID)))
+        return theme->fonts[fntID];
+
+    theme->fontsLoaded |= 1 << fntID;
+
+    // does the font by the key exist?
+    char fntKey[16];
+    if (fntID == 0)
+        snprintf(fntKey, sizeof(fntKey), "default_font");
+    else
+        snprintf(fntKey, sizeof(fntKey), "font%d", fntID);
+
+    char fullPath[128];
+    const char *fntFile;
+    if (configGetStr(themeConfig, fntKey, &fntFile)) {
+        snprintf(fullPath, sizeof(fullPath), "%s%s", themePath, fntFile);
+
+        int fontSize;
+        char sizeKey[64];
+        if (fntID == 0)
+            snprintf(sizeKey, sizeof(sizeKey), "default_font_size");
+        else
+            snprintf(sizeKey, sizeof(sizeKey), "font%d_size", fntID);
+
+        if (!configGetInt(themeConfig, sizeKey, &fontSize) || fontSize <= 0)
+            fontSize = FNTSYS_DEFAULT_SIZE;
+
+#ifdef __DEBUG
+        u32 start = cpu_ticks();
+#endif
+        int fntHandle = fntLoadFile(fullPath, fontSize);
+#ifdef __DEBUG
+        LOG("THEMES Font %d %s: %s, loaded in %u ms\n", fntID, fntFile, fntHandle != FNT_ERROR ? "ok" : "failed", (cpu_ticks() - start) / CPU_TICKS_PER_MSEC);
+#endif
+
+        // Do we have a valid font? Assign the font handle to the theme font slot
+        if (fntHandle != FNT_ERROR)
+            theme->fonts[fntID] = fntHandle;
+    }
+
+    return theme->fonts[fntID];
+}
+
+static void thmLoadFonts(config_set_t *themeConfig, const char *themePath, theme_t *theme)
+{
+    int fntID; // theme side font id, not the fntSys handle
+
+    theme->fonts[0] = FNT_DEFAULT;
+    theme->fontsLoaded = 0;
+    thmLoadFont(themeConfig, themePath, theme, 0);
+
+    // The other slots use the default font until they are loaded
+    for (fntID = 1; fntID < THM_MAX_FONTS; ++fntID)
+        theme->fonts[fntID] = theme->fonts[0];
+}
+
 // BasicElement /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void endBasic(theme_element_t *elem)
@@ -744,7 +956,7 @@ static theme_element_t *initBasic(const char *themePath, config_set_t *themeConf
     snprintf(elemProp, sizeof(elemProp), "%s_font", name);
     if (configGetInt(themeConfig, elemProp, &intValue)) {
         if (intValue > 0 && intValue < THM_MAX_FONTS)
-            elem->font = theme->fonts[intValue];
+            elem->font = thmLoadFont(themeConfig, themePath, theme, intValue);
     }
 
     return elem;
@@ -862,8 +1074,11 @@ static void drawItemsList(struct menu_list *menu, struct submenu_list *item, con
                 if (itemIconTex && itemIconTex->Mem)
                     rmDrawPixmap(itemIconTex, posX, posY, elem->aligned, DECORATOR_SIZE, DECORATOR_SIZE, elem->scaled, gDefaultCol);
                 else {
-                    if (itemsList->decoratorImage->defaultTexture)
-                        rmDrawPixmap(&itemsList->decoratorImage->defaultTexture->source, posX, posY, elem->aligned, DECORATOR_SIZE, DECORATOR_SIZE, elem->scaled, gDefaultCol);
+                    itemIconTex = thmGetImage(itemsList->decoratorImage->defaultTexture);
+                    if (itemIconTex)
+                        rmDrawPixmap(itemIconTex, posX, posY, elem->aligned, DECORATOR_SIZE, DECORATOR_SIZE, elem->scaled, gDefaultCol);
+                    else
+                        drawImagePlaceholder(itemsList->decoratorImage->defaultTexture, posX, posY, elem->aligned, DECORATOR_SIZE, DECORATOR_SIZE, elem->scaled);
                 }
                 fntRenderString(elem->font, elem->posX + DECORATOR_SIZE, posY, elem->aligned, elem->width, elem->height, submenuItemGetText(&ps->item), color);
             } else
@@ -1205,47 +1420,12 @@ static void thmSetColors(theme_t *theme)
     }
 }
 
-static void thmLoadFonts(config_set_t *themeConfig, const char *themePath, theme_t *theme)
-{
-    int fntID; // theme side font id, not the fntSys handle
-    for (fntID = 0; fntID < THM_MAX_FONTS; ++fntID) {
-        // does the font by the key exist?
-        char fntKey[16];
-
-        if (fntID == 0) {
-            snprintf(fntKey, sizeof(fntKey), "default_font");
-            theme->fonts[0] = FNT_DEFAULT;
-        } else {
-            snprintf(fntKey, sizeof(fntKey), "font%d", fntID);
-            theme->fonts[fntID] = theme->fonts[0];
-        }
-
-        char fullPath[128];
-        const char *fntFile;
-        if (configGetStr(themeConfig, fntKey, &fntFile)) {
-            snprintf(fullPath, sizeof(fullPath), "%s%s", themePath, fntFile);
-
-            int fontSize;
-            char sizeKey[64];
-            if (fntID == 0)
-                snprintf(sizeKey, sizeof(sizeKey), "default_font_size");
-            else
-                snprintf(sizeKey, sizeof(sizeKey), "font%d_size", fntID);
-
-            if (!configGetInt(themeConfig, sizeKey, &fontSize) || fontSize <= 0)
-                fontSize = FNTSYS_DEFAULT_SIZE;
-
-            int fntHandle = fntLoadFile(fullPath, fontSize);
-            // Do we have a valid font? Assign the font handle to the theme font slot
-            if (fntHandle != FNT_ERROR)
-                theme->fonts[fntID] = fntHandle;
-        }
-    }
-}
-
 static void thmLoad(const char *themePath)
 {
     LOG("THEMES Load theme path=%s\n", themePath);
+#ifdef __DEBUG
+    u32 start = cpu_ticks(), configEnd, elemsEnd;
+#endif
     char path[256];
     theme_t *curT = gTheme;
     theme_t *newT = (theme_t *)malloc(sizeof(theme_t));
@@ -1279,6 +1459,9 @@ static void thmLoad(const char *themePath)
         themeConfig = configAlloc(0, NULL, path);
         configRead(themeConfig); // try to load the theme config file. If it does not exist, defaults will be used.
     }
+#ifdef __DEBUG
+    configEnd = cpu_ticks();
+#endif
 
     int intValue;
     if (configGetInt(themeConfig, "use_default", &intValue))
@@ -1338,12 +1521,18 @@ static void thmLoad(const char *themePath)
         }
     }
 
-    if (themePath)
+    if (themePath) {
         validateGUIElems(themePath, themeConfig, newT);
+        // The main menu is shown first: its images go to the io worker now, ahead of the art that its first draw requests
+        queueMutableImages(&newT->mainElems);
+    }
 
     newT->itemsList = newT->gamesItemsList;
 
     configFree(themeConfig);
+#ifdef __DEBUG
+    elemsEnd = cpu_ticks();
+#endif
 
     LOG("THEMES Number of cache: %d\n", newT->gameCacheCount);
     LOG("THEMES Used height: %d\n", newT->usedHeight);
@@ -1382,6 +1571,12 @@ static void thmLoad(const char *themePath)
         for (i = ELF_FORMAT; i <= VMODE_PAL; i++)
             thmLoadResource(&newT->textures[i], i, NULL, GS_PSM_CT32, 1);
 
+#ifdef __DEBUG
+    // The images of the elements are not loaded yet, they are loaded when first drawn
+    LOG("THEMES Loaded in %u ms: config %u ms, fonts and elements %u ms, icons %u ms\n", (cpu_ticks() - start) / CPU_TICKS_PER_MSEC,
+        (configEnd - start) / CPU_TICKS_PER_MSEC, (elemsEnd - configEnd) / CPU_TICKS_PER_MSEC, (cpu_ticks() - elemsEnd) / CPU_TICKS_PER_MSEC);
+#endif
+
     gTheme = newT;
     thmFree(curT);
 }
@@ -1430,6 +1625,12 @@ void thmInit(void)
     LOG("THEMES Init\n");
     gTheme = NULL;
 
+    ee_sema_t sema;
+    sema.init_count = 1;
+    sema.max_count = 1;
+    sema.option = 0;
+    thmImageSemaId = CreateSema(&sema);
+
     thmReloadScreenExtents();
 
     // initialize default internal
@@ -1438,6 +1639,11 @@ void thmInit(void)
     thmAddElements(gBaseMCDir, "/", 0);
 }
 
+void thmInitLoader(void)
+{
+    ioRegisterHandler(IO_THEME_LOAD_IMAGE, &thmLoadImage);
+}
+
 void thmReinit(const char *path)
 {
     thmLoad(NULL);
@@ -1518,6 +1724,7 @@ char *thmGetFilePath(int themeID)
 void thmEnd(void)
 {
     thmFree(gTheme);
+    DeleteSema(thmImageSemaId);
 
     int i = 0;
     for (; i < nThemes; i++) {
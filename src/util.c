@@ -179,6 +179,7 @@ int openFile(char *path, int mode)
         return -1;
 }
 
+/* The buffer gets a NUL after the data, so text files can be parsed in place. */
 void *readFile(char *path, int align, int *size)
 {
     void *buffer = NULL;
@@ -194,17 +195,32 @@ void *readFile(char *path, int align, int *size)
         }
 
         if (align > 0)
-            buffer = memalign(64, realSize); // The allocation is aligned to aid the DMA transfers
+            buffer = memalign(64, realSize + 1); // The allocation is aligned to aid the DMA transfers
         else
-            buffer = malloc(realSize);
+            buffer = malloc(realSize + 1);
 
         if (!buffer) {
             LOG("UTIL ReadFile: Failed allocation of %d bytes", realSize);
+            close(fd);
             *size = 0;
         } else {
-            read(fd, buffer, realSize);
+            unsigned int done = 0;
+            int result;
+
+            // Devices may return less than asked for at a time
+            while (done < realSize && (result = read(fd, (char *)buffer + done, realSize - done)) > 0)
+                done += result;
             close(fd);
-            *size = realSize;
+
+            if (done < realSize) {
+                LOG("UTIL ReadFile: Read %u of %u bytes of %s\n", done, realSize, path);
+                free(buffer);
+                buffer = NULL;
+                *size = 0;
+            } else {
+                ((char *)buffer)[realSize] = '\0';
+                *size = realSize;
+            }
         }
     }
     return buffer;
@@ -231,11 +247,10 @@ int listDir(char *path, const char *separator, int maxElem,
     return index;
 }
 
-/* size will be the maximum line size possible */
-file_buffer_t *openFileBuffer(char *fpath, int mode, short allocResult, unsigned int size)
+/* size will be the size of the write buffer */
+file_buffer_t *openFileBuffer(char *fpath, int mode, unsigned int size)
 {
     file_buffer_t *fileBuffer = NULL;
-    unsigned char bom[3];
 
     int fd = openFile(fpath, mode);
     if (fd >= 0) {
@@ -243,18 +258,7 @@ file_buffer_t *openFileBuffer(char *fpath, int mode, short allocResult, unsigned
         fileBuffer->size = size;
         fileBuffer->available = 0;
         fileBuffer->buffer = (char *)malloc(size * sizeof(char));
-        if (mode == O_RDONLY) {
-            fileBuffer->lastPtr = NULL;
-
-            // Check for and skip the UTF-8 BOM sequence.
-            if ((read(fd, bom, sizeof(bom)) != 3) ||
-                (bom[0] != 0xEF || bom[1] != 0xBB || bom[2] != 0xBF)) {
-                // Not BOM, so rewind.
-                lseek(fd, 0, SEEK_SET);
-            }
-        } else
-            fileBuffer->lastPtr = fileBuffer->buffer;
-        fileBuffer->allocResult = allocResult;
+        fileBuffer->lastPtr = fileBuffer->buffer;
         fileBuffer->fd = fd;
         fileBuffer->mode = mode;
     }
@@ -262,118 +266,6 @@ file_buffer_t *openFileBuffer(char *fpath, int mode, short allocResult, unsigned
     return fileBuffer;
 }
 
-/* size will be the maximum line size possible */
-file_buffer_t *openFileBufferBuffer(short allocResult, const void *buffer, unsigned int size)
-{
-    file_buffer_t *fileBuffer = NULL;
-
-    fileBuffer = (file_buffer_t *)malloc(sizeof(file_buffer_t));
-    fileBuffer->size = size;
-    fileBuffer->available = size;
-    fileBuffer->buffer = (char *)malloc((size + 1) * sizeof(char));
-    fileBuffer->lastPtr = fileBuffer->buffer; // O_RDONLY, but with the data in the buffer.
-    fileBuffer->allocResult = allocResult;
-    fileBuffer->fd = -1;
-    fileBuffer->mode = O_RDONLY;
-
-    memcpy(fileBuffer->buffer, buffer, size);
-    fileBuffer->buffer[size] = '\0';
-
-    return fileBuffer;
-}
-
-int readFileBuffer(file_buffer_t *fileBuffer, char **outBuf)
-{
-    int lineSize = 0, readSize, length;
-    char *posLF = NULL;
-
-    while (1) {
-        // if lastPtr is set, then we continue the read from this point as reference
-        if (fileBuffer->lastPtr) {
-            // Calculate the remaining chars to the right of lastPtr
-            lineSize = fileBuffer->available - (fileBuffer->lastPtr - fileBuffer->buffer);
-            /* LOG("##### Continue read, position: %X (total: %d) line size (\\0 not inc.): %d end: %x\n",
-                fileBuffer->lastPtr - fileBuffer->buffer, fileBuffer->available, lineSize, fileBuffer->lastPtr[lineSize]); */
-            posLF = strchr(fileBuffer->lastPtr, '\n');
-        }
-
-        if (!posLF) { // We can come here either when the buffer is empty, or if the remaining chars don't have a LF
-
-            // if available, we shift the remaining chars to the left ...
-            if (lineSize) {
-                // LOG("##### LF not found, Shift %d characters from end to beginning\n", lineSize);
-                memmove(fileBuffer->buffer, fileBuffer->lastPtr, lineSize);
-            }
-
-            // ... and complete the buffer if we're not at EOF
-            if (fileBuffer->fd >= 0) {
-
-                // Load as many characters necessary to fill the buffer
-                length = fileBuffer->size - lineSize - 1;
-                // LOG("##### Asking for %d characters to complete buffer\n", length);
-                readSize = read(fileBuffer->fd, fileBuffer->buffer + lineSize, length);
-                fileBuffer->buffer[lineSize + readSize] = '\0';
-
-                // Search again (from the lastly added chars only), the result will be "analyzed" in next if
-                posLF = strchr(fileBuffer->buffer + lineSize, '\n');
-
-                // Now update read context info
-                lineSize = lineSize + readSize;
-                // LOG("##### %d characters really read, line size now (\\0 not inc.): %d\n", read, lineSize);
-
-                // If buffer not full it means we are at EOF
-                if (fileBuffer->size != lineSize + 1) {
-                    // LOG("##### Reached EOF\n");
-                    close(fileBuffer->fd);
-                    fileBuffer->fd = -1;
-                }
-            }
-
-            fileBuffer->lastPtr = fileBuffer->buffer;
-            fileBuffer->available = lineSize;
-        }
-
-        if (posLF)
-            lineSize = posLF - fileBuffer->lastPtr;
-
-        // Check the previous char (on Windows there are CR/LF instead of single linux LF)
-        if (lineSize)
-            if (*(fileBuffer->lastPtr + lineSize - 1) == '\r')
-                lineSize--;
-
-        fileBuffer->lastPtr[lineSize] = '\0';
-        *outBuf = fileBuffer->lastPtr;
-
-        // LOG("##### Result line is \"%s\" size: %d avail: %d pos: %d\n", fileBuffer->lastPtr, lineSize, fileBuffer->available, fileBuffer->lastPtr - fileBuffer->buffer);
-
-        // If we are at EOF and no more chars available to scan, then we are finished
-        if (!lineSize && !fileBuffer->available && fileBuffer->fd == -1)
-            return 0;
-
-        if (fileBuffer->lastPtr[0] == '#') { // '#' for comment lines
-            if (posLF)
-                fileBuffer->lastPtr = posLF + 1;
-            else
-                fileBuffer->lastPtr = NULL;
-            continue;
-        }
-
-        if (lineSize && fileBuffer->allocResult) {
-            *outBuf = (char *)malloc((lineSize + 1) * sizeof(char));
-            memcpy(*outBuf, fileBuffer->lastPtr, lineSize + 1);
-        }
-
-        // Either move the pointer to next chars, or set it to null to force a whole buffer read (if possible)
-        if (posLF)
-            fileBuffer->lastPtr = posLF + 1;
-        else {
-            fileBuffer->lastPtr = NULL;
-        }
-
-        return 1;
-    }
-}
-
 void writeFileBuffer(file_buffer_t *fileBuffer, char *inBuf, int size)
 {
     // LOG("writeFileBuffer avail: %d size: %d\n", fileBuffer->available, size);
@@ -1,6 +1,42 @@
 
 #include "include/vmc_groups.h"
 #include <string.h>
+
+#ifndef VMC_GROUPS_LINEAR
+/*  The lookup table is generated from the title ID lists below by pc/vmcgroups.py:
+    a minimal perfect hash that maps every listed title ID straight to its group. */
+#include "include/vmc_groups_hash.h"
+
+static unsigned int vmcGroupHash(unsigned int seed, const char *titleId)
+{
+    unsigned int hash = 2166136261u ^ seed;
+
+    while (*titleId != '\0') {
+        hash ^= (unsigned char)*titleId++;
+        hash *= 16777619u;
+    }
+
+    return hash ^ (hash >> 16);
+}
+
+const char *getGroupIdForTitleId(const char *titleId)
+{
+    unsigned int slot;
+
+    if (titleId == NULL) {
+        return NULL; // Handle NULL input gracefully
+    }
+
+    if (strlen(titleId) > VMC_TITLE_ID_LEN)
+        return titleId;
+
+    slot = vmcGroupHash(vmcHashSeeds[vmcGroupHash(0, titleId) % VMC_HASH_BUCKETS], titleId) % VMC_TITLE_COUNT;
+    if (strncmp(vmcTitleIds[slot], titleId, VMC_TITLE_ID_LEN) == 0)
+        return vmcGroupIds[vmcTitleGroups[slot]];
+
+    return titleId;
+}
+#else
 // Structure to hold a single Memory Card Group and its associated Title IDs
 typedef struct
 {
@@ -1388,4 +1424,5 @@ const char *getGroupIdForTitleId(const char *titleId)
 
     // If no matching Group ID was found for the given Title ID, return the original Title ID
     return titleId;
-}
\ No newline at end of file
+}
+#endif